@@ -7,10 +7,12 @@
 
 #include <GLES2/gl2.h>
 
+#include <blowgun/gl_extensions.h>
 #include <blowgun/matrix.h>
 #include <blowgun/program.h>
 #include <blowgun/program_builder.h>
 #include <blowgun/vertex_attribute.h>
+#include <blowgun/vertex_quantization.h>
 #include <blowgun/model_loader_obj.h>
 #include <blowgun/texture.h>
 #include <blowgun/texture_builder.h>
@@ -41,12 +43,21 @@ static const char * kFragmentShaderSource = "\
         gl_FragColor = texture2D(u_texture, v_vertex_texture);\
     }";
 
-// Projection Model-View matrix
-static std::shared_ptr<blowgun::Matrix> pmv_matrix;
+// Projection Model-View matrix. In this application, PMV is a result of
+// translation multiplied by perspective. Both are constant, so the
+// whole matrix is computed at compile time.
+static BLOWGUN_CONSTEXPR const blowgun::Matrix kPMVMatrix =
+    blowgun::Matrix::CreateProduct(
+        blowgun::Matrix::CreateTranslation(0.0f, 0.0f, -15.0f),
+        blowgun::Matrix::CreatePerspective(60.0f, 800.0f / 600.0f, 1.0f, 20.0f));
 
 // Model to draw.
 static std::shared_ptr<blowgun::Model> model;
 
+// PMV matrix, with the dequantization of the model's positions in
+// front of it.
+static blowgun::Matrix pmv_matrix;
+
 // Texture for model.
 static std::unique_ptr<blowgun::Texture> texture;
 
@@ -65,18 +76,6 @@ static const blowgun::i32 kVertexTextureAttrib = 1;
 void
 ModelLoadingApplication::OnInitialization()
 {
-    // Create perspective matrix.
-    blowgun::Matrix persp = blowgun::Matrix::CreateIdentity().
-        Perspective(60, 800.0f/600.0f, 1.0f, 20.0f);
-
-    // Create translation matrix.
-    blowgun::Matrix trans = blowgun::Matrix::CreateIdentity().
-        Translate(0.0f, 0.0f, -15.0f);
-
-    // In this application, PMV is a result of translation multiplied by
-    // perspective.
-    pmv_matrix = std::make_shared<blowgun::Matrix>(trans.Multiply(persp));
-
     // Build the GPU program.
     program = blowgun::ProgramBuilder().
         AddShader(GL_VERTEX_SHADER, kVertexShaderSource).
@@ -93,6 +92,13 @@ ModelLoadingApplication::OnInitialization()
     std::ifstream cubeObjFile("data/cube.obj", std::ios::in);
     model = loader.Load(cubeObjFile);
 
+    // Store it in half the bytes. Its positions are then relative to its
+    // bounds, which the PMV matrix maps back. Texture coordinates past
+    // [0, 1] only become half floats where the device can draw them.
+    model = blowgun::QuantizeModel(*model,
+        blowgun::HasGLExtension("GL_OES_vertex_half_float"));
+    pmv_matrix = blowgun::Matrix::CreateProduct(model->position_dequantization(), kPMVMatrix);
+
     // Open the texture file.
     // Notice that `std::ios::binary` need to be explicitly requested,
     // otherwise it will fail silently on Win32. Trust me, I just spent
@@ -115,10 +121,10 @@ ModelLoadingApplication::OnInitialization()
         SetHeight(image->height).
         SetType(GL_UNSIGNED_BYTE).
         SetData(image->data).
+        SetMipmaps(true).
         Build();
 
-    // Specify "zooming" filter.
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    // Specify "zooming" filter. Minifying uses the mipmaps, trilinearly.
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 }
 
@@ -132,7 +138,7 @@ ModelLoadingApplication::OnDraw() const
 
     // Set up PMV matrix.
     int pmv_matrix_location = program->GetUniformLocation("u_PMV_matrix");
-    glUniformMatrix4fv(pmv_matrix_location, 1, GL_FALSE, pmv_matrix->values());
+    glUniformMatrix4fv(pmv_matrix_location, 1, GL_FALSE, pmv_matrix.values());
 
     // Set up the texture.
     glActiveTexture(GL_TEXTURE0);
@@ -140,30 +146,35 @@ ModelLoadingApplication::OnDraw() const
     int texture_location = program->GetUniformLocation("u_texture");
     glUniform1i(texture_location, 0);
 
-    const std::vector<blowgun::VertexAttribute> vertex_attributes =
-        model->vertex_attributes();
+    // The vertices are used in place, without any copy.
+    const blowgun::VertexLayout & layout = model->vertex_layout();
+    const blowgun::u8 * vertices = model->vertex_data();
+    const blowgun::VertexElement * position =
+        layout.Find(blowgun::VertexAttributeUsage::kPosition);
+    const blowgun::VertexElement * tex_coord =
+        layout.Find(blowgun::VertexAttributeUsage::kTexCoord);
 
     // Send vertex position information to GPU program.
     glEnableVertexAttribArray(kVertexPositionAttrib);
     glVertexAttribPointer(
         kVertexPositionAttrib,
-        3,
-        GL_FLOAT,
-        GL_FALSE,
-        2 * sizeof(blowgun::VertexAttribute),
-        &vertex_attributes.at(0).data.float_3[0]);
+        blowgun::VertexAttributeFormatComponentCount(position->format),
+        blowgun::VertexAttributeFormatType(position->format),
+        blowgun::VertexAttributeFormatIsNormalized(position->format),
+        layout.stride(),
+        vertices + position->offset);
 
     // Send vertex texture coordinate information to GPU program.
     glEnableVertexAttribArray(kVertexTextureAttrib);
     glVertexAttribPointer(
         kVertexTextureAttrib,
-        2,
-        GL_FLOAT,
-        GL_FALSE,
-        2 * sizeof(blowgun::VertexAttribute),
-        &vertex_attributes.at(1).data.float_2[0]);
+        blowgun::VertexAttributeFormatComponentCount(tex_coord->format),
+        blowgun::VertexAttributeFormatType(tex_coord->format),
+        blowgun::VertexAttributeFormatIsNormalized(tex_coord->format),
+        layout.stride(),
+        vertices + tex_coord->offset);
 
-    glDrawArrays(GL_TRIANGLES, 0, vertex_attributes.size() / 2);
+    glDrawArrays(GL_TRIANGLES, 0, model->vertex_count());
 }
 
 void
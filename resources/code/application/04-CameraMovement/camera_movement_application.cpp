@@ -1,35 +1,39 @@
 #include "camera_movement_application.h"
 
+#include <cstring>
 #include <fstream>
 #include <stdexcept>
 #include <iostream>
+#include <vector>
 
 #include <GLES2/gl2.h>
 
+#include <blowgun/asset_manager.h>
+#include <blowgun/gl_extensions.h>
 #include <blowgun/matrix.h>
+#include <blowgun/quaternion.h>
 #include <blowgun/program.h>
 #include <blowgun/program_builder.h>
 #include <blowgun/model.h>
 #include <blowgun/model_loader_obj.h>
 #include <blowgun/texture.h>
-#include <blowgun/texture_builder.h>
 #include <blowgun/image_loader_tga.h>
 
 namespace
 {
-    static std::shared_ptr<blowgun::Matrix> pmv_matrix;
+    // The projection and the camera placement never change, so the
+    // starting PMV matrix is computed at compile time.
+    static BLOWGUN_CONSTEXPR const blowgun::Matrix kInitialPMVMatrix =
+        blowgun::Matrix::CreateProduct(
+            blowgun::Matrix::CreateTranslation(0.0f, 0.0f, -15.0f),
+            blowgun::Matrix::CreatePerspective(60.0f, 800.0f / 600.0f, 1.0f, 20.0f));
 
-    static std::shared_ptr<blowgun::Matrix>
-    CreatePMVMatrix()
-    {
-        blowgun::Matrix persp = blowgun::Matrix::CreateIdentity()
-            .Perspective(60, 800.0f/600.0f, 1.0f, 20.0f);
-
-        blowgun::Matrix trans = blowgun::Matrix::CreateIdentity()
-            .Translate(0.0f, 0.0f, -15.0f);
+    static blowgun::Matrix pmv_matrix;
 
-        return std::make_shared<blowgun::Matrix>(trans.Multiply(persp));
-    }
+    // The camera's accumulated rotation, and how much it rotates each
+    // frame.
+    static blowgun::Quat camera_rotation;
+    static blowgun::Quat frame_rotation;
 
     static std::unique_ptr<blowgun::Program> program;
     static const blowgun::i32 kVertexPositionAttrib = 0;
@@ -62,51 +66,77 @@ namespace
             .Build();
     }
 
+    static std::unique_ptr<blowgun::AssetManager> assets;
     static std::shared_ptr<blowgun::Model> model;
+    static std::shared_ptr<blowgun::Texture> texture;
+
+    // The vertices of `model`, one per index, when its indices are 32
+    // bits and the device can't draw them.
+    static std::vector<blowgun::u8> unindexed_vertices;
 
-    static std::shared_ptr<blowgun::Model>
-    CreateModel()
+    static std::vector<blowgun::u8>
+    Unindex(const blowgun::Model & model)
     {
-        // Build and load the model
-        blowgun::ModelLoaderOBJ loader;
-        std::ifstream cubeObjFile("data/cube.obj", std::ios::in);
-        return loader.Load(cubeObjFile);
+        const blowgun::u32 stride = model.vertex_layout().stride();
+        const std::vector<blowgun::u32> indices = model.ReadIndices();
+        std::vector<blowgun::u8> vertices(model.index_count() * stride);
+        for (blowgun::u32 i = 0; i < model.index_count(); ++i)
+            std::memcpy(&vertices[i * stride], model.vertex_data() + indices[i] * stride, stride);
+        return vertices;
     }
 
-    static std::unique_ptr<blowgun::Texture> texture;
-
-    static std::unique_ptr<blowgun::Texture>
-    CreateTexture()
+    static std::unique_ptr<blowgun::AssetManager>
+    CreateAssetManager()
     {
-        std::ifstream image_file("data/bricks_color_map.tga",
-            std::ios::binary | std::ios::in);
-        if (!image_file.is_open())
-            throw new std::runtime_error("Can't open texture file!");
-
-        blowgun::ImageLoaderTGA imageLoaderTGA;
-        std::shared_ptr<blowgun::Image> image = imageLoaderTGA.Load(image_file);
-
-        return blowgun::TextureBuilder()
-            .SetTarget(GL_TEXTURE_2D)
-            .SetLevelOfDetail(0)
-            .SetFormat(GL_RGB)
-            .SetWidth(image->width)
-            .SetHeight(image->height)
-            .SetType(GL_UNSIGNED_BYTE)
-            .SetData(image->data)
-            .AddParameter(GL_TEXTURE_MIN_FILTER, GL_LINEAR)
-            .AddParameter(GL_TEXTURE_MAG_FILTER, GL_LINEAR)
-            .Build();
+        // Models get shared vertices, so they can be drawn with indices.
+        auto obj_loader = std::make_shared<blowgun::ModelLoaderOBJ>();
+        obj_loader->SetIndexed(true);
+
+        std::unique_ptr<blowgun::AssetManager> manager(new blowgun::AssetManager());
+        manager->
+            AddModelLoader(obj_loader).
+            AddImageLoader(std::make_shared<blowgun::ImageLoaderTGA>());
+        return manager;
     }
 }
 
 void
 CameraMovementApplication::OnInitialization()
 {
-    pmv_matrix = CreatePMVMatrix();
+    pmv_matrix = kInitialPMVMatrix;
+
+    // Same as rotating by 0.1 degree around X, then Y, then Z.
+    frame_rotation =
+        blowgun::Quat::FromAxisAngle(0.1f, 0.0f, 0.0f, 1.0f) *
+        blowgun::Quat::FromAxisAngle(0.1f, 0.0f, 1.0f, 0.0f) *
+        blowgun::Quat::FromAxisAngle(0.1f, 1.0f, 0.0f, 0.0f);
+    camera_rotation = blowgun::Quat();
+
+    // Request the assets first, so they load in the background while
+    // the program builds.
+    assets = CreateAssetManager();
+    blowgun::AssetManager::ModelFuture model_future = assets->LoadModel("data/cube.obj");
+    blowgun::AssetManager::TextureFuture texture_future =
+        assets->LoadTexture("data/bricks_color_map.tga");
+
     program = CreateProgram();
-    model = CreateModel();
-    texture = CreateTexture();
+
+    assets->Flush();
+    model = model_future.get();
+    texture = texture_future.get();
+
+    // Models of more than 65535 vertices get 32-bit indices, which
+    // OpenGL ES 2.0 only draws with GL_OES_element_index_uint. Without
+    // it, the vertices are expanded and drawn in order instead.
+    if (model->index_format() == blowgun::IndexFormat::kUnsignedInt &&
+        !blowgun::HasGLExtension("GL_OES_element_index_uint"))
+    {
+        unindexed_vertices = Unindex(*model);
+    }
+
+    texture->Bind();
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 }
 
 void
@@ -121,7 +151,7 @@ CameraMovementApplication::OnDraw() const
 
     // Set up PMV matrix.
     int pmv_matrix_location = program->GetUniformLocation("u_PMV_matrix");
-    glUniformMatrix4fv(pmv_matrix_location, 1, GL_FALSE, pmv_matrix->values());
+    glUniformMatrix4fv(pmv_matrix_location, 1, GL_FALSE, pmv_matrix.values());
 
     // Set up the texture.
     glActiveTexture(GL_TEXTURE0);
@@ -129,8 +159,15 @@ CameraMovementApplication::OnDraw() const
     int texture_location = program->GetUniformLocation("u_texture");
     glUniform1i(texture_location, 0);
 
-    const std::vector<blowgun::VertexAttribute> vertex_attributes =
-        model->vertex_attributes();
+    // The vertices are used in place, without any copy.
+    const blowgun::VertexLayout & layout = model->vertex_layout();
+    const blowgun::u8 * vertices = unindexed_vertices.empty()
+        ? model->vertex_data()
+        : &unindexed_vertices[0];
+    const blowgun::VertexElement * position =
+        layout.Find(blowgun::VertexAttributeUsage::kPosition);
+    const blowgun::VertexElement * tex_coord =
+        layout.Find(blowgun::VertexAttributeUsage::kTexCoord);
 
     // Send vertex position information to GPU program.
     glEnableVertexAttribArray(kVertexPositionAttrib);
@@ -139,8 +176,8 @@ CameraMovementApplication::OnDraw() const
         3,
         GL_FLOAT,
         GL_FALSE,
-        2 * sizeof(blowgun::VertexAttribute),
-        &vertex_attributes.at(0).data.float_3[0]);
+        layout.stride(),
+        vertices + position->offset);
 
     // Send vertex texture coordinate information to GPU program.
     glEnableVertexAttribArray(kVertexTextureAttrib);
@@ -149,21 +186,32 @@ CameraMovementApplication::OnDraw() const
         2,
         GL_FLOAT,
         GL_FALSE,
-        2 * sizeof(blowgun::VertexAttribute),
-        &vertex_attributes.at(1).data.float_2[0]);
+        layout.stride(),
+        vertices + tex_coord->offset);
+
+    if (!unindexed_vertices.empty())
+    {
+        glDrawArrays(GL_TRIANGLES, 0, model->index_count());
+        return;
+    }
 
-    glDrawArrays(GL_TRIANGLES, 0, vertex_attributes.size() / 2);
+    glDrawElements(
+        GL_TRIANGLES,
+        model->index_count(),
+        model->index_format() == blowgun::IndexFormat::kUnsignedInt
+            ? GL_UNSIGNED_INT
+            : GL_UNSIGNED_SHORT,
+        model->index_data());
 }
 
 void
 CameraMovementApplication::OnUpdate()
 {
-    blowgun::Matrix *current_pmv = pmv_matrix.get();
-    pmv_matrix = std::make_shared<blowgun::Matrix>((*current_pmv)
-        .Rotate(0.1f, 1.0f, 0.0f, 0.0f)
-        .Rotate(0.1f, 0.0f, 1.0f, 0.0f)
-        .Rotate(0.1f, 0.0f, 0.0f, 1.0f)
-    );
+    // Accumulate the rotation as a quaternion, so each frame costs one
+    // quaternion product and one conversion instead of three matrix
+    // products.
+    camera_rotation = blowgun::Normalize(frame_rotation * camera_rotation);
+    pmv_matrix = kInitialPMVMatrix.Rotate(camera_rotation);
 }
 
 void
@@ -171,4 +219,6 @@ CameraMovementApplication::OnDestroy()
 {
     program->Delete();
     texture->Delete();
+    unindexed_vertices.clear();
+    assets.reset();
 }
@@ -0,0 +1,204 @@
+#include "bench.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <new>
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+
+using namespace bench;
+using blowgun::u32;
+using blowgun::u64;
+
+volatile float bench::sink;
+
+///
+// Allocation counting: every allocation of the whole program goes
+// through these replacements.
+///
+
+namespace
+{
+    std::atomic<u64> allocation_count(0);
+    std::atomic<u64> allocated_bytes(0);
+}
+
+void *
+operator new(std::size_t size)
+{
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+
+    void * p = std::malloc(size > 0 ? size : 1);
+    if (!p)
+        throw std::bad_alloc();
+    return p;
+}
+
+void
+operator delete(void * p) noexcept
+{
+    std::free(p);
+}
+
+u64
+bench::AllocationCount()
+{
+    return allocation_count.load(std::memory_order_relaxed);
+}
+
+u64
+bench::AllocatedBytes()
+{
+    return allocated_bytes.load(std::memory_order_relaxed);
+}
+
+///
+// Harness
+///
+
+namespace
+{
+    // Value below which `fraction` of the sorted samples lie.
+    double Percentile(const std::vector<double> & sorted, double fraction)
+    {
+        size_t index = static_cast<size_t>(fraction * (sorted.size() - 1) + 0.5);
+        return sorted[std::min(index, sorted.size() - 1)];
+    }
+
+    // JSON strings here are benchmark names, which never need more
+    // than quotes and backslashes escaped.
+    std::string Quote(const std::string & text)
+    {
+        std::string quoted("\"");
+        for (size_t i = 0; i < text.size(); ++i)
+        {
+            if (text[i] == '"' || text[i] == '\\')
+                quoted += '\\';
+            quoted += text[i];
+        }
+        return quoted + "\"";
+    }
+}
+
+Harness::Harness(const Options & options) :
+    options_(options), results_()
+{
+}
+
+void
+Harness::Run(const std::string & name, u32 ops_per_sample, u64 bytes_per_op,
+    const std::function<void ()> & op)
+{
+    typedef std::chrono::high_resolution_clock Clock;
+
+    if (name.find(options_.filter) == std::string::npos)
+        return;
+
+    for (u32 s = 0; s < options_.warmup_samples; ++s)
+    {
+        for (u32 i = 0; i < ops_per_sample; ++i)
+            op();
+    }
+
+    std::vector<double> sample_ns;
+    sample_ns.reserve(options_.samples);
+
+    const u64 allocations_before = AllocationCount();
+    const u64 bytes_before = AllocatedBytes();
+
+    for (u32 s = 0; s < options_.samples; ++s)
+    {
+        Clock::time_point start = Clock::now();
+        for (u32 i = 0; i < ops_per_sample; ++i)
+            op();
+        Clock::time_point end = Clock::now();
+
+        sample_ns.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            end - start).count() / static_cast<double>(ops_per_sample));
+    }
+
+    // The vector above reserved its storage beforehand, so whatever
+    // got allocated in between is the benchmark's own doing.
+    const double op_count = static_cast<double>(options_.samples) * ops_per_sample;
+
+    Result result;
+    result.name = name;
+    result.samples = options_.samples;
+    result.ops_per_sample = ops_per_sample;
+    result.allocations_per_op = (AllocationCount() - allocations_before) / op_count;
+    result.allocated_bytes_per_op = (AllocatedBytes() - bytes_before) / op_count;
+
+    std::sort(sample_ns.begin(), sample_ns.end());
+    result.median_ns = Percentile(sample_ns, 0.5);
+    result.p99_ns = Percentile(sample_ns, 0.99);
+    result.min_ns = sample_ns.front();
+    result.bytes_per_second = (bytes_per_op > 0 && result.median_ns > 0.0)
+        ? bytes_per_op / (result.median_ns * 1e-9)
+        : 0.0;
+
+    results_.push_back(result);
+}
+
+const std::vector<Result> &
+Harness::results() const
+{
+    return results_;
+}
+
+void
+Harness::WriteTable(std::ostream & output) const
+{
+    char line[256];
+    std::snprintf(line, sizeof(line), "%-40s %12s %12s %10s %10s %12s\n",
+        "benchmark", "median ns", "p99 ns", "MB/s", "allocs/op", "bytes/op");
+    output << line;
+
+    for (auto r = results_.begin(); r != results_.end(); ++r)
+    {
+        std::snprintf(line, sizeof(line), "%-40s %12.2f %12.2f %10.1f %10.2f %12.1f\n",
+            r->name.c_str(), r->median_ns, r->p99_ns, r->bytes_per_second / 1e6,
+            r->allocations_per_op, r->allocated_bytes_per_op);
+        output << line;
+    }
+}
+
+void
+Harness::WriteJSON(std::ostream & output) const
+{
+    output << "{\n  \"benchmarks\": [";
+    for (auto r = results_.begin(); r != results_.end(); ++r)
+    {
+        output << (r == results_.begin() ? "\n" : ",\n");
+        output
+            << "    {"
+            << "\"name\": " << Quote(r->name)
+            << ", \"samples\": " << r->samples
+            << ", \"ops_per_sample\": " << r->ops_per_sample
+            << ", \"median_ns\": " << r->median_ns
+            << ", \"p99_ns\": " << r->p99_ns
+            << ", \"min_ns\": " << r->min_ns
+            << ", \"bytes_per_second\": " << r->bytes_per_second
+            << ", \"allocations_per_op\": " << r->allocations_per_op
+            << ", \"allocated_bytes_per_op\": " << r->allocated_bytes_per_op
+            << "}";
+    }
+    output << "\n  ]\n}\n";
+}
+
+std::string
+bench::ReadFile(const char * path)
+{
+    std::ifstream file(path, std::ios::in | std::ios::binary);
+    if (!file)
+        throw new std::runtime_error(std::string("Can't open ") + path);
+
+    std::stringstream content;
+    content << file.rdbuf();
+    return content.str();
+}
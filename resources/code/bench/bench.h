@@ -0,0 +1,125 @@
+#ifndef BLOWGUN_BENCH_BENCH_H_
+#define BLOWGUN_BENCH_BENCH_H_
+
+#include <functional>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+#include <blowgun/types.h>
+
+namespace bench
+{
+
+/**
+ * Get the number of `operator new` calls, and the bytes they asked
+ * for, since the program started.
+ */
+blowgun::u64 AllocationCount();
+blowgun::u64 AllocatedBytes();
+
+struct Options
+{
+	/**
+	 * Samples run before measuring, to warm up caches and the branch
+	 * predictor. Not part of the results.
+	 */
+	blowgun::u32 warmup_samples;
+
+	/**
+	 * Samples measured for each benchmark.
+	 */
+	blowgun::u32 samples;
+
+	/**
+	 * Only run the benchmarks whose name contains this string.
+	 */
+	std::string filter;
+
+	Options() : warmup_samples(3), samples(30), filter() {}
+};
+
+struct Result
+{
+	std::string name;
+	blowgun::u32 samples;
+	blowgun::u32 ops_per_sample;
+
+	// Time of one operation.
+	double median_ns;
+	double p99_ns;
+	double min_ns;
+
+	// Zero for benchmarks that don't process a known amount of data.
+	double bytes_per_second;
+
+	double allocations_per_op;
+	double allocated_bytes_per_op;
+
+	Result() :
+		name(), samples(0), ops_per_sample(0), median_ns(0.0), p99_ns(0.0), min_ns(0.0),
+		bytes_per_second(0.0), allocations_per_op(0.0), allocated_bytes_per_op(0.0)
+	{
+	}
+};
+
+/**
+ * Runs benchmarks and collects their results.
+ *
+ * A benchmark is a function performing one operation. It is called
+ * `ops_per_sample` times per sample, so operations much shorter than
+ * the clock resolution can still be measured, and the timing of each
+ * sample gives one data point.
+ */
+class Harness
+{
+private:
+	Options options_;
+	std::vector<Result> results_;
+
+public:
+	explicit Harness(const Options & options);
+
+	/**
+	 * Measure `op`.
+	 *
+	 * @param   bytes_per_op
+	 *          Bytes processed by one operation, used to report
+	 *          throughput. Zero when it doesn't apply.
+	 */
+	void Run(const std::string & name, blowgun::u32 ops_per_sample,
+		blowgun::u64 bytes_per_op, const std::function<void ()> & op);
+
+	const std::vector<Result> & results() const;
+
+	/**
+	 * Print the results as a table, one benchmark per line.
+	 */
+	void WriteTable(std::ostream & output) const;
+
+	/**
+	 * Write the results as JSON, to track them between releases.
+	 */
+	void WriteJSON(std::ostream & output) const;
+};
+
+/*
+ * Benchmark suites, one per area of the library.
+ */
+void RunMatrixBenchmarks(Harness & harness);
+void RunModelBenchmarks(Harness & harness);
+void RunImageBenchmarks(Harness & harness);
+
+/**
+ * Read a whole file, so a benchmark can work from memory.
+ */
+std::string ReadFile(const char * path);
+
+/**
+ * Accumulates results so the optimizer can't drop the work.
+ */
+extern volatile float sink;
+
+}
+
+#endif // BLOWGUN_BENCH_BENCH_H_
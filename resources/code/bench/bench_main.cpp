@@ -0,0 +1,60 @@
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#include "bench.h"
+
+// Usage: blowgun_bench [--samples N] [--warmup N] [--filter TEXT] [--json FILE]
+//
+// Run from the build directory, so `data/` is found the same way the
+// applications find it.
+int main(int argc, char ** argv)
+{
+    bench::Options options;
+    const char * json_path = 0;
+
+    for (int i = 1; i < argc; i += 2)
+    {
+        if (i + 1 == argc)
+        {
+            std::cerr << "Missing value for " << argv[i] << std::endl;
+            return 1;
+        }
+
+        if (std::strcmp(argv[i], "--samples") == 0)
+            options.samples = std::max(1, std::atoi(argv[i + 1]));
+        else if (std::strcmp(argv[i], "--warmup") == 0)
+            options.warmup_samples = std::atoi(argv[i + 1]);
+        else if (std::strcmp(argv[i], "--filter") == 0)
+            options.filter = argv[i + 1];
+        else if (std::strcmp(argv[i], "--json") == 0)
+            json_path = argv[i + 1];
+        else
+        {
+            std::cerr << "Unknown option: " << argv[i] << std::endl;
+            return 1;
+        }
+    }
+
+    bench::Harness harness(options);
+    bench::RunMatrixBenchmarks(harness);
+    bench::RunModelBenchmarks(harness);
+    bench::RunImageBenchmarks(harness);
+
+    harness.WriteTable(std::cout);
+
+    if (json_path)
+    {
+        std::ofstream json(json_path);
+        harness.WriteJSON(json);
+        if (!json)
+        {
+            std::cerr << "Couldn't write " << json_path << std::endl;
+            return 1;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,185 @@
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <blowgun/etc1.h>
+#include <blowgun/image_loader_tga.h>
+#include <blowgun/mipmap.h>
+#include <blowgun/texture_atlas.h>
+#include <blowgun/texture_builder.h>
+
+#include "bench.h"
+
+using bench::ReadFile;
+using bench::sink;
+
+// Utility
+namespace
+{
+    // Turn an uncompressed 24-bit TGA into a run-length encoded 32-bit
+    // one, opaque, as artists ship them. Only identical neighbours are
+    // packed into runs; the others go into raw packets.
+    static std::string
+    EncodeRLE32(const std::string & tga)
+    {
+        const size_t kHeaderSize = 18;
+        const size_t pixel_count = (tga.size() - kHeaderSize) / 3;
+
+        std::string file = tga.substr(0, kHeaderSize);
+        file[2] = 10;
+        file[16] = 32;
+        file[17] = static_cast<char>(file[17] | 8);
+
+        std::vector<std::string> pixels(pixel_count);
+        for (size_t i = 0; i < pixel_count; ++i)
+            pixels[i] = tga.substr(kHeaderSize + i * 3, 3) + '\xFF';
+
+        size_t i = 0;
+        while (i < pixel_count)
+        {
+            size_t run = 1;
+            while (i + run < pixel_count && run < 128 && pixels[i + run] == pixels[i])
+                ++run;
+
+            if (run > 1)
+            {
+                file += static_cast<char>(0x80 | (run - 1));
+                file += pixels[i];
+                i += run;
+                continue;
+            }
+
+            size_t raw = 1;
+            while (i + raw < pixel_count && raw < 128 &&
+                (i + raw + 1 == pixel_count || pixels[i + raw] != pixels[i + raw + 1]))
+                ++raw;
+
+            file += static_cast<char>(raw - 1);
+            for (size_t k = 0; k < raw; ++k)
+                file += pixels[i + k];
+            i += raw;
+        }
+        return file;
+    }
+}
+
+void
+bench::RunImageBenchmarks(Harness & harness)
+{
+    // Decode from memory, so disk access doesn't blur the results.
+    const std::string tga = ReadFile("data/banana.tga");
+
+    // What reading the file from the stream costs alone, the floor of
+    // the decode below.
+    harness.Run("image/tga/Read/banana", 1, tga.size(), [&]()
+    {
+        std::istringstream stream(tga);
+        std::vector<char> bytes(tga.size());
+        stream.read(bytes.data(), bytes.size());
+        sink = sink + bytes[bytes.size() / 2];
+    });
+
+    harness.Run("image/tga/Load/banana", 1, tga.size(), [&]()
+    {
+        std::istringstream stream(tga);
+        blowgun::ImageLoaderTGA loader;
+        sink = sink + loader.Load(stream)->data.size();
+    });
+
+    // Bytes per op is the size of the decoded pixels here, so both are
+    // comparable with the uncompressed one.
+    const std::string rle = EncodeRLE32(tga);
+    harness.Run("image/tga/LoadRLE/banana", 1, (tga.size() - 18) / 3 * 4, [&]()
+    {
+        std::istringstream stream(rle);
+        blowgun::ImageLoaderTGA loader;
+        sink = sink + loader.Load(stream)->data.size();
+    });
+
+    std::istringstream stream(tga);
+    blowgun::ImageLoaderTGA loader;
+    auto image = loader.Load(stream);
+
+    // Levels from 256x256 down, plain, as light, and on every core.
+    harness.Run("texture/GenerateMipmaps/banana", 1, image->data.size(), [&]()
+    {
+        sink = sink + blowgun::GenerateMipmaps(image->data.data(), image->width, image->height,
+            3, false, 1).size();
+    });
+
+    harness.Run("texture/GenerateMipmaps/banana/srgb", 1, image->data.size(), [&]()
+    {
+        sink = sink + blowgun::GenerateMipmaps(image->data.data(), image->width, image->height,
+            3, true, 1).size();
+    });
+
+    harness.Run("texture/GenerateMipmaps/banana/threaded", 1, image->data.size(), [&]()
+    {
+        sink = sink + blowgun::GenerateMipmaps(image->data.data(), image->width, image->height,
+            3, false, 0).size();
+    });
+
+    harness.Run("texture/EncodeETC1/banana", 1, image->data.size(), [&]()
+    {
+        sink = sink + blowgun::EncodeETC1(image->data.data(), image->width, image->height,
+            3, blowgun::ETC1Quality::kFast, 1).size();
+    });
+
+    harness.Run("texture/EncodeETC1/banana/high", 1, image->data.size(), [&]()
+    {
+        sink = sink + blowgun::EncodeETC1(image->data.data(), image->width, image->height,
+            3, blowgun::ETC1Quality::kHigh, 1).size();
+    });
+
+    harness.Run("texture/EncodeETC1/banana/threaded", 1, image->data.size(), [&]()
+    {
+        sink = sink + blowgun::EncodeETC1(image->data.data(), image->width, image->height,
+            3, blowgun::ETC1Quality::kFast, 0).size();
+    });
+
+    const std::vector<blowgun::byte> etc1 = blowgun::EncodeETC1(image->data.data(),
+        image->width, image->height, 3);
+    harness.Run("texture/DecodeETC1/banana", 1, etc1.size(), [&]()
+    {
+        sink = sink + blowgun::DecodeETC1(etc1.data(), image->width, image->height).size();
+    });
+
+    // Icons and decals of 8 to 64 pixels, as a scene shares them.
+    std::vector<std::shared_ptr<blowgun::Image>> small_images;
+    size_t small_size = 0;
+    blowgun::u32 seed = 1;
+    for (int i = 0; i < 200; ++i)
+    {
+        seed = seed * 1664525 + 1013904223;
+        const blowgun::u16 width = static_cast<blowgun::u16>(8 + (seed >> 8) % 57);
+        const blowgun::u16 height = static_cast<blowgun::u16>(8 + (seed >> 20) % 57);
+        small_images.push_back(std::make_shared<blowgun::Image>(width, height, 32,
+            std::vector<blowgun::byte>(width * height * 4, static_cast<blowgun::byte>(i))));
+        small_size += small_images.back()->data.size();
+    }
+
+    harness.Run("texture/TextureAtlas/Build/200", 1, small_size, [&]()
+    {
+        blowgun::TextureAtlasBuilder builder;
+        builder.SetSafeMipmapLevels(2);
+        for (size_t i = 0; i < small_images.size(); ++i)
+            builder.Add(small_images[i]);
+        sink = sink + builder.Build()->image()->width;
+    });
+
+    // Everything `TextureBuilder` does with the pixels before handing
+    // them to GL, which can't be called without a context.
+    harness.Run("texture/TextureBuilder/SetData/banana", 1, image->data.size(), [&]()
+    {
+        blowgun::TextureBuilder builder;
+        builder
+            .SetTarget(GL_TEXTURE_2D)
+            .SetFormat(GL_RGB)
+            .SetType(GL_UNSIGNED_BYTE)
+            .SetWidth(image->width)
+            .SetHeight(image->height)
+            .SetData(image->data);
+        sink = sink + image->width;
+    });
+}
@@ -0,0 +1,204 @@
+#include <cmath>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <blowgun/matrix.h>
+#include <blowgun/matrix_batch.h>
+#include <blowgun/transform_chain.h>
+
+#include "bench.h"
+
+// Compares the per-operation cost of `blowgun::Matrix` against the
+// original, `std::vector`-backed implementation, and the batch API
+// against multiplying one matrix at a time. `LegacyMatrix` below is a
+// condensed rewrite of the original rather than a copy: it only has the
+// benchmarked operations, and allocates the same vectors they did.
+
+using bench::sink;
+
+namespace
+{
+    const float kPi = 3.1415926535897932384626433832795f;
+
+    class LegacyMatrix
+    {
+    private:
+        std::vector<float> values_;
+
+        static unsigned Index(unsigned row, unsigned column)
+        {
+            return (4 * row) + column;
+        }
+
+    public:
+        explicit LegacyMatrix(const std::vector<float> values)
+            : values_(values)
+        {
+        }
+
+        const float * values() const
+        {
+            return &values_[0];
+        }
+
+        const LegacyMatrix Multiply(const LegacyMatrix & other) const
+        {
+            std::vector<float> result_values(16);
+            for (unsigned i = 0; i < 4; ++i)
+            {
+                for (unsigned j = 0; j < 4; ++j)
+                {
+                    result_values[Index(i,j)] = 0.0f;
+                    for (unsigned k = 0; k < 4; ++k)
+                    {
+                        result_values[Index(i,j)] +=
+                            values_[Index(i,k)] * other.values_[Index(k,j)];
+                    }
+                }
+            }
+            return LegacyMatrix(result_values);
+        }
+
+        const LegacyMatrix Translate(float x, float y, float z) const
+        {
+            std::vector<float> r(values_);
+            for (unsigned j = 0; j < 4; ++j)
+                r[Index(3,j)] += r[Index(0,j)] * x + r[Index(1,j)] * y + r[Index(2,j)] * z;
+            return LegacyMatrix(r);
+        }
+
+        const LegacyMatrix Rotate(float angle, float x, float y, float z) const
+        {
+            float mag = sqrtf(x * x + y * y + z * z);
+            float s = sinf(angle * kPi / 180.0f);
+            float c = cosf(angle * kPi / 180.0f);
+            if (mag <= 0.0f)
+                return *this;
+
+            x /= mag; y /= mag; z /= mag;
+            float omc = 1.0f - c;
+            std::vector<float> r(16);
+            r[Index(0,0)] = omc * x * x + c;
+            r[Index(0,1)] = omc * x * y - z * s;
+            r[Index(0,2)] = omc * z * x + y * s;
+            r[Index(1,0)] = omc * x * y + z * s;
+            r[Index(1,1)] = omc * y * y + c;
+            r[Index(1,2)] = omc * y * z - x * s;
+            r[Index(2,0)] = omc * z * x - y * s;
+            r[Index(2,1)] = omc * y * z + x * s;
+            r[Index(2,2)] = omc * z * z + c;
+            r[Index(3,3)] = 1.0f;
+            return LegacyMatrix(r).Multiply(*this);
+        }
+
+        static LegacyMatrix CreateIdentity()
+        {
+            float identity_f[] =
+            {
+                1.0f, 0, 0, 0,
+                0, 1.0f, 0, 0,
+                0, 0, 1.0f, 0,
+                0, 0, 0, 1.0f
+            };
+            return LegacyMatrix(std::vector<float>(identity_f, identity_f + 16));
+        }
+    };
+
+    // Cost of computing `model * view_projection` for a whole scene.
+    void RunBatchBenchmarks(bench::Harness & harness, unsigned object_count)
+    {
+        // Every matrix is read once and written once.
+        const blowgun::u64 bytes = 2 * 16 * sizeof(float) * object_count;
+
+        blowgun::Matrix view_projection = blowgun::Matrix()
+            .Perspective(60.0f, 800.0f / 600.0f, 1.0f, 20.0f);
+        std::vector<blowgun::Matrix> models(object_count,
+            blowgun::Matrix().Translate(1.0f, 2.0f, 3.0f).Rotate(15.0f, 0.0f, 1.0f, 0.0f));
+        std::vector<blowgun::Matrix> out(object_count);
+
+        std::vector<float> soa_storage(16 * object_count, 1.0f);
+        std::vector<float> soa_out_storage(16 * object_count);
+        blowgun::MatrixArraySoA soa_models;
+        blowgun::MatrixArraySoA soa_out;
+        for (unsigned j = 0; j < 16; ++j)
+        {
+            soa_models.values[j] = &soa_storage[j * object_count];
+            soa_out.values[j] = &soa_out_storage[j * object_count];
+        }
+
+        std::ostringstream prefix;
+        prefix << "matrix/batch_" << object_count << "/";
+        const std::string name = prefix.str();
+
+        harness.Run(name + "one_by_one", 10, bytes, [&]()
+        {
+            for (unsigned i = 0; i < object_count; ++i)
+                out[i] = models[i].Multiply(view_projection);
+        });
+
+        harness.Run(name + "aos", 10, bytes, [&]()
+        {
+            blowgun::MultiplyBatch(&models[0], object_count, view_projection, &out[0]);
+        });
+
+        harness.Run(name + "soa", 10, bytes, [&]()
+        {
+            blowgun::MultiplyBatch(soa_models, object_count, view_projection, soa_out);
+        });
+
+        harness.Run(name + "threaded", 10, bytes, [&]()
+        {
+            blowgun::MultiplyBatch(&models[0], object_count, view_projection, &out[0], 0);
+        });
+
+        sink = sink + out[object_count - 1].values()[0] + soa_out.values[0][0];
+    }
+}
+
+void
+bench::RunMatrixBenchmarks(Harness & harness)
+{
+    const unsigned kOps = 100000;
+
+    LegacyMatrix legacy = LegacyMatrix::CreateIdentity().Rotate(10.0f, 1.0f, 1.0f, 0.0f);
+    blowgun::Matrix current = blowgun::Matrix().Rotate(10.0f, 1.0f, 1.0f, 0.0f);
+
+    harness.Run("matrix/legacy/Multiply", kOps, 0, [&]() { sink = sink + legacy.Multiply(legacy).values()[5]; });
+    harness.Run("matrix/Multiply", kOps, 0, [&]() { sink = sink + current.Multiply(current).values()[5]; });
+
+    harness.Run("matrix/legacy/Translate", kOps, 0, [&]() { sink = sink + legacy.Translate(1.0f, 2.0f, 3.0f).values()[13]; });
+    harness.Run("matrix/Translate", kOps, 0, [&]() { sink = sink + current.Translate(1.0f, 2.0f, 3.0f).values()[13]; });
+
+    harness.Run("matrix/legacy/Rotate", kOps, 0, [&]() { sink = sink + legacy.Rotate(0.1f, 0.0f, 1.0f, 0.0f).values()[2]; });
+    harness.Run("matrix/Rotate", kOps, 0, [&]() { sink = sink + current.Rotate(0.1f, 0.0f, 1.0f, 0.0f).values()[2]; });
+
+    harness.Run("matrix/Inverse", kOps, 0, [&]() { sink = sink + current.Inverse().values()[5]; });
+    harness.Run("matrix/AffineInverse", kOps, 0, [&]() { sink = sink + current.AffineInverse().values()[5]; });
+
+    // The per-frame camera update done by `CameraMovementApplication`.
+    harness.Run("matrix/legacy/CameraFrame", kOps, 0, [&]()
+    {
+        legacy = legacy
+            .Rotate(0.1f, 1.0f, 0.0f, 0.0f)
+            .Rotate(0.1f, 0.0f, 1.0f, 0.0f)
+            .Rotate(0.1f, 0.0f, 0.0f, 1.0f);
+    });
+    harness.Run("matrix/CameraFrame", kOps, 0, [&]()
+    {
+        current = current
+            .Rotate(0.1f, 1.0f, 0.0f, 0.0f)
+            .Rotate(0.1f, 0.0f, 1.0f, 0.0f)
+            .Rotate(0.1f, 0.0f, 0.0f, 1.0f);
+    });
+    harness.Run("matrix/TransformChain/CameraFrame", kOps, 0, [&]()
+    {
+        current = blowgun::TransformChain(current)
+            .Rotate(0.1f, 1.0f, 0.0f, 0.0f)
+            .Rotate(0.1f, 0.0f, 1.0f, 0.0f)
+            .Rotate(0.1f, 0.0f, 0.0f, 1.0f)
+            .ToMatrix();
+    });
+
+    RunBatchBenchmarks(harness, 5000);
+}
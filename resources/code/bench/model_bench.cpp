@@ -0,0 +1,132 @@
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <blowgun/cooked_mesh.h>
+#include <blowgun/mesh_normals.h>
+#include <blowgun/mesh_optimizer.h>
+#include <blowgun/mesh_simplifier.h>
+#include <blowgun/model_loader_obj.h>
+
+#include "bench.h"
+
+using bench::ReadFile;
+using bench::sink;
+
+void
+bench::RunModelBenchmarks(Harness & harness)
+{
+    // Parse from memory, so disk access doesn't blur the results.
+    const std::string obj = ReadFile("data/banana.obj");
+
+    harness.Run("model/obj/Load/banana", 1, obj.size(), [&]()
+    {
+        std::istringstream stream(obj);
+        blowgun::ModelLoaderOBJ loader;
+        sink = sink + loader.Load(stream)->vertex_count();
+    });
+
+    harness.Run("model/obj/LoadMemory/banana", 1, obj.size(), [&]()
+    {
+        blowgun::ModelLoaderOBJ loader;
+        sink = sink + loader.Load(obj.data(), obj.size())->bounds().sphere.radius;
+    });
+
+    harness.Run("model/obj/LoadMemory/banana/threaded", 1, obj.size(), [&]()
+    {
+        blowgun::ModelLoaderOBJ loader(0);
+        sink = sink + loader.Load(obj.data(), obj.size())->bounds().sphere.radius;
+    });
+
+    harness.Run("model/obj/LoadIndexed/banana", 1, obj.size(), [&]()
+    {
+        blowgun::ModelLoaderOBJ loader;
+        loader.SetIndexed(true);
+        sink = sink + loader.Load(obj.data(), obj.size())->index_count();
+    });
+
+    harness.Run("model/obj/LoadTangents/banana", 1, obj.size(), [&]()
+    {
+        blowgun::ModelLoaderOBJ loader;
+        loader.SetIndexed(true).SetTangents(true);
+        sink = sink + loader.Load(obj.data(), obj.size())->index_count();
+    });
+
+    // Mapped from the file, which is in the page cache after the first
+    // sample.
+    harness.Run("model/obj/LoadFile/banana", 1, obj.size(), [&]()
+    {
+        blowgun::ModelLoaderOBJ loader;
+        sink = sink + loader.Load(std::string("data/banana.obj"))->bounds().sphere.radius;
+    });
+
+    // The same model, cooked once and then mapped.
+    {
+        blowgun::ModelLoaderOBJ loader;
+        loader.SetIndexed(true);
+        std::ofstream cooked("banana.mesh", std::ios::out | std::ios::binary);
+        blowgun::CookMesh(*loader.Load(obj.data(), obj.size()), cooked);
+    }
+
+    harness.Run("model/mesh/Map/banana", 1, obj.size(), [&]()
+    {
+        blowgun::CookedMesh mesh(std::string("banana.mesh"));
+        sink = sink + mesh.vertex_data()[mesh.vertex_data_size() - 1];
+    });
+
+    harness.Run("model/mesh/CreateModel/banana", 1, obj.size(), [&]()
+    {
+        blowgun::CookedMesh mesh(std::string("banana.mesh"));
+        sink = sink + mesh.CreateModel()->vertex_count();
+    });
+
+    // Applications fetch the vertices of their model every frame.
+    std::istringstream stream(obj);
+    blowgun::ModelLoaderOBJ loader;
+    auto model = loader.Load(stream);
+
+    harness.Run("model/vertex_data/banana", 10, model->vertex_data_size(), [&]()
+    {
+        sink = sink + model->vertex_data()[0];
+    });
+
+    // Smooth normals of the indexed model, in place in its vertices.
+    loader.SetIndexed(true);
+    auto indexed = loader.Load(obj.data(), obj.size());
+    std::vector<blowgun::u32> indices = indexed->ReadIndices();
+    std::vector<blowgun::u8> vertices(indexed->vertex_data(),
+        indexed->vertex_data() + indexed->vertex_data_size());
+    const blowgun::VertexLayout & layout = indexed->vertex_layout();
+    const blowgun::u32 normal_offset = layout.Find(blowgun::VertexAttributeUsage::kNormal)->offset;
+
+    harness.Run("model/normals/Compute/banana", 1, indexed->vertex_data_size(), [&]()
+    {
+        blowgun::ComputeNormals(
+            reinterpret_cast<const float *>(&vertices[0]),
+            indexed->vertex_count(),
+            &indices[0],
+            indexed->index_count(),
+            reinterpret_cast<float *>(&vertices[normal_offset]),
+            layout.stride());
+        sink = sink + vertices[normal_offset];
+    });
+
+    // Vertex cache, overdraw and vertex fetch optimization, as the mesh
+    // cooker runs it.
+    harness.Run("model/optimize/banana", 1, indexed->vertex_data_size(), [&]()
+    {
+        sink = sink + blowgun::OptimizeModel(*indexed)->vertex_count();
+    });
+
+    // Levels of detail at half, a quarter and a tenth of the triangles.
+    std::vector<float> lod_ratios;
+    lod_ratios.push_back(0.5f);
+    lod_ratios.push_back(0.25f);
+    lod_ratios.push_back(0.1f);
+
+    harness.Run("model/lod/BuildLodChain/banana", 1, indexed->vertex_data_size(), [&]()
+    {
+        sink = sink + blowgun::BuildLodChain(indexed, lod_ratios).back().error;
+    });
+}
@@ -0,0 +1,423 @@
+#include "asset_manager.h"
+
+#include <exception>
+#include <fstream>
+#include <stdexcept>
+#include <utility>
+
+#include <GLES2/gl2.h>
+
+#include "parallel.h"
+#include "texture_builder.h"
+
+using namespace blowgun;
+
+// Utility
+namespace
+{
+    // Open the file at `path` and load it with the first of `loaders`
+    // that accepts it.
+    template <typename Asset, typename Loader>
+    static std::shared_ptr<Asset>
+    LoadFile(const std::vector<std::shared_ptr<Loader>> & loaders, const std::string & path)
+    {
+        std::ifstream input(path.c_str(), std::ios::in | std::ios::binary);
+        if (!input.is_open())
+            throw new std::runtime_error("Can't open " + path);
+
+        for (size_t i = 0; i < loaders.size(); ++i)
+        {
+            input.clear();
+            input.seekg(0, std::ios::beg);
+            if (!loaders[i]->CanLoad(input))
+                continue;
+
+            input.clear();
+            input.seekg(0, std::ios::beg);
+            return loaders[i]->Load(input);
+        }
+
+        throw new std::runtime_error("No loader for " + path);
+    }
+
+    // The exception being handled, for a future. Errors are thrown as
+    // `std::runtime_error *`, but nobody could delete one shared by
+    // several futures: it is copied, deleted, and the copy is thrown.
+    static std::exception_ptr
+    CurrentError()
+    {
+        try
+        {
+            throw;
+        }
+        catch (std::runtime_error * error)
+        {
+            const std::runtime_error copy(*error);
+            delete error;
+            try
+            {
+                throw copy;
+            }
+            catch (...)
+            {
+                return std::current_exception();
+            }
+        }
+        catch (...)
+        {
+            return std::current_exception();
+        }
+    }
+
+    // Remove the finished entries of `cache` that failed, or whose
+    // asset nobody else holds, and append those assets to `released`.
+    template <typename Cache, typename Asset>
+    static u32
+    RemoveUnused(Cache & cache, std::vector<std::shared_ptr<Asset>> & released)
+    {
+        u32 count = 0;
+        for (auto i = cache.begin(); i != cache.end();)
+        {
+            bool unused = false;
+            if (i->second.done)
+            {
+                // Done futures are ready, so this doesn't wait.
+                try
+                {
+                    // One owner is the state of the future, another one
+                    // is `asset`.
+                    std::shared_ptr<Asset> asset = i->second.future.get();
+                    unused = asset.use_count() <= 2;
+                    if (unused)
+                        released.push_back(asset);
+                }
+                catch (...)
+                {
+                    unused = true;
+                }
+            }
+
+            if (unused)
+            {
+                cache.erase(i++);
+                ++count;
+            }
+            else
+            {
+                ++i;
+            }
+        }
+        return count;
+    }
+
+    static GLenum
+    TextureFormat(const Image & image)
+    {
+        switch (image.bpp)
+        {
+        case 8  : return GL_LUMINANCE;
+        case 16 : return GL_LUMINANCE_ALPHA;
+        case 32 : return GL_RGBA;
+        default : return GL_RGB;
+        }
+    }
+}
+
+AssetManager::AssetManager(u32 thread_count) :
+    model_loaders_(),
+    image_loaders_(),
+    mutex_(),
+    condition_(),
+    tasks_(),
+    uploads_(),
+    pending_count_(0),
+    stopping_(false),
+    models_(),
+    images_(),
+    textures_(),
+    workers_()
+{
+    if (thread_count == 0)
+        thread_count = HardwareThreadCount();
+
+    for (u32 i = 0; i < thread_count; ++i)
+        workers_.push_back(std::thread(&AssetManager::RunWorker, this));
+}
+
+AssetManager::~AssetManager()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    condition_.notify_all();
+
+    for (auto worker = workers_.begin(); worker != workers_.end(); ++worker)
+        worker->join();
+}
+
+AssetManager &
+AssetManager::AddModelLoader(const std::shared_ptr<ModelLoader> & loader)
+{
+    model_loaders_.push_back(loader);
+    return *this;
+}
+
+AssetManager &
+AssetManager::AddImageLoader(const std::shared_ptr<ImageLoader> & loader)
+{
+    image_loaders_.push_back(loader);
+    return *this;
+}
+
+void
+AssetManager::RunWorker()
+{
+    for (;;)
+    {
+        std::function<void ()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            while (tasks_.empty() && !stopping_)
+                condition_.wait(lock);
+
+            // Queued loads are still done when stopping, so nobody
+            // waits forever on their future.
+            if (tasks_.empty())
+                return;
+
+            task = tasks_.front();
+            tasks_.pop_front();
+        }
+        task();
+    }
+}
+
+template <typename T>
+std::shared_future<std::shared_ptr<T>>
+AssetManager::Request(
+    std::map<std::string, CacheEntry<T>> & cache,
+    const std::string & path,
+    const std::function<std::shared_ptr<T> ()> & load)
+{
+    auto found = cache.find(path);
+    if (found != cache.end())
+        return found->second.future;
+
+    auto promise = std::make_shared<std::promise<std::shared_ptr<T>>>();
+    CacheEntry<T> & entry = cache[path];
+    entry.future = promise->get_future().share();
+
+    auto * self = this;
+    auto * target = &cache;
+    tasks_.push_back([self, target, path, promise, load]()
+    {
+        std::shared_ptr<T> asset;
+        std::exception_ptr error;
+        try
+        {
+            asset = load();
+        }
+        catch (...)
+        {
+            error = CurrentError();
+        }
+
+        // Fulfil the promise and finish at once, so the future of a
+        // finished entry is ready, and whoever gets the asset sees it
+        // finished.
+        std::lock_guard<std::mutex> lock(self->mutex_);
+        if (error)
+            promise->set_exception(error);
+        else
+            promise->set_value(std::move(asset));
+        self->Finish(*target, path);
+    });
+    ++pending_count_;
+    condition_.notify_all();
+
+    return entry.future;
+}
+
+template <typename T>
+void
+AssetManager::Finish(std::map<std::string, CacheEntry<T>> & cache, const std::string & path)
+{
+    // The entry is still there: only finished ones are ever removed, and
+    // this one only becomes finished here.
+    CacheEntry<T> & entry = cache[path];
+    entry.done = true;
+    for (size_t i = 0; i < entry.waiting.size(); ++i)
+        entry.waiting[i]();
+    entry.waiting.clear();
+
+    --pending_count_;
+    condition_.notify_all();
+}
+
+AssetManager::ModelFuture
+AssetManager::LoadModel(const std::string & path)
+{
+    const std::vector<std::shared_ptr<ModelLoader>> & loaders = model_loaders_;
+    std::lock_guard<std::mutex> lock(mutex_);
+    return Request<Model>(models_, path, [&loaders, path]()
+    {
+        return LoadFile<Model>(loaders, path);
+    });
+}
+
+AssetManager::ImageFuture
+AssetManager::LoadImage(const std::string & path)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return RequestImage(path);
+}
+
+AssetManager::ImageFuture
+AssetManager::RequestImage(const std::string & path)
+{
+    const std::vector<std::shared_ptr<ImageLoader>> & loaders = image_loaders_;
+    return Request<Image>(images_, path, [&loaders, path]()
+    {
+        return LoadFile<Image>(loaders, path);
+    });
+}
+
+AssetManager::TextureFuture
+AssetManager::LoadTexture(const std::string & path)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto found = textures_.find(path);
+    if (found != textures_.end())
+        return found->second.future;
+
+    const ImageFuture image = RequestImage(path);
+
+    auto promise = std::make_shared<std::promise<std::shared_ptr<Texture>>>();
+    CacheEntry<Texture> & entry = textures_[path];
+    entry.future = promise->get_future().share();
+
+    auto * self = this;
+    std::function<void ()> upload = [self, path, image, promise]()
+    {
+        std::shared_ptr<Texture> texture;
+        std::exception_ptr error;
+        try
+        {
+            const std::shared_ptr<Image> decoded = image.get();
+
+            // Rows of RGB pixels aren't always 4-byte aligned.
+            GLint alignment;
+            glGetIntegerv(GL_UNPACK_ALIGNMENT, &alignment);
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+            try
+            {
+                texture = TextureBuilder().
+                    SetTarget(GL_TEXTURE_2D).
+                    SetLevelOfDetail(0).
+                    SetFormat(TextureFormat(*decoded)).
+                    SetWidth(decoded->width).
+                    SetHeight(decoded->height).
+                    SetType(GL_UNSIGNED_BYTE).
+                    SetData(decoded->data).
+                    Build();
+            }
+            catch (...)
+            {
+                glPixelStorei(GL_UNPACK_ALIGNMENT, alignment);
+                throw;
+            }
+            glPixelStorei(GL_UNPACK_ALIGNMENT, alignment);
+        }
+        catch (...)
+        {
+            error = CurrentError();
+        }
+
+        std::lock_guard<std::mutex> lock(self->mutex_);
+        if (error)
+            promise->set_exception(error);
+        else
+            promise->set_value(std::move(texture));
+        self->Finish(self->textures_, path);
+    };
+
+    // Leave the upload to the OpenGL thread once the image is decoded,
+    // rather than have a worker wait for it. The image entry is still
+    // there: it was just requested, with the lock held since.
+    CacheEntry<Image> & source = images_[path];
+    if (source.done)
+    {
+        uploads_.push_back(upload);
+    }
+    else
+    {
+        source.waiting.push_back([self, upload]()
+        {
+            self->uploads_.push_back(upload);
+        });
+    }
+    ++pending_count_;
+    condition_.notify_all();
+
+    return entry.future;
+}
+
+u32
+AssetManager::ProcessUploads(u32 max_count)
+{
+    u32 count = 0;
+    while (count < max_count)
+    {
+        std::function<void ()> upload;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (uploads_.empty())
+                break;
+
+            upload = uploads_.front();
+            uploads_.pop_front();
+        }
+        upload();
+        ++count;
+    }
+    return count;
+}
+
+void
+AssetManager::Flush()
+{
+    for (;;)
+    {
+        ProcessUploads();
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (pending_count_ == 0)
+            return;
+        if (uploads_.empty())
+            condition_.wait(lock);
+    }
+}
+
+u32
+AssetManager::ReleaseUnused()
+{
+    // Released assets are destroyed, and textures deleted, once the
+    // lock is released.
+    std::vector<std::shared_ptr<Model>> released_models;
+    std::vector<std::shared_ptr<Image>> released_images;
+    std::vector<std::shared_ptr<Texture>> released_textures;
+    u32 count = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        count += RemoveUnused(models_, released_models);
+        count += RemoveUnused(images_, released_images);
+        count += RemoveUnused(textures_, released_textures);
+    }
+
+    for (size_t i = 0; i < released_textures.size(); ++i)
+        released_textures[i]->Delete();
+
+    return count;
+}
@@ -0,0 +1,183 @@
+#ifndef BLOWGUN_ASSET_MANAGER_H_
+#define BLOWGUN_ASSET_MANAGER_H_
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "image.h"
+#include "image_loader.h"
+#include "model.h"
+#include "model_loader.h"
+#include "texture.h"
+#include "types.h"
+
+namespace blowgun
+{
+
+/**
+ * Loads models, images and textures on a pool of background threads,
+ * and keeps them for whoever asks for the same path again.
+ *
+ * Each file is opened on a worker thread, and handed to the first
+ * registered loader whose `CanLoad` accepts it. Requests return at once
+ * with a future; a request for a path that is already loading, or
+ * loaded, gets the same future, so nothing is loaded twice.
+ *
+ * Textures are decoded on the workers too, but OpenGL calls have to
+ * come from the thread that owns the context: their upload is queued
+ * once the image is decoded, and waits until that thread calls
+ * `ProcessUploads` or `Flush`.
+ *
+ * Every failure, such as a missing file or a format no loader knows, is
+ * thrown from the `get` of the future as a `std::runtime_error`, by
+ * value unlike in the rest of the library: several callers can share a
+ * future, so none of them could delete a pointer.
+ */
+class AssetManager
+{
+public:
+	typedef std::shared_future<std::shared_ptr<Model>>   ModelFuture;
+	typedef std::shared_future<std::shared_ptr<Image>>   ImageFuture;
+	typedef std::shared_future<std::shared_ptr<Texture>> TextureFuture;
+
+	/**
+	 * @param   thread_count
+	 *          Number of background threads. Zero means
+	 *          `HardwareThreadCount()`.
+	 */
+	explicit AssetManager(u32 thread_count = 0);
+
+	/**
+	 * Wait for the loads in progress, then stop the threads. Uploads
+	 * that weren't processed are abandoned: their futures throw
+	 * `std::future_error`.
+	 */
+	~AssetManager();
+
+	/**
+	 * Register a loader, tried after the ones registered before it.
+	 * Loaders have to be registered before anything is loaded.
+	 */
+	AssetManager & AddModelLoader(const std::shared_ptr<ModelLoader> & loader);
+	AssetManager & AddImageLoader(const std::shared_ptr<ImageLoader> & loader);
+
+	ModelFuture LoadModel(const std::string & path);
+	ImageFuture LoadImage(const std::string & path);
+
+	/**
+	 * Load the image at `path` and create a `GL_TEXTURE_2D` out of it,
+	 * on the next call to `ProcessUploads` or `Flush` once it is
+	 * decoded. The image goes through the cache of `LoadImage`, and no
+	 * worker waits for it.
+	 */
+	TextureFuture LoadTexture(const std::string & path);
+
+	/**
+	 * Create the textures whose image is decoded, at most `max_count`
+	 * of them so a frame doesn't take too long. Must be called from the
+	 * thread that owns the OpenGL context.
+	 *
+	 * @return  The number of textures created.
+	 */
+	u32 ProcessUploads(u32 max_count = 0xFFFFFFFF);
+
+	/**
+	 * Wait until every requested asset is loaded, creating textures on
+	 * the way. Must be called from the thread that owns the OpenGL
+	 * context, typically once at startup, after requesting everything.
+	 */
+	void Flush();
+
+	/**
+	 * Forget the assets only the cache still holds, and the failed
+	 * loads, so they are loaded again on the next request. Loads in
+	 * progress are kept. Forgotten textures are deleted, so this must be
+	 * called from the thread that owns the OpenGL context, and callers
+	 * have to keep the assets they use, not only their futures.
+	 *
+	 * @return  The number of assets forgotten.
+	 */
+	u32 ReleaseUnused();
+
+private:
+	template <typename T>
+	struct CacheEntry
+	{
+		std::shared_future<std::shared_ptr<T>> future;
+		bool                                   done;
+
+		/**
+		 * Called with `mutex_` held once the load is over, to queue
+		 * what depends on it.
+		 */
+		std::vector<std::function<void ()>>    waiting;
+
+		CacheEntry() : future(), done(false), waiting() {}
+	};
+
+	typedef std::map<std::string, CacheEntry<Model>>   ModelCache;
+	typedef std::map<std::string, CacheEntry<Image>>   ImageCache;
+	typedef std::map<std::string, CacheEntry<Texture>> TextureCache;
+
+	std::vector<std::shared_ptr<ModelLoader>> model_loaders_;
+	std::vector<std::shared_ptr<ImageLoader>> image_loaders_;
+
+	/**
+	 * Everything below is guarded by `mutex_`. `condition_` is notified
+	 * whenever a task is queued or finished, and when stopping.
+	 */
+	std::mutex                         mutex_;
+	std::condition_variable            condition_;
+	std::deque<std::function<void ()>> tasks_;
+	std::deque<std::function<void ()>> uploads_;
+	u32                                pending_count_;
+	bool                               stopping_;
+
+	ModelCache                         models_;
+	ImageCache                         images_;
+	TextureCache                       textures_;
+
+	std::vector<std::thread>           workers_;
+
+	void RunWorker();
+
+	/**
+	 * Get the future of `path` in `cache`, or start loading it with
+	 * `load` on a worker. `mutex_` must be held.
+	 */
+	template <typename T>
+	std::shared_future<std::shared_ptr<T>> Request(
+		std::map<std::string, CacheEntry<T>> & cache,
+		const std::string & path,
+		const std::function<std::shared_ptr<T> ()> & load);
+
+	/**
+	 * Get the future of the image at `path`, or start loading it.
+	 * `mutex_` must be held.
+	 */
+	ImageFuture RequestImage(const std::string & path);
+
+	/**
+	 * Record that the load of `path` in `cache` is over, successful or
+	 * not, and call what was waiting for it. Its future must be ready.
+	 * `mutex_` must be held.
+	 */
+	template <typename T>
+	void Finish(std::map<std::string, CacheEntry<T>> & cache, const std::string & path);
+
+	// Disallow copy and assign.
+	AssetManager(const AssetManager & rhs);
+	AssetManager & operator=(const AssetManager & rhs);
+};
+
+}
+
+#endif // BLOWGUN_ASSET_MANAGER_H_
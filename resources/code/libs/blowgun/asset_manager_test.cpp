@@ -0,0 +1,182 @@
+#include <cstdio>
+#include <fstream>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "asset_manager.h"
+#include "cooked_mesh.h"
+#include "image_loader_tga.h"
+#include "model_loader_cooked.h"
+#include "model_loader_obj.h"
+
+using namespace blowgun;
+
+namespace
+{
+    // OBJ loader that counts how many models it loads.
+    class CountingLoader : public ModelLoaderOBJ
+    {
+    private:
+        std::mutex mutex_;
+        u32        load_count_;
+
+    public:
+        CountingLoader() : ModelLoaderOBJ(), mutex_(), load_count_(0) {}
+
+        virtual std::shared_ptr<Model> Load(std::istream & stream)
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                ++load_count_;
+            }
+            return ModelLoaderOBJ::Load(stream);
+        }
+
+        u32 load_count()
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return load_count_;
+        }
+    };
+
+    template <typename Future>
+    bool ThrowsRuntimeError(const Future & future)
+    {
+        try
+        {
+            future.get();
+        }
+        catch (const std::runtime_error &)
+        {
+            return true;
+        }
+        return false;
+    }
+}
+
+TEST(AssetManagerTest, DispatchByContent)
+{
+    const std::string cooked_path = "asset_manager_test.mesh";
+    {
+        ModelLoaderOBJ loader;
+        std::ofstream file(cooked_path.c_str(), std::ios::out | std::ios::binary);
+        CookMesh(*loader.SetIndexed(true).Load(std::string("data/banana.obj")), file);
+    }
+
+    {
+        AssetManager assets(2);
+        assets
+            .AddModelLoader(std::make_shared<ModelLoaderCooked>())
+            .AddModelLoader(std::make_shared<ModelLoaderOBJ>());
+
+        AssetManager::ModelFuture cube = assets.LoadModel("data/cube.obj");
+        AssetManager::ModelFuture banana = assets.LoadModel(cooked_path);
+
+        EXPECT_EQ(0u, cube.get()->index_count());
+        EXPECT_EQ(36u, cube.get()->vertex_count());
+        EXPECT_GT(banana.get()->index_count(), 0u);
+
+        // A TGA is neither.
+        EXPECT_TRUE(ThrowsRuntimeError(assets.LoadModel("data/banana.tga")));
+        EXPECT_TRUE(ThrowsRuntimeError(assets.LoadModel("data/missing.obj")));
+    }
+
+    std::remove(cooked_path.c_str());
+}
+
+TEST(AssetManagerTest, LoadsOnce)
+{
+    auto loader = std::make_shared<CountingLoader>();
+    AssetManager assets(3);
+    assets.AddModelLoader(loader);
+
+    // Requests from several threads at once share one load.
+    std::vector<AssetManager::ModelFuture> futures(8);
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < futures.size(); ++i)
+    {
+        threads.push_back(std::thread([&assets, &futures, i]()
+        {
+            futures[i] = assets.LoadModel("data/banana.obj");
+        }));
+    }
+    for (size_t i = 0; i < threads.size(); ++i)
+        threads[i].join();
+
+    std::shared_ptr<Model> model = futures[0].get();
+    for (size_t i = 1; i < futures.size(); ++i)
+        EXPECT_EQ(model, futures[i].get());
+    EXPECT_EQ(1u, loader->load_count());
+
+    // Still cached while somebody holds it.
+    futures.clear();
+    EXPECT_EQ(0u, assets.ReleaseUnused());
+    EXPECT_EQ(model, assets.LoadModel("data/banana.obj").get());
+    EXPECT_EQ(1u, loader->load_count());
+
+    // Gone once nobody does.
+    model.reset();
+    EXPECT_EQ(1u, assets.ReleaseUnused());
+    EXPECT_TRUE(assets.LoadModel("data/banana.obj").get() != nullptr);
+    EXPECT_EQ(2u, loader->load_count());
+}
+
+TEST(AssetManagerTest, Images)
+{
+    AssetManager assets(2);
+    assets.AddImageLoader(std::make_shared<ImageLoaderTGA>());
+
+    AssetManager::ImageFuture image = assets.LoadImage("data/banana.tga");
+    AssetManager::ImageFuture missing = assets.LoadImage("data/missing.tga");
+
+    // Nothing to upload: waits for the loads only.
+    assets.Flush();
+    EXPECT_EQ(0u, assets.ProcessUploads());
+
+    std::shared_ptr<Image> decoded = image.get();
+    EXPECT_GT(decoded->width, 0);
+    EXPECT_EQ(decoded, assets.LoadImage("data/banana.tga").get());
+    EXPECT_TRUE(ThrowsRuntimeError(missing));
+
+    // Failed loads are forgotten, so they can be tried again.
+    EXPECT_EQ(1u, assets.ReleaseUnused());
+}
+
+TEST(AssetManagerTest, Textures)
+{
+    // Without an OpenGL context, only textures that fail can be
+    // uploaded: they fail before any OpenGL call.
+    AssetManager::TextureFuture texture;
+    {
+        AssetManager assets(1);
+        assets
+            .AddModelLoader(std::make_shared<ModelLoaderOBJ>())
+            .AddImageLoader(std::make_shared<ImageLoaderTGA>());
+
+        AssetManager::TextureFuture missing = assets.LoadTexture("data/missing.tga");
+        texture = assets.LoadTexture("data/banana.tga");
+
+        // The only worker doesn't wait for the uploads.
+        std::shared_ptr<Model> model = assets.LoadModel("data/cube.obj").get();
+        std::shared_ptr<Image> image = assets.LoadImage("data/banana.tga").get();
+        EXPECT_TRUE(model != nullptr);
+        EXPECT_TRUE(image != nullptr);
+
+        // The missing image fails its texture too, once uploaded.
+        EXPECT_EQ(1u, assets.ProcessUploads(1));
+        EXPECT_TRUE(ThrowsRuntimeError(missing));
+        EXPECT_TRUE(ThrowsRuntimeError(assets.LoadTexture("data/missing.tga")));
+
+        // The failed image and texture.
+        EXPECT_EQ(2u, assets.ReleaseUnused());
+    }
+
+    // Never uploaded.
+    EXPECT_THROW(texture.get(), std::future_error);
+}
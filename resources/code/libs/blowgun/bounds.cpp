@@ -0,0 +1,111 @@
+#include "bounds.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "simd.h"
+
+using namespace blowgun;
+
+// Utility
+namespace
+{
+    static const float * Position(const u8 * base, u32 index, u32 stride)
+    {
+        return reinterpret_cast<const float *>(base + index * stride);
+    }
+}
+
+Bounds
+blowgun::ComputeBounds(const float * positions, u32 count, u32 stride)
+{
+    using namespace simd;
+
+    Bounds bounds;
+    bounds.sphere.radius = 0.0f;
+    if (count == 0)
+        return bounds;
+
+    if (stride == 0)
+        stride = 3 * sizeof(float);
+    const u8 * base = reinterpret_cast<const u8 *>(positions);
+
+    // Positions are loaded four floats at a time, and the fourth lane
+    // is simply ignored. That would read past the end of a tightly
+    // packed array for the last position, so that one is always read
+    // one float at a time.
+    const u32 load_count = (stride >= 4 * sizeof(float)) ? count : count - 1;
+
+    ///
+    // Box: per-lane minimum and maximum over every position.
+    ///
+
+    const float * first = Position(base, 0, stride);
+    Float4 min = Set(first[0], first[1], first[2], 0.0f);
+    Float4 max = min;
+
+    u32 i = 0;
+    for (; i < load_count; ++i)
+    {
+        const Float4 p = Load(Position(base, i, stride));
+        min = Min(min, p);
+        max = Max(max, p);
+    }
+    for (; i < count; ++i)
+    {
+        const float * p = Position(base, i, stride);
+        const Float4 v = Set(p[0], p[1], p[2], 0.0f);
+        min = Min(min, v);
+        max = Max(max, v);
+    }
+
+    BLOWGUN_ALIGN(16) float lanes[4];
+    Store(lanes, min);
+    bounds.aabb.min = Vec3(lanes[0], lanes[1], lanes[2]);
+    Store(lanes, max);
+    bounds.aabb.max = Vec3(lanes[0], lanes[1], lanes[2]);
+
+    ///
+    // Sphere: the furthest position from the center of the box, four
+    // positions per step, transposed so each register holds one axis.
+    ///
+
+    const Vec3 center = (bounds.aabb.min + bounds.aabb.max) * 0.5f;
+    const Float4 center_x = Splat(center.x);
+    const Float4 center_y = Splat(center.y);
+    const Float4 center_z = Splat(center.z);
+
+    Float4 max_distance2 = Splat(0.0f);
+
+    i = 0;
+    for (; i + 4 <= load_count; i += 4)
+    {
+        Float4 x = Load(Position(base, i + 0, stride));
+        Float4 y = Load(Position(base, i + 1, stride));
+        Float4 z = Load(Position(base, i + 2, stride));
+        Float4 w = Load(Position(base, i + 3, stride));
+        simd::Transpose(x, y, z, w);
+
+        const Float4 dx = Sub(x, center_x);
+        const Float4 dy = Sub(y, center_y);
+        const Float4 dz = Sub(z, center_z);
+        Float4 distance2 = Mul(dx, dx);
+        distance2 = MulAdd(dy, dy, distance2);
+        distance2 = MulAdd(dz, dz, distance2);
+        max_distance2 = Max(max_distance2, distance2);
+    }
+
+    Store(lanes, max_distance2);
+    float radius2 = std::max(std::max(lanes[0], lanes[1]), std::max(lanes[2], lanes[3]));
+
+    for (; i < count; ++i)
+    {
+        const float * p = Position(base, i, stride);
+        const Vec3 offset = Vec3(p[0], p[1], p[2]) - center;
+        radius2 = std::max(radius2, Dot(offset, offset));
+    }
+
+    bounds.sphere.center = center;
+    bounds.sphere.radius = std::sqrt(radius2);
+    return bounds;
+}
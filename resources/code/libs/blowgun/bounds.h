@@ -0,0 +1,57 @@
+#ifndef BLOWGUN_BOUNDS_H_
+#define BLOWGUN_BOUNDS_H_
+
+#include "types.h"
+#include "vector.h"
+
+namespace blowgun
+{
+
+/**
+ * Axis-aligned bounding box.
+ */
+struct AABB
+{
+	Vec3 min;
+	Vec3 max;
+
+	AABB() : min(), max() {}
+};
+
+struct BoundingSphere
+{
+	Vec3  center;
+	float radius;
+
+	BoundingSphere() : center(), radius(0.0f) {}
+};
+
+/**
+ * Both bounding volumes of a set of positions. The sphere is centered
+ * on the box, which makes it a little looser than the smallest
+ * possible sphere, but cheap to compute.
+ *
+ * The bounds of an empty set are a box and a sphere of zero size at
+ * the origin.
+ */
+struct Bounds
+{
+	AABB           aabb;
+	BoundingSphere sphere;
+
+	Bounds() : aabb(), sphere() {}
+};
+
+/**
+ * Compute the bounds of `count` positions of 3 floats each.
+ *
+ * @param   stride
+ *          Byte offset between two consecutive positions, the same
+ *          way `glVertexAttribPointer` takes it. Zero means the
+ *          positions are tightly packed.
+ */
+Bounds ComputeBounds(const float * positions, u32 count, u32 stride = 0);
+
+}
+
+#endif // BLOWGUN_BOUNDS_H_
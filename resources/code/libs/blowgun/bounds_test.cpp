@@ -0,0 +1,78 @@
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "bounds.h"
+
+using namespace blowgun;
+
+namespace
+{
+    // 103 isn't a multiple of the SIMD width, so the leftover path is
+    // exercised too.
+    static const u32 kCount = 103;
+
+    Vec3 CreatePosition(u32 i)
+    {
+        return Vec3(
+            std::sin(i * 0.37f) * 5.0f + 1.0f,
+            std::cos(i * 0.11f) * 2.0f - 3.0f,
+            static_cast<float>(i % 17) * 0.25f);
+    }
+}
+
+TEST(BoundsTest, EmptyIsZero)
+{
+    const Bounds bounds = ComputeBounds(nullptr, 0);
+    EXPECT_FLOAT_EQ(0.0f, bounds.aabb.min.x);
+    EXPECT_FLOAT_EQ(0.0f, bounds.aabb.max.z);
+    EXPECT_FLOAT_EQ(0.0f, bounds.sphere.radius);
+}
+
+TEST(BoundsTest, PackedAndStridedMatchReference)
+{
+    std::vector<float> packed;
+    std::vector<float> strided;
+    Vec3 min = CreatePosition(0);
+    Vec3 max = min;
+    for (u32 i = 0; i < kCount; ++i)
+    {
+        const Vec3 p = CreatePosition(i);
+        packed.push_back(p.x);
+        packed.push_back(p.y);
+        packed.push_back(p.z);
+
+        // Same layout as a position followed by a texture coordinate.
+        strided.push_back(p.x);
+        strided.push_back(p.y);
+        strided.push_back(p.z);
+        strided.push_back(-100.0f);
+        strided.push_back(100.0f);
+
+        min = Vec3(std::min(min.x, p.x), std::min(min.y, p.y), std::min(min.z, p.z));
+        max = Vec3(std::max(max.x, p.x), std::max(max.y, p.y), std::max(max.z, p.z));
+    }
+
+    const Vec3 center = (min + max) * 0.5f;
+    float radius = 0.0f;
+    for (u32 i = 0; i < kCount; ++i)
+        radius = std::max(radius, Length(CreatePosition(i) - center));
+
+    const Bounds from_packed = ComputeBounds(&packed[0], kCount);
+    const Bounds from_strided = ComputeBounds(&strided[0], kCount, 5 * sizeof(float));
+
+    const Bounds * results[] = { &from_packed, &from_strided };
+    for (u32 i = 0; i < 2; ++i)
+    {
+        const Bounds & bounds = *results[i];
+        EXPECT_FLOAT_EQ(min.x, bounds.aabb.min.x);
+        EXPECT_FLOAT_EQ(min.y, bounds.aabb.min.y);
+        EXPECT_FLOAT_EQ(min.z, bounds.aabb.min.z);
+        EXPECT_FLOAT_EQ(max.x, bounds.aabb.max.x);
+        EXPECT_FLOAT_EQ(max.y, bounds.aabb.max.y);
+        EXPECT_FLOAT_EQ(max.z, bounds.aabb.max.z);
+        EXPECT_FLOAT_EQ(center.x, bounds.sphere.center.x);
+        EXPECT_NEAR(radius, bounds.sphere.radius, 1e-5f);
+    }
+}
@@ -0,0 +1,26 @@
+#ifndef BLOWGUN_COMPILER_H_
+#define BLOWGUN_COMPILER_H_
+
+/*
+ * Papering over differences between the supported compilers.
+ */
+
+/*
+ * `constexpr` for the compilers that understand it. MSVC only does
+ * starting from Visual Studio 2015; older versions get plain inline
+ * functions, evaluated at runtime.
+ *
+ * `BLOWGUN_HAS_CONSTEXPR` tells which of the two is in effect. Code that
+ * needs other C++11 initialization, such as brace-initialized member
+ * arrays, which those versions lack too, keeps a plain alternative
+ * behind it.
+ */
+#if defined(_MSC_VER) && _MSC_VER < 1900
+#	define BLOWGUN_CONSTEXPR
+#	define BLOWGUN_HAS_CONSTEXPR 0
+#else
+#	define BLOWGUN_CONSTEXPR constexpr
+#	define BLOWGUN_HAS_CONSTEXPR 1
+#endif
+
+#endif // BLOWGUN_COMPILER_H_
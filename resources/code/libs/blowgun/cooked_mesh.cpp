@@ -0,0 +1,457 @@
+#include "cooked_mesh.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+using namespace blowgun;
+
+// Utility
+namespace
+{
+    static const char kMagic[4] = { 'B', 'G', 'M', 'H' };
+
+    // Vertex and index blobs start on this boundary, so they can be
+    // read in place with aligned loads.
+    static const u32 kBlobAlignment = 16;
+
+    static const u32 kBoundsFloatCount = 10;
+
+    struct Header
+    {
+        char  magic[4];
+        u32   version;
+        u32   vertex_count;
+        u32   vertex_stride;
+        u32   element_count;
+        u32   index_format;
+        u32   index_count;
+        u32   group_count;
+        u32   vertex_offset;
+        u32   index_offset;
+        u32   groups_offset;
+        u32   file_size;
+        float bounds[kBoundsFloatCount];
+        float position_offset[3];
+        float position_scale;
+    };
+
+    struct Element
+    {
+        u32 usage;
+        u32 format;
+        u32 offset;
+    };
+
+    struct GroupHeader
+    {
+        u32   first_vertex;
+        u32   vertex_count;
+        float bounds[kBoundsFloatCount];
+        u32   name_length;
+    };
+
+    static u32
+    Align(u32 offset, u32 alignment)
+    {
+        return (offset + alignment - 1) / alignment * alignment;
+    }
+
+    static void
+    PackBounds(const Bounds & bounds, float * out)
+    {
+        out[0] = bounds.aabb.min.x;
+        out[1] = bounds.aabb.min.y;
+        out[2] = bounds.aabb.min.z;
+        out[3] = bounds.aabb.max.x;
+        out[4] = bounds.aabb.max.y;
+        out[5] = bounds.aabb.max.z;
+        out[6] = bounds.sphere.center.x;
+        out[7] = bounds.sphere.center.y;
+        out[8] = bounds.sphere.center.z;
+        out[9] = bounds.sphere.radius;
+    }
+
+    static Bounds
+    UnpackBounds(const float * in)
+    {
+        Bounds bounds;
+        bounds.aabb.min = Vec3(in[0], in[1], in[2]);
+        bounds.aabb.max = Vec3(in[3], in[4], in[5]);
+        bounds.sphere.center = Vec3(in[6], in[7], in[8]);
+        bounds.sphere.radius = in[9];
+        return bounds;
+    }
+
+    static u32
+    IndexSize(IndexFormat::Enum format)
+    {
+        return (format == IndexFormat::kUnsignedInt) ? sizeof(u32) : sizeof(u16);
+    }
+
+    static void
+    ThrowInvalid(const char * what)
+    {
+        throw new std::runtime_error(std::string("Invalid cooked mesh: ") + what);
+    }
+
+    // Check that `[offset, offset + size)` is inside a file of
+    // `file_size` bytes, without overflowing.
+    static bool
+    IsInside(u32 offset, u64 size, u32 file_size)
+    {
+        return offset <= file_size && size <= static_cast<u64>(file_size - offset);
+    }
+
+    // Check that every one of `count` indices refers to one of
+    // `vertex_count` vertices.
+    template <typename Index>
+    static bool
+    AreIndicesInRange(const void * data, u32 count, u32 vertex_count)
+    {
+        const Index * indices = static_cast<const Index *>(data);
+        Index largest = 0;
+        for (u32 i = 0; i < count; ++i)
+            largest = std::max(largest, indices[i]);
+        return count == 0 || largest < vertex_count;
+    }
+}
+
+void
+blowgun::CookMesh(const Model & model, std::ostream & stream)
+{
+    const VertexLayout & layout = model.vertex_layout();
+    const std::vector<VertexElement> & elements = layout.elements();
+    const std::vector<ModelGroup> & groups = model.groups();
+
+    ///
+    // Place every blob, so the header can be written first.
+    ///
+
+    Header header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version       = kCookedMeshVersion;
+    header.vertex_count  = model.vertex_count();
+    header.vertex_stride = layout.stride();
+    header.element_count = static_cast<u32>(elements.size());
+    header.index_format  = model.index_format();
+    header.index_count   = model.index_count();
+    header.group_count   = static_cast<u32>(groups.size());
+    PackBounds(model.bounds(), header.bounds);
+    header.position_offset[0] = model.position_offset().x;
+    header.position_offset[1] = model.position_offset().y;
+    header.position_offset[2] = model.position_offset().z;
+    header.position_scale     = model.position_scale();
+
+    const u32 vertex_size = model.vertex_data_size();
+    const u32 index_size = model.index_count() * IndexSize(model.index_format());
+
+    header.vertex_offset = Align(
+        sizeof(Header) + header.element_count * sizeof(Element), kBlobAlignment);
+    header.index_offset = Align(header.vertex_offset + vertex_size, kBlobAlignment);
+    header.groups_offset = Align(header.index_offset + index_size, sizeof(u32));
+
+    u32 file_size = header.groups_offset;
+    for (size_t i = 0; i < groups.size(); ++i)
+    {
+        file_size += sizeof(GroupHeader) +
+            Align(static_cast<u32>(groups[i].name.size()), sizeof(u32));
+    }
+    header.file_size = file_size;
+
+    ///
+    // Write everything, padding up to each offset with zeros.
+    ///
+
+    static const char kPadding[kBlobAlignment] = { 0 };
+    u32 written = 0;
+
+    auto write = [&](const void * data, u32 size)
+    {
+        stream.write(static_cast<const char *>(data), size);
+        written += size;
+    };
+    auto pad_to = [&](u32 offset)
+    {
+        write(kPadding, offset - written);
+    };
+
+    write(&header, sizeof(header));
+
+    for (size_t i = 0; i < elements.size(); ++i)
+    {
+        Element element;
+        element.usage  = elements[i].usage;
+        element.format = elements[i].format;
+        element.offset = elements[i].offset;
+        write(&element, sizeof(element));
+    }
+
+    pad_to(header.vertex_offset);
+    if (vertex_size > 0)
+        write(model.vertex_data(), vertex_size);
+
+    pad_to(header.index_offset);
+    if (index_size > 0)
+        write(model.index_data(), index_size);
+
+    pad_to(header.groups_offset);
+    for (size_t i = 0; i < groups.size(); ++i)
+    {
+        GroupHeader group;
+        group.first_vertex = groups[i].first_vertex;
+        group.vertex_count = groups[i].vertex_count;
+        PackBounds(groups[i].bounds, group.bounds);
+        group.name_length  = static_cast<u32>(groups[i].name.size());
+        write(&group, sizeof(group));
+
+        write(groups[i].name.data(), group.name_length);
+        pad_to(Align(written, sizeof(u32)));
+    }
+
+    if (!stream)
+        throw new std::runtime_error("Can't write cooked mesh.");
+}
+
+bool
+blowgun::IsCookedMesh(const char * data, std::size_t size)
+{
+    return size >= sizeof(kMagic) && std::memcmp(data, kMagic, sizeof(kMagic)) == 0;
+}
+
+CookedMesh::CookedMesh(const std::string & path) :
+    file_(new MappedFile(path)),
+    vertex_layout_(),
+    vertex_data_(nullptr),
+    vertex_count_(0),
+    index_format_(IndexFormat::kUnsignedShort),
+    index_data_(nullptr),
+    index_count_(0),
+    bounds_(),
+    groups_(),
+    position_offset_(),
+    position_scale_(1.0f)
+{
+    Parse(file_->data(), file_->size());
+}
+
+CookedMesh::CookedMesh(const char * data, std::size_t size) :
+    file_(),
+    vertex_layout_(),
+    vertex_data_(nullptr),
+    vertex_count_(0),
+    index_format_(IndexFormat::kUnsignedShort),
+    index_data_(nullptr),
+    index_count_(0),
+    bounds_(),
+    groups_(),
+    position_offset_(),
+    position_scale_(1.0f)
+{
+    Parse(data, size);
+}
+
+void
+CookedMesh::Parse(const char * data, std::size_t size)
+{
+    Header header;
+    if (size < sizeof(header) || !IsCookedMesh(data, size))
+        ThrowInvalid("bad magic.");
+
+    std::memcpy(&header, data, sizeof(header));
+    if (header.version != kCookedMeshVersion)
+        ThrowInvalid("unsupported version.");
+    if (header.file_size != size)
+        ThrowInvalid("truncated file.");
+
+    const u32 file_size = header.file_size;
+
+    ///
+    // Layout.
+    ///
+
+    if (!IsInside(sizeof(Header), static_cast<u64>(header.element_count) * sizeof(Element),
+        file_size))
+    {
+        ThrowInvalid("truncated layout.");
+    }
+
+    for (u32 i = 0; i < header.element_count; ++i)
+    {
+        Element element;
+        std::memcpy(&element, data + sizeof(Header) + i * sizeof(Element), sizeof(element));
+        if (element.usage > VertexAttributeUsage::kColor ||
+            element.format > VertexAttributeFormat::kHalf4)
+        {
+            ThrowInvalid("unknown vertex attribute.");
+        }
+        vertex_layout_.Add(
+            static_cast<VertexAttributeUsage::Enum>(element.usage),
+            static_cast<VertexAttributeFormat::Enum>(element.format));
+
+        if (vertex_layout_.elements().back().offset != element.offset)
+            ThrowInvalid("vertex attributes aren't packed.");
+    }
+    if (vertex_layout_.stride() != header.vertex_stride)
+        ThrowInvalid("bad vertex stride.");
+
+    ///
+    // Vertices and indices, used in place.
+    ///
+
+    if (header.index_format > IndexFormat::kUnsignedInt)
+        ThrowInvalid("unknown index format.");
+    index_format_ = static_cast<IndexFormat::Enum>(header.index_format);
+
+    const u64 vertex_size = static_cast<u64>(header.vertex_count) * header.vertex_stride;
+    const u64 index_size = static_cast<u64>(header.index_count) * IndexSize(index_format_);
+    if (header.vertex_offset % kBlobAlignment != 0 ||
+        header.index_offset % kBlobAlignment != 0 ||
+        !IsInside(header.vertex_offset, vertex_size, file_size) ||
+        !IsInside(header.index_offset, index_size, file_size))
+    {
+        ThrowInvalid("bad vertex or index data.");
+    }
+
+    vertex_count_ = header.vertex_count;
+    vertex_data_ = vertex_count_ > 0
+        ? reinterpret_cast<const u8 *>(data + header.vertex_offset)
+        : nullptr;
+    index_count_ = header.index_count;
+    index_data_ = index_count_ > 0
+        ? static_cast<const void *>(data + header.index_offset)
+        : nullptr;
+
+    // Indices go to `glDrawElements` as they are, which doesn't check
+    // them.
+    const bool indices_in_range = (index_format_ == IndexFormat::kUnsignedInt)
+        ? AreIndicesInRange<u32>(index_data_, index_count_, vertex_count_)
+        : AreIndicesInRange<u16>(index_data_, index_count_, vertex_count_);
+    if (!indices_in_range)
+        ThrowInvalid("index out of range.");
+
+    bounds_ = UnpackBounds(header.bounds);
+    position_offset_ = Vec3(
+        header.position_offset[0], header.position_offset[1], header.position_offset[2]);
+    position_scale_ = header.position_scale;
+
+    ///
+    // Groups.
+    ///
+
+    // Ranges of indices when there are any, of vertices otherwise.
+    const u32 group_limit = (index_count_ > 0) ? index_count_ : vertex_count_;
+
+    u32 offset = header.groups_offset;
+    for (u32 i = 0; i < header.group_count; ++i)
+    {
+        GroupHeader group_header;
+        if (!IsInside(offset, sizeof(group_header), file_size))
+            ThrowInvalid("truncated groups.");
+        std::memcpy(&group_header, data + offset, sizeof(group_header));
+        offset += sizeof(group_header);
+
+        if (!IsInside(offset, group_header.name_length, file_size))
+            ThrowInvalid("truncated groups.");
+        if (!IsInside(group_header.first_vertex, group_header.vertex_count, group_limit))
+            ThrowInvalid("group out of range.");
+
+        ModelGroup group;
+        group.name.assign(data + offset, group_header.name_length);
+        group.first_vertex = group_header.first_vertex;
+        group.vertex_count = group_header.vertex_count;
+        group.bounds = UnpackBounds(group_header.bounds);
+        groups_.push_back(group);
+
+        offset = Align(offset + group_header.name_length, sizeof(u32));
+    }
+}
+
+const VertexLayout &
+CookedMesh::vertex_layout() const
+{
+    return vertex_layout_;
+}
+
+const u8 *
+CookedMesh::vertex_data() const
+{
+    return vertex_data_;
+}
+
+u32
+CookedMesh::vertex_data_size() const
+{
+    return vertex_count_ * vertex_layout_.stride();
+}
+
+u32
+CookedMesh::vertex_count() const
+{
+    return vertex_count_;
+}
+
+u32
+CookedMesh::index_count() const
+{
+    return index_count_;
+}
+
+IndexFormat::Enum
+CookedMesh::index_format() const
+{
+    return index_format_;
+}
+
+const void *
+CookedMesh::index_data() const
+{
+    return index_data_;
+}
+
+const Bounds &
+CookedMesh::bounds() const
+{
+    return bounds_;
+}
+
+const std::vector<ModelGroup> &
+CookedMesh::groups() const
+{
+    return groups_;
+}
+
+const Vec3 &
+CookedMesh::position_offset() const
+{
+    return position_offset_;
+}
+
+float
+CookedMesh::position_scale() const
+{
+    return position_scale_;
+}
+
+std::shared_ptr<Model>
+CookedMesh::CreateModel() const
+{
+    std::vector<u8> vertex_data(vertex_data_, vertex_data_ + vertex_data_size());
+
+    std::shared_ptr<Model> model;
+    if (index_count_ == 0)
+    {
+        model = std::make_shared<Model>(vertex_layout_, std::move(vertex_data), bounds_, groups_);
+    }
+    else
+    {
+        const std::vector<u32> indices = WidenIndices(index_format_, index_data_, index_count_);
+        model = std::make_shared<Model>(
+            vertex_layout_, std::move(vertex_data), indices, bounds_, groups_);
+    }
+
+    model->SetPositionDequantization(position_offset_, position_scale_);
+    return model;
+}
@@ -0,0 +1,132 @@
+#ifndef BLOWGUN_COOKED_MESH_H_
+#define BLOWGUN_COOKED_MESH_H_
+
+#include <cstddef>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "bounds.h"
+#include "mapped_file.h"
+#include "model.h"
+#include "types.h"
+#include "vertex_layout.h"
+
+namespace blowgun
+{
+
+/**
+ * Version of the cooked mesh format written by `CookMesh`. Files of
+ * any other version are rejected, and have to be cooked again.
+ */
+static const u32 kCookedMeshVersion = 2;
+
+/**
+ * Write `model` as a cooked mesh: a binary file that can be used as is,
+ * without any parsing.
+ *
+ * Every value is stored in the byte order of the machine that cooked
+ * the file, as 32-bit integers or floats, so it can be read in place:
+ * a file cooked on a machine of the other endianness is rejected, its
+ * version reading wrong. All the supported targets are little-endian.
+ *
+ * - A header: the magic "BGMH", the version, the vertex count and
+ *   stride, the number of layout elements, the index format and count,
+ *   the number of groups, the byte offsets of the vertex, index and
+ *   group blobs, the size of the file, the bounds of the mesh, and the
+ *   offset and scale of its positions.
+ * - The layout, as (usage, format, offset) for each element.
+ * - The vertices, starting on a 16-byte boundary.
+ * - The indices, starting on a 16-byte boundary.
+ * - The groups, as (first vertex, vertex count, bounds, name length)
+ *   each followed by the name, padded to 4 bytes.
+ *
+ * Throws when the stream can't be written.
+ */
+void CookMesh(const Model & model, std::ostream & stream);
+
+/**
+ * Check whether `data` starts like a cooked mesh.
+ */
+bool IsCookedMesh(const char * data, std::size_t size);
+
+/**
+ * Read-only view of a cooked mesh. The header is checked once, along
+ * with every index and group range, and the vertices and indices are
+ * then used in place: they can be handed to `glBufferData` or
+ * `glVertexAttribPointer` without any copy.
+ */
+class CookedMesh
+{
+private:
+	std::unique_ptr<MappedFile> file_;
+
+	VertexLayout            vertex_layout_;
+	const u8 *              vertex_data_;
+	u32                     vertex_count_;
+
+	IndexFormat::Enum       index_format_;
+	const void *            index_data_;
+	u32                     index_count_;
+
+	Bounds                  bounds_;
+	std::vector<ModelGroup> groups_;
+
+	Vec3                    position_offset_;
+	float                   position_scale_;
+
+	void Parse(const char * data, std::size_t size);
+
+	// Disallow copy and assign.
+	CookedMesh(const CookedMesh & rhs);
+	CookedMesh & operator=(const CookedMesh & rhs);
+
+public:
+	/**
+	 * Map the cooked mesh at `path`. Throws when the file can't be
+	 * mapped or isn't a valid cooked mesh.
+	 */
+	explicit CookedMesh(const std::string & path);
+
+	/**
+	 * View the cooked mesh in `[data, data + size)`, which must stay
+	 * valid for the lifetime of the view. The vertices and indices are
+	 * on a 16-byte boundary when `data` is, as a mapped file is.
+	 * Throws when it isn't a valid cooked mesh.
+	 */
+	CookedMesh(const char * data, std::size_t size);
+
+	const VertexLayout & vertex_layout() const;
+	const u8 * vertex_data() const;
+	u32 vertex_data_size() const;
+	u32 vertex_count() const;
+
+	/**
+	 * Get the index buffer. A mesh without indices has an index count
+	 * of zero and null index data.
+	 */
+	u32 index_count() const;
+	IndexFormat::Enum index_format() const;
+	const void * index_data() const;
+
+	const Bounds & bounds() const;
+	const std::vector<ModelGroup> & groups() const;
+
+	/**
+	 * Get how stored positions map back to model units, as
+	 * `Model::position_offset` and `Model::position_scale` do.
+	 */
+	const Vec3 & position_offset() const;
+	float position_scale() const;
+
+	/**
+	 * Copy the mesh into a `Model`, which doesn't depend on the view
+	 * afterward.
+	 */
+	std::shared_ptr<Model> CreateModel() const;
+};
+
+}
+
+#endif // BLOWGUN_COOKED_MESH_H_
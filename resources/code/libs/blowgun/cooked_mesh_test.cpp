@@ -0,0 +1,188 @@
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include <gtest/gtest.h>
+#include "cooked_mesh.h"
+#include "model_loader_obj.h"
+#include "vertex_quantization.h"
+
+using namespace blowgun;
+
+namespace
+{
+    std::string Cook(const Model & model)
+    {
+        std::ostringstream stream(std::ios::out | std::ios::binary);
+        CookMesh(model, stream);
+        return stream.str();
+    }
+
+    void ExpectSameBounds(const Bounds & expected, const Bounds & actual)
+    {
+        EXPECT_EQ(0, std::memcmp(&expected.aabb, &actual.aabb, sizeof(AABB)));
+        EXPECT_EQ(0, std::memcmp(&expected.sphere, &actual.sphere, sizeof(BoundingSphere)));
+    }
+
+    // Compare what a cooked mesh holds with the model it was cooked
+    // from.
+    template <typename Mesh>
+    void ExpectSameMesh(const Model & expected, const Mesh & actual)
+    {
+        ASSERT_TRUE(expected.vertex_layout() == actual.vertex_layout());
+        ASSERT_EQ(expected.vertex_count(), actual.vertex_count());
+        ASSERT_EQ(expected.vertex_data_size(), actual.vertex_data_size());
+        EXPECT_EQ(0, std::memcmp(expected.vertex_data(), actual.vertex_data(),
+            expected.vertex_data_size()));
+
+        ASSERT_EQ(expected.index_count(), actual.index_count());
+        EXPECT_EQ(expected.index_format(), actual.index_format());
+        const u32 index_size =
+            (expected.index_format() == IndexFormat::kUnsignedInt) ? 4 : 2;
+        if (expected.index_count() > 0)
+        {
+            EXPECT_EQ(0, std::memcmp(expected.index_data(), actual.index_data(),
+                expected.index_count() * index_size));
+        }
+
+        ExpectSameBounds(expected.bounds(), actual.bounds());
+        ASSERT_EQ(expected.groups().size(), actual.groups().size());
+        for (size_t i = 0; i < expected.groups().size(); ++i)
+        {
+            EXPECT_EQ(expected.groups()[i].name, actual.groups()[i].name);
+            EXPECT_EQ(expected.groups()[i].first_vertex, actual.groups()[i].first_vertex);
+            EXPECT_EQ(expected.groups()[i].vertex_count, actual.groups()[i].vertex_count);
+            ExpectSameBounds(expected.groups()[i].bounds, actual.groups()[i].bounds);
+        }
+
+        EXPECT_EQ(0, std::memcmp(&expected.position_offset(), &actual.position_offset(),
+            sizeof(Vec3)));
+        EXPECT_EQ(expected.position_scale(), actual.position_scale());
+    }
+}
+
+TEST(CookedMeshTest, RoundTripInMemory)
+{
+    ModelLoaderOBJ loader;
+    auto expanded = loader.Load(std::string("data/cube.obj"));
+    auto indexed = loader.SetIndexed(true).Load(std::string("data/cube.obj"));
+
+    const std::string expanded_data = Cook(*expanded);
+    CookedMesh expanded_mesh(expanded_data.data(), expanded_data.size());
+    ExpectSameMesh(*expanded, expanded_mesh);
+    EXPECT_EQ(nullptr, expanded_mesh.index_data());
+
+    const std::string indexed_data = Cook(*indexed);
+    CookedMesh indexed_mesh(indexed_data.data(), indexed_data.size());
+    ExpectSameMesh(*indexed, indexed_mesh);
+    ExpectSameMesh(*indexed, *indexed_mesh.CreateModel());
+}
+
+TEST(CookedMeshTest, RoundTripQuantized)
+{
+    ModelLoaderOBJ loader;
+    auto model = QuantizeModel(*loader.SetIndexed(true).Load(std::string("data/banana.obj")));
+
+    const std::string data = Cook(*model);
+    CookedMesh mesh(data.data(), data.size());
+    ExpectSameMesh(*model, mesh);
+    ExpectSameMesh(*model, *mesh.CreateModel());
+    EXPECT_NE(1.0f, mesh.position_scale());
+}
+
+TEST(CookedMeshTest, MapFromFile)
+{
+    ModelLoaderOBJ loader;
+    auto model = loader.SetIndexed(true).Load(std::string("data/banana.obj"));
+
+    const std::string path = "cooked_mesh_test.mesh";
+    {
+        std::ofstream file(path.c_str(), std::ios::out | std::ios::binary);
+        CookMesh(*model, file);
+    }
+
+    {
+        CookedMesh mesh(path);
+        ExpectSameMesh(*model, mesh);
+        EXPECT_EQ(0u, reinterpret_cast<size_t>(mesh.vertex_data()) % 16);
+        EXPECT_EQ(0u, reinterpret_cast<size_t>(mesh.index_data()) % 16);
+    }
+
+    std::remove(path.c_str());
+}
+
+TEST(CookedMeshTest, InvalidData)
+{
+    ModelLoaderOBJ loader;
+    const std::string data = Cook(*loader.Load(std::string("data/cube.obj")));
+    ASSERT_TRUE(IsCookedMesh(data.data(), data.size()));
+
+    // Not a cooked mesh at all.
+    const std::string obj = "v 0 0 0\n";
+    EXPECT_FALSE(IsCookedMesh(obj.data(), obj.size()));
+    EXPECT_THROW(CookedMesh(obj.data(), obj.size()), std::runtime_error *);
+
+    // Truncated.
+    EXPECT_THROW(CookedMesh(data.data(), data.size() - 1), std::runtime_error *);
+    EXPECT_THROW(CookedMesh(data.data(), 40), std::runtime_error *);
+
+    // Another version.
+    std::string other_version = data;
+    other_version[4] = static_cast<char>(kCookedMeshVersion + 1);
+    EXPECT_THROW(CookedMesh(other_version.data(), other_version.size()),
+        std::runtime_error *);
+
+    // Vertices past the end of the file.
+    std::string bad_count = data;
+    const u32 vertex_count = 0x10000000;
+    std::memcpy(&bad_count[8], &vertex_count, sizeof(vertex_count));
+    EXPECT_THROW(CookedMesh(bad_count.data(), bad_count.size()), std::runtime_error *);
+
+    EXPECT_THROW(CookedMesh(std::string("data/missing.mesh")), std::runtime_error *);
+}
+
+TEST(CookedMeshTest, CorruptRanges)
+{
+    // Offsets of some values of the header.
+    const u32 kVertexCountOffset = 8;
+    const u32 kIndexOffsetOffset = 36;
+    const u32 kGroupsOffsetOffset = 40;
+
+    ModelLoaderOBJ loader;
+    loader.SetIndexed(true);
+    std::shared_ptr<Model> model = loader.Load(std::string("data/cube.obj"));
+    ASSERT_GT(model->index_count(), 0u);
+    ASSERT_FALSE(model->groups().empty());
+    const std::string data = Cook(*model);
+    CookedMesh valid(data.data(), data.size());
+
+    u32 index_offset;
+    u32 groups_offset;
+    std::memcpy(&index_offset, &data[kIndexOffsetOffset], sizeof(index_offset));
+    std::memcpy(&groups_offset, &data[kGroupsOffsetOffset], sizeof(groups_offset));
+
+    // An index past the last vertex.
+    std::string bad_index = data;
+    const u16 index = static_cast<u16>(model->vertex_count());
+    std::memcpy(&bad_index[index_offset + 2 * 5], &index, sizeof(index));
+    EXPECT_THROW(CookedMesh(bad_index.data(), bad_index.size()), std::runtime_error *);
+
+    // Fewer vertices than the indices refer to.
+    std::string few_vertices = data;
+    const u32 vertex_count = model->vertex_count() - 1;
+    std::memcpy(&few_vertices[kVertexCountOffset], &vertex_count, sizeof(vertex_count));
+    EXPECT_THROW(CookedMesh(few_vertices.data(), few_vertices.size()), std::runtime_error *);
+
+    // A group reaching past the last index, and one starting past it.
+    std::string bad_group = data;
+    const u32 group_count = model->index_count() - model->groups()[0].first_vertex + 1;
+    std::memcpy(&bad_group[groups_offset + 4], &group_count, sizeof(group_count));
+    EXPECT_THROW(CookedMesh(bad_group.data(), bad_group.size()), std::runtime_error *);
+
+    bad_group = data;
+    const u32 first = 0xFFFFFFF0u;
+    std::memcpy(&bad_group[groups_offset], &first, sizeof(first));
+    EXPECT_THROW(CookedMesh(bad_group.data(), bad_group.size()), std::runtime_error *);
+}
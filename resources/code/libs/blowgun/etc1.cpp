@@ -0,0 +1,450 @@
+#include "etc1.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <stdexcept>
+
+#include "parallel.h"
+
+using namespace blowgun;
+
+// Utility
+namespace
+{
+    // Intensity modifiers, by table codeword. Each pixel adds one of
+    // them to every channel of the base color of its sub-block; the
+    // selector stored for the pixel is the index in this order.
+    static const int kModifiers[8][4] = {
+        {  2,   8,  -2,   -8 },
+        {  5,  17,  -5,  -17 },
+        {  9,  29,  -9,  -29 },
+        { 13,  42, -13,  -42 },
+        { 18,  60, -18,  -60 },
+        { 24,  80, -24,  -80 },
+        { 33, 106, -33, -106 },
+        { 47, 183, -47, -183 },
+    };
+
+    static const u32 kTableCount = 8;
+
+    // Pixels of each sub-block, as indices in a 4x4 block stored row by
+    // row. Without the flip bit, a block is split in two 2x4 halves side
+    // by side; with it, in two 4x2 halves one above the other.
+    static const u8 kSubBlockPixels[2][2][8] = {
+        { { 0, 1, 4, 5, 8, 9, 12, 13 }, { 2, 3, 6, 7, 10, 11, 14, 15 } },
+        { { 0, 1, 2, 3, 4, 5, 6, 7 }, { 8, 9, 10, 11, 12, 13, 14, 15 } },
+    };
+
+    // Base colors tried for a sub-block, as steps from its average: the
+    // average only with kFast, and its neighbors with kHigh.
+    static const int kCandidateOffsets[][3] = {
+        {  0,  0,  0 },
+        { -1, -1, -1 }, {  1,  1,  1 },
+        { -1,  0,  0 }, {  1,  0,  0 },
+        {  0, -1,  0 }, {  0,  1,  0 },
+        {  0,  0, -1 }, {  0,  0,  1 },
+    };
+
+    static const u32 kMaxCandidateCount =
+        sizeof(kCandidateOffsets) / sizeof(kCandidateOffsets[0]);
+
+    // Blocks are shared by threads in rows of at least this many.
+    static const u32 kMinBlocksPerRange = 256;
+
+    // Table and selectors fitting the pixels of a sub-block around a
+    // base color, and the squared error they leave.
+    struct SubBlockFit
+    {
+        u32 table;
+        u8  selectors[8];
+        u32 error;
+    };
+
+    // Everything stored in a block, and the squared error it leaves.
+    struct Encoding
+    {
+        bool differential;
+        bool flip;
+        int  codes[2][3];
+        u32  tables[2];
+        u8   selectors[2][8];
+        u32  error;
+    };
+
+    static int
+    Clamp(int value)
+    {
+        return std::min(255, std::max(0, value));
+    }
+
+    static int
+    Expand4(int code)
+    {
+        return (code << 4) | code;
+    }
+
+    static int
+    Expand5(int code)
+    {
+        return (code << 3) | (code >> 2);
+    }
+
+    // Round the average of 8 pixels, given their `sum`, to a code in
+    // [0, max_code].
+    static int
+    Quantize(int sum, int max_code)
+    {
+        return (sum * max_code + 4 * 255) / (8 * 255);
+    }
+
+    static u32
+    Distance(const int * pixel, const int * color, int modifier)
+    {
+        u32 distance = 0;
+        for (u32 c = 0; c < 3; ++c)
+        {
+            const int difference = Clamp(color[c] + modifier) - pixel[c];
+            distance += difference * difference;
+        }
+        return distance;
+    }
+
+    // Fit the 8 `pixels` of a sub-block around `color` with every table,
+    // keeping the best fit in `best`. A table is given up as soon as it
+    // can't do better.
+    static void
+    FitModifiers(const int * pixels, const int * color, bool high, SubBlockFit * best)
+    {
+        const int color_sum = color[0] + color[1] + color[2];
+        const int color_min = std::min(color[0], std::min(color[1], color[2]));
+        const int color_max = std::max(color[0], std::max(color[1], color[2]));
+        for (u32 table = 0; table < kTableCount; ++table)
+        {
+            const int * modifiers = kModifiers[table];
+
+            // Unless a channel saturates, the best modifier of a pixel is
+            // the closest to the mean difference of its channels with the
+            // base color. Otherwise, each one has to be tried.
+            const bool exact = high &&
+                (color_min - modifiers[1] < 0 || color_max + modifiers[1] > 255);
+
+            SubBlockFit fit;
+            fit.table = table;
+            fit.error = 0;
+            for (u32 i = 0; i < 8 && fit.error < best->error; ++i)
+            {
+                const int * pixel = pixels + 3 * i;
+                u32 selector = 0;
+                u32 error = 0;
+                if (exact)
+                {
+                    error = Distance(pixel, color, modifiers[0]);
+                    for (u32 s = 1; s < 4; ++s)
+                    {
+                        const u32 distance = Distance(pixel, color, modifiers[s]);
+                        if (distance < error)
+                        {
+                            error = distance;
+                            selector = s;
+                        }
+                    }
+                }
+                else
+                {
+                    const int difference = pixel[0] + pixel[1] + pixel[2] - color_sum;
+                    const int magnitude = std::abs(difference);
+                    selector = ((difference < 0) ? 2 : 0) +
+                        ((2 * magnitude > 3 * (modifiers[0] + modifiers[1])) ? 1 : 0);
+                    error = Distance(pixel, color, modifiers[selector]);
+                }
+                fit.selectors[i] = static_cast<u8>(selector);
+                fit.error += error;
+            }
+
+            if (fit.error < best->error)
+                *best = fit;
+        }
+    }
+
+    static void
+    PackBlock(const Encoding & encoding, byte * block)
+    {
+        u32 high = 0;
+        for (u32 c = 0; c < 3; ++c)
+        {
+            const u32 shift = 24 - 8 * c;
+            if (encoding.differential)
+            {
+                const int delta = encoding.codes[1][c] - encoding.codes[0][c];
+                high |= (encoding.codes[0][c] << (shift + 3)) | ((delta & 7) << shift);
+            }
+            else
+            {
+                high |= (encoding.codes[0][c] << (shift + 4)) | (encoding.codes[1][c] << shift);
+            }
+        }
+        high |= (encoding.tables[0] << 5) | (encoding.tables[1] << 2) |
+            ((encoding.differential ? 1 : 0) << 1) | (encoding.flip ? 1 : 0);
+
+        // Selectors are stored column by column, their high bits first.
+        u32 low = 0;
+        for (u32 s = 0; s < 2; ++s)
+        {
+            for (u32 i = 0; i < 8; ++i)
+            {
+                const u32 pixel = kSubBlockPixels[encoding.flip ? 1 : 0][s][i];
+                const u32 bit = (pixel % 4) * 4 + pixel / 4;
+                const u32 selector = encoding.selectors[s][i];
+                low |= ((selector & 1) << bit) | ((selector >> 1) << (bit + 16));
+            }
+        }
+
+        for (u32 i = 0; i < 4; ++i)
+        {
+            block[i] = static_cast<byte>(high >> (24 - 8 * i));
+            block[4 + i] = static_cast<byte>(low >> (24 - 8 * i));
+        }
+    }
+}
+
+u32
+blowgun::ETC1DataSize(u32 width, u32 height)
+{
+    return ((width + 3) / 4) * ((height + 3) / 4) * kETC1BlockSize;
+}
+
+void
+blowgun::EncodeETC1Block(const byte * pixels, ETC1Quality::Enum quality, byte * block)
+{
+    const bool high = quality == ETC1Quality::kHigh;
+
+    Encoding best;
+    best.error = ~0u;
+    for (u32 flip = 0; flip < 2; ++flip)
+    {
+        int sub_block_pixels[2][24];
+        int sums[2][3] = { { 0, 0, 0 }, { 0, 0, 0 } };
+        for (u32 s = 0; s < 2; ++s)
+        {
+            for (u32 i = 0; i < 8; ++i)
+            {
+                const byte * pixel = pixels + 3 * kSubBlockPixels[flip][s][i];
+                for (u32 c = 0; c < 3; ++c)
+                {
+                    sub_block_pixels[s][3 * i + c] = pixel[c];
+                    sums[s][c] += pixel[c];
+                }
+            }
+        }
+
+        for (u32 differential = 0; differential < 2; ++differential)
+        {
+            const int max_code = differential ? 31 : 15;
+            const u32 candidate_count = high ? kMaxCandidateCount : 1;
+
+            // Fit every candidate base color of each sub-block on its own.
+            int codes[2][kMaxCandidateCount][3];
+            SubBlockFit fits[2][kMaxCandidateCount];
+            u32 candidate_counts[2] = { 0, 0 };
+            for (u32 s = 0; s < 2; ++s)
+            {
+                const int rounded[3] = {
+                    Quantize(sums[s][0], max_code),
+                    Quantize(sums[s][1], max_code),
+                    Quantize(sums[s][2], max_code) };
+
+                for (u32 k = 0; k < candidate_count; ++k)
+                {
+                    const int r = rounded[0] + kCandidateOffsets[k][0];
+                    const int g = rounded[1] + kCandidateOffsets[k][1];
+                    const int b = rounded[2] + kCandidateOffsets[k][2];
+                    if (std::min(r, std::min(g, b)) < 0 || std::max(r, std::max(g, b)) > max_code)
+                        continue;
+
+                    const u32 n = candidate_counts[s]++;
+                    codes[s][n][0] = r;
+                    codes[s][n][1] = g;
+                    codes[s][n][2] = b;
+
+                    int color[3];
+                    for (u32 c = 0; c < 3; ++c)
+                        color[c] = differential ? Expand5(codes[s][n][c]) : Expand4(codes[s][n][c]);
+
+                    fits[s][n].error = ~0u;
+                    FitModifiers(sub_block_pixels[s], color, high, &fits[s][n]);
+                }
+            }
+
+            // Pair them up. Differential codes of the second sub-block
+            // must be within [-4, 3] of the first.
+            u32 best_pair[2] = { 0, 0 };
+            u32 best_error = ~0u;
+            for (u32 i = 0; i < candidate_counts[0]; ++i)
+            {
+                for (u32 j = 0; j < candidate_counts[1]; ++j)
+                {
+                    if (differential)
+                    {
+                        bool valid = true;
+                        for (u32 c = 0; c < 3; ++c)
+                        {
+                            const int delta = codes[1][j][c] - codes[0][i][c];
+                            valid = valid && delta >= -4 && delta <= 3;
+                        }
+                        if (!valid)
+                            continue;
+                    }
+
+                    const u32 error = fits[0][i].error + fits[1][j].error;
+                    if (error < best_error)
+                    {
+                        best_error = error;
+                        best_pair[0] = i;
+                        best_pair[1] = j;
+                    }
+                }
+            }
+
+            if (best_error >= best.error)
+                continue;
+
+            best.differential = differential != 0;
+            best.flip = flip != 0;
+            best.error = best_error;
+            for (u32 s = 0; s < 2; ++s)
+            {
+                const u32 n = best_pair[s];
+                for (u32 c = 0; c < 3; ++c)
+                    best.codes[s][c] = codes[s][n][c];
+                best.tables[s] = fits[s][n].table;
+                std::copy(fits[s][n].selectors, fits[s][n].selectors + 8, best.selectors[s]);
+            }
+        }
+    }
+
+    PackBlock(best, block);
+}
+
+void
+blowgun::DecodeETC1Block(const byte * block, byte * pixels)
+{
+    u32 high = 0;
+    u32 low = 0;
+    for (u32 i = 0; i < 4; ++i)
+    {
+        high = (high << 8) | block[i];
+        low = (low << 8) | block[4 + i];
+    }
+
+    const bool flip = (high & 1) != 0;
+    const bool differential = (high & 2) != 0;
+
+    int colors[2][3];
+    for (u32 c = 0; c < 3; ++c)
+    {
+        const u32 shift = 24 - 8 * c;
+        if (differential)
+        {
+            const int base = (high >> (shift + 3)) & 31;
+            const int delta = static_cast<int>(((high >> shift) & 7) ^ 4) - 4;
+            colors[0][c] = Expand5(base);
+            colors[1][c] = Expand5((base + delta) & 31);
+        }
+        else
+        {
+            colors[0][c] = Expand4((high >> (shift + 4)) & 15);
+            colors[1][c] = Expand4((high >> shift) & 15);
+        }
+    }
+    const u32 tables[2] = { (high >> 5) & 7, (high >> 2) & 7 };
+
+    for (u32 pixel = 0; pixel < 16; ++pixel)
+    {
+        const u32 x = pixel % 4;
+        const u32 y = pixel / 4;
+        const u32 bit = x * 4 + y;
+        const u32 s = flip ? y / 2 : x / 2;
+        const u32 selector = (((low >> (bit + 16)) & 1) << 1) | ((low >> bit) & 1);
+        const int modifier = kModifiers[tables[s]][selector];
+        for (u32 c = 0; c < 3; ++c)
+            pixels[3 * pixel + c] = static_cast<byte>(Clamp(colors[s][c] + modifier));
+    }
+}
+
+std::vector<byte>
+blowgun::EncodeETC1(
+    const byte * pixels,
+    u32 width,
+    u32 height,
+    u32 channel_count,
+    ETC1Quality::Enum quality,
+    u32 thread_count)
+{
+    if (channel_count < 3 || channel_count > 4)
+        throw new std::runtime_error("ETC1 needs pixels of 3 or 4 channels");
+
+    std::vector<byte> data(ETC1DataSize(width, height));
+    if (data.empty())
+        return data;
+
+    const u32 blocks_wide = (width + 3) / 4;
+    const u32 blocks_high = (height + 3) / 4;
+    byte * blocks = data.data();
+
+    ParallelFor(blocks_high, std::max(1u, kMinBlocksPerRange / blocks_wide), thread_count,
+        [=](u32 begin, u32 end)
+        {
+            byte block_pixels[16 * 3];
+            for (u32 block_y = begin; block_y < end; ++block_y)
+            {
+                for (u32 block_x = 0; block_x < blocks_wide; ++block_x)
+                {
+                    for (u32 y = 0; y < 4; ++y)
+                    {
+                        const u32 source_y = std::min(block_y * 4 + y, height - 1);
+                        for (u32 x = 0; x < 4; ++x)
+                        {
+                            const u32 source_x = std::min(block_x * 4 + x, width - 1);
+                            const byte * source = pixels +
+                                (static_cast<size_t>(source_y) * width + source_x) * channel_count;
+                            std::copy(source, source + 3, block_pixels + 3 * (y * 4 + x));
+                        }
+                    }
+
+                    EncodeETC1Block(block_pixels, quality,
+                        blocks + (static_cast<size_t>(block_y) * blocks_wide + block_x) *
+                        kETC1BlockSize);
+                }
+            }
+        });
+    return data;
+}
+
+std::vector<byte>
+blowgun::DecodeETC1(const byte * data, u32 width, u32 height)
+{
+    std::vector<byte> pixels(static_cast<size_t>(width) * height * 3);
+
+    const u32 blocks_wide = (width + 3) / 4;
+    const u32 blocks_high = (height + 3) / 4;
+    byte block_pixels[16 * 3];
+    for (u32 block_y = 0; block_y < blocks_high; ++block_y)
+    {
+        for (u32 block_x = 0; block_x < blocks_wide; ++block_x)
+        {
+            DecodeETC1Block(data, block_pixels);
+            data += kETC1BlockSize;
+
+            // Partial blocks are cropped.
+            const u32 row_count = std::min(4u, height - block_y * 4);
+            const u32 column_count = std::min(4u, width - block_x * 4);
+            for (u32 y = 0; y < row_count; ++y)
+            {
+                std::copy(block_pixels + 3 * 4 * y, block_pixels + 3 * (4 * y + column_count),
+                    pixels.begin() + 3 * ((static_cast<size_t>(block_y) * 4 + y) * width +
+                    block_x * 4));
+            }
+        }
+    }
+    return pixels;
+}
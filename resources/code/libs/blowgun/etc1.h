@@ -0,0 +1,82 @@
+#ifndef BLOWGUN_ETC1_H_
+#define BLOWGUN_ETC1_H_
+
+#include <vector>
+
+#include "types.h"
+
+namespace blowgun
+{
+
+namespace ETC1Quality
+{
+	enum Enum
+	{
+		/**
+		 * Fit each sub-block around its average color only, and pick
+		 * the modifier of each pixel from its brightness. Fast enough
+		 * to compress at load time.
+		 */
+		kFast,
+
+		/**
+		 * Also try the neighbors of the average colors, and pick the
+		 * modifiers by their exact error where channels saturate. An
+		 * order of magnitude slower, for offline compression.
+		 */
+		kHigh,
+	};
+}
+
+/**
+ * Size of an ETC1 block, which holds 4x4 pixels.
+ */
+static const u32 kETC1BlockSize = 8;
+
+/**
+ * Get the size of a `width` by `height` image compressed to ETC1, whose
+ * sizes are rounded up to whole blocks.
+ */
+u32 ETC1DataSize(u32 width, u32 height);
+
+/**
+ * Compress 4x4 RGB pixels, stored row by row, into an ETC1 block.
+ */
+void EncodeETC1Block(const byte * pixels, ETC1Quality::Enum quality, byte * block);
+
+/**
+ * Decompress an ETC1 block into 4x4 RGB pixels, stored row by row.
+ */
+void DecodeETC1Block(const byte * block, byte * pixels);
+
+/**
+ * Compress an image to ETC1, as `glCompressedTexImage2D` expects it
+ * with `GL_ETC1_RGB8_OES`: blocks left to right, then row by row. The
+ * last column and row of pixels are repeated to fill partial blocks.
+ *
+ * @param   pixels
+ *          Rows of pixels of `channel_count` bytes, 3 or 4, with no
+ *          padding between them. ETC1 has no alpha: a fourth channel is
+ *          ignored.
+ * @param   thread_count
+ *          Upper bound of threads to use, rows of blocks being spread
+ *          over them. Zero means `HardwareThreadCount()`.
+ * @return  `ETC1DataSize(width, height)` bytes.
+ */
+std::vector<byte> EncodeETC1(
+	const byte * pixels,
+	u32 width,
+	u32 height,
+	u32 channel_count,
+	ETC1Quality::Enum quality = ETC1Quality::kFast,
+	u32 thread_count = 0);
+
+/**
+ * Decompress an ETC1 image of `ETC1DataSize(width, height)` bytes into
+ * rows of RGB pixels, with no padding between them.
+ */
+std::vector<byte> DecodeETC1(const byte * data, u32 width, u32 height);
+
+}
+
+#endif // BLOWGUN_ETC1_H_
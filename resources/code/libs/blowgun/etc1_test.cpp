@@ -0,0 +1,181 @@
+#include <cmath>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "etc1.h"
+#include "image_loader_tga.h"
+
+using namespace blowgun;
+
+namespace
+{
+    std::vector<byte> RandomPixels(u32 size, u32 seed)
+    {
+        std::vector<byte> pixels(size);
+        for (u32 i = 0; i < size; ++i)
+        {
+            seed = seed * 1664525 + 1013904223;
+            pixels[i] = static_cast<byte>(seed >> 24);
+        }
+        return pixels;
+    }
+
+    // Smooth colors, as most textures have.
+    std::vector<byte> Gradient(u32 width, u32 height)
+    {
+        std::vector<byte> pixels(width * height * 3);
+        for (u32 y = 0; y < height; ++y)
+        {
+            for (u32 x = 0; x < width; ++x)
+            {
+                byte * pixel = &pixels[(y * width + x) * 3];
+                pixel[0] = static_cast<byte>(255 * x / (width - 1));
+                pixel[1] = static_cast<byte>(255 * y / (height - 1));
+                pixel[2] = static_cast<byte>(128 + 60 * std::sin(0.05 * (x + y)));
+            }
+        }
+        return pixels;
+    }
+
+    // Peak signal-to-noise ratio of the RGB channels of `decoded`.
+    double PSNR(const std::vector<byte> & pixels, u32 channel_count,
+        const std::vector<byte> & decoded)
+    {
+        const size_t pixel_count = decoded.size() / 3;
+        double error = 0.0;
+        for (size_t i = 0; i < pixel_count; ++i)
+        {
+            for (u32 c = 0; c < 3; ++c)
+            {
+                const double difference =
+                    static_cast<double>(pixels[i * channel_count + c]) - decoded[i * 3 + c];
+                error += difference * difference;
+            }
+        }
+        if (error == 0.0)
+            return 1000.0;
+        return 10.0 * std::log10(255.0 * 255.0 * 3 * pixel_count / error);
+    }
+
+    double RoundTripPSNR(const std::vector<byte> & pixels, u32 width, u32 height,
+        u32 channel_count, ETC1Quality::Enum quality)
+    {
+        const std::vector<byte> data =
+            EncodeETC1(pixels.data(), width, height, channel_count, quality, 1);
+        EXPECT_EQ(ETC1DataSize(width, height), data.size());
+        return PSNR(pixels, channel_count, DecodeETC1(data.data(), width, height));
+    }
+}
+
+TEST(ETC1Test, DataSize)
+{
+    EXPECT_EQ(0u, ETC1DataSize(0, 0));
+    EXPECT_EQ(8u, ETC1DataSize(1, 1));
+    EXPECT_EQ(8u, ETC1DataSize(4, 4));
+    EXPECT_EQ(48u, ETC1DataSize(5, 9));
+    EXPECT_EQ(512u * 512 / 2, ETC1DataSize(512, 512));
+}
+
+TEST(ETC1Test, DecodeBlock)
+{
+    // Individual mode, side by side: red with the smallest modifiers,
+    // green with the largest. The top left pixel has a negative one.
+    const byte individual[8] = { 0xF0, 0x0F, 0x00, 0x1C, 0x00, 0x01, 0x00, 0x00 };
+    byte pixels[16 * 3];
+    DecodeETC1Block(individual, pixels);
+    for (u32 i = 0; i < 16; ++i)
+    {
+        const byte * pixel = pixels + 3 * i;
+        if (i == 0)
+        {
+            EXPECT_EQ(253, pixel[0]);
+            EXPECT_EQ(0, pixel[1]);
+        }
+        else if (i % 4 < 2)
+        {
+            EXPECT_EQ(255, pixel[0]);
+            EXPECT_EQ(2, pixel[1]);
+            EXPECT_EQ(2, pixel[2]);
+        }
+        else
+        {
+            EXPECT_EQ(47, pixel[0]);
+            EXPECT_EQ(255, pixel[1]);
+            EXPECT_EQ(47, pixel[2]);
+        }
+    }
+
+    // Differential mode, one above the other: the red of the bottom
+    // half is 4 steps below the top one.
+    const byte differential[8] = { 0x84, 0x00, 0x00, 0x03, 0x00, 0x00, 0x00, 0x00 };
+    DecodeETC1Block(differential, pixels);
+    for (u32 i = 0; i < 16; ++i)
+    {
+        EXPECT_EQ((i < 8) ? 134 : 101, pixels[3 * i]);
+        EXPECT_EQ(2, pixels[3 * i + 1]);
+    }
+}
+
+TEST(ETC1Test, SolidColors)
+{
+    const std::vector<byte> colors = RandomPixels(3 * 200, 7);
+    for (u32 i = 0; i < colors.size(); i += 3)
+    {
+        byte pixels[16 * 3];
+        for (u32 k = 0; k < 16; ++k)
+            std::copy(&colors[i], &colors[i] + 3, pixels + 3 * k);
+
+        byte block[8];
+        byte decoded[16 * 3];
+        EncodeETC1Block(pixels, ETC1Quality::kFast, block);
+        DecodeETC1Block(block, decoded);
+        for (u32 k = 0; k < 16 * 3; ++k)
+            EXPECT_NEAR(pixels[k], decoded[k], 8);
+    }
+}
+
+TEST(ETC1Test, RoundTrip)
+{
+    const std::vector<byte> gradient = Gradient(64, 48);
+    const double fast = RoundTripPSNR(gradient, 64, 48, 3, ETC1Quality::kFast);
+    const double high = RoundTripPSNR(gradient, 64, 48, 3, ETC1Quality::kHigh);
+    EXPECT_GT(fast, 35.0);
+    EXPECT_GE(high, fast);
+
+    // The alpha channel is skipped, and partial blocks are cropped.
+    std::vector<byte> rgba;
+    for (u32 y = 0; y < 7; ++y)
+    {
+        for (u32 x = 0; x < 13; ++x)
+        {
+            const byte * pixel = &gradient[(y * 64 + x) * 3];
+            rgba.insert(rgba.end(), pixel, pixel + 3);
+            rgba.push_back(static_cast<byte>(x * y));
+        }
+    }
+    EXPECT_GT(RoundTripPSNR(rgba, 13, 7, 4, ETC1Quality::kFast), 35.0);
+
+    std::ifstream file("data/banana.tga", std::ios::in | std::ios::binary);
+    std::shared_ptr<Image> banana = ImageLoaderTGA().Load(file);
+    const u32 channel_count = banana->bpp / 8;
+    EXPECT_GT(RoundTripPSNR(banana->data, banana->width, banana->height, channel_count,
+        ETC1Quality::kFast), 36.0);
+}
+
+TEST(ETC1Test, Threads)
+{
+    const u32 width = 200;
+    const u32 height = 100;
+    const std::vector<byte> pixels = RandomPixels(width * height * 3, 11);
+
+    const std::vector<byte> single = EncodeETC1(pixels.data(), width, height, 3,
+        ETC1Quality::kFast, 1);
+    EXPECT_EQ(single, EncodeETC1(pixels.data(), width, height, 3, ETC1Quality::kFast, 4));
+
+    EXPECT_TRUE(EncodeETC1(pixels.data(), 0, 0, 3).empty());
+    EXPECT_THROW(EncodeETC1(pixels.data(), width, height, 2), std::runtime_error *);
+}
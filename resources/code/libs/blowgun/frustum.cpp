@@ -0,0 +1,294 @@
+#include "frustum.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#include "matrix.h"
+#include "parallel.h"
+#include "simd.h"
+#include "vector.h"
+
+using namespace blowgun;
+
+// Utility
+namespace
+{
+    // Number of objects below which splitting an array over another
+    // thread costs more than it saves. It is also the size of the
+    // blocks a threaded cull is split into.
+    static const u32 kMinObjectsPerThread = 4096;
+
+    // Each plane, splatted once so it can be reused for every group of
+    // four objects.
+    struct SplatPlanes
+    {
+        simd::Float4 a[Frustum::kPlaneCount];
+        simd::Float4 b[Frustum::kPlaneCount];
+        simd::Float4 c[Frustum::kPlaneCount];
+        simd::Float4 d[Frustum::kPlaneCount];
+
+        // |a|, |b| and |c|, used to project box extents on the normal.
+        simd::Float4 abs_a[Frustum::kPlaneCount];
+        simd::Float4 abs_b[Frustum::kPlaneCount];
+        simd::Float4 abs_c[Frustum::kPlaneCount];
+
+        explicit SplatPlanes(const Frustum & frustum)
+        {
+            using namespace simd;
+
+            for (u32 p = 0; p < Frustum::kPlaneCount; ++p)
+            {
+                const float * plane = frustum.plane(p);
+                a[p] = Splat(plane[0]);
+                b[p] = Splat(plane[1]);
+                c[p] = Splat(plane[2]);
+                d[p] = Splat(plane[3]);
+                abs_a[p] = Splat(std::fabs(plane[0]));
+                abs_b[p] = Splat(std::fabs(plane[1]));
+                abs_c[p] = Splat(std::fabs(plane[2]));
+            }
+        }
+
+        // Signed distance from plane `p` to four points.
+        simd::Float4 Distance(u32 p, simd::Float4 x, simd::Float4 y, simd::Float4 z) const
+        {
+            using namespace simd;
+            Float4 distance = MulAdd(a[p], x, d[p]);
+            distance = MulAdd(b[p], y, distance);
+            return MulAdd(c[p], z, distance);
+        }
+
+        // How far four boxes reach along the normal of plane `p`.
+        simd::Float4 Reach(u32 p, simd::Float4 x, simd::Float4 y, simd::Float4 z) const
+        {
+            using namespace simd;
+            Float4 reach = Mul(abs_a[p], x);
+            reach = MulAdd(abs_b[p], y, reach);
+            return MulAdd(abs_c[p], z, reach);
+        }
+    };
+
+    // Append the index of every lane whose margin is not negative.
+    static u32 AppendVisible(simd::Float4 margin, u32 first_index, u32 * visible, u32 visible_count)
+    {
+        BLOWGUN_ALIGN(16) float margins[4];
+        simd::Store(margins, margin);
+        for (u32 k = 0; k < 4; ++k)
+        {
+            if (margins[k] >= 0.0f)
+                visible[visible_count++] = first_index + k;
+        }
+        return visible_count;
+    }
+
+    // An object is inside when it is not entirely behind any plane,
+    // i.e. when the smallest of its six signed margins is not
+    // negative. Taking the minimum keeps everything in arithmetic,
+    // without any comparison mask.
+    static u32 CullSpheresRange(const Frustum & frustum, const SphereArraySoA & spheres,
+        u32 begin, u32 end, u32 * visible)
+    {
+        using namespace simd;
+
+        const SplatPlanes planes(frustum);
+        u32 visible_count = 0;
+
+        u32 i = begin;
+        for (; i + 4 <= end; i += 4)
+        {
+            const Float4 x = Load(spheres.center_x + i);
+            const Float4 y = Load(spheres.center_y + i);
+            const Float4 z = Load(spheres.center_z + i);
+            const Float4 r = Load(spheres.radius + i);
+
+            Float4 margin = Add(planes.Distance(0, x, y, z), r);
+            for (u32 p = 1; p < Frustum::kPlaneCount; ++p)
+                margin = Min(margin, Add(planes.Distance(p, x, y, z), r));
+
+            visible_count = AppendVisible(margin, i, visible, visible_count);
+        }
+
+        // Leftovers that don't fill a whole SIMD register.
+        for (; i < end; ++i)
+        {
+            const Vec3 center(spheres.center_x[i], spheres.center_y[i], spheres.center_z[i]);
+            if (frustum.IsSphereVisible(center, spheres.radius[i]))
+                visible[visible_count++] = i;
+        }
+
+        return visible_count;
+    }
+
+    static u32 CullAABBsRange(const Frustum & frustum, const AABBArraySoA & boxes,
+        u32 begin, u32 end, u32 * visible)
+    {
+        using namespace simd;
+
+        const SplatPlanes planes(frustum);
+        const Float4 half = Splat(0.5f);
+        u32 visible_count = 0;
+
+        u32 i = begin;
+        for (; i + 4 <= end; i += 4)
+        {
+            const Float4 min_x = Load(boxes.min_x + i);
+            const Float4 min_y = Load(boxes.min_y + i);
+            const Float4 min_z = Load(boxes.min_z + i);
+            const Float4 max_x = Load(boxes.max_x + i);
+            const Float4 max_y = Load(boxes.max_y + i);
+            const Float4 max_z = Load(boxes.max_z + i);
+
+            const Float4 center_x = Mul(Add(min_x, max_x), half);
+            const Float4 center_y = Mul(Add(min_y, max_y), half);
+            const Float4 center_z = Mul(Add(min_z, max_z), half);
+            const Float4 extent_x = Mul(Sub(max_x, min_x), half);
+            const Float4 extent_y = Mul(Sub(max_y, min_y), half);
+            const Float4 extent_z = Mul(Sub(max_z, min_z), half);
+
+            Float4 margin = Add(
+                planes.Distance(0, center_x, center_y, center_z),
+                planes.Reach(0, extent_x, extent_y, extent_z));
+            for (u32 p = 1; p < Frustum::kPlaneCount; ++p)
+            {
+                margin = Min(margin, Add(
+                    planes.Distance(p, center_x, center_y, center_z),
+                    planes.Reach(p, extent_x, extent_y, extent_z)));
+            }
+
+            visible_count = AppendVisible(margin, i, visible, visible_count);
+        }
+
+        for (; i < end; ++i)
+        {
+            const Vec3 min(boxes.min_x[i], boxes.min_y[i], boxes.min_z[i]);
+            const Vec3 max(boxes.max_x[i], boxes.max_y[i], boxes.max_z[i]);
+            if (frustum.IsAABBVisible(min, max))
+                visible[visible_count++] = i;
+        }
+
+        return visible_count;
+    }
+
+    // Cull in fixed-size blocks spread over several threads. Each block
+    // writes its visible indices at its own offset of `visible`, and
+    // the results are then packed together, so the output is the same
+    // as that of a single-threaded cull.
+    template <typename Objects, typename CullRange>
+    static u32 CullBlocks(const Frustum & frustum, const Objects & objects, u32 count,
+        u32 * visible, u32 thread_count, CullRange cull_range)
+    {
+        if (thread_count == 1 || count <= kMinObjectsPerThread)
+            return cull_range(frustum, objects, 0, count, visible);
+
+        const u32 block_count = (count + kMinObjectsPerThread - 1) / kMinObjectsPerThread;
+        std::vector<u32> block_visible_counts(block_count);
+
+        ParallelFor(block_count, 1, thread_count,
+            [&](u32 begin, u32 end)
+            {
+                for (u32 block = begin; block < end; ++block)
+                {
+                    const u32 first = block * kMinObjectsPerThread;
+                    const u32 last = std::min(first + kMinObjectsPerThread, count);
+                    block_visible_counts[block] =
+                        cull_range(frustum, objects, first, last, visible + first);
+                }
+            });
+
+        u32 visible_count = block_visible_counts[0];
+        for (u32 block = 1; block < block_count; ++block)
+        {
+            std::memmove(visible + visible_count, visible + block * kMinObjectsPerThread,
+                block_visible_counts[block] * sizeof(u32));
+            visible_count += block_visible_counts[block];
+        }
+        return visible_count;
+    }
+}
+
+Frustum::Frustum(const Matrix & projection)
+{
+    // The clip-space position of a point is `P * v` with P being the
+    // projection as GL sees it, i.e. with each group of four values
+    // being one of its columns. Each plane is a sum or difference of
+    // the fourth row of P and one of the other rows.
+    const float * m = projection.values();
+    float row[4][4];
+    for (u32 i = 0; i < 4; ++i)
+    {
+        for (u32 j = 0; j < 4; ++j)
+            row[i][j] = m[4 * j + i];
+    }
+
+    for (u32 p = 0; p < kPlaneCount; ++p)
+    {
+        const u32 axis = p / 2;
+        const float sign = (p % 2 == 0) ? 1.0f : -1.0f;
+        for (u32 j = 0; j < 4; ++j)
+            planes_[p][j] = row[3][j] + sign * row[axis][j];
+
+        float length = std::sqrt(
+            planes_[p][0] * planes_[p][0] +
+            planes_[p][1] * planes_[p][1] +
+            planes_[p][2] * planes_[p][2]);
+        if (length > 0.0f)
+        {
+            for (u32 j = 0; j < 4; ++j)
+                planes_[p][j] /= length;
+        }
+    }
+}
+
+const float *
+Frustum::plane(u32 index) const
+{
+    return planes_[index];
+}
+
+bool
+Frustum::IsSphereVisible(const Vec3 & center, float radius) const
+{
+    for (u32 p = 0; p < kPlaneCount; ++p)
+    {
+        const float * plane = planes_[p];
+        float distance =
+            plane[0] * center.x + plane[1] * center.y + plane[2] * center.z + plane[3];
+        if (distance + radius < 0.0f)
+            return false;
+    }
+    return true;
+}
+
+bool
+Frustum::IsAABBVisible(const Vec3 & min, const Vec3 & max) const
+{
+    for (u32 p = 0; p < kPlaneCount; ++p)
+    {
+        // The corner furthest along the plane normal.
+        const float * plane = planes_[p];
+        float distance =
+            plane[0] * (plane[0] >= 0.0f ? max.x : min.x) +
+            plane[1] * (plane[1] >= 0.0f ? max.y : min.y) +
+            plane[2] * (plane[2] >= 0.0f ? max.z : min.z) +
+            plane[3];
+        if (distance < 0.0f)
+            return false;
+    }
+    return true;
+}
+
+u32
+Frustum::Cull(const SphereArraySoA & spheres, u32 count, u32 * visible,
+    u32 thread_count) const
+{
+    return CullBlocks(*this, spheres, count, visible, thread_count, CullSpheresRange);
+}
+
+u32
+Frustum::Cull(const AABBArraySoA & boxes, u32 count, u32 * visible,
+    u32 thread_count) const
+{
+    return CullBlocks(*this, boxes, count, visible, thread_count, CullAABBsRange);
+}
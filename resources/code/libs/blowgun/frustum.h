@@ -0,0 +1,104 @@
+#ifndef BLOWGUN_FRUSTUM_H_
+#define BLOWGUN_FRUSTUM_H_
+
+#include "types.h"
+
+namespace blowgun
+{
+
+class Matrix;
+struct Vec3;
+
+/**
+ * Structure-of-arrays view over a number of bounding spheres.
+ *
+ * Each array has to hold at least as many floats as there are
+ * spheres.
+ */
+struct SphereArraySoA
+{
+	const float * center_x;
+	const float * center_y;
+	const float * center_z;
+	const float * radius;
+};
+
+/**
+ * Structure-of-arrays view over a number of axis-aligned bounding
+ * boxes, given by their minimum and maximum corners.
+ */
+struct AABBArraySoA
+{
+	const float * min_x;
+	const float * min_y;
+	const float * min_z;
+	const float * max_x;
+	const float * max_y;
+	const float * max_z;
+};
+
+/**
+ * The six clip planes of a projection, used to skip objects that
+ * can't end up on screen.
+ *
+ * The planes are pulled out of the matrix the objects are drawn with:
+ * a projection matrix gives planes in view space, a PMV matrix gives
+ * planes in the space of the model's own coordinates. Every test is
+ * conservative: an object that is reported as invisible is guaranteed
+ * to be outside, while a few objects just outside a corner of the
+ * frustum may still be reported as visible.
+ */
+class Frustum
+{
+private:
+	/**
+	 * Planes as (a, b, c, d), with `a * x + b * y + c * z + d >= 0`
+	 * on the inside. (a, b, c) is unit-length, so the left-hand side
+	 * is the distance to the plane. In order: left, right, bottom,
+	 * top, near, far.
+	 */
+	float planes_[6][4];
+
+public:
+	static const u32 kPlaneCount = 6;
+
+	/**
+	 * Extract the planes of a projection, such as the one built by
+	 * `Matrix::Perspective` or `Matrix::Frustum`, or of a whole PMV
+	 * matrix.
+	 */
+	explicit Frustum(const Matrix & projection);
+
+	/**
+	 * Get a plane as 4 floats (a, b, c, d).
+	 */
+	const float * plane(u32 index) const;
+
+	bool IsSphereVisible(const Vec3 & center, float radius) const;
+	bool IsAABBVisible(const Vec3 & min, const Vec3 & max) const;
+
+	/**
+	 * Test `count` spheres, four per SIMD instruction, and write the
+	 * indices of the visible ones, in increasing order, into
+	 * `visible`, which has to hold `count` indices.
+	 *
+	 * @param   thread_count
+	 *          Upper bound of threads to split a large array over. The
+	 *          default tests everything on the calling thread; zero
+	 *          means one thread per hardware thread.
+	 *
+	 * @return  The number of visible spheres.
+	 */
+	u32 Cull(const SphereArraySoA & spheres, u32 count, u32 * visible,
+		u32 thread_count = 1) const;
+
+	/**
+	 * Same as above, for axis-aligned bounding boxes.
+	 */
+	u32 Cull(const AABBArraySoA & boxes, u32 count, u32 * visible,
+		u32 thread_count = 1) const;
+};
+
+}
+
+#endif // BLOWGUN_FRUSTUM_H_
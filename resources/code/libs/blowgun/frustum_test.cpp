@@ -0,0 +1,150 @@
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "frustum.h"
+#include "matrix.h"
+#include "vector.h"
+
+using namespace blowgun;
+
+namespace
+{
+    // 9999 isn't a multiple of the SIMD width, so the leftover path
+    // is exercised too.
+    static const u32 kCount = 9999;
+
+    Matrix CreateProjection()
+    {
+        return Matrix().Perspective(60.0f, 800.0f / 600.0f, 1.0f, 20.0f);
+    }
+
+    // Objects spread around the camera, most of them off-screen.
+    Vec3 CreatePosition(u32 i)
+    {
+        return Vec3(
+            static_cast<float>(i % 37) - 18.0f,
+            static_cast<float>(i % 23) - 11.0f,
+            -static_cast<float>(i % 29));
+    }
+
+    float CreateSize(u32 i)
+    {
+        return 0.1f + static_cast<float>(i % 7) * 0.5f;
+    }
+}
+
+TEST(FrustumTest, PlanesOfPerspective)
+{
+    const Frustum frustum(CreateProjection());
+
+    // Near plane: z <= -1, far plane: z >= -20.
+    const float * near_plane = frustum.plane(4);
+    EXPECT_NEAR(-1.0f, near_plane[2], 1e-5f);
+    EXPECT_NEAR(-1.0f, near_plane[3], 1e-4f);
+
+    const float * far_plane = frustum.plane(5);
+    EXPECT_NEAR(1.0f, far_plane[2], 1e-5f);
+    EXPECT_NEAR(20.0f, far_plane[3], 1e-3f);
+}
+
+TEST(FrustumTest, SingleObjects)
+{
+    const Frustum frustum(CreateProjection());
+
+    EXPECT_TRUE(frustum.IsSphereVisible(Vec3(0.0f, 0.0f, -5.0f), 0.5f));
+    EXPECT_FALSE(frustum.IsSphereVisible(Vec3(0.0f, 0.0f, 5.0f), 0.5f));
+    EXPECT_FALSE(frustum.IsSphereVisible(Vec3(0.0f, 0.0f, -25.0f), 1.0f));
+    EXPECT_TRUE(frustum.IsSphereVisible(Vec3(0.0f, 0.0f, -21.0f), 2.0f));
+    EXPECT_FALSE(frustum.IsSphereVisible(Vec3(50.0f, 0.0f, -5.0f), 1.0f));
+
+    EXPECT_TRUE(frustum.IsAABBVisible(Vec3(-1.0f, -1.0f, -6.0f), Vec3(1.0f, 1.0f, -4.0f)));
+    EXPECT_TRUE(frustum.IsAABBVisible(Vec3(-100.0f, -1.0f, -6.0f), Vec3(100.0f, 1.0f, -4.0f)));
+    EXPECT_FALSE(frustum.IsAABBVisible(Vec3(-1.0f, 10.0f, -6.0f), Vec3(1.0f, 12.0f, -4.0f)));
+}
+
+TEST(FrustumTest, PMVPlanesWorkInModelSpace)
+{
+    // A model pushed 10 units away from the camera: its origin is
+    // visible, while a point 10 units closer is at the camera itself.
+    const Matrix pmv = Matrix().Translate(0.0f, 0.0f, -10.0f).Multiply(CreateProjection());
+    const Frustum frustum(pmv);
+
+    EXPECT_TRUE(frustum.IsSphereVisible(Vec3(0.0f, 0.0f, 0.0f), 0.1f));
+    EXPECT_FALSE(frustum.IsSphereVisible(Vec3(0.0f, 0.0f, 10.0f), 0.1f));
+}
+
+TEST(FrustumTest, CullSpheresMatchesSingleTests)
+{
+    std::vector<float> x(kCount), y(kCount), z(kCount), radius(kCount);
+    for (u32 i = 0; i < kCount; ++i)
+    {
+        const Vec3 position = CreatePosition(i);
+        x[i] = position.x;
+        y[i] = position.y;
+        z[i] = position.z;
+        radius[i] = CreateSize(i);
+    }
+    SphereArraySoA spheres = { &x[0], &y[0], &z[0], &radius[0] };
+
+    const Frustum frustum(CreateProjection());
+
+    std::vector<u32> expected;
+    for (u32 i = 0; i < kCount; ++i)
+    {
+        if (frustum.IsSphereVisible(CreatePosition(i), CreateSize(i)))
+            expected.push_back(i);
+    }
+    ASSERT_LT(0u, expected.size());
+    ASSERT_GT(kCount, expected.size());
+
+    std::vector<u32> single(kCount);
+    std::vector<u32> threaded(kCount);
+    single.resize(frustum.Cull(spheres, kCount, &single[0]));
+    threaded.resize(frustum.Cull(spheres, kCount, &threaded[0], 0));
+
+    EXPECT_EQ(expected, single);
+    EXPECT_EQ(expected, threaded);
+}
+
+TEST(FrustumTest, CullAABBsMatchesSingleTests)
+{
+    std::vector<float> min_x(kCount), min_y(kCount), min_z(kCount);
+    std::vector<float> max_x(kCount), max_y(kCount), max_z(kCount);
+    for (u32 i = 0; i < kCount; ++i)
+    {
+        const Vec3 position = CreatePosition(i);
+        const float size = CreateSize(i);
+        min_x[i] = position.x - size;
+        min_y[i] = position.y - size * 0.5f;
+        min_z[i] = position.z - size * 2.0f;
+        max_x[i] = position.x + size;
+        max_y[i] = position.y + size * 0.5f;
+        max_z[i] = position.z + size * 2.0f;
+    }
+    AABBArraySoA boxes =
+    {
+        &min_x[0], &min_y[0], &min_z[0],
+        &max_x[0], &max_y[0], &max_z[0]
+    };
+
+    const Frustum frustum(CreateProjection());
+
+    std::vector<u32> expected;
+    for (u32 i = 0; i < kCount; ++i)
+    {
+        const Vec3 min(min_x[i], min_y[i], min_z[i]);
+        const Vec3 max(max_x[i], max_y[i], max_z[i]);
+        if (frustum.IsAABBVisible(min, max))
+            expected.push_back(i);
+    }
+    ASSERT_LT(0u, expected.size());
+    ASSERT_GT(kCount, expected.size());
+
+    std::vector<u32> single(kCount);
+    std::vector<u32> threaded(kCount);
+    single.resize(frustum.Cull(boxes, kCount, &single[0]));
+    threaded.resize(frustum.Cull(boxes, kCount, &threaded[0], 0));
+
+    EXPECT_EQ(expected, single);
+    EXPECT_EQ(expected, threaded);
+}
@@ -0,0 +1,31 @@
+#include "gl_extensions.h"
+
+#include <cstring>
+
+#include <GLES2/gl2.h>
+
+using namespace blowgun;
+
+bool
+blowgun::HasExtension(const char * extensions, const char * name)
+{
+    const std::size_t length = std::strlen(name);
+    if (!extensions || length == 0)
+        return false;
+
+    for (const char * found = std::strstr(extensions, name); found;
+        found = std::strstr(found + length, name))
+    {
+        const bool starts = found == extensions || found[-1] == ' ';
+        const bool ends = found[length] == ' ' || found[length] == '\0';
+        if (starts && ends)
+            return true;
+    }
+    return false;
+}
+
+bool
+blowgun::HasGLExtension(const char * name)
+{
+    return HasExtension(reinterpret_cast<const char *>(glGetString(GL_EXTENSIONS)), name);
+}
@@ -0,0 +1,23 @@
+#ifndef BLOWGUN_GL_EXTENSIONS_H_
+#define BLOWGUN_GL_EXTENSIONS_H_
+
+namespace blowgun
+{
+
+/**
+ * Check whether `extensions`, a list of names separated by spaces as
+ * `glGetString(GL_EXTENSIONS)` returns it, holds `name`. Names that
+ * merely start with `name` don't count.
+ */
+bool HasExtension(const char * extensions, const char * name);
+
+/**
+ * Check whether the current OpenGL context supports the extension
+ * `name`, such as "GL_OES_element_index_uint". Must be called from the
+ * thread that owns the OpenGL context.
+ */
+bool HasGLExtension(const char * name);
+
+}
+
+#endif // BLOWGUN_GL_EXTENSIONS_H_
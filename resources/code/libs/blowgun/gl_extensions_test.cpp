@@ -0,0 +1,20 @@
+#include <gtest/gtest.h>
+#include "gl_extensions.h"
+
+using namespace blowgun;
+
+TEST(GLExtensionsTest, HasExtension)
+{
+    const char * extensions = "GL_OES_vertex_half_float_x GL_OES_element_index_uint GL_EXT_a";
+    EXPECT_TRUE(HasExtension(extensions, "GL_OES_element_index_uint"));
+    EXPECT_TRUE(HasExtension(extensions, "GL_EXT_a"));
+
+    // Whole names only.
+    EXPECT_FALSE(HasExtension(extensions, "GL_OES_vertex_half_float"));
+    EXPECT_FALSE(HasExtension(extensions, "GL_OES_element"));
+    EXPECT_FALSE(HasExtension(extensions, "index_uint"));
+
+    EXPECT_FALSE(HasExtension(extensions, ""));
+    EXPECT_FALSE(HasExtension(0, "GL_EXT_a"));
+    EXPECT_FALSE(HasExtension("", "GL_EXT_a"));
+}
@@ -3,6 +3,7 @@
 
 #include "types.h"
 
+#include <utility>
 #include <vector>
 
 namespace blowgun
@@ -16,7 +17,7 @@ struct Image
 	const std::vector<byte>  data;
 
 	explicit Image(u16 width, u16 height, byte bpp, std::vector<byte> data) :
-		width(width), height(height), bpp(bpp), data(data) {}
+		width(width), height(height), bpp(bpp), data(std::move(data)) {}
 };
 
 }
@@ -1,7 +1,11 @@
 #include "image_loader_tga.h"
 
+#include <cstring>
 #include <stdexcept>
+#include <utility>
+#include <vector>
 
+#include "pixel_kernels.h"
 #include "types.h"
 
 using namespace blowgun;
@@ -30,85 +34,303 @@ namespace
 		byte bits_per_pixel;
 		byte image_descriptor;
 	};
+#pragma pack(pop)
+
+	namespace TGAImageType
+	{
+		enum Enum
+		{
+			kTrueColor    = 2,
+			kGrayscale    = 3,
+			kTrueColorRLE = 10,
+			kGrayscaleRLE = 11
+		};
+	}
+
+	const byte kAttributeBitsMask = 0x0F;
+	const byte kRightToLeftBit    = 1 << 4;
+	const byte kTopToBottomBit    = 1 << 5;
+	const byte kInterleavingMask  = 0xC0;
+
+	// A run packet repeats one pixel, a raw packet stores its pixels.
+	const byte kRunPacketBit      = 0x80;
+	const u32  kMaxPacketPixels   = 128;
+
+	/**
+	 * Tell whether this loader can decode the pixels a header describes.
+	 */
+	static bool
+	IsSupported(const TGA_HEADER & header)
+	{
+		if (header.width == 0 || header.height == 0)
+			return false;
+
+		// Colour maps are only skipped, but they must still be valid.
+		if (header.colour_map_type > 1)
+			return false;
+		if (header.colour_map_type == 1 &&
+			header.palette_entry_depth != 15 && header.palette_entry_depth != 16 &&
+			header.palette_entry_depth != 24 && header.palette_entry_depth != 32)
+			return false;
+
+		if ((header.image_descriptor & (kInterleavingMask | kRightToLeftBit)) != 0)
+			return false;
+
+		switch (header.image_type)
+		{
+		case TGAImageType::kTrueColor :
+		case TGAImageType::kTrueColorRLE :
+			return header.bits_per_pixel == 15 || header.bits_per_pixel == 16 ||
+				header.bits_per_pixel == 24 || header.bits_per_pixel == 32;
+		case TGAImageType::kGrayscale :
+		case TGAImageType::kGrayscaleRLE :
+			return header.bits_per_pixel == 8 || header.bits_per_pixel == 16;
+		default :
+			return false;
+		}
+	}
+
+	const u64 kUnknownSize = ~static_cast<u64>(0);
 
 	/**
-	 * The standard TGA color order.
+	 * Get the number of bytes between the current position of `input`
+	 * and its end, or `kUnknownSize` if it can't seek.
 	 */
-	struct TGA_RGB_VALUE
+	static u64
+	RemainingSize(std::istream & input)
 	{
-		byte blue;
-		byte green;
-		byte red;
+		const std::streampos position = input.tellg();
+		if (position == std::streampos(-1))
+			return kUnknownSize;
+
+		input.seekg(0, std::ios::end);
+		const std::streampos end = input.tellg();
+		input.seekg(position);
+		if (end == std::streampos(-1) || end < position)
+			return kUnknownSize;
+		return static_cast<u64>(end - position);
+	}
+
+	/**
+	 * Tell whether `size` bytes can hold `pixel_count` pixels of
+	 * `pixel_size` bytes, run-length encoded if `compressed`.
+	 */
+	static bool
+	CanHoldPixels(u64 size, u32 pixel_size, u32 pixel_count, bool compressed)
+	{
+		if (size == kUnknownSize)
+			return true;
+
+		// At best, each run packet expands one pixel to many.
+		const u64 max_pixels = compressed ?
+			(size / (1 + pixel_size) + 1) * kMaxPacketPixels : size / pixel_size;
+		return pixel_count <= max_pixels;
+	}
+
+	/**
+	 * Reads a stream through a buffer of fixed size, a few bytes at a
+	 * time, without a call to the stream for each of them.
+	 */
+	class BufferedReader
+	{
+	public:
+		explicit BufferedReader(std::istream & input) :
+			input_(input), buffer_(64 * 1024), begin_(0), end_(0) {}
+
+		/**
+		 * Get the next `size` bytes, at most a fourth of the buffer, or
+		 * throw if the stream ends before.
+		 */
+		const byte * Read(size_t size)
+		{
+			if (end_ - begin_ < size)
+			{
+				// Keep what is left, and fill up the rest.
+				std::memmove(&buffer_[0], &buffer_[begin_], end_ - begin_);
+				end_ -= begin_;
+				begin_ = 0;
+				if (input_)
+				{
+					input_.read(reinterpret_cast<char *>(&buffer_[end_]), buffer_.size() - end_);
+					end_ += static_cast<size_t>(input_.gcount());
+				}
+				if (end_ < size)
+					throw new std::runtime_error("Truncated TGA content");
+			}
+
+			const byte * bytes = &buffer_[begin_];
+			begin_ += size;
+			return bytes;
+		}
+
+	private:
+		std::istream &    input_;
+		std::vector<byte> buffer_;
+		size_t            begin_;
+		size_t            end_;
+
+		// Disallow copy and assign.
+		BufferedReader(const BufferedReader & rhs);
+		BufferedReader & operator=(const BufferedReader & rhs);
 	};
-#pragma pack(pop)
+
+	/**
+	 * Expand `pixel_count` run-length encoded pixels of `pixel_size`
+	 * bytes from `input` into `pixels`, keeping the TGA byte order.
+	 * Packets may go on from one row to the next, but not past the
+	 * last pixel.
+	 */
+	static void
+	DecodeRLE(std::istream & input, byte * pixels, u32 pixel_size, u32 pixel_count)
+	{
+		BufferedReader reader(input);
+		u32 decoded = 0;
+		while (decoded < pixel_count)
+		{
+			const byte header = *reader.Read(1);
+			const u32 count = (header & ~kRunPacketBit) + 1;
+			if (count > pixel_count - decoded)
+				throw new std::runtime_error("TGA packet past the end of the image");
+
+			byte * destination = pixels + static_cast<size_t>(decoded) * pixel_size;
+			if (header & kRunPacketBit)
+			{
+				kernels::FillPixels(destination, reader.Read(pixel_size), pixel_size, count);
+			}
+			else
+			{
+				const size_t size = count * pixel_size;
+				std::memcpy(destination, reader.Read(size), size);
+			}
+			decoded += count;
+		}
+	}
+
+	/**
+	 * Convert 16-bit A1R5G5B5 pixels to RGB, or to RGBA when `alpha` is
+	 * set.
+	 */
+	static std::vector<byte>
+	ExpandHighColor(const std::vector<byte> & source, u32 pixel_count, bool alpha)
+	{
+		const u32 pixel_size = alpha ? 4 : 3;
+		std::vector<byte> pixels(static_cast<size_t>(pixel_count) * pixel_size);
+		for (u32 i = 0; i < pixel_count; ++i)
+		{
+			const u32 value = source[i * 2] | (source[i * 2 + 1] << 8);
+			const u32 red = (value >> 10) & 0x1F;
+			const u32 green = (value >> 5) & 0x1F;
+			const u32 blue = value & 0x1F;
+
+			byte * pixel = &pixels[static_cast<size_t>(i) * pixel_size];
+			pixel[0] = static_cast<byte>((red << 3) | (red >> 2));
+			pixel[1] = static_cast<byte>((green << 3) | (green >> 2));
+			pixel[2] = static_cast<byte>((blue << 3) | (blue >> 2));
+			if (alpha)
+				pixel[3] = (value & 0x8000) ? 0xFF : 0x00;
+		}
+		return pixels;
+	}
+
+	static TGA_HEADER
+	ReadHeader(std::istream & input)
+	{
+		TGA_HEADER header;
+		input.read(reinterpret_cast<char *>(&header), sizeof(TGA_HEADER));
+		if (input.gcount() != sizeof(TGA_HEADER))
+			throw new std::runtime_error("Truncated TGA header");
+		return header;
+	}
 }
 
 bool
-ImageLoaderTGA::CanLoad(std::istream & /*input*/) const
+ImageLoaderTGA::CanLoad(std::istream & input) const
 {
-	// TODO: Read the header of the input stream to ensure
-	// that the stream conforms to TGA spec.
-	return true;
+	// TGA files have no magic number, only a header that has to make
+	// sense.
+	input.seekg(0, std::ios::beg);
+	TGA_HEADER header;
+	input.read(reinterpret_cast<char *>(&header), sizeof(TGA_HEADER));
+	return input.gcount() == sizeof(TGA_HEADER) && IsSupported(header);
 }
 
 std::shared_ptr<Image>
 ImageLoaderTGA::Load(std::istream & input) const
 {
-	const u32 kInvertedBitInfoLocation = 1 << 5;
-
 	input.seekg(0, std::ios::beg);
 
 	/*
 	 * Read the header first.
 	 */
-	TGA_HEADER image_info;
-	input.read(reinterpret_cast<char *>(&image_info), sizeof(TGA_HEADER));
+	const TGA_HEADER image_info = ReadHeader(input);
+	if (!IsSupported(image_info))
+		throw new std::runtime_error("Unsupported TGA format");
+
+	// Skip the image ID and the colour map, which true color and
+	// grayscale images don't need.
+	const u32 colour_map_size = (image_info.colour_map_type != 0) ?
+		image_info.palette_size * ((image_info.palette_entry_depth + 7) / 8) : 0;
+	input.seekg(image_info.id_size + colour_map_size, std::ios::cur);
 
 	/*
-	 * Then the actual content.
+	 * Then the actual content, decoded straight where the image keeps
+	 * it when its pixels are stored as they come, and fixed up in place.
 	 */
-	// TODO: This code only supports RGB at the moment.
-	u32 pixels_count = image_info.width * image_info.height;
-	u32 content_size = sizeof(TGA_RGB_VALUE) * pixels_count;
-	
-	TGA_RGB_VALUE * raw_pixels = new TGA_RGB_VALUE[pixels_count];
-	input.read(reinterpret_cast<char *>(raw_pixels), content_size);
-	if ((u32) input.gcount() != content_size)
+	const bool compressed = image_info.image_type == TGAImageType::kTrueColorRLE ||
+		image_info.image_type == TGAImageType::kGrayscaleRLE;
+	const u32 pixel_size = (image_info.bits_per_pixel + 7) / 8;
+	const u32 pixel_count = static_cast<u32>(image_info.width) * image_info.height;
+	const u32 row_size = pixel_size * image_info.width;
+	const size_t content_size = static_cast<size_t>(row_size) * image_info.height;
+
+	// Check the size before allocating anything, so a broken header
+	// can't ask for gigabytes.
+	if (!CanHoldPixels(RemainingSize(input), pixel_size, pixel_count, compressed))
+		throw new std::runtime_error("Truncated TGA content");
+
+	std::vector<byte> pixels(content_size);
+	if (compressed)
 	{
-		std::cerr << "Read bytes count differs from content size!" << std::endl;
+		DecodeRLE(input, pixels.data(), pixel_size, pixel_count);
 	}
-
-	/*
-	 * Process the content.
-	 */
-	bool value_is_inverted =
-		(image_info.image_descriptor & kInvertedBitInfoLocation) == kInvertedBitInfoLocation;
-	std::vector<byte> pixels(pixels_count * 3);
-	u32 i = 0;
-	for (u16 y = 0; y < image_info.height; y++)
+	else
 	{
-		for(u16 x = 0; x < image_info.width; x++)
-		{
-			u32 index = y * image_info.width + x;
-
-			// If this TGA stream is _not_ inverted, adjust the index.
-			if(!value_is_inverted)
-				index = (image_info.height - 1 - y) * image_info.width + x;
+		input.read(reinterpret_cast<char *>(&pixels[0]), content_size);
+		if (static_cast<size_t>(input.gcount()) != content_size)
+			throw new std::runtime_error("Truncated TGA content");
+	}
 
-			pixels[(i * 3) + 0] = raw_pixels[index].red;
-			pixels[(i * 3) + 1] = raw_pixels[index].green;
-			pixels[(i * 3) + 2] = raw_pixels[index].blue;
+	// Rows are stored bottom to top, unless told otherwise.
+	if ((image_info.image_descriptor & kTopToBottomBit) == 0)
+		kernels::FlipRows(pixels.data(), row_size, image_info.height);
 
-			i++;
+	// Grayscale pixels are already in the order OpenGL wants.
+	byte bpp = image_info.bits_per_pixel;
+	if (image_info.image_type == TGAImageType::kTrueColor ||
+		image_info.image_type == TGAImageType::kTrueColorRLE)
+	{
+		switch (pixel_size)
+		{
+		case 2 :
+		{
+			const bool alpha = (image_info.image_descriptor & kAttributeBitsMask) != 0;
+			pixels = ExpandHighColor(pixels, pixel_count, alpha);
+			bpp = alpha ? 32 : 24;
+			break;
+		}
+		case 3 :
+			kernels::SwapRedBlue24(pixels.data(), pixels.data(), pixel_count);
+			break;
+		default :
+			kernels::SwapRedBlue32(pixels.data(), pixels.data(), pixel_count);
+			break;
 		}
 	}
 
-	delete[] raw_pixels;
-
 	return std::make_shared<Image>(
 		image_info.width,
 		image_info.height,
-		image_info.bits_per_pixel,
-		pixels
+		bpp,
+		std::move(pixels)
 	);
 }
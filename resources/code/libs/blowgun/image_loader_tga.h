@@ -6,6 +6,17 @@
 namespace blowgun
 {
 
+/**
+ * Loads true color and grayscale TGA images, uncompressed or run-length
+ * encoded (image types 2, 3, 10 and 11).
+ *
+ * True color images of 24 and 32 bits come out as RGB and RGBA, and 16
+ * bits ones as RGB, or RGBA when their header says they have alpha.
+ * Grayscale images of 8 and 16 bits come out as luminance, and
+ * luminance and alpha. Rows always go from top to bottom.
+ *
+ * Truncated or inconsistent files throw a `std::runtime_error *`.
+ */
 class ImageLoaderTGA : public ImageLoader
 {
 public:
@@ -0,0 +1,385 @@
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "image_loader_tga.h"
+#include "pixel_kernels.h"
+
+using namespace blowgun;
+
+namespace
+{
+    // Color of pixel (x, y), from the top left, with a few flat areas so
+    // that run-length encoding finds runs, some across rows.
+    void Color(u32 x, u32 y, byte * rgba)
+    {
+        if (y % 3 == 0 || x > 40)
+        {
+            rgba[0] = static_cast<byte>(y * 5);
+            rgba[1] = static_cast<byte>(y);
+            rgba[2] = static_cast<byte>(200 - y);
+            rgba[3] = static_cast<byte>(x > 40 ? 0xFF : 0x00);
+            return;
+        }
+        rgba[0] = static_cast<byte>(x);
+        rgba[1] = static_cast<byte>(y);
+        rgba[2] = static_cast<byte>(x / 4 + y);
+        rgba[3] = static_cast<byte>(x * y);
+    }
+
+    // Pixel (x, y) as the TGA stores it, `bpp` bits of it.
+    std::string StoredPixel(u32 x, u32 y, bool grayscale, u8 bpp)
+    {
+        byte rgba[4];
+        Color(x, y, rgba);
+
+        std::string pixel;
+        if (grayscale)
+        {
+            pixel.push_back(static_cast<char>(rgba[0]));
+            if (bpp == 16)
+                pixel.push_back(static_cast<char>(rgba[3]));
+        }
+        else if (bpp == 16)
+        {
+            const u32 value = ((rgba[3] & 0x80) << 8) | ((rgba[0] >> 3) << 10) |
+                ((rgba[1] >> 3) << 5) | (rgba[2] >> 3);
+            pixel.push_back(static_cast<char>(value & 0xFF));
+            pixel.push_back(static_cast<char>(value >> 8));
+        }
+        else
+        {
+            pixel.push_back(static_cast<char>(rgba[2]));
+            pixel.push_back(static_cast<char>(rgba[1]));
+            pixel.push_back(static_cast<char>(rgba[0]));
+            if (bpp == 32)
+                pixel.push_back(static_cast<char>(rgba[3]));
+        }
+        return pixel;
+    }
+
+    // Encode `pixels` as TGA packets: runs of two pixels or more become
+    // run packets, the others raw packets.
+    std::string EncodeRLE(const std::vector<std::string> & pixels)
+    {
+        std::string packets;
+        size_t i = 0;
+        while (i < pixels.size())
+        {
+            size_t run = 1;
+            while (i + run < pixels.size() && run < 128 && pixels[i + run] == pixels[i])
+                ++run;
+
+            if (run > 1)
+            {
+                packets.push_back(static_cast<char>(0x80 | (run - 1)));
+                packets += pixels[i];
+                i += run;
+                continue;
+            }
+
+            size_t raw = 1;
+            while (i + raw < pixels.size() && raw < 128 &&
+                (i + raw + 1 == pixels.size() || pixels[i + raw] != pixels[i + raw + 1]))
+                ++raw;
+
+            packets.push_back(static_cast<char>(raw - 1));
+            for (size_t k = 0; k < raw; ++k)
+                packets += pixels[i + k];
+            i += raw;
+        }
+        return packets;
+    }
+
+    std::string CreateTGA(u8 image_type, u8 bpp, u16 width, u16 height, bool top_to_bottom,
+        u8 id_size = 0, u8 attribute_bits = 0)
+    {
+        const bool grayscale = (image_type & 7) == 3;
+
+        std::string file(18, '\0');
+        file[0] = static_cast<char>(id_size);
+        file[2] = static_cast<char>(image_type);
+        file[12] = static_cast<char>(width & 0xFF);
+        file[13] = static_cast<char>(width >> 8);
+        file[14] = static_cast<char>(height & 0xFF);
+        file[15] = static_cast<char>(height >> 8);
+        file[16] = static_cast<char>(bpp);
+        file[17] = static_cast<char>((top_to_bottom ? 0x20 : 0x00) | attribute_bits);
+        file.append(id_size, 'i');
+
+        std::vector<std::string> pixels;
+        for (u32 row = 0; row < height; ++row)
+        {
+            const u32 y = top_to_bottom ? row : height - 1 - row;
+            for (u32 x = 0; x < width; ++x)
+                pixels.push_back(StoredPixel(x, y, grayscale, bpp));
+        }
+
+        if (image_type >= 8)
+            return file + EncodeRLE(pixels);
+
+        for (size_t i = 0; i < pixels.size(); ++i)
+            file += pixels[i];
+        return file;
+    }
+
+    // Check `image` holds the colors of `Color`, in `bpp` bits per pixel,
+    // each channel of them rounded to `bits` bits.
+    void ExpectColors(const Image & image, u16 width, u16 height, u8 bpp, u32 bits = 8)
+    {
+        ASSERT_EQ(width, image.width);
+        ASSERT_EQ(height, image.height);
+        ASSERT_EQ(bpp, image.bpp);
+        ASSERT_EQ(width * height * (bpp / 8u), image.data.size());
+
+        const byte mask = static_cast<byte>(0xFF << (8 - bits));
+        for (u32 y = 0; y < height; ++y)
+        {
+            for (u32 x = 0; x < width; ++x)
+            {
+                byte rgba[4];
+                Color(x, y, rgba);
+
+                const byte * pixel = &image.data[(y * width + x) * (bpp / 8)];
+                if (bpp <= 16)
+                {
+                    EXPECT_EQ(rgba[0], pixel[0]);
+                    if (bpp == 16)
+                    {
+                        EXPECT_EQ(rgba[3], pixel[1]);
+                    }
+                    continue;
+                }
+
+                for (u32 k = 0; k < 3; ++k)
+                    EXPECT_EQ(rgba[k] & mask, pixel[k] & mask);
+                if (bpp == 32)
+                {
+                    const byte alpha = (bits == 5) ? ((rgba[3] & 0x80) ? 0xFF : 0x00) : rgba[3];
+                    EXPECT_EQ(alpha, pixel[3]);
+                }
+            }
+        }
+    }
+
+    std::shared_ptr<Image> Load(const std::string & file)
+    {
+        std::istringstream stream(file);
+        return ImageLoaderTGA().Load(stream);
+    }
+
+    bool CanLoad(const std::string & file)
+    {
+        std::istringstream stream(file);
+        return ImageLoaderTGA().CanLoad(stream);
+    }
+}
+
+TEST(ImageLoaderTGATest, SwapRedBlue)
+{
+    // Sizes around every vector width, copied and in place.
+    for (u32 pixel_size = 3; pixel_size <= 4; ++pixel_size)
+    {
+        for (u32 count = 0; count < 70; ++count)
+        {
+            std::vector<u8> source(count * pixel_size + 1, 0xEE);
+            for (u32 i = 0; i < count * pixel_size; ++i)
+                source[i] = static_cast<u8>(i * 7 + 1);
+
+            std::vector<u8> copy(source.size(), 0xEE);
+            std::vector<u8> in_place(source);
+            if (pixel_size == 3)
+            {
+                kernels::SwapRedBlue24(source.data(), copy.data(), count);
+                kernels::SwapRedBlue24(in_place.data(), in_place.data(), count);
+            }
+            else
+            {
+                kernels::SwapRedBlue32(source.data(), copy.data(), count);
+                kernels::SwapRedBlue32(in_place.data(), in_place.data(), count);
+            }
+
+            for (u32 i = 0; i < count; ++i)
+            {
+                for (u32 k = 0; k < 3; ++k)
+                {
+                    EXPECT_EQ(source[i * pixel_size + 2 - k], copy[i * pixel_size + k]);
+                    EXPECT_EQ(source[i * pixel_size + 2 - k], in_place[i * pixel_size + k]);
+                }
+                if (pixel_size == 4)
+                {
+                    EXPECT_EQ(source[i * 4 + 3], copy[i * 4 + 3]);
+                    EXPECT_EQ(source[i * 4 + 3], in_place[i * 4 + 3]);
+                }
+            }
+
+            // Nothing written past the end.
+            EXPECT_EQ(0xEE, copy.back());
+            EXPECT_EQ(0xEE, in_place.back());
+        }
+    }
+}
+
+TEST(ImageLoaderTGATest, FillPixels)
+{
+    const u8 pixel[4] = { 1, 2, 3, 4 };
+    for (u32 pixel_size = 1; pixel_size <= 4; ++pixel_size)
+    {
+        for (u32 count = 0; count <= 130; ++count)
+        {
+            std::vector<u8> pixels(count * pixel_size + 1, 0xEE);
+            kernels::FillPixels(pixels.data(), pixel, pixel_size, count);
+
+            for (u32 i = 0; i < count * pixel_size; ++i)
+                ASSERT_EQ(pixel[i % pixel_size], pixels[i]);
+            EXPECT_EQ(0xEE, pixels.back());
+        }
+    }
+}
+
+TEST(ImageLoaderTGATest, FlipRows)
+{
+    for (u32 rows = 0; rows < 6; ++rows)
+    {
+        std::vector<u8> data(rows * 5);
+        for (u32 i = 0; i < data.size(); ++i)
+            data[i] = static_cast<u8>(i);
+
+        kernels::FlipRows(data.data(), 5, rows);
+        for (u32 i = 0; i < data.size(); ++i)
+            EXPECT_EQ((rows - 1 - i / 5) * 5 + i % 5, data[i]);
+    }
+}
+
+TEST(ImageLoaderTGATest, TrueColor)
+{
+    for (u8 image_type = 2; image_type <= 10; image_type += 8)
+    {
+        ExpectColors(*Load(CreateTGA(image_type, 24, 37, 11, false)), 37, 11, 24);
+        ExpectColors(*Load(CreateTGA(image_type, 24, 37, 11, true, 5)), 37, 11, 24);
+        ExpectColors(*Load(CreateTGA(image_type, 24, 1, 1, false)), 1, 1, 24);
+
+        ExpectColors(*Load(CreateTGA(image_type, 32, 300, 9, false, 0, 8)), 300, 9, 32);
+        ExpectColors(*Load(CreateTGA(image_type, 32, 45, 7, true)), 45, 7, 32);
+
+        // 16 bits become 24, or 32 with alpha.
+        ExpectColors(*Load(CreateTGA(image_type, 16, 45, 7, false)), 45, 7, 24, 5);
+        ExpectColors(*Load(CreateTGA(image_type, 16, 45, 7, true, 0, 1)), 45, 7, 32, 5);
+    }
+}
+
+TEST(ImageLoaderTGATest, Grayscale)
+{
+    for (u8 image_type = 3; image_type <= 11; image_type += 8)
+    {
+        ExpectColors(*Load(CreateTGA(image_type, 8, 200, 13, false)), 200, 13, 8);
+        ExpectColors(*Load(CreateTGA(image_type, 8, 3, 2, true, 1)), 3, 2, 8);
+        ExpectColors(*Load(CreateTGA(image_type, 16, 50, 13, false, 0, 8)), 50, 13, 16);
+    }
+}
+
+TEST(ImageLoaderTGATest, Compression)
+{
+    // Runs shrink the flat areas.
+    const std::string raw = CreateTGA(2, 32, 300, 30, false);
+    const std::string compressed = CreateTGA(10, 32, 300, 30, false);
+    EXPECT_LT(compressed.size() * 3, raw.size());
+    EXPECT_EQ(Load(raw)->data, Load(compressed)->data);
+
+    // A packet can't go past the last pixel.
+    std::string overflow = CreateTGA(11, 8, 4, 1, true);
+    overflow.resize(18);
+    overflow += std::string("\x82\x01\x81\x02", 4);
+    EXPECT_THROW(Load(overflow), std::runtime_error *);
+}
+
+TEST(ImageLoaderTGATest, CanLoad)
+{
+    EXPECT_TRUE(CanLoad(CreateTGA(2, 24, 4, 4, false)));
+    EXPECT_TRUE(CanLoad(CreateTGA(10, 32, 4, 4, false)));
+    EXPECT_TRUE(CanLoad(CreateTGA(11, 8, 4, 4, false)));
+
+    EXPECT_FALSE(CanLoad(""));
+    EXPECT_FALSE(CanLoad(CreateTGA(2, 24, 4, 4, false).substr(0, 17)));
+    EXPECT_FALSE(CanLoad("# Blender OBJ File\nv 0.0 1.0 0.0\nv 1.0 0.0 0.0\n"));
+
+    // Colour-mapped, wrong depths, empty, interleaved and mirrored.
+    EXPECT_FALSE(CanLoad(CreateTGA(1, 8, 4, 4, false)));
+    EXPECT_FALSE(CanLoad(CreateTGA(2, 8, 4, 4, false)));
+    EXPECT_FALSE(CanLoad(CreateTGA(3, 24, 4, 4, false)));
+    EXPECT_FALSE(CanLoad(CreateTGA(10, 24, 0, 4, false)));
+    EXPECT_FALSE(CanLoad(CreateTGA(2, 24, 4, 4, false, 0, 0x40)));
+    EXPECT_FALSE(CanLoad(CreateTGA(2, 24, 4, 4, false, 0, 0x10)));
+
+    std::string colour_map = CreateTGA(2, 24, 4, 4, false);
+    colour_map[1] = 1;
+    colour_map[7] = 12;
+    EXPECT_FALSE(CanLoad(colour_map));
+}
+
+TEST(ImageLoaderTGATest, Errors)
+{
+    const std::string file = CreateTGA(2, 24, 8, 8, false);
+    EXPECT_THROW(Load(file.substr(0, file.size() - 1)), std::runtime_error *);
+    EXPECT_THROW(Load(file.substr(0, 10)), std::runtime_error *);
+    EXPECT_THROW(Load(CreateTGA(3, 24, 8, 8, false)), std::runtime_error *);
+
+    // A header asking for much more than the file holds fails before
+    // allocating it.
+    std::string huge = CreateTGA(10, 32, 8, 8, false);
+    huge[12] = huge[13] = huge[14] = huge[15] = '\xFF';
+    EXPECT_THROW(Load(huge), std::runtime_error *);
+}
+
+TEST(ImageLoaderTGATest, Fuzz)
+{
+    const std::string files[] = {
+        CreateTGA(2, 24, 19, 7, false, 3),
+        CreateTGA(10, 32, 60, 9, true),
+        CreateTGA(11, 8, 70, 5, false),
+        CreateTGA(10, 16, 50, 6, false, 0, 1),
+    };
+
+    u32 seed = 12345;
+    for (size_t f = 0; f < sizeof(files) / sizeof(files[0]); ++f)
+    {
+        const std::string & file = files[f];
+
+        // Every truncation fails cleanly.
+        for (size_t size = 0; size < file.size(); ++size)
+        {
+            try
+            {
+                Load(file.substr(0, size));
+                ADD_FAILURE() << "Loaded " << size << " of " << file.size() << " bytes";
+            }
+            catch (std::runtime_error * e)
+            {
+                delete e;
+            }
+        }
+
+        // Random damage either fails cleanly, or gives a whole image.
+        for (u32 i = 0; i < 500; ++i)
+        {
+            std::string damaged(file);
+            for (u32 k = 0; k < 1 + i % 4; ++k)
+            {
+                seed = seed * 1664525 + 1013904223;
+                damaged[(seed >> 8) % damaged.size()] = static_cast<char>(seed >> 24);
+            }
+
+            try
+            {
+                std::shared_ptr<Image> image = Load(damaged);
+                EXPECT_EQ(image->width * image->height * (image->bpp / 8u), image->data.size());
+            }
+            catch (std::runtime_error * e)
+            {
+                delete e;
+            }
+        }
+    }
+}
@@ -0,0 +1,309 @@
+#include "ktx.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#include <GLES2/gl2ext.h>
+
+#include "etc1.h"
+#include "mipmap.h"
+
+using namespace blowgun;
+
+// Utility
+namespace
+{
+    static const byte kIdentifier[12] = {
+        0xAB, 'K', 'T', 'X', ' ', '1', '1', 0xBB, '\r', '\n', 0x1A, '\n' };
+
+    // Written as is, so it reads reversed on a machine of the other
+    // endianness.
+    static const u32 kEndianness = 0x04030201;
+
+    static const u32 kHeaderValueCount = 13;
+
+    struct Header
+    {
+        byte identifier[12];
+        u32  endianness;
+        u32  type;
+        u32  type_size;
+        u32  format;
+        u32  internal_format;
+        u32  base_internal_format;
+        u32  width;
+        u32  height;
+        u32  depth;
+        u32  array_element_count;
+        u32  face_count;
+        u32  level_count;
+        u32  key_value_size;
+    };
+
+    static u32
+    SwapBytes(u32 value)
+    {
+        return (value >> 24) | ((value >> 8) & 0xFF00) | ((value << 8) & 0xFF0000) | (value << 24);
+    }
+
+    static u32
+    Align(u32 offset, u32 alignment)
+    {
+        return (offset + alignment - 1) / alignment * alignment;
+    }
+
+    static void
+    ThrowInvalid(const char * what)
+    {
+        throw new std::runtime_error(std::string("Invalid KTX container: ") + what);
+    }
+
+    static void
+    ThrowUnsupported(const char * what)
+    {
+        throw new std::runtime_error(std::string("Unsupported KTX container: ") + what);
+    }
+
+    // Check that `[offset, offset + size)` is inside a file of
+    // `file_size` bytes, without overflowing.
+    static bool
+    IsInside(u64 offset, u64 size, u64 file_size)
+    {
+        return offset <= file_size && size <= file_size - offset;
+    }
+
+    // Get the size of a pixel of `format` and `type`, in bytes, or zero
+    // for a pair `glTexImage2D` doesn't take.
+    static u32
+    PixelSize(GLenum format, GLenum type)
+    {
+        if (type == GL_UNSIGNED_SHORT_5_6_5 || type == GL_UNSIGNED_SHORT_4_4_4_4 ||
+            type == GL_UNSIGNED_SHORT_5_5_5_1)
+        {
+            return 2;
+        }
+        if (type != GL_UNSIGNED_BYTE)
+            return 0;
+
+        switch (format)
+        {
+        case GL_ALPHA           : return 1;
+        case GL_LUMINANCE       : return 1;
+        case GL_LUMINANCE_ALPHA : return 2;
+        case GL_RGB             : return 3;
+        case GL_RGBA            : return 4;
+        }
+        return 0;
+    }
+
+    // Get how many bytes `glTexImage2D` reads for a level, with rows
+    // padded to the default `GL_UNPACK_ALIGNMENT` of 4: all of them but
+    // the last one.
+    static u64
+    UncompressedDataSize(u32 width, u32 height, u32 pixel_size)
+    {
+        const u64 row_size = static_cast<u64>(width) * pixel_size;
+        return (row_size + 3) / 4 * 4 * (height - 1) + row_size;
+    }
+}
+
+void
+blowgun::WriteKTX(
+    std::ostream & stream,
+    GLenum internal_format,
+    GLenum format,
+    GLenum type,
+    u32 width,
+    u32 height,
+    const std::vector<std::vector<byte>> & levels)
+{
+    Header header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.identifier, kIdentifier, sizeof(kIdentifier));
+    header.endianness           = kEndianness;
+    header.type                 = type;
+    header.type_size            = (type == 0 || type == GL_UNSIGNED_BYTE) ? 1 : 2;
+    header.format               = (type == 0) ? 0 : format;
+    header.internal_format      = internal_format;
+    header.base_internal_format = format;
+    header.width                = width;
+    header.height               = height;
+    header.face_count           = 1;
+    header.level_count          = static_cast<u32>(levels.size());
+    stream.write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+    static const char kPadding[4] = { 0 };
+    for (size_t i = 0; i < levels.size(); ++i)
+    {
+        const u32 size = static_cast<u32>(levels[i].size());
+        stream.write(reinterpret_cast<const char *>(&size), sizeof(size));
+        stream.write(reinterpret_cast<const char *>(levels[i].data()), size);
+        stream.write(kPadding, Align(size, 4) - size);
+    }
+
+    if (!stream)
+        throw new std::runtime_error("Can't write KTX container.");
+}
+
+bool
+blowgun::IsKTX(const char * data, std::size_t size)
+{
+    return size >= sizeof(kIdentifier) &&
+        std::memcmp(data, kIdentifier, sizeof(kIdentifier)) == 0;
+}
+
+KTXFile::KTXFile(const std::string & path) :
+    file_(new MappedFile(path)),
+    internal_format_(0),
+    format_(0),
+    type_(0),
+    width_(0),
+    height_(0),
+    levels_()
+{
+    Parse(file_->data(), file_->size());
+}
+
+KTXFile::KTXFile(const char * data, std::size_t size) :
+    file_(),
+    internal_format_(0),
+    format_(0),
+    type_(0),
+    width_(0),
+    height_(0),
+    levels_()
+{
+    Parse(data, size);
+}
+
+void
+KTXFile::Parse(const char * data, std::size_t size)
+{
+    Header header;
+    if (size < sizeof(header) || !IsKTX(data, size))
+        ThrowInvalid("bad identifier.");
+
+    std::memcpy(&header, data, sizeof(header));
+
+    bool swapped = false;
+    if (header.endianness != kEndianness)
+    {
+        if (SwapBytes(header.endianness) != kEndianness)
+            ThrowInvalid("bad endianness.");
+
+        swapped = true;
+        u32 * values = &header.endianness;
+        for (u32 i = 0; i < kHeaderValueCount; ++i)
+            values[i] = SwapBytes(values[i]);
+
+        // Levels are used in place, so they can't be swapped.
+        if (header.type_size != 1)
+            ThrowUnsupported("pixels of the other endianness.");
+    }
+
+    if (header.height == 0 || header.depth != 0 || header.array_element_count != 0 ||
+        header.face_count != 1)
+    {
+        ThrowUnsupported("not a 2D texture.");
+    }
+    if (header.width == 0)
+        ThrowInvalid("empty texture.");
+
+    // Zero levels asks for mipmaps to be generated: there is only one.
+    const u32 level_count = std::max(1u, header.level_count);
+    if (level_count > MipmapLevelCount(header.width, header.height))
+        ThrowInvalid("too many levels.");
+
+    // Uncompressed levels are uploaded without their size: it must be
+    // checked against what `glTexImage2D` is going to read.
+    const u32 pixel_size = PixelSize(header.base_internal_format, header.type);
+    if (header.type != 0 && pixel_size == 0)
+        ThrowUnsupported("unknown pixel format.");
+
+    internal_format_ = header.internal_format;
+    format_ = header.base_internal_format;
+    type_ = header.type;
+    width_ = header.width;
+    height_ = header.height;
+
+    ///
+    // Levels, each one after its size and padded to 4 bytes.
+    ///
+
+    u64 offset = static_cast<u64>(sizeof(Header)) + header.key_value_size;
+    for (u32 i = 0; i < level_count; ++i)
+    {
+        u32 level_size;
+        if (!IsInside(offset, sizeof(level_size), size))
+            ThrowInvalid("truncated levels.");
+        std::memcpy(&level_size, data + offset, sizeof(level_size));
+        if (swapped)
+            level_size = SwapBytes(level_size);
+        offset += sizeof(level_size);
+
+        if (!IsInside(offset, level_size, size))
+            ThrowInvalid("truncated levels.");
+
+        KTXLevel level;
+        level.width = std::max(1u, width_ >> i);
+        level.height = std::max(1u, height_ >> i);
+        level.data = reinterpret_cast<const byte *>(data + offset);
+        level.size = level_size;
+        if (internal_format_ == GL_ETC1_RGB8_OES &&
+            level.size != ETC1DataSize(level.width, level.height))
+        {
+            ThrowInvalid("bad ETC1 level size.");
+        }
+        if (pixel_size != 0 &&
+            level.size < UncompressedDataSize(level.width, level.height, pixel_size))
+        {
+            ThrowInvalid("level too small.");
+        }
+        levels_.push_back(level);
+
+        offset += Align(level_size, 4);
+    }
+}
+
+GLenum
+KTXFile::internal_format() const
+{
+    return internal_format_;
+}
+
+GLenum
+KTXFile::format() const
+{
+    return format_;
+}
+
+GLenum
+KTXFile::type() const
+{
+    return type_;
+}
+
+bool
+KTXFile::compressed() const
+{
+    return type_ == 0;
+}
+
+u32
+KTXFile::width() const
+{
+    return width_;
+}
+
+u32
+KTXFile::height() const
+{
+    return height_;
+}
+
+const std::vector<KTXLevel> &
+KTXFile::levels() const
+{
+    return levels_;
+}
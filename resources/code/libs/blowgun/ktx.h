@@ -0,0 +1,127 @@
+#ifndef BLOWGUN_KTX_H_
+#define BLOWGUN_KTX_H_
+
+#include <cstddef>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <GLES2/gl2.h>
+
+#include "mapped_file.h"
+#include "types.h"
+
+namespace blowgun
+{
+
+/**
+ * Write a 2D texture as a KTX 1.1 container, without key/value data.
+ *
+ * @param   internal_format
+ *          Format of the texture in OpenGL, such as `GL_RGB`, or
+ *          `GL_ETC1_RGB8_OES` for compressed data.
+ * @param   format
+ *          Format of the pixels, such as `GL_RGB`. For compressed data,
+ *          the format they decompress to.
+ * @param   type
+ *          Type of the pixels, such as `GL_UNSIGNED_BYTE`, or zero for
+ *          compressed data.
+ * @param   levels
+ *          Data of each level of the mipmap chain, from the largest,
+ *          as `glTexImage2D` reads it with a `GL_UNPACK_ALIGNMENT` of 4,
+ *          or as `glCompressedTexImage2D` does.
+ *
+ * Throws when the stream can't be written.
+ */
+void WriteKTX(
+	std::ostream & stream,
+	GLenum internal_format,
+	GLenum format,
+	GLenum type,
+	u32 width,
+	u32 height,
+	const std::vector<std::vector<byte>> & levels);
+
+/**
+ * Check whether `data` starts like a KTX container.
+ */
+bool IsKTX(const char * data, std::size_t size);
+
+/**
+ * Level of the mipmap chain of a `KTXFile`.
+ */
+struct KTXLevel
+{
+	u32          width;
+	u32          height;
+	const byte * data;
+	u32          size;
+};
+
+/**
+ * Read-only view of a KTX 1.1 container of a 2D texture. The header is
+ * checked once, and the levels are then used in place: they can be
+ * handed to `glCompressedTexImage2D`, or to `TextureBuilder::SetKTX`,
+ * without any copy.
+ *
+ * Arrays, cube maps and 3D textures aren't supported. Neither are
+ * containers written on a machine of the other endianness, unless
+ * their data is made of bytes, as compressed data is. Uncompressed
+ * pixels must be of a format and type OpenGL ES 2.0 takes, and each
+ * level hold as many bytes as `glTexImage2D` reads.
+ */
+class KTXFile
+{
+private:
+	std::unique_ptr<MappedFile> file_;
+
+	GLenum                internal_format_;
+	GLenum                format_;
+	GLenum                type_;
+	u32                   width_;
+	u32                   height_;
+	std::vector<KTXLevel> levels_;
+
+	void Parse(const char * data, std::size_t size);
+
+	// Disallow copy and assign.
+	KTXFile(const KTXFile & rhs);
+	KTXFile & operator=(const KTXFile & rhs);
+
+public:
+	/**
+	 * Map the KTX container at `path`. Throws when the file can't be
+	 * mapped or isn't a supported KTX container.
+	 */
+	explicit KTXFile(const std::string & path);
+
+	/**
+	 * View the KTX container in `[data, data + size)`, which must stay
+	 * valid for the lifetime of the view. Throws when it isn't a
+	 * supported KTX container.
+	 */
+	KTXFile(const char * data, std::size_t size);
+
+	/**
+	 * Get the formats, as given to `WriteKTX`: for compressed data,
+	 * `type` is zero and `format` is the format it decompresses to.
+	 */
+	GLenum internal_format() const;
+	GLenum format() const;
+	GLenum type() const;
+	bool compressed() const;
+
+	u32 width() const;
+	u32 height() const;
+
+	/**
+	 * Get the levels of the mipmap chain, from the largest. There is at
+	 * least one.
+	 */
+	const std::vector<KTXLevel> & levels() const;
+};
+
+}
+
+#endif // BLOWGUN_KTX_H_
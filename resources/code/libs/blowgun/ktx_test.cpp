@@ -0,0 +1,200 @@
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <GLES2/gl2.h>
+#include <GLES2/gl2ext.h>
+
+#include <gtest/gtest.h>
+#include "etc1.h"
+#include "ktx.h"
+
+using namespace blowgun;
+
+namespace
+{
+    // Offsets of some values of the header.
+    static const u32 kEndiannessOffset = 12;
+    static const u32 kTypeSizeOffset = 20;
+    static const u32 kFaceCountOffset = 52;
+    static const u32 kLevelCountOffset = 56;
+    static const u32 kHeaderSize = 64;
+
+    // ETC1 levels of an 8x8 texture, with distinct bytes.
+    std::vector<std::vector<byte>> ETC1Levels()
+    {
+        std::vector<std::vector<byte>> levels;
+        for (u32 size = 8; size > 0; size /= 2)
+        {
+            levels.push_back(std::vector<byte>(ETC1DataSize(size, size)));
+            for (size_t i = 0; i < levels.back().size(); ++i)
+                levels.back()[i] = static_cast<byte>(size + i);
+        }
+        return levels;
+    }
+
+    std::string Write(GLenum internal_format, GLenum format, GLenum type, u32 width, u32 height,
+        const std::vector<std::vector<byte>> & levels)
+    {
+        std::ostringstream stream(std::ios::out | std::ios::binary);
+        WriteKTX(stream, internal_format, format, type, width, height, levels);
+        return stream.str();
+    }
+
+    void SetValue(std::string & data, u32 offset, u32 value)
+    {
+        std::memcpy(&data[offset], &value, sizeof(value));
+    }
+
+    // Reverse the bytes of the value at `offset`.
+    void Swap(std::string & data, u32 offset)
+    {
+        std::swap(data[offset], data[offset + 3]);
+        std::swap(data[offset + 1], data[offset + 2]);
+    }
+
+    bool IsValid(const std::string & data)
+    {
+        try
+        {
+            KTXFile file(data.data(), data.size());
+            return true;
+        }
+        catch (std::runtime_error * error)
+        {
+            delete error;
+            return false;
+        }
+    }
+
+    void ExpectLevels(const KTXFile & file, const std::vector<std::vector<byte>> & levels)
+    {
+        ASSERT_EQ(levels.size(), file.levels().size());
+        for (size_t i = 0; i < levels.size(); ++i)
+        {
+            const KTXLevel & level = file.levels()[i];
+            EXPECT_EQ(file.width() >> i, level.width);
+            EXPECT_EQ(levels[i].size(), level.size);
+            EXPECT_EQ(0, std::memcmp(levels[i].data(), level.data, level.size));
+            EXPECT_EQ(0u, reinterpret_cast<size_t>(level.data) % 4);
+        }
+    }
+}
+
+TEST(KTXTest, Compressed)
+{
+    const std::vector<std::vector<byte>> levels = ETC1Levels();
+    const std::string data = Write(GL_ETC1_RGB8_OES, GL_RGB, 0, 8, 8, levels);
+    EXPECT_TRUE(IsKTX(data.data(), data.size()));
+
+    KTXFile file(data.data(), data.size());
+    EXPECT_TRUE(file.compressed());
+    EXPECT_EQ(static_cast<GLenum>(GL_ETC1_RGB8_OES), file.internal_format());
+    EXPECT_EQ(static_cast<GLenum>(GL_RGB), file.format());
+    EXPECT_EQ(8u, file.width());
+    EXPECT_EQ(8u, file.height());
+    ExpectLevels(file, levels);
+
+    // Used in place.
+    EXPECT_EQ(data.data() + kHeaderSize + 4, reinterpret_cast<const char *>(file.levels()[0].data));
+
+    // Written on a machine of the other endianness.
+    std::string swapped = data;
+    for (u32 offset = kEndiannessOffset; offset < kHeaderSize; offset += 4)
+        Swap(swapped, offset);
+    for (u32 i = 0, offset = kHeaderSize; i < levels.size(); ++i)
+    {
+        Swap(swapped, offset);
+        offset += 4 + static_cast<u32>(levels[i].size());
+    }
+    KTXFile swapped_file(swapped.data(), swapped.size());
+    EXPECT_EQ(static_cast<GLenum>(GL_ETC1_RGB8_OES), swapped_file.internal_format());
+    ExpectLevels(swapped_file, levels);
+}
+
+TEST(KTXTest, Uncompressed)
+{
+    // Rows of 3 bytes are padded to 4, and so are levels.
+    std::vector<std::vector<byte>> levels;
+    levels.push_back(std::vector<byte>(8, 1));
+    levels.push_back(std::vector<byte>(1, 2));
+
+    const std::string path = "ktx_test.ktx";
+    {
+        std::ofstream stream(path.c_str(), std::ios::out | std::ios::binary);
+        WriteKTX(stream, GL_LUMINANCE, GL_LUMINANCE, GL_UNSIGNED_BYTE, 3, 2, levels);
+    }
+
+    {
+        KTXFile file(path);
+        EXPECT_FALSE(file.compressed());
+        EXPECT_EQ(static_cast<GLenum>(GL_LUMINANCE), file.format());
+        EXPECT_EQ(static_cast<GLenum>(GL_UNSIGNED_BYTE), file.type());
+        EXPECT_EQ(3u, file.width());
+        EXPECT_EQ(2u, file.height());
+        ExpectLevels(file, levels);
+        EXPECT_EQ(1u, file.levels()[1].height);
+    }
+
+    std::remove(path.c_str());
+}
+
+TEST(KTXTest, Errors)
+{
+    const std::string data = Write(GL_ETC1_RGB8_OES, GL_RGB, 0, 8, 8, ETC1Levels());
+    EXPECT_TRUE(IsValid(data));
+
+    for (size_t size = 0; size < data.size(); ++size)
+        EXPECT_FALSE(IsValid(data.substr(0, size)));
+
+    std::string invalid = data;
+    invalid[1] = 'X';
+    EXPECT_FALSE(IsKTX(invalid.data(), invalid.size()));
+    EXPECT_FALSE(IsValid(invalid));
+
+    invalid = data;
+    SetValue(invalid, kEndiannessOffset, 0x04030102);
+    EXPECT_FALSE(IsValid(invalid));
+
+    invalid = data;
+    SetValue(invalid, kFaceCountOffset, 6);
+    EXPECT_FALSE(IsValid(invalid));
+
+    invalid = data;
+    SetValue(invalid, kLevelCountOffset, 5);
+    EXPECT_FALSE(IsValid(invalid));
+
+    // Pixels of 16 bits of the other endianness would need a copy.
+    invalid = data;
+    SetValue(invalid, kTypeSizeOffset, 2);
+    for (u32 offset = kEndiannessOffset; offset < kHeaderSize; offset += 4)
+        Swap(invalid, offset);
+    EXPECT_FALSE(IsValid(invalid));
+
+    // ETC1 levels of the wrong size.
+    std::vector<std::vector<byte>> levels = ETC1Levels();
+    levels[1].resize(16);
+    EXPECT_FALSE(IsValid(Write(GL_ETC1_RGB8_OES, GL_RGB, 0, 8, 8, levels)));
+
+    // Uncompressed levels shorter than what `glTexImage2D` reads: rows
+    // of 6 bytes padded to 8, but the last one.
+    levels.clear();
+    levels.push_back(std::vector<byte>(8 * 2 + 6));
+    levels.push_back(std::vector<byte>(2));
+    EXPECT_TRUE(IsValid(Write(GL_RGB, GL_RGB, GL_UNSIGNED_SHORT_5_6_5, 3, 3, levels)));
+    levels[0].resize(8 * 2 + 5);
+    EXPECT_FALSE(IsValid(Write(GL_RGB, GL_RGB, GL_UNSIGNED_SHORT_5_6_5, 3, 3, levels)));
+    levels[0].resize(8 * 2 + 6);
+    levels[1].resize(1);
+    EXPECT_FALSE(IsValid(Write(GL_RGB, GL_RGB, GL_UNSIGNED_SHORT_5_6_5, 3, 3, levels)));
+
+    // Pixels whose size is unknown.
+    levels.pop_back();
+    EXPECT_FALSE(IsValid(Write(GL_RGB, GL_RGB, GL_FLOAT, 3, 3, levels)));
+
+    EXPECT_THROW(KTXFile("data/missing.ktx"), std::runtime_error *);
+}
@@ -0,0 +1,66 @@
+#include "mapped_file.h"
+
+#if defined(__linux__)
+
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace blowgun;
+
+MappedFile::MappedFile(const std::string & path) :
+    data_(nullptr), size_(0)
+{
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        throw new std::runtime_error("Can't open " + path);
+
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) != 0)
+    {
+        close(fd);
+        throw new std::runtime_error("Can't read the size of " + path);
+    }
+
+    // Mapping zero bytes is an error, while an empty file is not.
+    size_ = static_cast<std::size_t>(file_stat.st_size);
+    if (size_ > 0)
+    {
+        void * data = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED)
+        {
+            close(fd);
+            throw new std::runtime_error("Can't map " + path);
+        }
+
+        // The whole file is about to be read from start to end.
+        madvise(data, size_, MADV_SEQUENTIAL);
+        data_ = static_cast<const char *>(data);
+    }
+
+    // The mapping keeps the file alive on its own.
+    close(fd);
+}
+
+MappedFile::~MappedFile()
+{
+    if (data_)
+        munmap(const_cast<char *>(data_), size_);
+}
+
+const char *
+MappedFile::data() const
+{
+    return data_;
+}
+
+std::size_t
+MappedFile::size() const
+{
+    return size_;
+}
+
+#endif // defined(__linux__)
@@ -0,0 +1,65 @@
+#include "mapped_file.h"
+
+#ifdef WIN32
+
+#include <stdexcept>
+
+#include <windows.h>
+
+using namespace blowgun;
+
+MappedFile::MappedFile(const std::string & path) :
+    data_(nullptr), size_(0)
+{
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ,
+        NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+        throw new std::runtime_error("Can't open " + path);
+
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file, &file_size))
+    {
+        CloseHandle(file);
+        throw new std::runtime_error("Can't read the size of " + path);
+    }
+
+    // Mapping zero bytes is an error, while an empty file is not.
+    size_ = static_cast<std::size_t>(file_size.QuadPart);
+    if (size_ > 0)
+    {
+        HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+        void * data = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : NULL;
+
+        // The view keeps the file alive on its own.
+        if (mapping)
+            CloseHandle(mapping);
+        if (!data)
+        {
+            CloseHandle(file);
+            throw new std::runtime_error("Can't map " + path);
+        }
+        data_ = static_cast<const char *>(data);
+    }
+
+    CloseHandle(file);
+}
+
+MappedFile::~MappedFile()
+{
+    if (data_)
+        UnmapViewOfFile(data_);
+}
+
+const char *
+MappedFile::data() const
+{
+    return data_;
+}
+
+std::size_t
+MappedFile::size() const
+{
+    return size_;
+}
+
+#endif // WIN32
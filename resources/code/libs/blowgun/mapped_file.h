@@ -0,0 +1,43 @@
+#ifndef BLOWGUN_MAPPED_FILE_H_
+#define BLOWGUN_MAPPED_FILE_H_
+
+#include <cstddef>
+#include <string>
+
+namespace blowgun
+{
+
+/**
+ * Read-only, memory-mapped view of a whole file.
+ *
+ * Nothing is copied: pages are read in by the OS as the data gets
+ * touched. The view stays valid for the lifetime of the object.
+ */
+class MappedFile
+{
+private:
+	const char * data_;
+	std::size_t  size_;
+
+	// Disallow copy and assign.
+	MappedFile(const MappedFile & rhs);
+	MappedFile & operator=(const MappedFile & rhs);
+
+public:
+	/**
+	 * Map the file at `path`. Throws when it can't be opened or
+	 * mapped.
+	 */
+	explicit MappedFile(const std::string & path);
+	~MappedFile();
+
+	/**
+	 * Get the content of the file. Null when the file is empty.
+	 */
+	const char * data() const;
+	std::size_t size() const;
+};
+
+}
+
+#endif // BLOWGUN_MAPPED_FILE_H_
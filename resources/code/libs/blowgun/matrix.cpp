@@ -1,5 +1,9 @@
 #include "matrix.h"
 
+#include "matrix_kernels.h"
+#include "quaternion.h"
+#include "vector.h"
+
 #include <stdexcept>
 #include <iostream>
 
@@ -21,11 +25,15 @@ namespace
     }
 }
 
-Matrix::Matrix(const std::vector<float> values)
-    : values_(values)
+Matrix::Matrix(Uninitialized)
 {
 }
 
+Matrix::Matrix(const float * values)
+{
+    std::memcpy(values_, values, sizeof(values_));
+}
+
 const float *
 Matrix::values() const
 {
@@ -35,74 +43,25 @@ Matrix::values() const
 const Matrix
 Matrix::Multiply(const Matrix & other) const
 {
-    std::vector<float> result_values(16);
-
-    for (u32 i = 0; i < kColumnCount; ++i)
-    {
-        for (u32 j = 0; j < kColumnCount; ++j)
-        {
-            result_values[Index(i,j)] = 0.0f;
-            for (u32 k = 0; k < kColumnCount; ++k)
-            {
-                result_values[Index(i,j)] +=
-                    values_[Index(i,k)] * other.values_[Index(k,j)];
-            }
-        }
-    }
-
-    return Matrix(result_values);
+    Matrix result(kUninitialized);
+    kernels::Multiply(values_, other.values_, result.values_);
+    return result;
 }
 
 const Matrix
 Matrix::Scale (float factor_x, float factor_y, float factor_z) const
 {
-    std::vector<float> result_values(values_);
-
-    result_values[Index(0,0)] *= factor_x;
-    result_values[Index(0,1)] *= factor_x;
-    result_values[Index(0,2)] *= factor_x;
-
-    result_values[Index(1,0)] *= factor_y;
-    result_values[Index(1,1)] *= factor_y;
-    result_values[Index(1,2)] *= factor_y;
-
-    result_values[Index(2,0)] *= factor_z;
-    result_values[Index(2,1)] *= factor_z;
-    result_values[Index(2,2)] *= factor_z;
-
-    return Matrix(result_values);
+    Matrix result(kUninitialized);
+    kernels::Scale(values_, factor_x, factor_y, factor_z, result.values_);
+    return result;
 }
 
 const Matrix
 Matrix::Translate(float factor_x, float factor_y, float factor_z) const
 {
-    std::vector<float> result_values(values_);
-
-    result_values[Index(3,0)] += (
-        result_values[Index(0,0)] * factor_x +
-        result_values[Index(1,0)] * factor_y +
-        result_values[Index(2,0)] * factor_z
-        );
-
-    result_values[Index(3,1)] += (
-        result_values[Index(0,1)] * factor_x +
-        result_values[Index(1,1)] * factor_y +
-        result_values[Index(2,1)] * factor_z
-        );
-
-    result_values[Index(3,2)] += (
-        result_values[Index(0,2)] * factor_x +
-        result_values[Index(1,2)] * factor_y +
-        result_values[Index(2,2)] * factor_z
-        );
-
-    result_values[Index(3,3)] += (
-        result_values[Index(0,3)] * factor_x +
-        result_values[Index(1,3)] * factor_y +
-        result_values[Index(2,3)] * factor_z
-        );
-
-    return Matrix(result_values);
+    Matrix result(kUninitialized);
+    kernels::Translate(values_, factor_x, factor_y, factor_z, result.values_);
+    return result;
 }
 
 const Matrix
@@ -122,7 +81,6 @@ Matrix::Rotate(float angle,
     {
         float xx, yy, zz, xy, yz, zx, xs, ys, zs;
         float one_minus_cos;
-        std::vector<float> rotation_values(16);
 
         axis_x /= mag;
         axis_y /= mag;
@@ -139,28 +97,26 @@ Matrix::Rotate(float angle,
         zs = axis_z * sin_angle;
         one_minus_cos = 1.0f - cos_angle;
 
-        rotation_values[Index(0,0)] = (one_minus_cos * xx) + cos_angle;
-        rotation_values[Index(0,1)] = (one_minus_cos * xy) - zs;
-        rotation_values[Index(0,2)] = (one_minus_cos * zx) + ys;
-        rotation_values[Index(0,3)] = 0.0f;
-
-        rotation_values[Index(1,0)] = (one_minus_cos * xy) + zs;
-        rotation_values[Index(1,1)] = (one_minus_cos * yy) + cos_angle;
-        rotation_values[Index(1,2)] = (one_minus_cos * yz) - xs;
-        rotation_values[Index(1,3)] = 0.0f;
-
-        rotation_values[Index(2,0)] = (one_minus_cos * zx) - ys;
-        rotation_values[Index(2,1)] = (one_minus_cos * yz) + xs;
-        rotation_values[Index(2,2)] = (one_minus_cos * zz) + cos_angle;
-        rotation_values[Index(2,3)] = 0.0f;
-
-        rotation_values[Index(3,0)] = 0.0f;
-        rotation_values[Index(3,1)] = 0.0f;
-        rotation_values[Index(3,2)] = 0.0f;
-        rotation_values[Index(3,3)] = 1.0f;
-
-        Matrix rotation(rotation_values);
-        return rotation.Multiply(*this);
+        // Only the upper-left 3x3 part of a rotation matrix is
+        // interesting, the rest of it is identity.
+        const float rotation_values[9] =
+        {
+            (one_minus_cos * xx) + cos_angle,
+            (one_minus_cos * xy) - zs,
+            (one_minus_cos * zx) + ys,
+
+            (one_minus_cos * xy) + zs,
+            (one_minus_cos * yy) + cos_angle,
+            (one_minus_cos * yz) - xs,
+
+            (one_minus_cos * zx) - ys,
+            (one_minus_cos * yz) + xs,
+            (one_minus_cos * zz) + cos_angle
+        };
+
+        Matrix result(kUninitialized);
+        kernels::MultiplyLinear3(rotation_values, values_, result.values_);
+        return result;
     }
 
     return *this;
@@ -170,7 +126,7 @@ const Matrix
 Matrix::Frustum(float left, float right, float bottom, float top,
     float near_z, float far_z) const
 {
-    std::vector<float> frustum_values(16);
+    float frustum_values[16];
 
     float delta_x = right - left;
     float delta_y = top - bottom;
@@ -200,8 +156,9 @@ Matrix::Frustum(float left, float right, float bottom, float top,
         frustum_values[Index(3,1)] =
             frustum_values[Index(3,3)] = 0.0f;
 
-    Matrix frustum(frustum_values);
-    return frustum.Multiply(*this);
+    Matrix result(kUninitialized);
+    kernels::Multiply(frustum_values, values_, result.values_);
+    return result;
 }
 
 const Matrix
@@ -218,6 +175,79 @@ Matrix::Perspective(float fov_y, float aspect,
         );
 }
 
+const Matrix
+Matrix::Transpose() const
+{
+    Matrix result(kUninitialized);
+    kernels::Transpose(values_, result.values_);
+    return result;
+}
+
+const Matrix
+Matrix::Inverse() const
+{
+    Matrix result(kUninitialized);
+    if (!kernels::Inverse(values_, result.values_))
+        throw new std::runtime_error("Matrix is not invertible.");
+    return result;
+}
+
+const Matrix
+Matrix::AffineInverse() const
+{
+    Matrix result(kUninitialized);
+    if (!kernels::AffineInverse(values_, result.values_))
+        throw new std::runtime_error("Matrix is not invertible.");
+    return result;
+}
+
+void
+Matrix::InverseTranspose3x3(float * out) const
+{
+    if (!kernels::InverseTranspose3x3(values_, out))
+        throw new std::runtime_error("Matrix is not invertible.");
+}
+
+const Vec3
+Matrix::Unproject(const Vec3 & window,
+    float viewport_x, float viewport_y,
+    float viewport_width, float viewport_height) const
+{
+    using namespace simd;
+
+    const Matrix inverse = Inverse();
+    const float * m = inverse.values_;
+
+    // Window coordinates to normalized device coordinates.
+    float ndc_x = 2.0f * (window.x - viewport_x) / viewport_width - 1.0f;
+    float ndc_y = 2.0f * (window.y - viewport_y) / viewport_height - 1.0f;
+    float ndc_z = 2.0f * window.z - 1.0f;
+
+    Float4 point = Load(m + 12);
+    point = MulAdd(Splat(ndc_x), Load(m + 0), point);
+    point = MulAdd(Splat(ndc_y), Load(m + 4), point);
+    point = MulAdd(Splat(ndc_z), Load(m + 8), point);
+
+    BLOWGUN_ALIGN(16) float result[4];
+    Store(result, point);
+
+    if (result[3] == 0.0f)
+        throw new std::runtime_error("Point can't be unprojected.");
+
+    return Vec3(result[0] / result[3], result[1] / result[3], result[2] / result[3]);
+}
+
+const Matrix
+Matrix::Rotate(const Quat & rotation) const
+{
+    float rotation_values[9];
+    rotation.ToRotation3(rotation_values);
+
+    Matrix result(kUninitialized);
+    kernels::MultiplyLinear3(rotation_values, values_, result.values_);
+    return result;
+}
+
 void
 Matrix::Print()
 {
@@ -235,21 +265,34 @@ Matrix::Print()
 }
 
 Matrix
-Matrix::CreateIdentity()
+Matrix::CreateTransform(const Vec3 & translation, const Quat & rotation,
+    const Vec3 & scale)
 {
-    // It would be nicer if MSVC supported initializer-list.
-    // Until they do, let's use the cumbersome vector initialization.
-    float identity_f[] =
-    {
-        1.0f, 0, 0, 0,
-        0, 1.0f, 0, 0,
-        0, 0, 1.0f, 0,
-        0, 0, 0, 1.0f
-    };
-    std::vector<float> identity_values(
-        identity_f,
-        identity_f + sizeof(identity_f) / sizeof(float)
-        );
+    float r[9];
+    rotation.ToRotation3(r);
+
+    Matrix result(kUninitialized);
+    float * m = result.values_;
+
+    m[Index(0,0)] = r[0] * scale.x;
+    m[Index(0,1)] = r[1] * scale.x;
+    m[Index(0,2)] = r[2] * scale.x;
+    m[Index(0,3)] = 0.0f;
+
+    m[Index(1,0)] = r[3] * scale.y;
+    m[Index(1,1)] = r[4] * scale.y;
+    m[Index(1,2)] = r[5] * scale.y;
+    m[Index(1,3)] = 0.0f;
+
+    m[Index(2,0)] = r[6] * scale.z;
+    m[Index(2,1)] = r[7] * scale.z;
+    m[Index(2,2)] = r[8] * scale.z;
+    m[Index(2,3)] = 0.0f;
+
+    m[Index(3,0)] = translation.x;
+    m[Index(3,1)] = translation.y;
+    m[Index(3,2)] = translation.z;
+    m[Index(3,3)] = 1.0f;
 
-    return Matrix(identity_values);
+    return result;
 }
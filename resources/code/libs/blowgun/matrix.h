@@ -2,27 +2,137 @@
 #define BLOWGUN_MATRIX_H_
 
 #include "types.h"
+#include "compiler.h"
+#include "simd.h"
 
-#include <vector>
+#include <stdexcept>
 
 namespace blowgun
 {
 
+namespace detail
+{
+	// Taylor series of sin(x) and cos(x), usable at compile time.
+	// Precise enough for the angles a projection works with.
+	inline BLOWGUN_CONSTEXPR double SinSeries(double x2, double term, int n)
+	{
+		return n > 12 ? 0.0 : term + SinSeries(x2, -term * x2 / ((2 * n) * (2 * n + 1)), n + 1);
+	}
+
+	inline BLOWGUN_CONSTEXPR double CosSeries(double x2, double term, int n)
+	{
+		return n > 12 ? 0.0 : term + CosSeries(x2, -term * x2 / ((2 * n - 1) * (2 * n)), n + 1);
+	}
+
+	inline BLOWGUN_CONSTEXPR double Tan(double x)
+	{
+		return SinSeries(x * x, x, 1) / CosSeries(x * x, 1.0, 1);
+	}
+}
+
+struct Vec3;
+struct Quat;
+
+/**
+ * 4x4 matrix of floats.
+ *
+ * Matrix is a plain value type: it lives entirely inside the object
+ * (no heap allocation), it is 16-byte aligned, and it can be freely
+ * copied and assigned.
+ */
 class Matrix
 {
 private:
-	const std::vector<float> values_;
+	BLOWGUN_ALIGN(16) float values_[16];
 
-	// Private constructor is used in order to keep the data type
-	// for Matrix's value private.
-	explicit Matrix(const std::vector<float> values);
+	// Used by the operations below, which overwrite every value
+	// anyway, to skip the identity initialization.
+	enum Uninitialized { kUninitialized };
+	explicit Matrix(Uninitialized);
 
-private:
-	// Disallow assignment.
-	Matrix & operator=(const Matrix &);
+	static BLOWGUN_CONSTEXPR float ProductValue(const Matrix & a, const Matrix & b, u32 row, u32 column)
+	{
+		return
+			a.values_[4 * row + 0] * b.values_[0 + column] +
+			a.values_[4 * row + 1] * b.values_[4 + column] +
+			a.values_[4 * row + 2] * b.values_[8 + column] +
+			a.values_[4 * row + 3] * b.values_[12 + column];
+	}
+
+	friend class TransformChain;
+
+	static BLOWGUN_CONSTEXPR Matrix CreatePerspectiveFromHeight(float frustum_h, float aspect, float near_z, float far_z)
+	{
+		return CreateFrustum(
+			-frustum_h * aspect, frustum_h * aspect, -frustum_h, frustum_h, near_z, far_z);
+	}
 
 public:
 
+	/**
+	 * Create identity matrix.
+	 */
+#if BLOWGUN_HAS_CONSTEXPR
+	BLOWGUN_CONSTEXPR Matrix() :
+		values_{
+			1.0f, 0, 0, 0,
+			0, 1.0f, 0, 0,
+			0, 0, 1.0f, 0,
+			0, 0, 0, 1.0f }
+	{
+	}
+#else
+	// No brace initialization of member arrays either.
+	Matrix()
+	{
+		values_[0]  = 1.0f; values_[1]  = 0;    values_[2]  = 0;    values_[3]  = 0;
+		values_[4]  = 0;    values_[5]  = 1.0f; values_[6]  = 0;    values_[7]  = 0;
+		values_[8]  = 0;    values_[9]  = 0;    values_[10] = 1.0f; values_[11] = 0;
+		values_[12] = 0;    values_[13] = 0;    values_[14] = 0;    values_[15] = 1.0f;
+	}
+#endif
+
+	/**
+	 * Create a Matrix from 16 floats, laid out the same way as the
+	 * array returned by `values()`.
+	 */
+	explicit Matrix(const float * values);
+
+	/**
+	 * Same as above, with each value passed separately. Usable at
+	 * compile time.
+	 */
+	BLOWGUN_CONSTEXPR Matrix(
+		float v0,  float v1,  float v2,  float v3,
+		float v4,  float v5,  float v6,  float v7,
+		float v8,  float v9,  float v10, float v11,
+		float v12, float v13, float v14, float v15)
+#if BLOWGUN_HAS_CONSTEXPR
+		: values_{
+			v0,  v1,  v2,  v3,
+			v4,  v5,  v6,  v7,
+			v8,  v9,  v10, v11,
+			v12, v13, v14, v15 }
+	{
+	}
+#else
+	{
+		values_[0]  = v0;  values_[1]  = v1;  values_[2]  = v2;  values_[3]  = v3;
+		values_[4]  = v4;  values_[5]  = v5;  values_[6]  = v6;  values_[7]  = v7;
+		values_[8]  = v8;  values_[9]  = v9;  values_[10] = v10; values_[11] = v11;
+		values_[12] = v12; values_[13] = v13; values_[14] = v14; values_[15] = v15;
+	}
+#endif
+
+	/**
+	 * Get a single value, in the same order as `values()`. Usable at
+	 * compile time.
+	 */
+	BLOWGUN_CONSTEXPR float value(u32 index) const
+	{
+		return values_[index];
+	}
+
 	/**
 	 * Get the raw values of the Matrix.
 	 *
@@ -38,15 +148,135 @@ public:
 	const Matrix Rotate(float angle, float axis_x, float axis_y, float axis_z) const;
 	const Matrix Frustum(float left, float right, float bottom, float top, float near_z, float far_z) const;
 	const Matrix Perspective(float fov_y, float aspect, float near_z, float far_z) const;
+	const Matrix Transpose() const;
+
+	/**
+	 * Get the inverse of the Matrix.
+	 *
+	 * Throws when the Matrix has no inverse.
+	 */
+	const Matrix Inverse() const;
+
+	/**
+	 * Same as `Inverse`, but only for matrices made of translations,
+	 * rotations and scales (no projection). Only the 3x3 linear part
+	 * gets inverted, which is a lot cheaper.
+	 *
+	 * Throws when the Matrix has no inverse.
+	 */
+	const Matrix AffineInverse() const;
+
+	/**
+	 * Write the inverse transpose of the upper-left 3x3 part, i.e.
+	 * the normal matrix of a model-view Matrix, into `out` as 9
+	 * floats ready for `glUniformMatrix3fv`.
+	 *
+	 * Throws when that part has no inverse.
+	 */
+	void InverseTranspose3x3(float * out) const;
+
+	/**
+	 * Map window coordinates back to object coordinates, the same way
+	 * `gluUnProject` does. The Matrix has to be the PMV matrix the
+	 * object was drawn with; the viewport is the one given to
+	 * `glViewport`, and `window.z` is the depth, between 0 and 1.
+	 *
+	 * Throws when the PMV matrix has no inverse.
+	 */
+	const Vec3 Unproject(const Vec3 & window,
+		float viewport_x, float viewport_y,
+		float viewport_width, float viewport_height) const;
+
+	/**
+	 * Rotate by a quaternion.
+	 *
+	 * `m.Rotate(q)` gives the same result as `q.ToMatrix().Multiply(m)`,
+	 * but only costs a 3x3 product.
+	 */
+	const Matrix Rotate(const Quat & rotation) const;
 
 	void Print();
 
 	/**
 	 * Create identity matrix.
 	 */
-	static Matrix CreateIdentity();
+	static BLOWGUN_CONSTEXPR Matrix CreateIdentity()
+	{
+		return Matrix();
+	}
+
+	/*
+	 * The builders below give the same results as calling the
+	 * matching operation on the identity matrix, e.g.
+	 * `CreateTranslation(x, y, z)` equals `Matrix().Translate(x, y, z)`.
+	 *
+	 * They can be evaluated at compile time, so a transform built out
+	 * of constants ends up as read-only data, e.g.:
+	 *
+	 *     static BLOWGUN_CONSTEXPR const Matrix kProjection =
+	 *         Matrix::CreatePerspective(60.0f, 4.0f / 3.0f, 1.0f, 20.0f);
+	 */
+
+	static BLOWGUN_CONSTEXPR Matrix CreateTranslation(float x, float y, float z)
+	{
+		return Matrix(
+			1.0f, 0, 0, 0,
+			0, 1.0f, 0, 0,
+			0, 0, 1.0f, 0,
+			x, y, z, 1.0f);
+	}
+
+	static BLOWGUN_CONSTEXPR Matrix CreateScale(float x, float y, float z)
+	{
+		return Matrix(
+			x, 0, 0, 0,
+			0, y, 0, 0,
+			0, 0, z, 0,
+			0, 0, 0, 1.0f);
+	}
+
+	static BLOWGUN_CONSTEXPR Matrix CreateFrustum(float left, float right, float bottom, float top, float near_z, float far_z)
+	{
+		return ((near_z <= 0.0f) || (far_z <= 0.0f) ||
+				(right - left <= 0.0f) || (top - bottom <= 0.0f) || (far_z - near_z <= 0.0f))
+			? throw new std::runtime_error("Invalid input parameter.")
+			: Matrix(
+				2.0f * near_z / (right - left), 0, 0, 0,
+				0, 2.0f * near_z / (top - bottom), 0, 0,
+				(right + left) / (right - left), (top + bottom) / (top - bottom), -(near_z + far_z) / (far_z - near_z), -1.0f,
+				0, 0, -2.0f * near_z * far_z / (far_z - near_z), 0);
+	}
+
+	static BLOWGUN_CONSTEXPR Matrix CreatePerspective(float fov_y, float aspect, float near_z, float far_z)
+	{
+		return CreatePerspectiveFromHeight(
+			static_cast<float>(detail::Tan(fov_y / 360.0 * 3.1415926535897932384626433832795)) * near_z,
+			aspect, near_z, far_z);
+	}
+
+	/**
+	 * Compute `a.Multiply(b)`. Slower than `Multiply`, but usable at
+	 * compile time.
+	 */
+	static BLOWGUN_CONSTEXPR Matrix CreateProduct(const Matrix & a, const Matrix & b)
+	{
+		return Matrix(
+			ProductValue(a, b, 0, 0), ProductValue(a, b, 0, 1), ProductValue(a, b, 0, 2), ProductValue(a, b, 0, 3),
+			ProductValue(a, b, 1, 0), ProductValue(a, b, 1, 1), ProductValue(a, b, 1, 2), ProductValue(a, b, 1, 3),
+			ProductValue(a, b, 2, 0), ProductValue(a, b, 2, 1), ProductValue(a, b, 2, 2), ProductValue(a, b, 2, 3),
+			ProductValue(a, b, 3, 0), ProductValue(a, b, 3, 1), ProductValue(a, b, 3, 2), ProductValue(a, b, 3, 3));
+	}
+
+	/**
+	 * Create a transform that scales, then rotates, then translates.
+	 *
+	 * The result is the same as
+	 * `Matrix().Translate(t).Rotate(r).Scale(s)`, but it is written
+	 * in a single pass without any matrix product.
+	 */
+	static Matrix CreateTransform(const Vec3 & translation, const Quat & rotation, const Vec3 & scale);
 };
-	
+
 }
 
 #endif // of BLOWGUN_MATRIX_H_
@@ -0,0 +1,271 @@
+#include "matrix_batch.h"
+
+#include <stdexcept>
+#include <type_traits>
+
+#include "matrix_kernels.h"
+#include "parallel.h"
+
+using namespace blowgun;
+
+// Utility
+namespace
+{
+    // Number of matrices below which splitting a batch over another
+    // thread costs more than it saves.
+    static const u32 kMinMatricesPerThread = 1024;
+
+    static void MultiplyRangeAoS(const float * models, const float * view_projection,
+        float * out, u32 begin, u32 end)
+    {
+        for (u32 i = begin; i < end; ++i)
+            kernels::Multiply(models + i * 16, view_projection, out + i * 16);
+    }
+
+    static void MultiplyRangeSoA(const MatrixArraySoA & models, const float * view_projection,
+        const MatrixArraySoA & out, u32 begin, u32 end)
+    {
+        using namespace simd;
+
+        // Every lane holds a different matrix, so the shared matrix is
+        // splatted once and reused for the whole range.
+        Float4 b[16];
+        for (u32 j = 0; j < 16; ++j)
+            b[j] = Splat(view_projection[j]);
+
+        u32 i = begin;
+        for (; i + 4 <= end; i += 4)
+        {
+            for (u32 row = 0; row < 16; row += 4)
+            {
+                const Float4 a0 = Load(models.values[row + 0] + i);
+                const Float4 a1 = Load(models.values[row + 1] + i);
+                const Float4 a2 = Load(models.values[row + 2] + i);
+                const Float4 a3 = Load(models.values[row + 3] + i);
+
+                for (u32 column = 0; column < 4; ++column)
+                {
+                    Float4 r = Mul(a0, b[column]);
+                    r = MulAdd(a1, b[4 + column], r);
+                    r = MulAdd(a2, b[8 + column], r);
+                    r = MulAdd(a3, b[12 + column], r);
+                    Store(out.values[row + column] + i, r);
+                }
+            }
+        }
+
+        // Leftovers that don't fill a whole SIMD register.
+        for (; i < end; ++i)
+        {
+            float a[16];
+            float r[16];
+            for (u32 j = 0; j < 16; ++j)
+                a[j] = models.values[j][i];
+            kernels::Multiply(a, view_projection, r);
+            for (u32 j = 0; j < 16; ++j)
+                out.values[j][i] = r[j];
+        }
+    }
+
+    static void InverseRangeAoS(const float * in, float * out, u32 begin, u32 end)
+    {
+        for (u32 i = begin; i < end; ++i)
+        {
+            if (!kernels::Inverse(in + i * 16, out + i * 16))
+                throw new std::runtime_error("Matrix is not invertible.");
+        }
+    }
+
+    static void InverseRangeSoA(const MatrixArraySoA & in, const MatrixArraySoA & out,
+        u32 begin, u32 end)
+    {
+        using namespace simd;
+
+        u32 i = begin;
+        for (; i + 4 <= end; i += 4)
+        {
+            // Every lane holds a different matrix, so this is the plain
+            // cofactor expansion, four matrices at a time.
+            Float4 a[16];
+            for (u32 j = 0; j < 16; ++j)
+                a[j] = Load(in.values[j] + i);
+
+            // 2x2 determinants of rows 0-1 (s) and rows 2-3 (c).
+            const Float4 s0 = Sub(Mul(a[0], a[5]), Mul(a[4], a[1]));
+            const Float4 s1 = Sub(Mul(a[0], a[6]), Mul(a[4], a[2]));
+            const Float4 s2 = Sub(Mul(a[0], a[7]), Mul(a[4], a[3]));
+            const Float4 s3 = Sub(Mul(a[1], a[6]), Mul(a[5], a[2]));
+            const Float4 s4 = Sub(Mul(a[1], a[7]), Mul(a[5], a[3]));
+            const Float4 s5 = Sub(Mul(a[2], a[7]), Mul(a[6], a[3]));
+
+            const Float4 c5 = Sub(Mul(a[10], a[15]), Mul(a[14], a[11]));
+            const Float4 c4 = Sub(Mul(a[9],  a[15]), Mul(a[13], a[11]));
+            const Float4 c3 = Sub(Mul(a[9],  a[14]), Mul(a[13], a[10]));
+            const Float4 c2 = Sub(Mul(a[8],  a[15]), Mul(a[12], a[11]));
+            const Float4 c1 = Sub(Mul(a[8],  a[14]), Mul(a[12], a[10]));
+            const Float4 c0 = Sub(Mul(a[8],  a[13]), Mul(a[12], a[9]));
+
+            Float4 determinant = Mul(s0, c5);
+            determinant = Sub(determinant, Mul(s1, c4));
+            determinant = MulAdd(s2, c3, determinant);
+            determinant = MulAdd(s3, c2, determinant);
+            determinant = Sub(determinant, Mul(s4, c1));
+            determinant = MulAdd(s5, c0, determinant);
+
+            BLOWGUN_ALIGN(16) float d[4];
+            Store(d, determinant);
+            if (d[0] == 0.0f || d[1] == 0.0f || d[2] == 0.0f || d[3] == 0.0f)
+                throw new std::runtime_error("Matrix is not invertible.");
+            const Float4 scale = Set(1.0f / d[0], 1.0f / d[1], 1.0f / d[2], 1.0f / d[3]);
+
+            Float4 b[16];
+            b[0]  = Add(Sub(Mul(a[5],  c5), Mul(a[6],  c4)), Mul(a[7],  c3));
+            b[1]  = Sub(Sub(Mul(a[2],  c4), Mul(a[1],  c5)), Mul(a[3],  c3));
+            b[2]  = Add(Sub(Mul(a[13], s5), Mul(a[14], s4)), Mul(a[15], s3));
+            b[3]  = Sub(Sub(Mul(a[10], s4), Mul(a[9],  s5)), Mul(a[11], s3));
+
+            b[4]  = Sub(Sub(Mul(a[6],  c2), Mul(a[4],  c5)), Mul(a[7],  c1));
+            b[5]  = Add(Sub(Mul(a[0],  c5), Mul(a[2],  c2)), Mul(a[3],  c1));
+            b[6]  = Sub(Sub(Mul(a[14], s2), Mul(a[12], s5)), Mul(a[15], s1));
+            b[7]  = Add(Sub(Mul(a[8],  s5), Mul(a[10], s2)), Mul(a[11], s1));
+
+            b[8]  = Add(Sub(Mul(a[4],  c4), Mul(a[5],  c2)), Mul(a[7],  c0));
+            b[9]  = Sub(Sub(Mul(a[1],  c2), Mul(a[0],  c4)), Mul(a[3],  c0));
+            b[10] = Add(Sub(Mul(a[12], s4), Mul(a[13], s2)), Mul(a[15], s0));
+            b[11] = Sub(Sub(Mul(a[9],  s2), Mul(a[8],  s4)), Mul(a[11], s0));
+
+            b[12] = Sub(Sub(Mul(a[5],  c1), Mul(a[4],  c3)), Mul(a[6],  c0));
+            b[13] = Add(Sub(Mul(a[0],  c3), Mul(a[1],  c1)), Mul(a[2],  c0));
+            b[14] = Sub(Sub(Mul(a[13], s1), Mul(a[12], s3)), Mul(a[14], s0));
+            b[15] = Add(Sub(Mul(a[8],  s3), Mul(a[9],  s1)), Mul(a[10], s0));
+
+            for (u32 j = 0; j < 16; ++j)
+                Store(out.values[j] + i, Mul(b[j], scale));
+        }
+
+        // Leftovers that don't fill a whole SIMD register.
+        for (; i < end; ++i)
+        {
+            float a[16];
+            for (u32 j = 0; j < 16; ++j)
+                a[j] = in.values[j][i];
+            if (!kernels::Inverse(a, a))
+                throw new std::runtime_error("Matrix is not invertible.");
+            for (u32 j = 0; j < 16; ++j)
+                out.values[j][i] = a[j];
+        }
+    }
+}
+
+void
+blowgun::MultiplyBatch(
+    const Matrix * models,
+    u32            count,
+    const Matrix & view_projection,
+    Matrix *       out,
+    u32            thread_count)
+{
+    // Matrix is nothing but its 16 floats, so an array of them is
+    // exactly an array of raw matrices.
+    static_assert(sizeof(Matrix) == 16 * sizeof(float),
+        "Matrix must not contain anything besides its values.");
+    static_assert(std::is_standard_layout<Matrix>::value,
+        "Matrix must be standard-layout.");
+
+    MultiplyBatch(
+        reinterpret_cast<const float *>(models),
+        count,
+        view_projection,
+        reinterpret_cast<float *>(out),
+        thread_count);
+}
+
+void
+blowgun::MultiplyBatch(
+    const float *  models,
+    u32            count,
+    const Matrix & view_projection,
+    float *        out,
+    u32            thread_count)
+{
+    const float * vp = view_projection.values();
+
+    // Skip the `std::function` of `ParallelFor` on a single thread, so
+    // that nothing is allocated.
+    if (ParallelRangeCount(count, kMinMatricesPerThread, thread_count) <= 1)
+    {
+        MultiplyRangeAoS(models, vp, out, 0, count);
+        return;
+    }
+
+    ParallelFor(count, kMinMatricesPerThread, thread_count,
+        [=](u32 begin, u32 end)
+        {
+            MultiplyRangeAoS(models, vp, out, begin, end);
+        });
+}
+
+void
+blowgun::MultiplyBatch(
+    const MatrixArraySoA & models,
+    u32                    count,
+    const Matrix &         view_projection,
+    const MatrixArraySoA & out,
+    u32                    thread_count)
+{
+    const float * vp = view_projection.values();
+
+    if (ParallelRangeCount(count, kMinMatricesPerThread, thread_count) <= 1)
+    {
+        MultiplyRangeSoA(models, vp, out, 0, count);
+        return;
+    }
+
+    ParallelFor(count, kMinMatricesPerThread, thread_count,
+        [&](u32 begin, u32 end)
+        {
+            MultiplyRangeSoA(models, vp, out, begin, end);
+        });
+}
+
+void
+blowgun::InverseBatch(
+    const Matrix * in,
+    u32            count,
+    Matrix *       out,
+    u32            thread_count)
+{
+    InverseBatch(
+        reinterpret_cast<const float *>(in),
+        count,
+        reinterpret_cast<float *>(out),
+        thread_count);
+}
+
+void
+blowgun::InverseBatch(
+    const float * in,
+    u32           count,
+    float *       out,
+    u32           thread_count)
+{
+    ParallelFor(count, kMinMatricesPerThread, thread_count,
+        [=](u32 begin, u32 end)
+        {
+            InverseRangeAoS(in, out, begin, end);
+        });
+}
+
+void
+blowgun::InverseBatch(
+    const MatrixArraySoA & in,
+    u32                    count,
+    const MatrixArraySoA & out,
+    u32                    thread_count)
+{
+    ParallelFor(count, kMinMatricesPerThread, thread_count,
+        [&](u32 begin, u32 end)
+        {
+            InverseRangeSoA(in, out, begin, end);
+        });
+}
@@ -0,0 +1,101 @@
+#ifndef BLOWGUN_MATRIX_BATCH_H_
+#define BLOWGUN_MATRIX_BATCH_H_
+
+#include "types.h"
+#include "matrix.h"
+
+namespace blowgun
+{
+
+/**
+ * Structure-of-arrays view over a number of matrices.
+ *
+ * `values[j][i]` is the j-th value (in `Matrix::values()` order) of the
+ * i-th matrix. Each of the 16 arrays has to hold at least as many
+ * floats as there are matrices.
+ */
+struct MatrixArraySoA
+{
+	float * values[16];
+};
+
+/**
+ * Multiply every model matrix by one shared view-projection matrix.
+ *
+ * For each `i`, `out[i]` receives `models[i].Multiply(view_projection)`,
+ * which is the same ordering the applications use to build their PMV
+ * matrix. Nothing is allocated unless the batch is split over several
+ * threads. `out` has to hold `count` matrices and must not overlap
+ * `models` unless they are the exact same buffer.
+ *
+ * @param   thread_count
+ *          Upper bound of threads to split a large batch over. The
+ *          default processes everything on the calling thread; zero
+ *          means one thread per hardware thread.
+ */
+void MultiplyBatch(
+	const Matrix * models,
+	u32            count,
+	const Matrix & view_projection,
+	Matrix *       out,
+	u32            thread_count = 1);
+
+/**
+ * Same as above, but for raw arrays of 16 floats per matrix, such
+ * as a mapped uniform or instance buffer.
+ */
+void MultiplyBatch(
+	const float *  models,
+	u32            count,
+	const Matrix & view_projection,
+	float *        out,
+	u32            thread_count = 1);
+
+/**
+ * Same as above, for matrices stored as structure-of-arrays. Four
+ * matrices are processed per SIMD instruction.
+ */
+void MultiplyBatch(
+	const MatrixArraySoA & models,
+	u32                    count,
+	const Matrix &         view_projection,
+	const MatrixArraySoA & out,
+	u32                    thread_count = 1);
+
+/**
+ * Invert every matrix of an array: `out[i]` receives
+ * `in[i].Inverse()`. `out` may be the same buffer as `in`.
+ *
+ * Throws when any of the matrices has no inverse.
+ *
+ * @param   thread_count
+ *          Same as for `MultiplyBatch`.
+ */
+void InverseBatch(
+	const Matrix * in,
+	u32            count,
+	Matrix *       out,
+	u32            thread_count = 1);
+
+/**
+ * Same as above, for raw arrays of 16 floats per matrix.
+ */
+void InverseBatch(
+	const float * in,
+	u32           count,
+	float *       out,
+	u32           thread_count = 1);
+
+/**
+ * Same as above, for matrices stored as structure-of-arrays. Four
+ * matrices are inverted per SIMD instruction.
+ */
+void InverseBatch(
+	const MatrixArraySoA & in,
+	u32                    count,
+	const MatrixArraySoA & out,
+	u32                    thread_count = 1);
+
+}
+
+#endif // BLOWGUN_MATRIX_BATCH_H_
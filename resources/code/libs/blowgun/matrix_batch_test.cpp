@@ -0,0 +1,121 @@
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "matrix_batch.h"
+
+using namespace blowgun;
+
+namespace
+{
+    // 4999 isn't a multiple of the SIMD width, so the leftover path
+    // is exercised too.
+    static const u32 kCount = 4999;
+
+    Matrix CreateModel(u32 i)
+    {
+        return Matrix()
+            .Translate(i * 0.5f, -1.0f * i, 2.0f)
+            .Rotate(i * 7.0f, 0.3f, 1.0f, 0.2f)
+            .Scale(1.0f + i * 0.001f, 1.0f, 0.5f);
+    }
+
+    Matrix CreateViewProjection()
+    {
+        return Matrix().Translate(0.0f, 0.0f, -15.0f)
+            .Multiply(Matrix().Perspective(60.0f, 800.0f / 600.0f, 1.0f, 20.0f));
+    }
+}
+
+TEST(MatrixBatchTest, AoSMatchesMultiply)
+{
+    std::vector<Matrix> models;
+    for (u32 i = 0; i < kCount; ++i)
+        models.push_back(CreateModel(i));
+    const Matrix vp = CreateViewProjection();
+
+    std::vector<Matrix> single(kCount);
+    std::vector<Matrix> threaded(kCount);
+    MultiplyBatch(&models[0], kCount, vp, &single[0]);
+    MultiplyBatch(&models[0], kCount, vp, &threaded[0], 0);
+
+    for (u32 i = 0; i < kCount; ++i)
+    {
+        const Matrix expected = models[i].Multiply(vp);
+        for (u32 j = 0; j < 16; ++j)
+        {
+            ASSERT_FLOAT_EQ(expected.values()[j], single[i].values()[j]);
+            ASSERT_FLOAT_EQ(expected.values()[j], threaded[i].values()[j]);
+        }
+    }
+}
+
+TEST(MatrixBatchTest, SoAMatchesMultiply)
+{
+    std::vector<float> model_storage(16 * kCount);
+    std::vector<float> out_storage(16 * kCount);
+    MatrixArraySoA models;
+    MatrixArraySoA out;
+    for (u32 j = 0; j < 16; ++j)
+    {
+        models.values[j] = &model_storage[j * kCount];
+        out.values[j] = &out_storage[j * kCount];
+    }
+
+    for (u32 i = 0; i < kCount; ++i)
+    {
+        const Matrix model = CreateModel(i);
+        for (u32 j = 0; j < 16; ++j)
+            models.values[j][i] = model.values()[j];
+    }
+    const Matrix vp = CreateViewProjection();
+
+    MultiplyBatch(models, kCount, vp, out, 0);
+
+    for (u32 i = 0; i < kCount; ++i)
+    {
+        const Matrix expected = CreateModel(i).Multiply(vp);
+        for (u32 j = 0; j < 16; ++j)
+            ASSERT_NEAR(expected.values()[j], out.values[j][i], 1e-5f);
+    }
+}
+
+TEST(MatrixBatchTest, InverseMatchesInverse)
+{
+    std::vector<Matrix> models;
+    for (u32 i = 0; i < kCount; ++i)
+        models.push_back(CreateModel(i).Multiply(CreateViewProjection()));
+
+    std::vector<float> in_storage(16 * kCount);
+    std::vector<float> out_storage(16 * kCount);
+    MatrixArraySoA in;
+    MatrixArraySoA out;
+    for (u32 j = 0; j < 16; ++j)
+    {
+        in.values[j] = &in_storage[j * kCount];
+        out.values[j] = &out_storage[j * kCount];
+    }
+    for (u32 i = 0; i < kCount; ++i)
+    {
+        for (u32 j = 0; j < 16; ++j)
+            in.values[j][i] = models[i].values()[j];
+    }
+
+    std::vector<Matrix> inverses(kCount);
+    InverseBatch(&models[0], kCount, &inverses[0], 0);
+    InverseBatch(in, kCount, out, 0);
+
+    for (u32 i = 0; i < kCount; ++i)
+    {
+        const Matrix expected = models[i].Inverse();
+        for (u32 j = 0; j < 16; ++j)
+        {
+            ASSERT_FLOAT_EQ(expected.values()[j], inverses[i].values()[j]);
+            // The SoA path sums the cofactors in another order, and
+            // projections are far from well-conditioned.
+            ASSERT_NEAR(expected.values()[j], out.values[j][i],
+                1e-3f * std::max(1.0f, std::fabs(expected.values()[j])));
+        }
+    }
+}
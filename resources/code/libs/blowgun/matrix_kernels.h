@@ -0,0 +1,287 @@
+#ifndef BLOWGUN_MATRIX_KERNELS_H_
+#define BLOWGUN_MATRIX_KERNELS_H_
+
+#include "simd.h"
+
+namespace blowgun
+{
+
+/*
+ * Raw 4x4 kernels shared by `Matrix` and the code that processes
+ * arrays of matrices.
+ *
+ * Every matrix here is 16 contiguous floats, in the same layout as
+ * `Matrix::values()`. Row `i` in the comments below means the four
+ * floats starting at `m + 4 * i`. The output may alias any input.
+ */
+namespace kernels
+{
+
+/**
+ * Compute `out = a * b`, following the same ordering as
+ * `Matrix::Multiply`.
+ */
+inline void Multiply(const float * a, const float * b, float * out)
+{
+	using namespace simd;
+
+	const Float4 b0 = Load(b + 0);
+	const Float4 b1 = Load(b + 4);
+	const Float4 b2 = Load(b + 8);
+	const Float4 b3 = Load(b + 12);
+
+	for (int i = 0; i < 16; i += 4)
+	{
+		Float4 row = Mul(Splat(a[i + 0]), b0);
+		row = MulAdd(Splat(a[i + 1]), b1, row);
+		row = MulAdd(Splat(a[i + 2]), b2, row);
+		row = MulAdd(Splat(a[i + 3]), b3, row);
+		Store(out + i, row);
+	}
+}
+
+/**
+ * Compute `out = r * m`, where `r` is a 3x3 linear part given as 9
+ * floats (three rows of three). It is the same as a full multiply by
+ * a 4x4 matrix whose last row and column are (0, 0, 0, 1), but without
+ * the wasted work.
+ */
+inline void MultiplyLinear3(const float * r, const float * m, float * out)
+{
+	using namespace simd;
+
+	const Float4 m0 = Load(m + 0);
+	const Float4 m1 = Load(m + 4);
+	const Float4 m2 = Load(m + 8);
+
+	Float4 row0 = Mul(Splat(r[0]), m0);
+	row0 = MulAdd(Splat(r[1]), m1, row0);
+	row0 = MulAdd(Splat(r[2]), m2, row0);
+
+	Float4 row1 = Mul(Splat(r[3]), m0);
+	row1 = MulAdd(Splat(r[4]), m1, row1);
+	row1 = MulAdd(Splat(r[5]), m2, row1);
+
+	Float4 row2 = Mul(Splat(r[6]), m0);
+	row2 = MulAdd(Splat(r[7]), m1, row2);
+	row2 = MulAdd(Splat(r[8]), m2, row2);
+
+	Store(out + 0, row0);
+	Store(out + 4, row1);
+	Store(out + 8, row2);
+	if (out != m)
+		Store(out + 12, Load(m + 12));
+}
+
+/**
+ * Scale the first three entries of rows 0, 1 and 2.
+ */
+inline void Scale(const float * m, float x, float y, float z, float * out)
+{
+	using namespace simd;
+
+	Store(out + 0, Mul(Load(m + 0), Set(x, x, x, 1.0f)));
+	Store(out + 4, Mul(Load(m + 4), Set(y, y, y, 1.0f)));
+	Store(out + 8, Mul(Load(m + 8), Set(z, z, z, 1.0f)));
+	if (out != m)
+		Store(out + 12, Load(m + 12));
+}
+
+/**
+ * Add `x * row0 + y * row1 + z * row2` to row 3.
+ */
+inline void Translate(const float * m, float x, float y, float z, float * out)
+{
+	using namespace simd;
+
+	const Float4 m0 = Load(m + 0);
+	const Float4 m1 = Load(m + 4);
+	const Float4 m2 = Load(m + 8);
+
+	Float4 row3 = Load(m + 12);
+	row3 = MulAdd(Splat(x), m0, row3);
+	row3 = MulAdd(Splat(y), m1, row3);
+	row3 = MulAdd(Splat(z), m2, row3);
+
+	if (out != m)
+	{
+		Store(out + 0, m0);
+		Store(out + 4, m1);
+		Store(out + 8, m2);
+	}
+	Store(out + 12, row3);
+}
+
+inline void Transpose(const float * m, float * out)
+{
+	using namespace simd;
+
+	Float4 r0 = Load(m + 0);
+	Float4 r1 = Load(m + 4);
+	Float4 r2 = Load(m + 8);
+	Float4 r3 = Load(m + 12);
+	simd::Transpose(r0, r1, r2, r3);
+	Store(out + 0, r0);
+	Store(out + 4, r1);
+	Store(out + 8, r2);
+	Store(out + 12, r3);
+}
+
+/**
+ * Cross product of the first three lanes of `a` and `b`. The last
+ * lane of the result is zero.
+ */
+inline simd::Float4 Cross3(simd::Float4 a, simd::Float4 b)
+{
+	using namespace simd;
+
+	return Sub(
+		Mul(Swizzle<1, 2, 0, 3>(a), Swizzle<2, 0, 1, 3>(b)),
+		Mul(Swizzle<2, 0, 1, 3>(a), Swizzle<1, 2, 0, 3>(b)));
+}
+
+/**
+ * Compute `out = m^-1` by cofactor expansion over 2x2 determinants.
+ *
+ * Returns false, leaving `out` untouched, when `m` has no inverse.
+ */
+inline bool Inverse(const float * m, float * out)
+{
+	using namespace simd;
+
+	// c[j] is column j, v[j] is the same column with the first two
+	// and the last two lanes swapped.
+	Float4 c0 = Load(m + 0);
+	Float4 c1 = Load(m + 4);
+	Float4 c2 = Load(m + 8);
+	Float4 c3 = Load(m + 12);
+	simd::Transpose(c0, c1, c2, c3);
+
+	const Float4 v0 = Swizzle<1, 0, 3, 2>(c0);
+	const Float4 v1 = Swizzle<1, 0, 3, 2>(c1);
+	const Float4 v2 = Swizzle<1, 0, 3, 2>(c2);
+	const Float4 v3 = Swizzle<1, 0, 3, 2>(c3);
+
+	// For columns p < q, `c[p] * v[q]` holds the products making up
+	// the 2x2 determinant of rows 0-1 (lanes 0 and 1) and rows 2-3
+	// (lanes 2 and 3). Each f below holds these two determinants as
+	// (lower, lower, upper, upper).
+	Float4 p;
+	p = Mul(c0, v1); const Float4 f01 = Sub(Swizzle<2, 2, 0, 0>(p), Swizzle<3, 3, 1, 1>(p));
+	p = Mul(c0, v2); const Float4 f02 = Sub(Swizzle<2, 2, 0, 0>(p), Swizzle<3, 3, 1, 1>(p));
+	p = Mul(c0, v3); const Float4 f03 = Sub(Swizzle<2, 2, 0, 0>(p), Swizzle<3, 3, 1, 1>(p));
+	p = Mul(c1, v2); const Float4 f12 = Sub(Swizzle<2, 2, 0, 0>(p), Swizzle<3, 3, 1, 1>(p));
+	p = Mul(c1, v3); const Float4 f13 = Sub(Swizzle<2, 2, 0, 0>(p), Swizzle<3, 3, 1, 1>(p));
+	p = Mul(c2, v3); const Float4 f23 = Sub(Swizzle<2, 2, 0, 0>(p), Swizzle<3, 3, 1, 1>(p));
+
+	const Float4 plus_minus = Set(1.0f, -1.0f, 1.0f, -1.0f);
+	const Float4 minus_plus = Set(-1.0f, 1.0f, -1.0f, 1.0f);
+
+	BLOWGUN_ALIGN(16) float adjugate[16];
+	Store(adjugate + 0,  Mul(plus_minus, Add(Sub(Mul(v1, f23), Mul(v2, f13)), Mul(v3, f12))));
+	Store(adjugate + 4,  Mul(minus_plus, Add(Sub(Mul(v0, f23), Mul(v2, f03)), Mul(v3, f02))));
+	Store(adjugate + 8,  Mul(plus_minus, Add(Sub(Mul(v0, f13), Mul(v1, f03)), Mul(v3, f01))));
+	Store(adjugate + 12, Mul(minus_plus, Add(Sub(Mul(v0, f12), Mul(v1, f02)), Mul(v2, f01))));
+
+	const float determinant =
+		m[0] * adjugate[0] + m[1] * adjugate[4] +
+		m[2] * adjugate[8] + m[3] * adjugate[12];
+	if (determinant == 0.0f)
+		return false;
+
+	const Float4 scale = Splat(1.0f / determinant);
+	Store(out + 0,  Mul(Load(adjugate + 0),  scale));
+	Store(out + 4,  Mul(Load(adjugate + 4),  scale));
+	Store(out + 8,  Mul(Load(adjugate + 8),  scale));
+	Store(out + 12, Mul(Load(adjugate + 12), scale));
+	return true;
+}
+
+/**
+ * Compute `out = m^-1` for a matrix whose last column is
+ * (0, 0, 0, 1), i.e. any combination of translations, rotations
+ * and scales. Only the 3x3 linear part has to be inverted.
+ *
+ * Returns false, leaving `out` untouched, when `m` has no inverse.
+ */
+inline bool AffineInverse(const float * m, float * out)
+{
+	using namespace simd;
+
+	const Float4 l0 = Load(m + 0);
+	const Float4 l1 = Load(m + 4);
+	const Float4 l2 = Load(m + 8);
+
+	// The inverse of the linear part is the transpose of these rows,
+	// divided by the determinant.
+	Float4 x0 = Cross3(l1, l2);
+	Float4 x1 = Cross3(l2, l0);
+	Float4 x2 = Cross3(l0, l1);
+
+	const float determinant = Sum(Mul(l0, x0));
+	if (determinant == 0.0f)
+		return false;
+
+	Float4 x3 = Splat(0.0f);
+	simd::Transpose(x0, x1, x2, x3);
+
+	const Float4 scale = Splat(1.0f / determinant);
+	const Float4 i0 = Mul(x0, scale);
+	const Float4 i1 = Mul(x1, scale);
+	const Float4 i2 = Mul(x2, scale);
+
+	Float4 row3 = Mul(Splat(-m[12]), i0);
+	row3 = MulAdd(Splat(-m[13]), i1, row3);
+	row3 = MulAdd(Splat(-m[14]), i2, row3);
+
+	Store(out + 0, i0);
+	Store(out + 4, i1);
+	Store(out + 8, i2);
+	Store(out + 12, Add(row3, Set(0.0f, 0.0f, 0.0f, 1.0f)));
+	return true;
+}
+
+/**
+ * Write the inverse transpose of the upper-left 3x3 part of `m` into
+ * `out` as 9 floats, laid out for `glUniformMatrix3fv`.
+ *
+ * Returns false, leaving `out` untouched, when that part has no
+ * inverse.
+ */
+inline bool InverseTranspose3x3(const float * m, float * out)
+{
+	using namespace simd;
+
+	const Float4 l0 = Load(m + 0);
+	const Float4 l1 = Load(m + 4);
+	const Float4 l2 = Load(m + 8);
+
+	const Float4 x0 = Cross3(l1, l2);
+
+	const float determinant = Sum(Mul(l0, x0));
+	if (determinant == 0.0f)
+		return false;
+
+	const Float4 scale = Splat(1.0f / determinant);
+
+	// Stored as rows of four, so the last store doesn't write past
+	// the 9 floats of `out`.
+	BLOWGUN_ALIGN(16) float rows[12];
+	Store(rows + 0, Mul(x0, scale));
+	Store(rows + 4, Mul(Cross3(l2, l0), scale));
+	Store(rows + 8, Mul(Cross3(l0, l1), scale));
+
+	for (int i = 0; i < 3; ++i)
+	{
+		out[i * 3 + 0] = rows[i * 4 + 0];
+		out[i * 3 + 1] = rows[i * 4 + 1];
+		out[i * 3 + 2] = rows[i * 4 + 2];
+	}
+	return true;
+}
+
+}
+
+}
+
+#endif // BLOWGUN_MATRIX_KERNELS_H_
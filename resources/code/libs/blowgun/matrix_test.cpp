@@ -0,0 +1,289 @@
+#include <algorithm>
+#include <cmath>
+
+#include <gtest/gtest.h>
+#include "compiler.h"
+#include "matrix.h"
+#include "vector.h"
+
+using namespace blowgun;
+
+namespace
+{
+    // Straightforward reference for `Matrix::Multiply`, the same way
+    // it used to be implemented before the SIMD kernels.
+    Matrix ReferenceMultiply(const Matrix & a, const Matrix & b)
+    {
+        float result[16];
+        for (int i = 0; i < 4; ++i)
+        {
+            for (int j = 0; j < 4; ++j)
+            {
+                result[i * 4 + j] = 0.0f;
+                for (int k = 0; k < 4; ++k)
+                {
+                    result[i * 4 + j] +=
+                        a.values()[i * 4 + k] * b.values()[k * 4 + j];
+                }
+            }
+        }
+        return Matrix(result);
+    }
+
+    Matrix CreateSample()
+    {
+        const float values[16] =
+        {
+             1.0f,  2.0f,  3.0f,  4.0f,
+             5.0f,  6.0f,  7.0f,  8.0f,
+             9.0f, 10.0f, 11.0f, 12.0f,
+            13.0f, 14.0f, 15.0f, 16.0f
+        };
+        return Matrix(values);
+    }
+
+    void ExpectMatrixNear(const Matrix & expected, const Matrix & actual)
+    {
+        for (int i = 0; i < 16; ++i)
+            EXPECT_NEAR(expected.values()[i], actual.values()[i], 1e-4f) << "index " << i;
+    }
+
+    // Gauss-Jordan elimination with partial pivoting, in double
+    // precision, as the reference for the inverse functions.
+    void ReferenceInverse(const float * m, int size, int stride, double * out)
+    {
+        double a[4][8];
+        for (int i = 0; i < size; ++i)
+        {
+            for (int j = 0; j < size; ++j)
+            {
+                a[i][j] = m[i * stride + j];
+                a[i][size + j] = (i == j) ? 1.0 : 0.0;
+            }
+        }
+
+        for (int column = 0; column < size; ++column)
+        {
+            int pivot = column;
+            for (int i = column + 1; i < size; ++i)
+            {
+                if (std::fabs(a[i][column]) > std::fabs(a[pivot][column]))
+                    pivot = i;
+            }
+            for (int j = 0; j < 2 * size; ++j)
+                std::swap(a[column][j], a[pivot][j]);
+
+            const double divisor = a[column][column];
+            for (int j = 0; j < 2 * size; ++j)
+                a[column][j] /= divisor;
+
+            for (int i = 0; i < size; ++i)
+            {
+                if (i == column)
+                    continue;
+                const double factor = a[i][column];
+                for (int j = 0; j < 2 * size; ++j)
+                    a[i][j] -= factor * a[column][j];
+            }
+        }
+
+        for (int i = 0; i < size; ++i)
+        {
+            for (int j = 0; j < size; ++j)
+                out[i * size + j] = a[i][size + j];
+        }
+    }
+
+    void ExpectInverseNear(const Matrix & m, const Matrix & actual)
+    {
+        double expected[16];
+        ReferenceInverse(m.values(), 4, 4, expected);
+        for (int i = 0; i < 16; ++i)
+            EXPECT_NEAR(expected[i], actual.values()[i], 1e-4) << "index " << i;
+    }
+
+    Matrix CreateModel()
+    {
+        return Matrix()
+            .Translate(3.0f, -2.0f, 5.0f)
+            .Rotate(35.0f, 0.3f, 1.0f, -0.5f)
+            .Scale(2.0f, 0.5f, 1.5f);
+    }
+}
+
+TEST(MatrixTest, DefaultIsIdentity)
+{
+    const Matrix identity;
+    for (int i = 0; i < 16; ++i)
+        EXPECT_EQ((i % 5 == 0) ? 1.0f : 0.0f, identity.values()[i]);
+}
+
+TEST(MatrixTest, IsAssignable)
+{
+    Matrix m;
+    m = CreateSample();
+    ExpectMatrixNear(CreateSample(), m);
+}
+
+TEST(MatrixTest, MultiplyMatchesReference)
+{
+    const Matrix a = CreateSample();
+    const Matrix b = Matrix().Rotate(30.0f, 1.0f, 2.0f, 3.0f).Translate(1.0f, -2.0f, 3.0f);
+
+    ExpectMatrixNear(ReferenceMultiply(a, b), a.Multiply(b));
+    ExpectMatrixNear(ReferenceMultiply(b, a), b.Multiply(a));
+}
+
+TEST(MatrixTest, RotateMatchesFullMultiply)
+{
+    const Matrix sample = CreateSample();
+
+    // 90 degrees around Z, laid out the way `values()` returns it.
+    const float rotation_values[16] =
+    {
+         0.0f, -1.0f, 0.0f, 0.0f,
+         1.0f,  0.0f, 0.0f, 0.0f,
+         0.0f,  0.0f, 1.0f, 0.0f,
+         0.0f,  0.0f, 0.0f, 1.0f
+    };
+    const Matrix rotation(rotation_values);
+
+    ExpectMatrixNear(ReferenceMultiply(rotation, sample), sample.Rotate(90.0f, 0.0f, 0.0f, 2.0f));
+}
+
+TEST(MatrixTest, ScaleKeepsLastColumn)
+{
+    const Matrix scaled = CreateSample().Scale(2.0f, 3.0f, 4.0f);
+
+    EXPECT_FLOAT_EQ(2.0f, scaled.values()[0]);
+    EXPECT_FLOAT_EQ(4.0f, scaled.values()[3]);
+    EXPECT_FLOAT_EQ(18.0f, scaled.values()[5]);
+    EXPECT_FLOAT_EQ(8.0f, scaled.values()[7]);
+    EXPECT_FLOAT_EQ(44.0f, scaled.values()[10]);
+    EXPECT_FLOAT_EQ(16.0f, scaled.values()[15]);
+}
+
+TEST(MatrixTest, TranslateMatchesFullMultiply)
+{
+    const Matrix sample = CreateSample();
+    const Matrix translation = Matrix().Translate(1.0f, 2.0f, 3.0f);
+
+    EXPECT_FLOAT_EQ(1.0f, translation.values()[12]);
+    EXPECT_FLOAT_EQ(2.0f, translation.values()[13]);
+    EXPECT_FLOAT_EQ(3.0f, translation.values()[14]);
+    ExpectMatrixNear(ReferenceMultiply(translation, sample), sample.Translate(1.0f, 2.0f, 3.0f));
+}
+
+TEST(MatrixTest, TransposeTwiceIsNoop)
+{
+    const Matrix sample = CreateSample();
+    const Matrix transposed = sample.Transpose();
+
+    EXPECT_EQ(5.0f, transposed.values()[1]);
+    EXPECT_EQ(2.0f, transposed.values()[4]);
+    ExpectMatrixNear(sample, transposed.Transpose());
+}
+
+namespace
+{
+    static BLOWGUN_CONSTEXPR const Matrix kConstantPMV = Matrix::CreateProduct(
+        Matrix::CreateTranslation(0.0f, 0.0f, -15.0f),
+        Matrix::CreatePerspective(60.0f, 800.0f / 600.0f, 1.0f, 20.0f));
+
+#if BLOWGUN_HAS_CONSTEXPR
+    // These only compile if the builders are really evaluated by the
+    // compiler.
+    static_assert(Matrix::CreateTranslation(1.0f, 2.0f, 3.0f).value(13) == 2.0f,
+        "CreateTranslation must be usable at compile time.");
+    static_assert(kConstantPMV.value(11) == -1.0f,
+        "CreatePerspective must be usable at compile time.");
+#endif
+}
+
+TEST(MatrixTest, ConstantBuildersMatchOperations)
+{
+    ExpectMatrixNear(Matrix().Translate(1.0f, -2.0f, 3.0f), Matrix::CreateTranslation(1.0f, -2.0f, 3.0f));
+    ExpectMatrixNear(Matrix().Scale(2.0f, 3.0f, 4.0f), Matrix::CreateScale(2.0f, 3.0f, 4.0f));
+    ExpectMatrixNear(
+        Matrix().Frustum(-1.0f, 2.0f, -3.0f, 4.0f, 0.5f, 50.0f),
+        Matrix::CreateFrustum(-1.0f, 2.0f, -3.0f, 4.0f, 0.5f, 50.0f));
+    ExpectMatrixNear(
+        Matrix().Perspective(75.0f, 16.0f / 9.0f, 0.1f, 100.0f),
+        Matrix::CreatePerspective(75.0f, 16.0f / 9.0f, 0.1f, 100.0f));
+
+    const Matrix runtime_pmv = Matrix().Translate(0.0f, 0.0f, -15.0f)
+        .Multiply(Matrix().Perspective(60.0f, 800.0f / 600.0f, 1.0f, 20.0f));
+    ExpectMatrixNear(runtime_pmv, kConstantPMV);
+}
+
+TEST(MatrixTest, InverseMatchesReference)
+{
+    const Matrix pmv = CreateModel()
+        .Multiply(Matrix().Translate(0.0f, 0.0f, -15.0f))
+        .Multiply(Matrix().Perspective(60.0f, 800.0f / 600.0f, 1.0f, 20.0f));
+    ExpectInverseNear(pmv, pmv.Inverse());
+
+    const float values[16] =
+    {
+        2.0f, -1.0f,  0.5f,  3.0f,
+        0.0f,  4.0f,  1.0f, -2.0f,
+        1.0f,  0.0f, -3.0f,  1.0f,
+        0.5f,  2.0f,  1.0f,  1.0f
+    };
+    ExpectInverseNear(Matrix(values), Matrix(values).Inverse());
+
+    ExpectMatrixNear(Matrix(), pmv.Multiply(pmv.Inverse()));
+}
+
+TEST(MatrixTest, InverseOfSingularMatrixThrows)
+{
+    EXPECT_THROW(CreateSample().Inverse(), std::runtime_error *);
+    EXPECT_THROW(Matrix().Scale(1.0f, 0.0f, 1.0f).AffineInverse(), std::runtime_error *);
+}
+
+TEST(MatrixTest, AffineInverseMatchesReference)
+{
+    const Matrix model = CreateModel();
+    ExpectInverseNear(model, model.AffineInverse());
+}
+
+TEST(MatrixTest, InverseTranspose3x3MatchesReference)
+{
+    const Matrix model_view = CreateModel().Translate(0.0f, 0.0f, -15.0f);
+
+    double inverse[9];
+    ReferenceInverse(model_view.values(), 3, 4, inverse);
+
+    float normal[9];
+    model_view.InverseTranspose3x3(normal);
+
+    // `glUniformMatrix3fv` reads the values column by column, so the
+    // transpose of the inverse is stored exactly like the inverse.
+    for (int i = 0; i < 9; ++i)
+        EXPECT_NEAR(inverse[(i % 3) * 3 + i / 3], normal[i], 1e-4) << "index " << i;
+}
+
+TEST(MatrixTest, UnprojectReversesProjection)
+{
+    const Matrix pmv = CreateModel()
+        .Multiply(Matrix().Translate(0.0f, 0.0f, -15.0f))
+        .Multiply(Matrix().Perspective(60.0f, 800.0f / 600.0f, 1.0f, 20.0f));
+    const float viewport[4] = { 10.0f, 20.0f, 800.0f, 600.0f };
+    const Vec3 point(0.5f, -1.0f, 2.0f);
+
+    // Project the point the same way GL does.
+    const float * m = pmv.values();
+    double clip[4];
+    for (int i = 0; i < 4; ++i)
+        clip[i] = point.x * m[i] + point.y * m[4 + i] + point.z * m[8 + i] + m[12 + i];
+    const Vec3 window(
+        static_cast<float>(viewport[0] + (clip[0] / clip[3] + 1.0) * 0.5 * viewport[2]),
+        static_cast<float>(viewport[1] + (clip[1] / clip[3] + 1.0) * 0.5 * viewport[3]),
+        static_cast<float>((clip[2] / clip[3] + 1.0) * 0.5));
+
+    const Vec3 unprojected = pmv.Unproject(window,
+        viewport[0], viewport[1], viewport[2], viewport[3]);
+    EXPECT_NEAR(point.x, unprojected.x, 1e-3f);
+    EXPECT_NEAR(point.y, unprojected.y, 1e-3f);
+    EXPECT_NEAR(point.z, unprojected.z, 1e-3f);
+}
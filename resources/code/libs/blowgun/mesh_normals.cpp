@@ -0,0 +1,277 @@
+#include "mesh_normals.h"
+
+#include <cmath>
+#include <vector>
+
+#include "parallel.h"
+#include "simd.h"
+#include "vector.h"
+
+using namespace blowgun;
+
+// Utility
+namespace
+{
+    // Number of triangles, or of vertices, below which splitting the
+    // work over another thread costs more than it saves.
+    static const u32 kMinTrianglesPerThread = 4096;
+    static const u32 kMinVerticesPerThread = 4096;
+
+    // Strided access to the attributes of one vertex.
+    struct Attribute
+    {
+        const u8 * base;
+        u32        stride;
+
+        Attribute(const float * data, u32 stride) :
+            base(reinterpret_cast<const u8 *>(data)), stride(stride) {}
+
+        const float * operator[](u32 vertex) const
+        {
+            return reinterpret_cast<const float *>(base + vertex * stride);
+        }
+    };
+
+    static Vec3
+    LoadVec3(const float * p)
+    {
+        return Vec3(p[0], p[1], p[2]);
+    }
+
+    // For each vertex, the triangles that use it, in increasing order.
+    // Summing over them gathers what each triangle contributes to the
+    // vertex without any two threads writing to the same vertex, and
+    // always in the same order.
+    struct Adjacency
+    {
+        std::vector<u32> offsets;
+        std::vector<u32> triangles;
+
+        Adjacency(const u32 * indices, u32 index_count, u32 vertex_count) :
+            offsets(vertex_count + 1, 0),
+            triangles(index_count)
+        {
+            for (u32 i = 0; i < index_count; ++i)
+                ++offsets[indices[i] + 1];
+            for (u32 v = 0; v < vertex_count; ++v)
+                offsets[v + 1] += offsets[v];
+
+            std::vector<u32> cursors(offsets.begin(), offsets.end() - 1);
+            for (u32 i = 0; i < index_count; ++i)
+                triangles[cursors[indices[i]]++] = i / 3;
+        }
+    };
+
+    // Cross product of the edges of each triangle in `[begin, end)`,
+    // whose length is twice the area of the triangle. Four triangles
+    // are processed at once, with one register per axis.
+    static void
+    ComputeFaceNormals(const Attribute & positions, const u32 * indices,
+        u32 begin, u32 end, float * x, float * y, float * z)
+    {
+        using namespace simd;
+
+        u32 t = begin;
+        for (; t + 4 <= end; t += 4)
+        {
+            const u32 * triangle = indices + 3 * t;
+
+            Float4 corner[3][3];
+            for (u32 k = 0; k < 3; ++k)
+            {
+                const float * p0 = positions[triangle[0 + k]];
+                const float * p1 = positions[triangle[3 + k]];
+                const float * p2 = positions[triangle[6 + k]];
+                const float * p3 = positions[triangle[9 + k]];
+                corner[k][0] = Set(p0[0], p1[0], p2[0], p3[0]);
+                corner[k][1] = Set(p0[1], p1[1], p2[1], p3[1]);
+                corner[k][2] = Set(p0[2], p1[2], p2[2], p3[2]);
+            }
+
+            const Float4 e1x = Sub(corner[1][0], corner[0][0]);
+            const Float4 e1y = Sub(corner[1][1], corner[0][1]);
+            const Float4 e1z = Sub(corner[1][2], corner[0][2]);
+            const Float4 e2x = Sub(corner[2][0], corner[0][0]);
+            const Float4 e2y = Sub(corner[2][1], corner[0][1]);
+            const Float4 e2z = Sub(corner[2][2], corner[0][2]);
+
+            Store(x + t, Sub(Mul(e1y, e2z), Mul(e1z, e2y)));
+            Store(y + t, Sub(Mul(e1z, e2x), Mul(e1x, e2z)));
+            Store(z + t, Sub(Mul(e1x, e2y), Mul(e1y, e2x)));
+        }
+
+        // Leftovers that don't fill a whole SIMD register.
+        for (; t < end; ++t)
+        {
+            const u32 * triangle = indices + 3 * t;
+            const Vec3 p0 = LoadVec3(positions[triangle[0]]);
+            const Vec3 n = Cross(
+                LoadVec3(positions[triangle[1]]) - p0,
+                LoadVec3(positions[triangle[2]]) - p0);
+            x[t] = n.x;
+            y[t] = n.y;
+            z[t] = n.z;
+        }
+    }
+
+    // Any unit vector orthogonal to `n`.
+    static Vec3
+    Orthogonal(const Vec3 & n)
+    {
+        const Vec3 axis = (std::fabs(n.x) < 0.9f) ? Vec3(1.0f, 0.0f, 0.0f) : Vec3(0.0f, 1.0f, 0.0f);
+        return Normalize(Cross(axis, n));
+    }
+}
+
+void
+blowgun::ComputeNormals(
+    const float * positions,
+    u32 vertex_count,
+    const u32 * indices,
+    u32 index_count,
+    float * normals,
+    u32 stride,
+    u32 thread_count)
+{
+    const u32 triangle_count = index_count / 3;
+    const Attribute position_of(positions, stride ? stride : 3 * sizeof(float));
+    const u32 normal_stride = stride ? stride : 3 * sizeof(float);
+    u8 * normal_base = reinterpret_cast<u8 *>(normals);
+
+    // One extra lane, so the last group of four can be stored whole.
+    std::vector<float> face_x(triangle_count + 4);
+    std::vector<float> face_y(triangle_count + 4);
+    std::vector<float> face_z(triangle_count + 4);
+
+    ParallelFor(triangle_count, kMinTrianglesPerThread, thread_count,
+        [&](u32 begin, u32 end)
+        {
+            ComputeFaceNormals(position_of, indices, begin, end,
+                &face_x[0], &face_y[0], &face_z[0]);
+        });
+
+    const Adjacency adjacency(indices, 3 * triangle_count, vertex_count);
+
+    ParallelFor(vertex_count, kMinVerticesPerThread, thread_count,
+        [&](u32 begin, u32 end)
+        {
+            for (u32 v = begin; v < end; ++v)
+            {
+                Vec3 sum;
+                for (u32 i = adjacency.offsets[v]; i < adjacency.offsets[v + 1]; ++i)
+                {
+                    const u32 t = adjacency.triangles[i];
+                    sum = sum + Vec3(face_x[t], face_y[t], face_z[t]);
+                }
+
+                const Vec3 normal = (Dot(sum, sum) > 0.0f)
+                    ? Normalize(sum)
+                    : Vec3(0.0f, 0.0f, 1.0f);
+
+                float * out = reinterpret_cast<float *>(normal_base + v * normal_stride);
+                out[0] = normal.x;
+                out[1] = normal.y;
+                out[2] = normal.z;
+            }
+        });
+}
+
+void
+blowgun::ComputeTangents(
+    const float * positions,
+    const float * normals,
+    const float * tex_coords,
+    u32 vertex_count,
+    const u32 * indices,
+    u32 index_count,
+    float * tangents,
+    u32 stride,
+    u32 thread_count)
+{
+    const u32 triangle_count = index_count / 3;
+    const Attribute position_of(positions, stride ? stride : 3 * sizeof(float));
+    const Attribute normal_of(normals, stride ? stride : 3 * sizeof(float));
+    const Attribute tex_coord_of(tex_coords, stride ? stride : 2 * sizeof(float));
+    const u32 tangent_stride = stride ? stride : 4 * sizeof(float);
+    u8 * tangent_base = reinterpret_cast<u8 *>(tangents);
+
+    ///
+    // Tangent and bitangent of each triangle, along the directions in
+    // which the texture coordinates grow, weighted by its area.
+    ///
+
+    std::vector<Vec3> face_tangents(triangle_count);
+    std::vector<Vec3> face_bitangents(triangle_count);
+
+    ParallelFor(triangle_count, kMinTrianglesPerThread, thread_count,
+        [&](u32 begin, u32 end)
+        {
+            for (u32 t = begin; t < end; ++t)
+            {
+                const u32 * triangle = indices + 3 * t;
+                const Vec3 p0 = LoadVec3(position_of[triangle[0]]);
+                const Vec3 e1 = LoadVec3(position_of[triangle[1]]) - p0;
+                const Vec3 e2 = LoadVec3(position_of[triangle[2]]) - p0;
+
+                const float * uv0 = tex_coord_of[triangle[0]];
+                const float * uv1 = tex_coord_of[triangle[1]];
+                const float * uv2 = tex_coord_of[triangle[2]];
+                const float du1 = uv1[0] - uv0[0];
+                const float dv1 = uv1[1] - uv0[1];
+                const float du2 = uv2[0] - uv0[0];
+                const float dv2 = uv2[1] - uv0[1];
+
+                // Mirrored texture coordinates flip both directions.
+                const float determinant = du1 * dv2 - du2 * dv1;
+                const float area = Length(Cross(e1, e2));
+                if (determinant == 0.0f || area == 0.0f)
+                {
+                    face_tangents[t] = Vec3();
+                    face_bitangents[t] = Vec3();
+                    continue;
+                }
+
+                const float sign = (determinant > 0.0f) ? area : -area;
+                face_tangents[t] = Normalize(e1 * dv2 - e2 * dv1) * sign;
+                face_bitangents[t] = Normalize(e2 * du1 - e1 * du2) * sign;
+            }
+        });
+
+    ///
+    // Sum them for each vertex, and make the tangent orthogonal to the
+    // normal of the vertex.
+    ///
+
+    const Adjacency adjacency(indices, 3 * triangle_count, vertex_count);
+
+    ParallelFor(vertex_count, kMinVerticesPerThread, thread_count,
+        [&](u32 begin, u32 end)
+        {
+            for (u32 v = begin; v < end; ++v)
+            {
+                Vec3 tangent;
+                Vec3 bitangent;
+                for (u32 i = adjacency.offsets[v]; i < adjacency.offsets[v + 1]; ++i)
+                {
+                    const u32 t = adjacency.triangles[i];
+                    tangent = tangent + face_tangents[t];
+                    bitangent = bitangent + face_bitangents[t];
+                }
+
+                const Vec3 normal = LoadVec3(normal_of[v]);
+                tangent = tangent - normal * Dot(normal, tangent);
+                tangent = (Dot(tangent, tangent) > 1e-20f)
+                    ? Normalize(tangent)
+                    : Orthogonal(normal);
+
+                const float handedness =
+                    (Dot(Cross(normal, tangent), bitangent) < 0.0f) ? -1.0f : 1.0f;
+
+                float * out = reinterpret_cast<float *>(tangent_base + v * tangent_stride);
+                out[0] = tangent.x;
+                out[1] = tangent.y;
+                out[2] = tangent.z;
+                out[3] = handedness;
+            }
+        });
+}
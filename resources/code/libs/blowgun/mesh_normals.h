@@ -0,0 +1,83 @@
+#ifndef BLOWGUN_MESH_NORMALS_H_
+#define BLOWGUN_MESH_NORMALS_H_
+
+#include "types.h"
+
+namespace blowgun
+{
+
+/**
+ * Compute smooth normals for the vertices of indexed triangles.
+ *
+ * The normal of a vertex is the sum of the normals of the triangles
+ * that use it, each weighted by the area of the triangle, normalized.
+ * Vertices that no triangle of non-zero area uses get (0, 0, 1).
+ *
+ * Triangles are spread over several threads, and the normal of each
+ * vertex is summed in triangle order, so the result doesn't depend on
+ * the number of threads.
+ *
+ * @param   positions
+ *          `vertex_count` positions of 3 floats each.
+ * @param   indices
+ *          3 indices per triangle, each lower than `vertex_count`.
+ * @param   normals
+ *          Receives one normal of 3 floats per vertex.
+ * @param   stride
+ *          Byte offset between two consecutive positions, and between
+ *          two consecutive normals. Zero means both are tightly packed.
+ * @param   thread_count
+ *          Upper bound of threads to use, including the calling one.
+ *          Zero means `HardwareThreadCount()`.
+ */
+void ComputeNormals(
+	const float * positions,
+	u32 vertex_count,
+	const u32 * indices,
+	u32 index_count,
+	float * normals,
+	u32 stride = 0,
+	u32 thread_count = 1);
+
+/**
+ * Compute tangents for the vertices of indexed triangles, the way
+ * normal maps baked in MikkTSpace expect them.
+ *
+ * Each triangle contributes its tangent and bitangent, as given by its
+ * texture coordinates, weighted by its area. The tangent of a vertex is
+ * then made orthogonal to its normal, and its fourth component is the
+ * handedness, 1 or -1, so the bitangent is `w * cross(normal, tangent)`.
+ * Vertices without any usable triangle get a tangent orthogonal to
+ * their normal.
+ *
+ * @param   positions
+ *          `vertex_count` positions of 3 floats each.
+ * @param   normals
+ *          One unit-length normal of 3 floats per vertex.
+ * @param   tex_coords
+ *          One texture coordinate of 2 floats per vertex.
+ * @param   indices
+ *          3 indices per triangle, each lower than `vertex_count`.
+ * @param   tangents
+ *          Receives one tangent of 4 floats per vertex.
+ * @param   stride
+ *          Byte offset between two consecutive vertices of each of the
+ *          arrays above. Zero means every array is tightly packed.
+ * @param   thread_count
+ *          Upper bound of threads to use, including the calling one.
+ *          Zero means `HardwareThreadCount()`.
+ */
+void ComputeTangents(
+	const float * positions,
+	const float * normals,
+	const float * tex_coords,
+	u32 vertex_count,
+	const u32 * indices,
+	u32 index_count,
+	float * tangents,
+	u32 stride = 0,
+	u32 thread_count = 1);
+
+}
+
+#endif // BLOWGUN_MESH_NORMALS_H_
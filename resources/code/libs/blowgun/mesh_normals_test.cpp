@@ -0,0 +1,143 @@
+#include <cmath>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "mesh_normals.h"
+
+using namespace blowgun;
+
+TEST(MeshNormalsTest, AreaWeightedNormals)
+{
+    // Two triangles sharing the edge (0, 1), one in the xy plane and
+    // one, three times as large, in the xz plane. The third vertex is
+    // used by a degenerate triangle only.
+    const float positions[] =
+    {
+        0.0f, 0.0f, 0.0f,
+        1.0f, 0.0f, 0.0f,
+        0.0f, 1.0f, 0.0f,
+        0.0f, 0.0f, -3.0f,
+        5.0f, 5.0f, 5.0f,
+    };
+    const u32 indices[] = { 0, 1, 2,  0, 1, 3,  4, 4, 0 };
+
+    float normals[5 * 3];
+    ComputeNormals(positions, 5, indices, 9, normals);
+
+    const float length = std::sqrt(10.0f);
+    EXPECT_NEAR(0.0f, normals[0], 1e-6f);
+    EXPECT_NEAR(3.0f / length, normals[1], 1e-6f);
+    EXPECT_NEAR(1.0f / length, normals[2], 1e-6f);
+    EXPECT_NEAR(1.0f, normals[2 * 3 + 2], 1e-6f);
+    EXPECT_NEAR(1.0f, normals[3 * 3 + 1], 1e-6f);
+
+    // No triangle with an area.
+    EXPECT_EQ(0.0f, normals[4 * 3 + 0]);
+    EXPECT_EQ(0.0f, normals[4 * 3 + 1]);
+    EXPECT_EQ(1.0f, normals[4 * 3 + 2]);
+}
+
+TEST(MeshNormalsTest, StridedTangents)
+{
+    // A quad in the xy plane, with interleaved vertices. The texture is
+    // rotated by 90 degrees: u grows along y, and v along -x.
+    struct Vertex
+    {
+        float position[3];
+        float normal[3];
+        float tex_coord[2];
+        float tangent[4];
+    };
+    Vertex vertices[4] =
+    {
+        { { 0, 0, 0 }, { 0, 0, 0 }, { 0, 1 }, { 0, 0, 0, 0 } },
+        { { 1, 0, 0 }, { 0, 0, 0 }, { 0, 0 }, { 0, 0, 0, 0 } },
+        { { 1, 1, 0 }, { 0, 0, 0 }, { 1, 0 }, { 0, 0, 0, 0 } },
+        { { 0, 1, 0 }, { 0, 0, 0 }, { 1, 1 }, { 0, 0, 0, 0 } },
+    };
+    const u32 indices[] = { 0, 1, 2,  0, 2, 3 };
+
+    ComputeNormals(vertices[0].position, 4, indices, 6, vertices[0].normal, sizeof(Vertex));
+    ComputeTangents(vertices[0].position, vertices[0].normal, vertices[0].tex_coord, 4,
+        indices, 6, vertices[0].tangent, sizeof(Vertex));
+
+    for (u32 i = 0; i < 4; ++i)
+    {
+        EXPECT_NEAR(1.0f, vertices[i].normal[2], 1e-6f);
+        EXPECT_NEAR(0.0f, vertices[i].tangent[0], 1e-6f);
+        EXPECT_NEAR(1.0f, vertices[i].tangent[1], 1e-6f);
+        EXPECT_NEAR(0.0f, vertices[i].tangent[2], 1e-6f);
+
+        // The bitangent, along -x, is cross(normal, tangent).
+        EXPECT_EQ(1.0f, vertices[i].tangent[3]);
+    }
+}
+
+TEST(MeshNormalsTest, DegenerateTexCoords)
+{
+    // Every corner has the same texture coordinate: tangents are still
+    // unit length, and orthogonal to the normal.
+    const float positions[] = { 0, 0, 0,  0, 1, 0,  0, 0, 1 };
+    const float normals[] = { 1, 0, 0,  1, 0, 0,  1, 0, 0 };
+    const float tex_coords[] = { 0.5f, 0.5f,  0.5f, 0.5f,  0.5f, 0.5f };
+    const u32 indices[] = { 0, 1, 2 };
+
+    float tangents[3 * 4];
+    ComputeTangents(positions, normals, tex_coords, 3, indices, 3, tangents);
+
+    for (u32 i = 0; i < 3; ++i)
+    {
+        const float * t = &tangents[4 * i];
+        EXPECT_NEAR(1.0f, t[0] * t[0] + t[1] * t[1] + t[2] * t[2], 1e-6f);
+        EXPECT_NEAR(0.0f, t[0], 1e-6f);
+        EXPECT_EQ(1.0f, std::fabs(t[3]));
+    }
+}
+
+TEST(MeshNormalsTest, ThreadCountDoesNotChangeResult)
+{
+    // A bumpy grid, large enough to be split over several threads.
+    const u32 size = 200;
+    std::vector<float> positions;
+    std::vector<float> tex_coords;
+    for (u32 y = 0; y < size; ++y)
+    {
+        for (u32 x = 0; x < size; ++x)
+        {
+            positions.push_back(static_cast<float>(x));
+            positions.push_back(static_cast<float>(y));
+            positions.push_back(std::sin(x * 0.3f) * std::cos(y * 0.2f));
+            tex_coords.push_back(x / static_cast<float>(size));
+            tex_coords.push_back(y / static_cast<float>(size));
+        }
+    }
+
+    std::vector<u32> indices;
+    for (u32 y = 0; y + 1 < size; ++y)
+    {
+        for (u32 x = 0; x + 1 < size; ++x)
+        {
+            const u32 v = y * size + x;
+            const u32 quad[] = { v, v + 1, v + size + 1,  v, v + size + 1, v + size };
+            indices.insert(indices.end(), quad, quad + 6);
+        }
+    }
+
+    const u32 vertex_count = size * size;
+    const u32 index_count = static_cast<u32>(indices.size());
+
+    std::vector<float> serial_normals(3 * vertex_count);
+    std::vector<float> serial_tangents(4 * vertex_count);
+    ComputeNormals(&positions[0], vertex_count, &indices[0], index_count, &serial_normals[0]);
+    ComputeTangents(&positions[0], &serial_normals[0], &tex_coords[0], vertex_count,
+        &indices[0], index_count, &serial_tangents[0]);
+
+    std::vector<float> normals(3 * vertex_count);
+    std::vector<float> tangents(4 * vertex_count);
+    ComputeNormals(&positions[0], vertex_count, &indices[0], index_count, &normals[0], 0, 4);
+    ComputeTangents(&positions[0], &normals[0], &tex_coords[0], vertex_count,
+        &indices[0], index_count, &tangents[0], 0, 4);
+
+    EXPECT_EQ(serial_normals, normals);
+    EXPECT_EQ(serial_tangents, tangents);
+}
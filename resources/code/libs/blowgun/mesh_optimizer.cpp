@@ -0,0 +1,494 @@
+#include "mesh_optimizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "bounds.h"
+#include "vector.h"
+
+using namespace blowgun;
+
+// Utility
+namespace
+{
+    static const u32 kNoIndex = 0xFFFFFFFF;
+
+    ///
+    // Tom Forsyth's vertex cache optimization, with the constants of
+    // "Linear-Speed Vertex Cache Optimisation".
+    ///
+
+    static const u32   kForsythCacheSize     = 32;
+    static const float kCacheDecayPower      = 1.5f;
+    static const float kLastTriangleScore    = 0.75f;
+    static const float kValenceBoostScale    = 2.0f;
+    static const float kValenceBoostPower    = 0.5f;
+    static const u32   kMaxTabulatedValence  = 32;
+
+    // Scores of a vertex, tabulated by position in the cache and by
+    // number of triangles still using it.
+    class ForsythScores
+    {
+    private:
+        float cache_[kForsythCacheSize];
+        float valence_[kMaxTabulatedValence];
+
+    public:
+        ForsythScores()
+        {
+            for (u32 i = 0; i < kForsythCacheSize; ++i)
+            {
+                // The vertices of the last triangle get a fixed score,
+                // so the next triangle doesn't just reuse its edge and
+                // make a strip.
+                cache_[i] = (i < 3)
+                    ? kLastTriangleScore
+                    : std::pow(1.0f - static_cast<float>(i - 3) / (kForsythCacheSize - 3),
+                        kCacheDecayPower);
+            }
+            for (u32 i = 0; i < kMaxTabulatedValence; ++i)
+            {
+                valence_[i] = (i == 0)
+                    ? 0.0f
+                    : kValenceBoostScale * std::pow(static_cast<float>(i), -kValenceBoostPower);
+            }
+        }
+
+        float
+        Score(u32 cache_position, u32 remaining) const
+        {
+            // Vertices without any triangle left are never picked.
+            if (remaining == 0)
+                return -1.0f;
+
+            const float valence = (remaining < kMaxTabulatedValence)
+                ? valence_[remaining]
+                : kValenceBoostScale * std::pow(static_cast<float>(remaining), -kValenceBoostPower);
+
+            return (cache_position == kNoIndex)
+                ? valence
+                : valence + cache_[cache_position];
+        }
+    };
+
+    // Built once at startup, rather than on first use, so concurrent
+    // first calls don't race on it.
+    static const ForsythScores kForsythScores;
+
+    static Vec3
+    LoadVec3(const u8 * base, u32 stride, u32 vertex)
+    {
+        const float * p = reinterpret_cast<const float *>(base + vertex * stride);
+        return Vec3(p[0], p[1], p[2]);
+    }
+
+    // Consecutive triangles of an index buffer, drawn together.
+    struct Cluster
+    {
+        u32   first;
+        u32   end;
+        float sort_key;
+    };
+
+    static bool
+    DrawsFirst(const Cluster & lhs, const Cluster & rhs)
+    {
+        return lhs.sort_key > rhs.sort_key;
+    }
+}
+
+VertexCacheStatistics
+blowgun::AnalyzeVertexCache(
+    const u32 * indices,
+    u32 index_count,
+    u32 vertex_count,
+    u32 cache_size)
+{
+    // A vertex is in the FIFO as long as fewer than `cache_size` other
+    // vertices were transformed since it was.
+    std::vector<u32> timestamps(vertex_count, 0);
+    std::vector<u8> used(vertex_count, 0);
+    u32 time = cache_size + 1;
+    u32 used_count = 0;
+
+    VertexCacheStatistics statistics;
+    statistics.vertices_transformed = 0;
+
+    for (u32 i = 0; i < index_count; ++i)
+    {
+        const u32 vertex = indices[i];
+        if (time - timestamps[vertex] > cache_size)
+        {
+            timestamps[vertex] = time++;
+            ++statistics.vertices_transformed;
+        }
+        if (!used[vertex])
+        {
+            used[vertex] = 1;
+            ++used_count;
+        }
+    }
+
+    const u32 triangle_count = index_count / 3;
+    statistics.acmr = triangle_count
+        ? static_cast<float>(statistics.vertices_transformed) / triangle_count
+        : 0.0f;
+    statistics.atvr = used_count
+        ? static_cast<float>(statistics.vertices_transformed) / used_count
+        : 0.0f;
+    return statistics;
+}
+
+void
+blowgun::OptimizeVertexCache(
+    const u32 * indices,
+    u32 index_count,
+    u32 vertex_count,
+    u32 * destination)
+{
+    const u32 triangle_count = index_count / 3;
+    if (triangle_count == 0)
+        return;
+
+    ///
+    // Triangles of each vertex. The ones not emitted yet are kept
+    // first, in `[offsets[v], offsets[v] + remaining[v])`.
+    ///
+
+    std::vector<u32> offsets(vertex_count + 1, 0);
+    std::vector<u32> remaining(vertex_count, 0);
+    std::vector<u32> triangles(3 * triangle_count);
+
+    for (u32 i = 0; i < 3 * triangle_count; ++i)
+        ++remaining[indices[i]];
+    for (u32 v = 0; v < vertex_count; ++v)
+        offsets[v + 1] = offsets[v] + remaining[v];
+
+    {
+        std::vector<u32> cursors(offsets.begin(), offsets.end() - 1);
+        for (u32 i = 0; i < 3 * triangle_count; ++i)
+            triangles[cursors[indices[i]]++] = i / 3;
+    }
+
+    std::vector<u32> cache_positions(vertex_count, kNoIndex);
+    std::vector<float> vertex_scores(vertex_count);
+    for (u32 v = 0; v < vertex_count; ++v)
+        vertex_scores[v] = kForsythScores.Score(kNoIndex, remaining[v]);
+
+    std::vector<u8> emitted(triangle_count, 0);
+    u32 best = kNoIndex;
+    float best_score = -1.0f;
+    for (u32 t = 0; t < triangle_count; ++t)
+    {
+        const u32 * triangle = indices + 3 * t;
+        const float score = vertex_scores[triangle[0]] +
+            vertex_scores[triangle[1]] + vertex_scores[triangle[2]];
+        if (score > best_score)
+        {
+            best_score = score;
+            best = t;
+        }
+    }
+
+    // The LRU cache, most recent first, with room for the vertices of
+    // one more triangle before the oldest ones are evicted.
+    u32 cache[kForsythCacheSize + 3];
+    u32 cache_count = 0;
+    u32 next_unemitted = 0;
+
+    for (u32 out = 0; out < triangle_count; ++out)
+    {
+        // When no triangle uses a cached vertex, start again from the
+        // first one that is left.
+        if (best == kNoIndex)
+        {
+            while (emitted[next_unemitted])
+                ++next_unemitted;
+            best = next_unemitted;
+        }
+
+        const u32 * triangle = indices + 3 * best;
+        std::memcpy(destination + 3 * out, triangle, 3 * sizeof(u32));
+        emitted[best] = 1;
+
+        for (u32 k = 0; k < 3; ++k)
+        {
+            const u32 v = triangle[k];
+            u32 * first = &triangles[offsets[v]];
+            u32 * last = first + remaining[v] - 1;
+            *std::find(first, last + 1, best) = *last;
+            --remaining[v];
+        }
+
+        ///
+        // Move the vertices of the triangle to the front of the cache.
+        ///
+
+        u32 new_cache[kForsythCacheSize + 3];
+        u32 new_count = 0;
+        for (u32 k = 0; k < 3; ++k)
+        {
+            if (std::find(new_cache, new_cache + new_count, triangle[k]) == new_cache + new_count)
+                new_cache[new_count++] = triangle[k];
+        }
+        for (u32 i = 0; i < cache_count; ++i)
+        {
+            const u32 v = cache[i];
+            if (v != triangle[0] && v != triangle[1] && v != triangle[2])
+                new_cache[new_count++] = v;
+        }
+
+        for (u32 i = 0; i < new_count; ++i)
+        {
+            const u32 v = new_cache[i];
+            cache_positions[v] = (i < kForsythCacheSize) ? i : kNoIndex;
+            vertex_scores[v] = kForsythScores.Score(cache_positions[v], remaining[v]);
+        }
+
+        ///
+        // Rescore the triangles around the cache, evicted vertices
+        // included, and pick the best one for the next step.
+        ///
+
+        best = kNoIndex;
+        best_score = -1.0f;
+        for (u32 i = 0; i < new_count; ++i)
+        {
+            const u32 v = new_cache[i];
+            for (u32 j = offsets[v]; j < offsets[v] + remaining[v]; ++j)
+            {
+                const u32 t = triangles[j];
+                const u32 * other = indices + 3 * t;
+                const float score = vertex_scores[other[0]] +
+                    vertex_scores[other[1]] + vertex_scores[other[2]];
+                if (score > best_score)
+                {
+                    best_score = score;
+                    best = t;
+                }
+            }
+        }
+
+        cache_count = std::min(new_count, kForsythCacheSize);
+        std::memcpy(cache, new_cache, cache_count * sizeof(u32));
+    }
+}
+
+void
+blowgun::OptimizeOverdraw(
+    const u32 * indices,
+    u32 index_count,
+    const float * positions,
+    u32 vertex_count,
+    u32 stride,
+    u32 * destination,
+    float threshold)
+{
+    const u32 triangle_count = index_count / 3;
+    if (triangle_count == 0)
+        return;
+
+    if (stride == 0)
+        stride = 3 * sizeof(float);
+    const u8 * position_base = reinterpret_cast<const u8 *>(positions);
+
+    ///
+    // Split the triangles in clusters, each one efficient enough on its
+    // own, starting with an empty FIFO cache.
+    ///
+
+    const float target_acmr = threshold * AnalyzeVertexCache(
+        indices, index_count, vertex_count, kDefaultVertexCacheSize).acmr;
+
+    std::vector<Cluster> clusters;
+    std::vector<u32> timestamps(vertex_count, 0);
+    u32 time = kDefaultVertexCacheSize + 1;
+    u32 cluster_first = 0;
+    u32 cluster_misses = 0;
+
+    for (u32 t = 0; t < triangle_count; ++t)
+    {
+        for (u32 k = 0; k < 3; ++k)
+        {
+            const u32 vertex = indices[3 * t + k];
+            if (time - timestamps[vertex] > kDefaultVertexCacheSize)
+            {
+                timestamps[vertex] = time++;
+                ++cluster_misses;
+            }
+        }
+
+        const u32 cluster_size = t + 1 - cluster_first;
+        if (t + 1 == triangle_count || cluster_misses <= target_acmr * cluster_size)
+        {
+            Cluster cluster = { cluster_first, t + 1, 0.0f };
+            clusters.push_back(cluster);
+
+            // Flush the cache for the next cluster.
+            cluster_first = t + 1;
+            cluster_misses = 0;
+            time += kDefaultVertexCacheSize + 1;
+        }
+    }
+
+    ///
+    // Sort them by how much they face away from the center of the
+    // mesh: these are the ones most likely to hide the others.
+    ///
+
+    Vec3 mesh_center;
+    float mesh_area = 0.0f;
+    std::vector<Vec3> cluster_centers(clusters.size());
+    std::vector<Vec3> cluster_normals(clusters.size());
+
+    for (size_t c = 0; c < clusters.size(); ++c)
+    {
+        Vec3 center;
+        Vec3 normal;
+        float area = 0.0f;
+
+        for (u32 t = clusters[c].first; t < clusters[c].end; ++t)
+        {
+            const u32 * triangle = indices + 3 * t;
+            const Vec3 p0 = LoadVec3(position_base, stride, triangle[0]);
+            const Vec3 p1 = LoadVec3(position_base, stride, triangle[1]);
+            const Vec3 p2 = LoadVec3(position_base, stride, triangle[2]);
+
+            const Vec3 face_normal = Cross(p1 - p0, p2 - p0);
+            const float face_area = Length(face_normal);
+
+            center = center + (p0 + p1 + p2) * (face_area / 3.0f);
+            normal = normal + face_normal;
+            area += face_area;
+        }
+
+        mesh_center = mesh_center + center;
+        mesh_area += area;
+        cluster_centers[c] = (area > 0.0f) ? center * (1.0f / area) : center;
+        cluster_normals[c] = Normalize(normal);
+    }
+
+    if (mesh_area > 0.0f)
+        mesh_center = mesh_center * (1.0f / mesh_area);
+
+    for (size_t c = 0; c < clusters.size(); ++c)
+        clusters[c].sort_key = Dot(cluster_centers[c] - mesh_center, cluster_normals[c]);
+
+    std::stable_sort(clusters.begin(), clusters.end(), DrawsFirst);
+
+    u32 out = 0;
+    for (size_t c = 0; c < clusters.size(); ++c)
+    {
+        const u32 count = 3 * (clusters[c].end - clusters[c].first);
+        std::memcpy(destination + out, indices + 3 * clusters[c].first, count * sizeof(u32));
+        out += count;
+    }
+}
+
+u32
+blowgun::OptimizeVertexFetch(
+    u32 * indices,
+    u32 index_count,
+    const u8 * vertices,
+    u32 vertex_count,
+    u32 stride,
+    u8 * destination)
+{
+    std::vector<u32> remap(vertex_count, kNoIndex);
+    u32 used_count = 0;
+
+    for (u32 i = 0; i < index_count; ++i)
+    {
+        const u32 vertex = indices[i];
+        if (remap[vertex] == kNoIndex)
+        {
+            remap[vertex] = used_count;
+            std::memcpy(destination + used_count * stride, vertices + vertex * stride, stride);
+            ++used_count;
+        }
+        indices[i] = remap[vertex];
+    }
+
+    return used_count;
+}
+
+std::shared_ptr<Model>
+blowgun::OptimizeModel(const Model & model, float overdraw_threshold)
+{
+    if (model.index_count() == 0)
+        throw new std::runtime_error("Can't optimize a model without indices.");
+
+    const std::vector<u32> indices = model.ReadIndices();
+    const u32 index_count = model.index_count();
+    const u32 vertex_count = model.vertex_count();
+    const VertexLayout & layout = model.vertex_layout();
+    const u32 stride = layout.stride();
+
+    const VertexElement * position = layout.Find(VertexAttributeUsage::kPosition);
+    const float * positions = (position && position->format == VertexAttributeFormat::kFloat3)
+        ? reinterpret_cast<const float *>(model.vertex_data() + position->offset)
+        : nullptr;
+
+    ///
+    // Triangles never move from one group to another: each range of
+    // indices between two group boundaries is reordered on its own.
+    ///
+
+    std::vector<u32> boundaries;
+    boundaries.push_back(0);
+    boundaries.push_back(index_count);
+    for (size_t i = 0; i < model.groups().size(); ++i)
+    {
+        const ModelGroup & group = model.groups()[i];
+        boundaries.push_back(std::min(group.first_vertex, index_count));
+        boundaries.push_back(std::min(group.first_vertex + group.vertex_count, index_count));
+    }
+    std::sort(boundaries.begin(), boundaries.end());
+    boundaries.erase(std::unique(boundaries.begin(), boundaries.end()), boundaries.end());
+
+    // Trailing indices that don't make a whole triangle are kept as
+    // they are.
+    std::vector<u32> cache_optimized(indices);
+    std::vector<u32> optimized(indices);
+    for (size_t i = 0; i + 1 < boundaries.size(); ++i)
+    {
+        const u32 first = boundaries[i];
+        const u32 count = boundaries[i + 1] - first;
+
+        OptimizeVertexCache(&indices[first], count, vertex_count, &cache_optimized[first]);
+
+        if (positions)
+        {
+            OptimizeOverdraw(&cache_optimized[first], count, positions, vertex_count, stride,
+                &optimized[first], overdraw_threshold);
+        }
+        else
+        {
+            std::copy(cache_optimized.begin() + first, cache_optimized.begin() + first + count,
+                optimized.begin() + first);
+        }
+    }
+
+    ///
+    // Renumber the vertices, dropping the ones no index uses.
+    ///
+
+    std::vector<u8> vertex_data(model.vertex_data_size());
+    const u32 used_count = OptimizeVertexFetch(&optimized[0], index_count,
+        model.vertex_data(), vertex_count, stride, &vertex_data[0]);
+    vertex_data.resize(used_count * stride);
+
+    const Bounds bounds = positions
+        ? ComputeBounds(reinterpret_cast<const float *>(&vertex_data[position->offset]),
+            used_count, stride)
+        : model.bounds();
+
+    auto result = std::make_shared<Model>(layout, std::move(vertex_data), optimized, bounds,
+        model.groups());
+    result->SetPositionDequantization(model.position_offset(), model.position_scale());
+    return result;
+}
@@ -0,0 +1,118 @@
+#ifndef BLOWGUN_MESH_OPTIMIZER_H_
+#define BLOWGUN_MESH_OPTIMIZER_H_
+
+#include <memory>
+
+#include "model.h"
+#include "types.h"
+
+namespace blowgun
+{
+
+/**
+ * Size of the post-transform vertex cache that statistics simulate by
+ * default. Mobile GPUs have a FIFO of 16 to 32 entries.
+ */
+static const u32 kDefaultVertexCacheSize = 16;
+
+/**
+ * How well the triangles of an index buffer reuse the post-transform
+ * vertex cache.
+ */
+struct VertexCacheStatistics
+{
+	/** Number of vertices the vertex shader runs on. */
+	u32   vertices_transformed;
+
+	/**
+	 * Average cache miss ratio: vertices transformed per triangle. 3 is
+	 * the worst, and 0.5 about the best a regular grid can do.
+	 */
+	float acmr;
+
+	/**
+	 * Average transformed vertex ratio: vertices transformed per vertex
+	 * used. 1 is the best.
+	 */
+	float atvr;
+};
+
+/**
+ * Simulate a FIFO vertex cache of `cache_size` entries over `indices`.
+ */
+VertexCacheStatistics AnalyzeVertexCache(
+	const u32 * indices,
+	u32 index_count,
+	u32 vertex_count,
+	u32 cache_size = kDefaultVertexCacheSize);
+
+/**
+ * Reorder triangles so consecutive ones share vertices, with Tom
+ * Forsyth's linear-speed vertex cache optimization: each step emits the
+ * triangle whose vertices score best, from their position in a
+ * simulated LRU cache and the number of triangles still using them.
+ *
+ * `destination` receives `index_count` indices and must not overlap
+ * `indices`.
+ */
+void OptimizeVertexCache(
+	const u32 * indices,
+	u32 index_count,
+	u32 vertex_count,
+	u32 * destination);
+
+/**
+ * Reorder clusters of triangles so the ones facing outward are drawn
+ * first, and hide what is behind them, while keeping the vertex cache
+ * efficiency of `indices`, which should already be optimized by
+ * `OptimizeVertexCache`.
+ *
+ * Clusters end wherever their own cache miss ratio, starting from an
+ * empty cache, is at most `threshold` times the one of the whole index
+ * buffer. Any order of such clusters keeps the cache miss ratio within
+ * about `threshold` of the original.
+ *
+ * @param   positions
+ *          `vertex_count` positions of 3 floats each, `stride` bytes
+ *          apart. Zero means tightly packed.
+ * @param   destination
+ *          Receives `index_count` indices. Must not overlap `indices`.
+ */
+void OptimizeOverdraw(
+	const u32 * indices,
+	u32 index_count,
+	const float * positions,
+	u32 vertex_count,
+	u32 stride,
+	u32 * destination,
+	float threshold = 1.05f);
+
+/**
+ * Renumber vertices in the order the indices first use them, so the
+ * vertex fetch reads memory sequentially, and rewrite `indices` in
+ * place.
+ *
+ * `destination` receives the vertices of `stride` bytes each, used
+ * ones only, and must not overlap `vertices`. Returns how many there
+ * are.
+ */
+u32 OptimizeVertexFetch(
+	u32 * indices,
+	u32 index_count,
+	const u8 * vertices,
+	u32 vertex_count,
+	u32 stride,
+	u8 * destination);
+
+/**
+ * Run the three optimizations above on an indexed model: triangles are
+ * reordered within each group, then vertices are renumbered. The
+ * groups keep their index ranges.
+ *
+ * Throws when `model` isn't indexed.
+ */
+std::shared_ptr<Model> OptimizeModel(const Model & model, float overdraw_threshold = 1.05f);
+
+}
+
+#endif // BLOWGUN_MESH_OPTIMIZER_H_
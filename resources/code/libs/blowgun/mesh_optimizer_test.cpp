@@ -0,0 +1,196 @@
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "mesh_optimizer.h"
+#include "model_loader_obj.h"
+
+using namespace blowgun;
+
+namespace
+{
+    // A grid of `size` by `size` vertices, whose triangles are shuffled
+    // so they reuse the vertex cache badly.
+    struct Grid
+    {
+        std::vector<float> positions;
+        std::vector<u32>   indices;
+        u32                vertex_count;
+
+        Grid() : positions(), indices(), vertex_count(0) {}
+    };
+
+    Grid CreateShuffledGrid(u32 size)
+    {
+        Grid grid;
+        grid.vertex_count = size * size;
+        for (u32 y = 0; y < size; ++y)
+        {
+            for (u32 x = 0; x < size; ++x)
+            {
+                grid.positions.push_back(static_cast<float>(x));
+                grid.positions.push_back(static_cast<float>(y));
+                grid.positions.push_back(0.0f);
+            }
+        }
+
+        for (u32 y = 0; y + 1 < size; ++y)
+        {
+            for (u32 x = 0; x + 1 < size; ++x)
+            {
+                const u32 v = y * size + x;
+                const u32 quad[] = { v, v + 1, v + size + 1,  v, v + size + 1, v + size };
+                grid.indices.insert(grid.indices.end(), quad, quad + 6);
+            }
+        }
+
+        // Fisher-Yates on whole triangles, with a fixed seed.
+        u32 seed = 12345;
+        for (u32 t = static_cast<u32>(grid.indices.size() / 3) - 1; t > 0; --t)
+        {
+            seed = seed * 1664525u + 1013904223u;
+            const u32 other = (seed >> 8) % (t + 1);
+            for (u32 k = 0; k < 3; ++k)
+                std::swap(grid.indices[3 * t + k], grid.indices[3 * other + k]);
+        }
+        return grid;
+    }
+
+    // Triangles of `indices`, in a canonical order, so index buffers
+    // can be compared regardless of the order of their triangles.
+    std::vector<std::vector<u32>> SortedTriangles(const u32 * indices, u32 count)
+    {
+        std::vector<std::vector<u32>> triangles;
+        for (u32 i = 0; i + 3 <= count; i += 3)
+            triangles.push_back(std::vector<u32>(indices + i, indices + i + 3));
+        std::sort(triangles.begin(), triangles.end());
+        return triangles;
+    }
+
+    // Triangles of a group, as the bytes of their vertices.
+    std::vector<std::string> GroupTriangles(const Model & model, const ModelGroup & group)
+    {
+        const std::vector<u32> indices = model.ReadIndices();
+        const u32 stride = model.vertex_layout().stride();
+        const char * vertices = reinterpret_cast<const char *>(model.vertex_data());
+
+        std::vector<std::string> triangles;
+        for (u32 i = group.first_vertex; i < group.first_vertex + group.vertex_count; i += 3)
+        {
+            std::string triangle;
+            for (u32 k = 0; k < 3; ++k)
+                triangle.append(vertices + indices[i + k] * stride, stride);
+            triangles.push_back(triangle);
+        }
+        std::sort(triangles.begin(), triangles.end());
+        return triangles;
+    }
+}
+
+TEST(MeshOptimizerTest, AnalyzeVertexCache)
+{
+    const u32 indices[] = { 0, 1, 2,  2, 1, 3,  0, 1, 2 };
+
+    VertexCacheStatistics statistics = AnalyzeVertexCache(indices, 9, 4);
+    EXPECT_EQ(4u, statistics.vertices_transformed);
+    EXPECT_FLOAT_EQ(4.0f / 3.0f, statistics.acmr);
+    EXPECT_FLOAT_EQ(1.0f, statistics.atvr);
+
+    // With a FIFO of 3 vertices, vertex 3 evicts vertex 0, which then
+    // evicts vertex 1, and so on.
+    statistics = AnalyzeVertexCache(indices, 9, 4, 3);
+    EXPECT_EQ(7u, statistics.vertices_transformed);
+    EXPECT_FLOAT_EQ(7.0f / 4.0f, statistics.atvr);
+}
+
+TEST(MeshOptimizerTest, OptimizeVertexCache)
+{
+    const Grid grid = CreateShuffledGrid(32);
+    const u32 index_count = static_cast<u32>(grid.indices.size());
+
+    std::vector<u32> optimized(index_count);
+    OptimizeVertexCache(&grid.indices[0], index_count, grid.vertex_count, &optimized[0]);
+
+    EXPECT_EQ(SortedTriangles(&grid.indices[0], index_count),
+        SortedTriangles(&optimized[0], index_count));
+
+    const VertexCacheStatistics before =
+        AnalyzeVertexCache(&grid.indices[0], index_count, grid.vertex_count);
+    const VertexCacheStatistics after =
+        AnalyzeVertexCache(&optimized[0], index_count, grid.vertex_count);
+    EXPECT_GT(before.acmr, 2.5f);
+    EXPECT_LT(after.acmr, 0.8f);
+    EXPECT_LT(after.atvr, 1.6f);
+}
+
+TEST(MeshOptimizerTest, OptimizeOverdrawKeepsCacheEfficiency)
+{
+    const Grid grid = CreateShuffledGrid(32);
+    const u32 index_count = static_cast<u32>(grid.indices.size());
+
+    std::vector<u32> cache_optimized(index_count);
+    std::vector<u32> optimized(index_count);
+    OptimizeVertexCache(&grid.indices[0], index_count, grid.vertex_count, &cache_optimized[0]);
+    OptimizeOverdraw(&cache_optimized[0], index_count, &grid.positions[0], grid.vertex_count, 0,
+        &optimized[0], 1.05f);
+
+    EXPECT_EQ(SortedTriangles(&grid.indices[0], index_count),
+        SortedTriangles(&optimized[0], index_count));
+
+    const float before = AnalyzeVertexCache(&cache_optimized[0], index_count, grid.vertex_count).acmr;
+    const float after = AnalyzeVertexCache(&optimized[0], index_count, grid.vertex_count).acmr;
+    EXPECT_LE(after, before * 1.05f + 0.01f);
+}
+
+TEST(MeshOptimizerTest, OptimizeVertexFetch)
+{
+    const u8 vertices[] = { 10, 11, 12, 13, 14 };
+    u32 indices[] = { 3, 1, 4,  4, 1, 0 };
+
+    u8 optimized[5] = { 0 };
+    EXPECT_EQ(4u, OptimizeVertexFetch(indices, 6, vertices, 5, 1, optimized));
+
+    const u32 expected_indices[] = { 0, 1, 2,  2, 1, 3 };
+    const u8 expected_vertices[] = { 13, 11, 14, 10 };
+    EXPECT_TRUE(std::equal(indices, indices + 6, expected_indices));
+    EXPECT_TRUE(std::equal(optimized, optimized + 4, expected_vertices));
+}
+
+TEST(MeshOptimizerTest, OptimizeModel)
+{
+    ModelLoaderOBJ loader;
+    auto model = loader.SetIndexed(true).Load(std::string("data/banana.obj"));
+    auto optimized = OptimizeModel(*model);
+
+    EXPECT_TRUE(model->vertex_layout() == optimized->vertex_layout());
+    EXPECT_EQ(model->vertex_count(), optimized->vertex_count());
+    ASSERT_EQ(model->index_count(), optimized->index_count());
+
+    // Triangles stay in their group.
+    ASSERT_EQ(model->groups().size(), optimized->groups().size());
+    for (size_t i = 0; i < model->groups().size(); ++i)
+    {
+        EXPECT_EQ(GroupTriangles(*model, model->groups()[i]),
+            GroupTriangles(*optimized, optimized->groups()[i]));
+    }
+
+    const std::vector<u32> before = model->ReadIndices();
+    const std::vector<u32> after = optimized->ReadIndices();
+    EXPECT_LT(AnalyzeVertexCache(&after[0], optimized->index_count(), optimized->vertex_count()).acmr,
+        AnalyzeVertexCache(&before[0], model->index_count(), model->vertex_count()).acmr);
+
+    // Vertices are in the order of their first use.
+    u32 next = 0;
+    for (size_t i = 0; i < after.size(); ++i)
+    {
+        ASSERT_LE(after[i], next);
+        if (after[i] == next)
+            ++next;
+    }
+
+    ModelLoaderOBJ expanded_loader;
+    EXPECT_THROW(OptimizeModel(*expanded_loader.Load(std::string("data/cube.obj"))),
+        std::runtime_error *);
+}
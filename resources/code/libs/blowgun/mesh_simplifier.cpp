@@ -0,0 +1,703 @@
+#include "mesh_simplifier.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+#include "bounds.h"
+#include "mesh_optimizer.h"
+#include "parallel.h"
+#include "vector.h"
+
+using namespace blowgun;
+
+// Utility
+namespace
+{
+    // Weight of the quadrics that keep texture seams in place, relative
+    // to the ones of the faces.
+    static const double kSeamWeight = 10.0;
+
+    // Quadric error (Garland and Heckbert): a symmetric 4x4 matrix that
+    // gives the sum of the squared distances to a set of planes, each
+    // one weighted by the area it stands for, and that total area.
+    struct Quadric
+    {
+        double a00, a11, a22, a01, a02, a12;
+        double b0, b1, b2;
+        double c;
+        double weight;
+    };
+
+    // Quadric of the distance to the plane `dot(normal, p) + d = 0`,
+    // where `normal` is unit length.
+    static Quadric
+    PlaneQuadric(const Vec3 & normal, double d, double weight)
+    {
+        Quadric q;
+        q.a00 = weight * normal.x * normal.x;
+        q.a11 = weight * normal.y * normal.y;
+        q.a22 = weight * normal.z * normal.z;
+        q.a01 = weight * normal.x * normal.y;
+        q.a02 = weight * normal.x * normal.z;
+        q.a12 = weight * normal.y * normal.z;
+        q.b0 = weight * normal.x * d;
+        q.b1 = weight * normal.y * d;
+        q.b2 = weight * normal.z * d;
+        q.c = weight * d * d;
+        q.weight = weight;
+        return q;
+    }
+
+    static void
+    Accumulate(Quadric & q, const Quadric & other)
+    {
+        q.a00 += other.a00;
+        q.a11 += other.a11;
+        q.a22 += other.a22;
+        q.a01 += other.a01;
+        q.a02 += other.a02;
+        q.a12 += other.a12;
+        q.b0 += other.b0;
+        q.b1 += other.b1;
+        q.b2 += other.b2;
+        q.c += other.c;
+        q.weight += other.weight;
+    }
+
+    static double
+    Evaluate(const Quadric & q, const Vec3 & p)
+    {
+        const double x = p.x;
+        const double y = p.y;
+        const double z = p.z;
+        const double error =
+            q.a00 * x * x + q.a11 * y * y + q.a22 * z * z +
+            2.0 * (q.a01 * x * y + q.a02 * x * z + q.a12 * y * z) +
+            2.0 * (q.b0 * x + q.b1 * y + q.b2 * z) +
+            q.c;
+
+        // Rounding can make it slightly negative.
+        return (error > 0.0) ? error : 0.0;
+    }
+
+    // What a vertex may do.
+    namespace VertexKind
+    {
+        enum Enum
+        {
+            // Inside the surface, with a position of its own: it may
+            // collapse onto any neighbor.
+            kManifold,
+
+            // On a texture seam, sharing its position with exactly one
+            // other vertex: both collapse together, along the seam.
+            kSeam,
+
+            // On an open border, or anything more complex: it stays.
+            kLocked
+        };
+    }
+
+    struct Collapse
+    {
+        u32    from;
+        u32    to;
+        double error;
+    };
+
+    static bool
+    IsCheaper(const Collapse & lhs, const Collapse & rhs)
+    {
+        return lhs.error < rhs.error;
+    }
+
+    // Directed edges of a set of triangles, searchable.
+    class EdgeSet
+    {
+    private:
+        std::vector<u64> keys_;
+
+        static u64
+        Key(u32 from, u32 to)
+        {
+            return (static_cast<u64>(from) << 32) | to;
+        }
+
+    public:
+        EdgeSet() : keys_() {}
+
+        // Collect the edges of `indices`, through `remap` if not null.
+        void
+        Build(const u32 * indices, u32 count, const std::vector<u32> * remap)
+        {
+            keys_.resize(count);
+            for (u32 i = 0; i < count; ++i)
+            {
+                const u32 from = indices[i];
+                const u32 to = indices[(i % 3 == 2) ? i - 2 : i + 1];
+                keys_[i] = remap
+                    ? Key((*remap)[from], (*remap)[to])
+                    : Key(from, to);
+            }
+            std::sort(keys_.begin(), keys_.end());
+        }
+
+        bool
+        Contains(u32 from, u32 to) const
+        {
+            return std::binary_search(keys_.begin(), keys_.end(), Key(from, to));
+        }
+    };
+
+    // Strided positions.
+    struct Positions
+    {
+        const u8 * base;
+        u32        stride;
+
+        Vec3
+        operator[](u32 vertex) const
+        {
+            const float * p = reinterpret_cast<const float *>(base + vertex * stride);
+            return Vec3(p[0], p[1], p[2]);
+        }
+
+        bool
+        Less(u32 lhs, u32 rhs) const
+        {
+            const Vec3 a = (*this)[lhs];
+            const Vec3 b = (*this)[rhs];
+            if (a.x != b.x)
+                return a.x < b.x;
+            if (a.y != b.y)
+                return a.y < b.y;
+            return a.z < b.z;
+        }
+    };
+
+    // Check whether moving `from` onto `to` turns any of the triangles
+    // around the position of `from` over, or makes one degenerate.
+    static bool
+    Flips(u32 from, u32 to, const u32 * indices, const std::vector<u32> & offsets,
+        const std::vector<u32> & triangles, const std::vector<u32> & position_ids,
+        const Positions & positions)
+    {
+        const u32 from_position = position_ids[from];
+        const u32 to_position = position_ids[to];
+        const Vec3 target = positions[to];
+
+        for (u32 i = offsets[from_position]; i < offsets[from_position + 1]; ++i)
+        {
+            const u32 * triangle = indices + 3 * triangles[i];
+
+            Vec3 before[3];
+            Vec3 after[3];
+            bool collapses = false;
+            for (u32 k = 0; k < 3; ++k)
+            {
+                const u32 position = position_ids[triangle[k]];
+                collapses = collapses || (position == to_position);
+                before[k] = positions[triangle[k]];
+                after[k] = (position == from_position) ? target : before[k];
+            }
+
+            // Triangles along the edge disappear anyway.
+            if (collapses)
+                continue;
+
+            const Vec3 normal_before = Cross(before[1] - before[0], before[2] - before[0]);
+            const Vec3 normal_after = Cross(after[1] - after[0], after[2] - after[0]);
+            if (Dot(normal_before, normal_after) <= 0.0f)
+                return true;
+        }
+
+        return false;
+    }
+}
+
+u32
+blowgun::SimplifyMesh(
+    const u32 * indices,
+    u32 index_count,
+    const float * positions,
+    u32 vertex_count,
+    u32 stride,
+    u32 target_index_count,
+    u32 * destination,
+    float * result_error)
+{
+    Positions position_of;
+    position_of.base = reinterpret_cast<const u8 *>(positions);
+    position_of.stride = stride ? stride : 3 * sizeof(float);
+
+    u32 count = index_count / 3 * 3;
+    if (destination != indices)
+        std::copy(indices, indices + count, destination);
+
+    double max_error = 0.0;
+
+    ///
+    // Vertices that share a position: `position_ids` maps each one to
+    // the first of them, and `wedges` links each one to the next, in a
+    // cycle. Quadrics and neighborhoods are by position.
+    ///
+
+    std::vector<u32> order(vertex_count);
+    for (u32 v = 0; v < vertex_count; ++v)
+        order[v] = v;
+    std::sort(order.begin(), order.end(),
+        [&](u32 lhs, u32 rhs) { return position_of.Less(lhs, rhs); });
+
+    std::vector<u32> position_ids(vertex_count);
+    std::vector<u32> wedges(vertex_count);
+    for (u32 first = 0; first < vertex_count; )
+    {
+        u32 end = first + 1;
+        while (end < vertex_count && !position_of.Less(order[first], order[end]))
+            ++end;
+
+        for (u32 i = first; i < end; ++i)
+        {
+            position_ids[order[i]] = order[first];
+            wedges[order[i]] = order[(i + 1 < end) ? i + 1 : first];
+        }
+        first = end;
+    }
+
+    std::vector<Quadric> quadrics;
+    std::vector<u8> kinds(vertex_count);
+    std::vector<u32> border_out(vertex_count);
+    std::vector<u32> border_in(vertex_count);
+    std::vector<u8> open_positions(vertex_count);
+    std::vector<u32> offsets(vertex_count + 1);
+    std::vector<u32> triangles;
+    std::vector<u32> remap(vertex_count);
+    std::vector<u8> touched(vertex_count);
+    std::vector<Collapse> collapses;
+    EdgeSet vertex_edges;
+    EdgeSet position_edges;
+
+    // Each pass collapses as many edges as it can without two of them
+    // touching the same triangles, and then rebuilds everything.
+    while (count > target_index_count)
+    {
+        const u32 triangle_count = count / 3;
+
+        ///
+        // Classify the vertices. An edge without its opposite is on a
+        // seam when the positions have it, and on an open border when
+        // even they don't.
+        ///
+
+        vertex_edges.Build(destination, count, nullptr);
+        position_edges.Build(destination, count, &position_ids);
+
+        std::fill(border_out.begin(), border_out.end(), 0);
+        std::fill(border_in.begin(), border_in.end(), 0);
+        std::fill(open_positions.begin(), open_positions.end(), 0);
+
+        for (u32 i = 0; i < count; ++i)
+        {
+            const u32 from = destination[i];
+            const u32 to = destination[(i % 3 == 2) ? i - 2 : i + 1];
+            if (!vertex_edges.Contains(to, from))
+            {
+                ++border_out[from];
+                ++border_in[to];
+            }
+            if (!position_edges.Contains(position_ids[to], position_ids[from]))
+            {
+                open_positions[position_ids[from]] = 1;
+                open_positions[position_ids[to]] = 1;
+            }
+        }
+
+        for (u32 v = 0; v < vertex_count; ++v)
+        {
+            if (open_positions[position_ids[v]])
+                kinds[v] = VertexKind::kLocked;
+            else if (wedges[v] == v)
+                kinds[v] = (border_out[v] == 0) ? VertexKind::kManifold : VertexKind::kLocked;
+            else if (wedges[wedges[v]] == v && border_out[v] == 1 && border_in[v] == 1)
+                kinds[v] = VertexKind::kSeam;
+            else
+                kinds[v] = VertexKind::kLocked;
+        }
+
+        ///
+        // On the first pass, sum the quadrics of the faces around each
+        // position, and of the planes through the seams, which keep
+        // them where they are.
+        ///
+
+        if (quadrics.empty())
+        {
+            Quadric zero;
+            std::memset(&zero, 0, sizeof(zero));
+            quadrics.assign(vertex_count, zero);
+
+            for (u32 t = 0; t < triangle_count; ++t)
+            {
+                const u32 * triangle = destination + 3 * t;
+                const Vec3 p0 = position_of[triangle[0]];
+                const Vec3 p1 = position_of[triangle[1]];
+                const Vec3 p2 = position_of[triangle[2]];
+
+                const Vec3 cross = Cross(p1 - p0, p2 - p0);
+                const float area = Length(cross);
+                if (area == 0.0f)
+                    continue;
+
+                const Vec3 normal = cross * (1.0f / area);
+                const Quadric face = PlaneQuadric(normal, -Dot(normal, p0), 0.5 * area);
+                for (u32 k = 0; k < 3; ++k)
+                    Accumulate(quadrics[position_ids[triangle[k]]], face);
+
+                for (u32 k = 0; k < 3; ++k)
+                {
+                    const u32 from = triangle[k];
+                    const u32 to = triangle[(k + 1) % 3];
+                    if (vertex_edges.Contains(to, from))
+                        continue;
+
+                    const Vec3 edge = position_of[to] - position_of[from];
+                    const Vec3 seam_normal = Normalize(Cross(edge, normal));
+                    const Quadric seam = PlaneQuadric(seam_normal,
+                        -Dot(seam_normal, position_of[from]),
+                        kSeamWeight * Dot(edge, edge));
+                    Accumulate(quadrics[position_ids[from]], seam);
+                    Accumulate(quadrics[position_ids[to]], seam);
+                }
+            }
+        }
+
+        ///
+        // List the allowed collapses, cheapest first.
+        ///
+
+        collapses.clear();
+        for (u32 i = 0; i < count; ++i)
+        {
+            const u32 a = destination[i];
+            const u32 b = destination[(i % 3 == 2) ? i - 2 : i + 1];
+            const bool on_seam = !vertex_edges.Contains(b, a);
+
+            const u32 ends[2][2] = { { a, b }, { b, a } };
+            for (u32 e = 0; e < 2; ++e)
+            {
+                const u32 from = ends[e][0];
+                const u32 to = ends[e][1];
+
+                if (kinds[from] == VertexKind::kLocked)
+                    continue;
+
+                // A seam vertex moves along the seam, and the vertex on
+                // the other side of it follows along the matching edge.
+                if (kinds[from] == VertexKind::kSeam &&
+                    (!on_seam || kinds[to] != VertexKind::kSeam ||
+                        kinds[wedges[from]] != VertexKind::kSeam ||
+                        kinds[wedges[to]] != VertexKind::kSeam ||
+                        !(vertex_edges.Contains(wedges[a], wedges[b]) ||
+                            vertex_edges.Contains(wedges[b], wedges[a]))))
+                {
+                    continue;
+                }
+
+                Collapse collapse;
+                collapse.from = from;
+                collapse.to = to;
+                collapse.error = Evaluate(quadrics[position_ids[from]], position_of[to]);
+                collapses.push_back(collapse);
+            }
+        }
+
+        std::sort(collapses.begin(), collapses.end(), IsCheaper);
+
+        ///
+        // Triangles around each position, to check for flips.
+        ///
+
+        std::fill(offsets.begin(), offsets.end(), 0);
+        for (u32 i = 0; i < count; ++i)
+            ++offsets[position_ids[destination[i]] + 1];
+        for (u32 v = 0; v < vertex_count; ++v)
+            offsets[v + 1] += offsets[v];
+
+        triangles.resize(count);
+        {
+            std::vector<u32> cursors(offsets.begin(), offsets.end() - 1);
+            for (u32 i = 0; i < count; ++i)
+                triangles[cursors[position_ids[destination[i]]]++] = i / 3;
+        }
+
+        ///
+        // Apply the cheapest collapses, each one far enough from the
+        // others that they don't interfere, until enough triangles are
+        // gone. Each collapse removes about two.
+        ///
+
+        const u32 triangles_to_remove = (count - target_index_count + 2) / 3;
+        u32 removed = 0;
+        u32 applied = 0;
+
+        std::fill(touched.begin(), touched.end(), 0);
+        for (u32 v = 0; v < vertex_count; ++v)
+            remap[v] = v;
+
+        for (size_t i = 0; i < collapses.size() && removed < triangles_to_remove; ++i)
+        {
+            const Collapse & collapse = collapses[i];
+            const u32 from_position = position_ids[collapse.from];
+            const u32 to_position = position_ids[collapse.to];
+
+            if (touched[from_position] || touched[to_position])
+                continue;
+            if (Flips(collapse.from, collapse.to, destination, offsets, triangles,
+                position_ids, position_of))
+            {
+                continue;
+            }
+
+            remap[collapse.from] = collapse.to;
+            if (kinds[collapse.from] == VertexKind::kSeam)
+                remap[wedges[collapse.from]] = wedges[collapse.to];
+
+            const double weight = quadrics[from_position].weight;
+            if (weight > 0.0)
+                max_error = std::max(max_error, std::sqrt(collapse.error / weight));
+            Accumulate(quadrics[to_position], quadrics[from_position]);
+
+            for (u32 j = offsets[from_position]; j < offsets[from_position + 1]; ++j)
+            {
+                const u32 * triangle = destination + 3 * triangles[j];
+                for (u32 k = 0; k < 3; ++k)
+                    touched[position_ids[triangle[k]]] = 1;
+            }
+
+            removed += 2;
+            ++applied;
+        }
+
+        if (applied == 0)
+            break;
+
+        ///
+        // Rewrite the triangles, dropping the ones that collapsed.
+        ///
+
+        u32 out = 0;
+        for (u32 t = 0; t < triangle_count; ++t)
+        {
+            const u32 a = remap[destination[3 * t + 0]];
+            const u32 b = remap[destination[3 * t + 1]];
+            const u32 c = remap[destination[3 * t + 2]];
+            const u32 pa = position_ids[a];
+            const u32 pb = position_ids[b];
+            const u32 pc = position_ids[c];
+            if (pa == pb || pb == pc || pa == pc)
+                continue;
+
+            destination[out++] = a;
+            destination[out++] = b;
+            destination[out++] = c;
+        }
+        count = out;
+    }
+
+    if (result_error)
+        *result_error = static_cast<float>(max_error);
+    return count;
+}
+
+std::shared_ptr<Model>
+blowgun::SimplifyModel(const Model & model, float triangle_ratio, float * result_error)
+{
+    if (model.index_count() == 0)
+        throw new std::runtime_error("Can't simplify a model without indices.");
+
+    const VertexLayout & layout = model.vertex_layout();
+    const VertexElement * position = layout.Find(VertexAttributeUsage::kPosition);
+    if (!position || position->format != VertexAttributeFormat::kFloat3)
+        throw new std::runtime_error("Can't simplify a model without float positions.");
+
+    const std::vector<u32> indices = model.ReadIndices();
+    const u32 index_count = model.index_count();
+    const u32 vertex_count = model.vertex_count();
+    const u32 stride = layout.stride();
+    const float * positions =
+        reinterpret_cast<const float *>(model.vertex_data() + position->offset);
+
+    ///
+    // Simplify each range of indices between two group boundaries on
+    // its own, so triangles stay in their group, and keep at least one
+    // triangle in each.
+    ///
+
+    std::vector<u32> boundaries;
+    boundaries.push_back(0);
+    boundaries.push_back(index_count);
+    for (size_t i = 0; i < model.groups().size(); ++i)
+    {
+        const ModelGroup & group = model.groups()[i];
+        boundaries.push_back(std::min(group.first_vertex, index_count));
+        boundaries.push_back(std::min(group.first_vertex + group.vertex_count, index_count));
+    }
+    std::sort(boundaries.begin(), boundaries.end());
+    boundaries.erase(std::unique(boundaries.begin(), boundaries.end()), boundaries.end());
+
+    std::vector<u32> simplified(index_count);
+    std::vector<u32> new_boundaries(boundaries.size());
+    std::vector<u32> segment;
+    u32 out = 0;
+    float max_error = 0.0f;
+
+    for (size_t i = 0; i + 1 < boundaries.size(); ++i)
+    {
+        new_boundaries[i] = out;
+
+        const u32 first = boundaries[i];
+        const u32 count = boundaries[i + 1] - first;
+        const u32 target = std::max(1u,
+            static_cast<u32>(count / 3 * std::max(0.0f, triangle_ratio))) * 3;
+
+        float error = 0.0f;
+        segment.resize(count);
+        const u32 segment_count = SimplifyMesh(&indices[first], count, positions,
+            vertex_count, stride, target, &segment[0], &error);
+        max_error = std::max(max_error, error);
+
+        OptimizeVertexCache(&segment[0], segment_count, vertex_count, &simplified[out]);
+        out += segment_count;
+    }
+    new_boundaries.back() = out;
+    simplified.resize(out);
+
+    std::vector<ModelGroup> groups(model.groups());
+    for (size_t i = 0; i < groups.size(); ++i)
+    {
+        const u32 group_first = std::min(groups[i].first_vertex, index_count);
+        const u32 group_end = std::min(groups[i].first_vertex + groups[i].vertex_count, index_count);
+        const size_t first = std::lower_bound(boundaries.begin(), boundaries.end(), group_first) -
+            boundaries.begin();
+        const size_t end = std::lower_bound(boundaries.begin(), boundaries.end(), group_end) -
+            boundaries.begin();
+        groups[i].first_vertex = new_boundaries[first];
+        groups[i].vertex_count = new_boundaries[end] - new_boundaries[first];
+    }
+
+    ///
+    // Keep only the vertices that are still used.
+    ///
+
+    std::vector<u8> vertex_data(model.vertex_data_size());
+    const u32 used_count = simplified.empty() ? 0 : OptimizeVertexFetch(&simplified[0], out,
+        model.vertex_data(), vertex_count, stride, &vertex_data[0]);
+    vertex_data.resize(used_count * stride);
+
+    // The bounds are in model units, the positions in stored ones.
+    const Vec3 & offset = model.position_offset();
+    const float scale = model.position_scale();
+    Bounds bounds = ComputeBounds(
+        used_count ? reinterpret_cast<const float *>(&vertex_data[position->offset]) : nullptr,
+        used_count, stride);
+    bounds.aabb.min = offset + bounds.aabb.min * scale;
+    bounds.aabb.max = offset + bounds.aabb.max * scale;
+    bounds.sphere.center = offset + bounds.sphere.center * scale;
+    bounds.sphere.radius *= scale;
+
+    if (result_error)
+        *result_error = max_error * scale;
+
+    std::shared_ptr<Model> result = std::make_shared<Model>(layout, std::move(vertex_data),
+        simplified, bounds, std::move(groups));
+    result->SetPositionDequantization(offset, scale);
+    return result;
+}
+
+std::vector<ModelLod>
+blowgun::BuildLodChain(
+    const std::shared_ptr<Model> & model,
+    const std::vector<float> & triangle_ratios)
+{
+    std::vector<ModelLod> chain;
+
+    ModelLod original;
+    original.model = model;
+    original.error = 0.0f;
+    chain.push_back(original);
+
+    const float original_triangles = static_cast<float>(model->index_count() / 3);
+    for (size_t i = 0; i < triangle_ratios.size(); ++i)
+    {
+        const ModelLod & previous = chain.back();
+        const float previous_triangles = static_cast<float>(previous.model->index_count() / 3);
+        const float ratio = (previous_triangles > 0.0f)
+            ? std::min(1.0f, triangle_ratios[i] * original_triangles / previous_triangles)
+            : 1.0f;
+
+        // Errors add up, since each level only knows how far it is
+        // from the previous one.
+        float error = 0.0f;
+        ModelLod level;
+        level.model = SimplifyModel(*previous.model, ratio, &error);
+        level.error = previous.error + error;
+        chain.push_back(level);
+    }
+
+    return chain;
+}
+
+std::vector<std::vector<ModelLod>>
+blowgun::BuildLodChains(
+    const std::vector<std::shared_ptr<Model>> & models,
+    const std::vector<float> & triangle_ratios,
+    u32 thread_count)
+{
+    std::vector<std::vector<ModelLod>> chains(models.size());
+
+    ParallelFor(static_cast<u32>(models.size()), 1, thread_count,
+        [&](u32 begin, u32 end)
+        {
+            for (u32 i = begin; i < end; ++i)
+                chains[i] = BuildLodChain(models[i], triangle_ratios);
+        });
+
+    return chains;
+}
+
+float
+blowgun::ProjectedSize(
+    const Matrix & projection,
+    float size,
+    float distance,
+    float viewport_height)
+{
+    // The projection scales y by `value(5)`, and a perspective one then
+    // divides by the distance, which it copies to w through `value(11)`.
+    const float scale = projection.value(5) * 0.5f * viewport_height;
+    if (projection.value(11) == 0.0f)
+        return size * scale;
+
+    return size * scale / std::max(distance, 1e-6f);
+}
+
+u32
+blowgun::SelectLod(
+    const std::vector<ModelLod> & chain,
+    const Matrix & projection,
+    float distance,
+    float viewport_height,
+    float max_pixel_error)
+{
+    u32 selected = 0;
+    for (u32 i = 1; i < chain.size(); ++i)
+    {
+        if (ProjectedSize(projection, chain[i].error, distance, viewport_height) > max_pixel_error)
+            break;
+        selected = i;
+    }
+    return selected;
+}
@@ -0,0 +1,124 @@
+#ifndef BLOWGUN_MESH_SIMPLIFIER_H_
+#define BLOWGUN_MESH_SIMPLIFIER_H_
+
+#include <memory>
+#include <vector>
+
+#include "matrix.h"
+#include "model.h"
+#include "types.h"
+
+namespace blowgun
+{
+
+/**
+ * Simplify indexed triangles down to about `target_index_count`
+ * indices, by collapsing edges in order of quadric error (Garland and
+ * Heckbert).
+ *
+ * Each collapse moves a vertex onto one of its neighbors, so no vertex
+ * is created and every attribute stays exact. Vertices that share a
+ * position, such as the two sides of a texture seam, only collapse
+ * together, along the seam, so texture coordinates don't stretch
+ * across it. Open borders and positions shared by more than two
+ * vertices never move.
+ *
+ * @param   positions
+ *          `vertex_count` positions of 3 floats each, `stride` bytes
+ *          apart. Zero means tightly packed.
+ * @param   destination
+ *          Receives the remaining triangles, as indices into the same
+ *          vertices. May be `indices` itself.
+ * @param   result_error
+ *          If not null, receives how far the result strays from the
+ *          original surface, approximately, in the units of the
+ *          positions.
+ * @return  The number of indices written to `destination`, which is
+ *          more than the target when no collapse is left.
+ */
+u32 SimplifyMesh(
+	const u32 * indices,
+	u32 index_count,
+	const float * positions,
+	u32 vertex_count,
+	u32 stride,
+	u32 target_index_count,
+	u32 * destination,
+	float * result_error = nullptr);
+
+/**
+ * Simplify an indexed model to about `triangle_ratio` of its
+ * triangles. Each group is simplified on its own, and the vertices no
+ * triangle uses anymore are dropped. The result keeps the position
+ * dequantization of `model`, and `result_error` is in model units.
+ *
+ * Throws when `model` isn't indexed or its positions aren't floats.
+ */
+std::shared_ptr<Model> SimplifyModel(
+	const Model & model,
+	float triangle_ratio,
+	float * result_error = nullptr);
+
+/**
+ * One level of detail of a model.
+ */
+struct ModelLod
+{
+	std::shared_ptr<Model> model;
+
+	/**
+	 * How far the level strays from the original model, in model units.
+	 * Zero for the original.
+	 */
+	float error;
+
+	ModelLod() : model(), error(0.0f) {}
+};
+
+/**
+ * Build levels of detail of `model`: the model itself, then one level
+ * per ratio of its triangles, in the order given, which should be
+ * decreasing. Each level is simplified from the previous one.
+ */
+std::vector<ModelLod> BuildLodChain(
+	const std::shared_ptr<Model> & model,
+	const std::vector<float> & triangle_ratios);
+
+/**
+ * Build the chains of several models, spread over several threads.
+ *
+ * @param   thread_count
+ *          Upper bound of threads to use, including the calling one.
+ *          Zero means `HardwareThreadCount()`.
+ */
+std::vector<std::vector<ModelLod>> BuildLodChains(
+	const std::vector<std::shared_ptr<Model>> & models,
+	const std::vector<float> & triangle_ratios,
+	u32 thread_count = 1);
+
+/**
+ * Get how many pixels a length of `size`, at `distance` in front of
+ * the camera, covers vertically once projected with `projection`. The
+ * distance doesn't matter for orthographic projections.
+ */
+float ProjectedSize(
+	const Matrix & projection,
+	float size,
+	float distance,
+	float viewport_height);
+
+/**
+ * Pick the coarsest level of `chain` whose error covers at most
+ * `max_pixel_error` pixels on screen, for a model at `distance` in
+ * front of the camera.
+ */
+u32 SelectLod(
+	const std::vector<ModelLod> & chain,
+	const Matrix & projection,
+	float distance,
+	float viewport_height,
+	float max_pixel_error = 1.0f);
+
+}
+
+#endif // BLOWGUN_MESH_SIMPLIFIER_H_
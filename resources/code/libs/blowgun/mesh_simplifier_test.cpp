@@ -0,0 +1,235 @@
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "mesh_simplifier.h"
+#include "model_loader_obj.h"
+
+using namespace blowgun;
+
+namespace
+{
+    // A flat grid of `size` by `size` quads in the xy plane, split in
+    // two charts down the middle: the column of vertices at the split
+    // is duplicated, as a texture seam would be.
+    struct SeamGrid
+    {
+        std::vector<float> positions;
+        std::vector<u32>   charts;
+        std::vector<u32>   indices;
+
+        SeamGrid() : positions(), charts(), indices() {}
+    };
+
+    SeamGrid CreateSeamGrid(u32 size)
+    {
+        SeamGrid grid;
+        const u32 split = size / 2;
+
+        // Vertex of each chart at (x, y).
+        std::vector<u32> left((size + 1) * (size + 1), 0);
+        std::vector<u32> right((size + 1) * (size + 1), 0);
+        for (u32 y = 0; y <= size; ++y)
+        {
+            for (u32 x = 0; x <= size; ++x)
+            {
+                for (u32 chart = 0; chart < 2; ++chart)
+                {
+                    if ((chart == 0 && x > split) || (chart == 1 && x < split))
+                        continue;
+
+                    // Bump it a bit, so the grid isn't flat.
+                    const u32 vertex = static_cast<u32>(grid.charts.size());
+                    grid.positions.push_back(static_cast<float>(x));
+                    grid.positions.push_back(static_cast<float>(y));
+                    grid.positions.push_back(0.05f * std::sin(0.3f * x) * std::cos(0.4f * y));
+                    grid.charts.push_back(chart);
+                    (chart == 0 ? left : right)[y * (size + 1) + x] = vertex;
+                }
+            }
+        }
+
+        for (u32 y = 0; y < size; ++y)
+        {
+            for (u32 x = 0; x < size; ++x)
+            {
+                const std::vector<u32> & chart = (x < split) ? left : right;
+                const u32 v00 = chart[y * (size + 1) + x];
+                const u32 v10 = chart[y * (size + 1) + x + 1];
+                const u32 v01 = chart[(y + 1) * (size + 1) + x];
+                const u32 v11 = chart[(y + 1) * (size + 1) + x + 1];
+                const u32 quad[] = { v00, v10, v11,  v00, v11, v01 };
+                grid.indices.insert(grid.indices.end(), quad, quad + 6);
+            }
+        }
+        return grid;
+    }
+}
+
+TEST(MeshSimplifierTest, SimplifyKeepsSeams)
+{
+    const SeamGrid grid = CreateSeamGrid(24);
+    const u32 index_count = static_cast<u32>(grid.indices.size());
+    const u32 vertex_count = static_cast<u32>(grid.charts.size());
+
+    std::vector<u32> simplified(index_count);
+    float error = -1.0f;
+    const u32 count = SimplifyMesh(&grid.indices[0], index_count, &grid.positions[0],
+        vertex_count, 0, index_count / 4, &simplified[0], &error);
+
+    EXPECT_LE(count, index_count / 4 + 6);
+    EXPECT_EQ(0u, count % 3);
+    EXPECT_GE(error, 0.0f);
+    EXPECT_LT(error, 0.05f);
+
+    // Each triangle stays within one chart.
+    for (u32 i = 0; i < count; i += 3)
+    {
+        EXPECT_EQ(grid.charts[simplified[i]], grid.charts[simplified[i + 1]]);
+        EXPECT_EQ(grid.charts[simplified[i]], grid.charts[simplified[i + 2]]);
+    }
+
+    // The outline is an open border, and doesn't move: the corners of
+    // the grid are still there.
+    const float corners[4][2] = { { 0, 0 }, { 24, 0 }, { 0, 24 }, { 24, 24 } };
+    for (u32 c = 0; c < 4; ++c)
+    {
+        bool found = false;
+        for (u32 i = 0; i < count; ++i)
+        {
+            const float * position = &grid.positions[3 * simplified[i]];
+            found = found || (position[0] == corners[c][0] && position[1] == corners[c][1]);
+        }
+        EXPECT_TRUE(found);
+    }
+}
+
+TEST(MeshSimplifierTest, SimplifyInPlace)
+{
+    const SeamGrid grid = CreateSeamGrid(8);
+    std::vector<u32> indices(grid.indices);
+    const u32 count = SimplifyMesh(&indices[0], static_cast<u32>(indices.size()),
+        &grid.positions[0], static_cast<u32>(grid.charts.size()), 0,
+        static_cast<u32>(indices.size()) / 2, &indices[0]);
+
+    EXPECT_LT(count, grid.indices.size());
+    EXPECT_GT(count, 0u);
+}
+
+TEST(MeshSimplifierTest, SimplifyModel)
+{
+    ModelLoaderOBJ loader;
+    auto model = loader.SetIndexed(true).Load(std::string("data/banana.obj"));
+
+    float error = -1.0f;
+    auto simplified = SimplifyModel(*model, 0.25f, &error);
+
+    EXPECT_TRUE(model->vertex_layout() == simplified->vertex_layout());
+    EXPECT_LE(simplified->index_count(), model->index_count() * 3 / 10);
+    EXPECT_LT(simplified->vertex_count(), model->vertex_count());
+    EXPECT_GT(error, 0.0f);
+    EXPECT_LT(error, 0.05f * model->bounds().sphere.radius);
+
+    // Vertices are the original ones, attributes included.
+    const u32 stride = model->vertex_layout().stride();
+    for (u32 v = 0; v < simplified->vertex_count(); v += 97)
+    {
+        bool found = false;
+        for (u32 w = 0; w < model->vertex_count() && !found; ++w)
+        {
+            found = std::memcmp(simplified->vertex_data() + v * stride,
+                model->vertex_data() + w * stride, stride) == 0;
+        }
+        EXPECT_TRUE(found);
+    }
+
+    // Groups cover the new index buffer, in the same order.
+    ASSERT_EQ(model->groups().size(), simplified->groups().size());
+    u32 next = 0;
+    for (size_t i = 0; i < simplified->groups().size(); ++i)
+    {
+        EXPECT_EQ(model->groups()[i].name, simplified->groups()[i].name);
+        EXPECT_EQ(next, simplified->groups()[i].first_vertex);
+        EXPECT_GT(simplified->groups()[i].vertex_count, 0u);
+        next += simplified->groups()[i].vertex_count;
+    }
+    EXPECT_EQ(simplified->index_count(), next);
+
+    // Positions stored in other units keep their mapping to model ones.
+    model->SetPositionDequantization(Vec3(1.0f, 2.0f, 3.0f), 4.0f);
+    float scaled_error = -1.0f;
+    auto scaled = SimplifyModel(*model, 0.25f, &scaled_error);
+    EXPECT_EQ(1.0f, scaled->position_offset().x);
+    EXPECT_EQ(3.0f, scaled->position_offset().z);
+    EXPECT_EQ(4.0f, scaled->position_scale());
+    EXPECT_FLOAT_EQ(4.0f * error, scaled_error);
+    EXPECT_FLOAT_EQ(2.0f + 4.0f * simplified->bounds().aabb.min.y, scaled->bounds().aabb.min.y);
+    EXPECT_FLOAT_EQ(4.0f * simplified->bounds().sphere.radius, scaled->bounds().sphere.radius);
+
+    ModelLoaderOBJ expanded_loader;
+    EXPECT_THROW(SimplifyModel(*expanded_loader.Load(std::string("data/cube.obj")), 0.5f),
+        std::runtime_error *);
+}
+
+TEST(MeshSimplifierTest, LodChains)
+{
+    ModelLoaderOBJ loader;
+    loader.SetIndexed(true);
+    std::vector<std::shared_ptr<Model>> models;
+    models.push_back(loader.Load(std::string("data/banana.obj")));
+    models.push_back(loader.Load(std::string("data/cube.obj")));
+
+    std::vector<float> ratios;
+    ratios.push_back(0.5f);
+    ratios.push_back(0.25f);
+    ratios.push_back(0.1f);
+
+    const std::vector<std::vector<ModelLod>> serial = BuildLodChains(models, ratios);
+    const std::vector<std::vector<ModelLod>> threaded = BuildLodChains(models, ratios, 2);
+    ASSERT_EQ(2u, serial.size());
+    ASSERT_EQ(2u, threaded.size());
+
+    for (size_t m = 0; m < models.size(); ++m)
+    {
+        ASSERT_EQ(4u, serial[m].size());
+        EXPECT_EQ(models[m], serial[m][0].model);
+        EXPECT_EQ(0.0f, serial[m][0].error);
+
+        for (size_t i = 1; i < serial[m].size(); ++i)
+        {
+            EXPECT_LE(serial[m][i].model->index_count(), serial[m][i - 1].model->index_count());
+            EXPECT_GE(serial[m][i].error, serial[m][i - 1].error);
+            EXPECT_EQ(serial[m][i].model->ReadIndices(), threaded[m][i].model->ReadIndices());
+            EXPECT_EQ(serial[m][i].error, threaded[m][i].error);
+        }
+    }
+
+    // The cube has no vertex to spare: its faces don't share vertices,
+    // so every corner is on a seam of three or more vertices.
+    EXPECT_EQ(models[1]->index_count(), serial[1][3].model->index_count());
+
+    EXPECT_LT(serial[0][3].model->index_count(), models[0]->index_count() / 5);
+}
+
+TEST(MeshSimplifierTest, SelectLod)
+{
+    // With a 90 degree field of view, one unit at a distance of 10
+    // covers a tenth of half the viewport.
+    const Matrix projection = Matrix::CreatePerspective(90.0f, 1.0f, 1.0f, 100.0f);
+    EXPECT_NEAR(10.0f, ProjectedSize(projection, 1.0f, 10.0f, 200.0f), 1e-4f);
+    EXPECT_NEAR(5.0f, ProjectedSize(projection, 1.0f, 20.0f, 200.0f), 1e-4f);
+
+    std::vector<ModelLod> chain(4);
+    chain[0].error = 0.0f;
+    chain[1].error = 0.01f;
+    chain[2].error = 0.1f;
+    chain[3].error = 1.0f;
+
+    EXPECT_EQ(2u, SelectLod(chain, projection, 10.0f, 200.0f));
+    EXPECT_EQ(3u, SelectLod(chain, projection, 200.0f, 200.0f));
+    EXPECT_EQ(0u, SelectLod(chain, projection, 0.5f, 200.0f));
+    EXPECT_EQ(1u, SelectLod(chain, projection, 10.0f, 200.0f, 0.5f));
+}
@@ -0,0 +1,80 @@
+#include "mipmap.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "parallel.h"
+#include "pixel_kernels.h"
+
+using namespace blowgun;
+
+u32
+blowgun::MipmapLevelCount(u32 width, u32 height)
+{
+    u32 count = 1;
+    for (u32 size = std::max(width, height); size > 1; size /= 2)
+        ++count;
+    return count;
+}
+
+std::vector<std::vector<byte>>
+blowgun::GenerateMipmaps(
+    const byte * pixels,
+    u32 width,
+    u32 height,
+    u32 channel_count,
+    bool srgb,
+    u32 thread_count)
+{
+    if (channel_count < 1 || channel_count > 4)
+        throw new std::runtime_error("Mipmaps need pixels of 1 to 4 channels");
+
+    // Rows are shared by threads in ranges of about this many bytes, so
+    // small levels stay on the calling thread.
+    static const u32 kMinBytesPerRange = 64 * 1024;
+
+    std::vector<std::vector<byte>> levels;
+    levels.reserve(MipmapLevelCount(width, height) - 1);
+
+    const byte * source = pixels;
+    u32 source_width = width;
+    u32 source_height = height;
+    while (source_width > 1 || source_height > 1)
+    {
+        const u32 level_width = std::max(1u, source_width / 2);
+        const u32 level_height = std::max(1u, source_height / 2);
+        const u32 source_row_size = source_width * channel_count;
+        const u32 row_size = level_width * channel_count;
+
+        levels.push_back(std::vector<byte>(static_cast<size_t>(row_size) * level_height));
+        byte * level = levels.back().data();
+
+        // A single row is averaged with itself.
+        const u32 next_row = (source_height > 1) ? source_row_size : 0;
+
+        ParallelFor(level_height, std::max(1u, kMinBytesPerRange / row_size), thread_count,
+            [=](u32 begin, u32 end)
+            {
+                for (u32 y = begin; y < end; ++y)
+                {
+                    const byte * row0 = source + static_cast<size_t>(y) * 2 * source_row_size;
+                    byte * destination = level + static_cast<size_t>(y) * row_size;
+                    if (srgb)
+                    {
+                        kernels::DownsampleRowsSRGB(row0, row0 + next_row, source_width,
+                            channel_count, destination);
+                    }
+                    else
+                    {
+                        kernels::DownsampleRows(row0, row0 + next_row, source_width,
+                            channel_count, destination);
+                    }
+                }
+            });
+
+        source = level;
+        source_width = level_width;
+        source_height = level_height;
+    }
+    return levels;
+}
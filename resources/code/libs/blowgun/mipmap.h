@@ -0,0 +1,46 @@
+#ifndef BLOWGUN_MIPMAP_H_
+#define BLOWGUN_MIPMAP_H_
+
+#include <vector>
+
+#include "types.h"
+
+namespace blowgun
+{
+
+/**
+ * Get the number of levels of a full mipmap chain, from a `width` by
+ * `height` level down to 1x1, both included.
+ */
+u32 MipmapLevelCount(u32 width, u32 height);
+
+/**
+ * Generate the levels of a mipmap chain below an image, each one half
+ * the size of the one above, rounded down, down to 1x1. Each pixel is
+ * the average of a 2x2 block of the level above.
+ *
+ * @param   pixels
+ *          Rows of pixels of `channel_count` bytes, from 1 to 4, with no
+ *          padding between them.
+ * @param   srgb
+ *          Whether colors are sRGB, to be averaged as light instead of
+ *          as values. Dark and bright areas then keep their brightness
+ *          in the smaller levels. The alpha channel of 2 and 4-channel
+ *          pixels is always averaged as it is.
+ * @param   thread_count
+ *          Upper bound of threads to use, rows of each level being
+ *          spread over them. Zero means `HardwareThreadCount()`.
+ * @return  The levels from the second one, so the first level is the
+ *          one of `width / 2` by `height / 2`. Empty for a 1x1 image.
+ */
+std::vector<std::vector<byte>> GenerateMipmaps(
+	const byte * pixels,
+	u32 width,
+	u32 height,
+	u32 channel_count,
+	bool srgb = false,
+	u32 thread_count = 0);
+
+}
+
+#endif // BLOWGUN_MIPMAP_H_
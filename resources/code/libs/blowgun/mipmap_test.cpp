@@ -0,0 +1,145 @@
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "mipmap.h"
+
+using namespace blowgun;
+
+namespace
+{
+    std::vector<byte> RandomPixels(u32 size, u32 seed)
+    {
+        std::vector<byte> pixels(size);
+        for (u32 i = 0; i < size; ++i)
+        {
+            seed = seed * 1664525 + 1013904223;
+            pixels[i] = static_cast<byte>(seed >> 24);
+        }
+        return pixels;
+    }
+
+    // The next level, computed the plain way.
+    std::vector<byte> Downsample(const std::vector<byte> & pixels, u32 width, u32 height,
+        u32 channel_count)
+    {
+        const u32 level_width = std::max(1u, width / 2);
+        const u32 level_height = std::max(1u, height / 2);
+
+        std::vector<byte> level(level_width * level_height * channel_count);
+        for (u32 y = 0; y < level_height; ++y)
+        {
+            for (u32 x = 0; x < level_width; ++x)
+            {
+                const u32 x0 = 2 * x, x1 = std::min(2 * x + 1, width - 1);
+                const u32 y0 = 2 * y, y1 = std::min(2 * y + 1, height - 1);
+                for (u32 k = 0; k < channel_count; ++k)
+                {
+                    const u32 sum =
+                        pixels[(y0 * width + x0) * channel_count + k] +
+                        pixels[(y0 * width + x1) * channel_count + k] +
+                        pixels[(y1 * width + x0) * channel_count + k] +
+                        pixels[(y1 * width + x1) * channel_count + k];
+                    level[(y * level_width + x) * channel_count + k] =
+                        static_cast<byte>((sum + 2) / 4);
+                }
+            }
+        }
+        return level;
+    }
+
+    double ToLinear(double srgb)
+    {
+        return (srgb <= 0.04045) ? srgb / 12.92 : std::pow((srgb + 0.055) / 1.055, 2.4);
+    }
+}
+
+TEST(MipmapTest, LevelCount)
+{
+    EXPECT_EQ(1u, MipmapLevelCount(1, 1));
+    EXPECT_EQ(10u, MipmapLevelCount(512, 512));
+    EXPECT_EQ(4u, MipmapLevelCount(8, 2));
+    EXPECT_EQ(3u, MipmapLevelCount(5, 7));
+
+    std::vector<byte> pixels(8 * 2 * 3);
+    std::vector<std::vector<byte>> levels = GenerateMipmaps(pixels.data(), 8, 2, 3);
+    ASSERT_EQ(3u, levels.size());
+    EXPECT_EQ(4u * 1 * 3, levels[0].size());
+    EXPECT_EQ(2u * 1 * 3, levels[1].size());
+    EXPECT_EQ(1u * 1 * 3, levels[2].size());
+
+    EXPECT_TRUE(GenerateMipmaps(pixels.data(), 1, 1, 3).empty());
+    EXPECT_THROW(GenerateMipmaps(pixels.data(), 2, 2, 5), std::runtime_error *);
+}
+
+TEST(MipmapTest, Box)
+{
+    // Odd and even sizes around every vector width, for every channel
+    // count, on one thread and on several.
+    const u32 sizes[][2] = { { 64, 64 }, { 37, 20 }, { 1, 9 }, { 50, 1 }, { 33, 7 } };
+    for (u32 channel_count = 1; channel_count <= 4; ++channel_count)
+    {
+        for (u32 s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s)
+        {
+            u32 width = sizes[s][0];
+            u32 height = sizes[s][1];
+            std::vector<byte> expected = RandomPixels(width * height * channel_count, s);
+            std::vector<std::vector<byte>> levels =
+                GenerateMipmaps(expected.data(), width, height, channel_count, false, 1);
+            std::vector<std::vector<byte>> threaded =
+                GenerateMipmaps(expected.data(), width, height, channel_count, false, 4);
+
+            ASSERT_EQ(MipmapLevelCount(width, height) - 1, levels.size());
+            for (size_t i = 0; i < levels.size(); ++i)
+            {
+                expected = Downsample(expected, width, height, channel_count);
+                width = std::max(1u, width / 2);
+                height = std::max(1u, height / 2);
+
+                EXPECT_EQ(expected, levels[i]);
+                EXPECT_EQ(expected, threaded[i]);
+            }
+        }
+    }
+}
+
+TEST(MipmapTest, GammaCorrect)
+{
+    // A black and white checkerboard is half as bright: 50% of the light
+    // is 188 in sRGB, not 128. Alpha is averaged as it is.
+    const byte checkerboard[] = {
+        0, 0, 0, 0,          255, 255, 255, 255,
+        255, 255, 255, 255,  0, 0, 0, 0,
+    };
+
+    std::vector<std::vector<byte>> box = GenerateMipmaps(checkerboard, 2, 2, 4);
+    EXPECT_EQ(128, box[0][0]);
+    EXPECT_EQ(128, box[0][3]);
+
+    std::vector<std::vector<byte>> srgb = GenerateMipmaps(checkerboard, 2, 2, 4, true);
+    EXPECT_EQ(188, srgb[0][0]);
+    EXPECT_EQ(188, srgb[0][1]);
+    EXPECT_EQ(188, srgb[0][2]);
+    EXPECT_EQ(128, srgb[0][3]);
+
+    // Any flat color stays the same, and any mix stays within one step
+    // of the exact average of light.
+    for (u32 value = 0; value < 256; ++value)
+    {
+        const byte flat[] = {
+            static_cast<byte>(value), static_cast<byte>(value),
+            static_cast<byte>(value), static_cast<byte>(value) };
+        EXPECT_EQ(value, GenerateMipmaps(flat, 2, 2, 1, true)[0][0]);
+
+        const byte mix[] = {
+            static_cast<byte>(value), static_cast<byte>(255 - value),
+            static_cast<byte>(value / 2), static_cast<byte>(value / 3) };
+        double linear = 0.0;
+        for (u32 i = 0; i < 4; ++i)
+            linear += ToLinear(mix[i] / 255.0) / 4.0;
+
+        const double srgb_value = GenerateMipmaps(mix, 2, 2, 1, true)[0][0] / 255.0;
+        EXPECT_NEAR(linear, ToLinear(srgb_value), ToLinear(srgb_value) * 0.03 + 0.0005);
+    }
+}
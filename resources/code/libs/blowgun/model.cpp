@@ -1,25 +1,181 @@
 #include "model.h"
 
+#include <algorithm>
+#include <utility>
+
 using namespace blowgun;
 
 Model::Model() :
-	vertex_attributes_(std::vector<VertexAttribute>())
+	vertex_layout_(),
+	vertex_data_(),
+	vertex_count_(0),
+	bounds_(ComputeBounds(0, 0)),
+	groups_(),
+	position_offset_(),
+	position_scale_(1.0f),
+	index_format_(IndexFormat::kUnsignedShort),
+	indices_16_(),
+	indices_32_()
+{
+}
+
+Model::Model(const VertexLayout & vertex_layout,
+	std::vector<u8> vertex_data,
+	const Bounds & bounds,
+	std::vector<ModelGroup> groups) :
+	vertex_layout_(vertex_layout),
+	vertex_data_(std::move(vertex_data)),
+	vertex_count_(0),
+	bounds_(bounds),
+	groups_(std::move(groups)),
+	position_offset_(),
+	position_scale_(1.0f),
+	index_format_(IndexFormat::kUnsignedShort),
+	indices_16_(),
+	indices_32_()
+{
+	if (vertex_layout_.stride() > 0)
+		vertex_count_ = static_cast<u32>(vertex_data_.size() / vertex_layout_.stride());
+}
+
+Model::Model(const VertexLayout & vertex_layout,
+	std::vector<u8> vertex_data,
+	const std::vector<u32> & indices,
+	const Bounds & bounds,
+	std::vector<ModelGroup> groups) :
+	vertex_layout_(vertex_layout),
+	vertex_data_(std::move(vertex_data)),
+	vertex_count_(0),
+	bounds_(bounds),
+	groups_(std::move(groups)),
+	position_offset_(),
+	position_scale_(1.0f),
+	index_format_(IndexFormat::kUnsignedShort),
+	indices_16_(),
+	indices_32_()
+{
+	if (vertex_layout_.stride() > 0)
+		vertex_count_ = static_cast<u32>(vertex_data_.size() / vertex_layout_.stride());
+
+	u32 max_index = 0;
+	for (size_t i = 0; i < indices.size(); ++i)
+		max_index = std::max(max_index, indices[i]);
+
+	if (max_index > 0xFFFF)
+	{
+		index_format_ = IndexFormat::kUnsignedInt;
+		indices_32_ = indices;
+	}
+	else
+	{
+		indices_16_.assign(indices.begin(), indices.end());
+	}
+}
+
+const VertexLayout &
+Model::vertex_layout() const
 {
+	return vertex_layout_;
 }
 
-Model::Model(std::vector<VertexAttribute> vertex_attributes) :
-	vertex_attributes_(vertex_attributes)
+const u8 *
+Model::vertex_data() const
 {
+	return vertex_data_.empty() ? nullptr : &vertex_data_[0];
 }
 
-std::vector<VertexAttribute> const
-Model::vertex_attributes() const
+u32
+Model::vertex_data_size() const
 {
-	return vertex_attributes_;
+	return static_cast<u32>(vertex_data_.size());
+}
+
+u32
+Model::vertex_count() const
+{
+	return vertex_count_;
+}
+
+const Bounds &
+Model::bounds() const
+{
+	return bounds_;
+}
+
+const std::vector<ModelGroup> &
+Model::groups() const
+{
+	return groups_;
 }
 
 void
-Model::AddVertexAttribute(VertexAttribute va)
+Model::SetPositionDequantization(const Vec3 & offset, float scale)
+{
+	position_offset_ = offset;
+	position_scale_ = scale;
+}
+
+const Vec3 &
+Model::position_offset() const
 {
-	vertex_attributes_.push_back(va);
+	return position_offset_;
+}
+
+float
+Model::position_scale() const
+{
+	return position_scale_;
+}
+
+Matrix
+Model::position_dequantization() const
+{
+	return Matrix::CreateProduct(
+		Matrix::CreateScale(position_scale_, position_scale_, position_scale_),
+		Matrix::CreateTranslation(position_offset_.x, position_offset_.y, position_offset_.z));
+}
+
+u32
+Model::index_count() const
+{
+	return static_cast<u32>(
+		(index_format_ == IndexFormat::kUnsignedInt) ? indices_32_.size() : indices_16_.size());
+}
+
+IndexFormat::Enum
+Model::index_format() const
+{
+	return index_format_;
+}
+
+const void *
+Model::index_data() const
+{
+	if (index_count() == 0)
+		return nullptr;
+
+	return (index_format_ == IndexFormat::kUnsignedInt)
+		? static_cast<const void *>(&indices_32_[0])
+		: static_cast<const void *>(&indices_16_[0]);
+}
+
+std::vector<u32>
+Model::ReadIndices() const
+{
+	return (index_format_ == IndexFormat::kUnsignedInt)
+		? indices_32_
+		: std::vector<u32>(indices_16_.begin(), indices_16_.end());
+}
+
+std::vector<u32>
+blowgun::WidenIndices(IndexFormat::Enum format, const void * data, u32 count)
+{
+	if (format == IndexFormat::kUnsignedInt)
+	{
+		const u32 * indices = static_cast<const u32 *>(data);
+		return std::vector<u32>(indices, indices + count);
+	}
+
+	const u16 * indices = static_cast<const u16 *>(data);
+	return std::vector<u32>(indices, indices + count);
 }
@@ -1,20 +1,78 @@
 #ifndef BLOWGUN_MODEL_H_
 #define BLOWGUN_MODEL_H_
 
+#include <string>
 #include <vector>
 
-#include "vertex_attribute.h"
+#include "bounds.h"
+#include "matrix.h"
+#include "types.h"
+#include "vertex_layout.h"
 
 namespace blowgun
 {
 
+/**
+ * Type of the indices of an indexed `Model`, as `glDrawElements`
+ * takes them. 32-bit indices need `GL_OES_element_index_uint` on
+ * OpenGL ES 2.0, so they are only used when 16 bits aren't enough.
+ */
+namespace IndexFormat
+{
+	enum Enum
+	{
+		kUnsignedShort = 0,
+		kUnsignedInt   = 1
+	};
+}
+
+/**
+ * Contiguous range of vertices that belong to one group of a `Model`,
+ * such as a `g` section of an OBJ file. When the `Model` is indexed,
+ * this is a range of its indices instead.
+ */
+struct ModelGroup
+{
+	std::string name;
+	u32         first_vertex;
+	u32         vertex_count;
+	Bounds      bounds;
+
+	ModelGroup() : name(), first_vertex(0), vertex_count(0), bounds() {}
+};
+
 class Model
 {
 private:
 	/**
-	 * Container to hold `VertexAttribute` for the `Model`.
+	 * Interleaved vertices, each one laid out as `vertex_layout_`
+	 * describes, ready to be handed to `glVertexAttribPointer`.
+	 */
+	VertexLayout            vertex_layout_;
+	std::vector<u8>         vertex_data_;
+	u32                     vertex_count_;
+
+	/**
+	 * Bounds of the whole `Model` and of each of its groups, computed
+	 * once by the loader.
+	 */
+	Bounds                  bounds_;
+	std::vector<ModelGroup> groups_;
+
+	/**
+	 * How quantized positions map back to model units: `position_offset_
+	 * + position_scale_ * p`.
+	 */
+	Vec3                    position_offset_;
+	float                   position_scale_;
+
+	/**
+	 * Indices of an indexed `Model`, in `index_format_`. Only one of
+	 * the two containers is used.
 	 */
-	std::vector<VertexAttribute> vertex_attributes_;
+	IndexFormat::Enum       index_format_;
+	std::vector<u16>        indices_16_;
+	std::vector<u32>        indices_32_;
 
 	// Disallow copy and assign.
 	Model(const Model & rhs);
@@ -22,13 +80,89 @@ private:
 
 public:
 	Model();
-	Model(std::vector<VertexAttribute> vertex_attributes);
 
-	std::vector<VertexAttribute> const vertex_attributes() const;
+	/**
+	 * Create a `Model` from `vertex_data`, which holds a whole number
+	 * of vertices laid out as `vertex_layout` describes.
+	 */
+	Model(const VertexLayout & vertex_layout,
+		std::vector<u8> vertex_data,
+		const Bounds & bounds,
+		std::vector<ModelGroup> groups);
 
-	void AddVertexAttribute(VertexAttribute va);
+	/**
+	 * Create an indexed `Model`, whose triangles are given by `indices`
+	 * into its vertices. The indices are stored in 16 bits when every
+	 * one of them fits.
+	 */
+	Model(const VertexLayout & vertex_layout,
+		std::vector<u8> vertex_data,
+		const std::vector<u32> & indices,
+		const Bounds & bounds,
+		std::vector<ModelGroup> groups);
+
+	/**
+	 * Get the vertices, without copying them. Attribute `e` of vertex
+	 * `i` starts at `vertex_data() + i * stride + e.offset`. The data
+	 * is null when the `Model` has no vertices.
+	 */
+	const VertexLayout & vertex_layout() const;
+	const u8 * vertex_data() const;
+	u32 vertex_data_size() const;
+	u32 vertex_count() const;
+
+	/**
+	 * Get the bounds of every position of the `Model`, so it can be
+	 * culled or sorted without walking its vertices.
+	 */
+	const Bounds & bounds() const;
+
+	const std::vector<ModelGroup> & groups() const;
+
+	/**
+	 * Set how positions stored as normalized integers map back to model
+	 * units. The bounds and groups stay in model units.
+	 */
+	void SetPositionDequantization(const Vec3 & offset, float scale);
+
+	/**
+	 * Get how stored positions map back to model units. They are used
+	 * as is, with an offset of zero and a scale of one, unless the
+	 * `Model` was quantized.
+	 */
+	const Vec3 & position_offset() const;
+	float position_scale() const;
+
+	/**
+	 * Get the same mapping as a Matrix, to apply before the model
+	 * matrix, e.g. `Matrix::CreateProduct(position_dequantization(),
+	 * pmv)`. The scale is the same on every axis, so normals go through
+	 * the model matrix unchanged.
+	 */
+	Matrix position_dequantization() const;
+
+	/**
+	 * Get the index buffer, ready for `glDrawElements`. A `Model`
+	 * without indices is drawn with `glDrawArrays` instead, and has
+	 * an index count of zero.
+	 */
+	u32 index_count() const;
+	IndexFormat::Enum index_format() const;
+	const void * index_data() const;
+
+	/**
+	 * Get a copy of the indices, widened to 32 bits whatever their
+	 * format, for the CPU-side passes. Empty when the `Model` has no
+	 * indices.
+	 */
+	std::vector<u32> ReadIndices() const;
 };
 
+/**
+ * Widen `count` indices of `format`, stored at `data`, to 32 bits.
+ */
+std::vector<u32> WidenIndices(IndexFormat::Enum format, const void * data, u32 count);
+
 }
 
 #endif // of BLOWGUN_MODEL_H_
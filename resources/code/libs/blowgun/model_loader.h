@@ -1,14 +1,36 @@
 #ifndef BLOWGUN_MODEL_LOADER_H_
 #define BLOWGUN_MODEL_LOADER_H_
 
+#include <istream>
+#include <memory>
+
+#include "model.h"
+
 namespace blowgun
 {
 
+/**
+ * Loader of one file format of models.
+ *
+ * `AssetManager` calls both methods from several threads at once, so
+ * they must not change the loader.
+ */
 class ModelLoader
 {
 public:
+	/**
+	 * Check whether `input` looks like a model of this format, from its
+	 * first bytes. The stream is left anywhere: rewind it before
+	 * loading.
+	 */
 	virtual bool CanLoad(std::istream & input) = 0;
+
+	/**
+	 * Load a model from `input`, from its current position. Throws
+	 * when the content is malformed.
+	 */
 	virtual std::shared_ptr<Model> Load(std::istream & input) = 0;
+
 	virtual ~ModelLoader() {};
 };
 
@@ -0,0 +1,32 @@
+#include "model_loader_cooked.h"
+
+#include <vector>
+
+#include "cooked_mesh.h"
+
+using namespace blowgun;
+
+bool
+ModelLoaderCooked::CanLoad(std::istream & input)
+{
+    char magic[4];
+    input.read(magic, sizeof(magic));
+    return IsCookedMesh(magic, static_cast<std::size_t>(input.gcount()));
+}
+
+std::shared_ptr<Model>
+ModelLoaderCooked::Load(std::istream & input)
+{
+    static const std::size_t kBlockSize = 64 * 1024;
+
+    std::vector<char> content;
+    std::size_t size = 0;
+    while (input)
+    {
+        content.resize(size + kBlockSize);
+        input.read(&content[size], kBlockSize);
+        size += static_cast<std::size_t>(input.gcount());
+    }
+
+    return CookedMesh(content.empty() ? nullptr : &content[0], size).CreateModel();
+}
@@ -0,0 +1,35 @@
+#ifndef BLOWGUN_MODEL_LOADER_COOKED_H_
+#define BLOWGUN_MODEL_LOADER_COOKED_H_
+
+#include <istream>
+#include <memory>
+
+#include "model.h"
+#include "model_loader.h"
+
+namespace blowgun
+{
+
+/**
+ * Loader of cooked meshes, as `CookMesh` writes them, for code that
+ * goes through `ModelLoader`. `CookedMesh` maps a file without any copy
+ * instead, when the path is known.
+ */
+class ModelLoaderCooked : public ModelLoader
+{
+public:
+	/**
+	 * Check whether `input` starts with the magic of a cooked mesh.
+	 */
+	virtual bool CanLoad(std::istream & input);
+
+	/**
+	 * Read the whole content of `input` and copy the mesh into a
+	 * `Model`. Throws when it isn't a valid cooked mesh.
+	 */
+	virtual std::shared_ptr<Model> Load(std::istream & input);
+};
+
+}
+
+#endif // BLOWGUN_MODEL_LOADER_COOKED_H_
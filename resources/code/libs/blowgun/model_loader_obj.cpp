@@ -1,172 +1,989 @@
 #include "model_loader_obj.h"
 
-#include <fstream>
-#include <iostream>
+#include <algorithm>
+#include <cstring>
+#include <istream>
 #include <sstream>
 #include <stdexcept>
 #include <tuple>
+#include <utility>
 
+#include "bounds.h"
+#include "mapped_file.h"
+#include "mesh_normals.h"
+#include "parallel.h"
 #include "types.h"
 
 using namespace blowgun;
 
-ModelLoaderOBJ::ModelLoaderOBJ()
+// Utility
+namespace
 {
-}
+    // Size of text below which splitting a file over another thread
+    // costs more than it saves.
+    static const size_t kMinBytesPerThread = 64 * 1024;
 
-std::shared_ptr<Model>
-ModelLoaderOBJ::Load(std::istream & stream)
-{
-    typedef struct V3_
+    // Number of vertices below which building the attributes of a
+    // `Model` isn't worth another thread.
+    static const u32 kMinVerticesPerThread = 16 * 1024;
+
+    struct Float3
     {
         float x;
         float y;
         float z;
-    } V3;
+    };
 
-    typedef struct V2_
+    struct Float2
     {
         float u;
         float v;
-    } V2;
+    };
 
-    std::vector<VertexAttribute> vertex_attributes;
-    std::vector<std::tuple<u32, u32>> vertex_mappings;
+    // One corner of a triangle, as 0-based indices into the positions,
+    // texture coordinates and normals of the file. A corner without any
+    // texture coordinate or normal has `kNoIndex` instead.
+    struct Corner
+    {
+        u32 position;
+        u32 tex_coord;
+        u32 normal;
+    };
 
-    std::vector<V3> vertices_position;
-    std::vector<V2> vertices_tex_coord;
+    static const u32 kNoIndex = 0xFFFFFFFF;
 
-    std::string line;
-    while (std::getline(stream, line))
+    // Number of lines, and of each kind of vertex record, in a range
+    // of OBJ text.
+    struct ObjCounts
     {
-        // Ignore empty line
-        if (line.empty())
-            continue;
+        u32 lines;
+        u32 positions;
+        u32 tex_coords;
+        u32 normals;
+    };
+
+    // Everything the faces of an OBJ file refer to.
+    struct ObjData
+    {
+        std::vector<Float3> positions;
+        std::vector<Float2> tex_coords;
+        std::vector<Float3> normals;
+        std::vector<Corner> corners;
+
+        // Name of each group, and the index in `corners` where it
+        // starts. Faces before the first 'g' go to the default group.
+        std::vector<std::tuple<std::string, u32>> group_starts;
+
+        ObjData() : positions(), tex_coords(), normals(), corners(), group_starts() {}
+    };
+
+    // Cursor over the characters of one line. The parsing functions
+    // below never look past `end`, which is the '\n' of the line or
+    // the end of the file, so the content doesn't need to be
+    // null-terminated.
+    struct LineCursor
+    {
+        const char * at;
+        const char * end;
+        u32          line_number;
+    };
+
+    static void
+    ThrowParseError(const LineCursor & cursor, const char * what)
+    {
+        std::ostringstream message;
+        message << "OBJ line " << cursor.line_number << ": " << what;
+        throw new std::runtime_error(message.str());
+    }
+
+    // '\r' counts as a blank, so files with Windows line endings parse
+    // the same way.
+    static bool
+    IsBlank(char c)
+    {
+        return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+    }
+
+    static bool
+    IsDigit(char c)
+    {
+        return static_cast<unsigned char>(c - '0') < 10;
+    }
+
+    static void
+    SkipBlanks(LineCursor & cursor)
+    {
+        while (cursor.at < cursor.end && IsBlank(*cursor.at))
+            ++cursor.at;
+    }
+
+    static bool
+    AtEndOfLine(const LineCursor & cursor)
+    {
+        return cursor.at == cursor.end;
+    }
+
+    // Powers of ten that a double holds exactly.
+    static const double kPowersOf10[] =
+    {
+        1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,
+        1e8,  1e9,  1e10, 1e11, 1e12, 1e13, 1e14, 1e15,
+        1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+    static const int kMaxExactPowerOf10 = 22;
+
+    static double
+    ScaleByPowerOf10(double value, int exponent)
+    {
+        if (exponent >= 0)
+        {
+            while (exponent > kMaxExactPowerOf10)
+            {
+                value *= kPowersOf10[kMaxExactPowerOf10];
+                exponent -= kMaxExactPowerOf10;
+            }
+            return value * kPowersOf10[exponent];
+        }
+
+        exponent = -exponent;
+        while (exponent > kMaxExactPowerOf10)
+        {
+            value /= kPowersOf10[kMaxExactPowerOf10];
+            exponent -= kMaxExactPowerOf10;
+        }
+        return value / kPowersOf10[exponent];
+    }
+
+    // Parse a decimal number such as `-12`, `0.5`, `.5`, `5.` or
+    // `1.5e-3`. Unlike `strtof` or `operator>>`, this doesn't depend
+    // on the current locale, and is a lot faster.
+    //
+    // Digits are accumulated in an integer, and scaled by a power of
+    // ten only once at the end. That is exact as long as the mantissa
+    // fits in a double, which covers anything an exporter writes.
+    static float
+    ParseFloat(LineCursor & cursor)
+    {
+        SkipBlanks(cursor);
+
+        const char * at = cursor.at;
+        const char * end = cursor.end;
+
+        bool negative = false;
+        if (at < end && (*at == '-' || *at == '+'))
+            negative = (*at++ == '-');
+
+        // Digits beyond the 19th don't fit in the mantissa. They are
+        // dropped, and only shift the exponent.
+        u64 mantissa = 0;
+        int exponent = 0;
+        int digit_count = 0;
+        int significant_digit_count = 0;
+
+        for (; at < end && IsDigit(*at); ++at, ++digit_count)
+        {
+            if (significant_digit_count < 19)
+            {
+                mantissa = mantissa * 10 + static_cast<u64>(*at - '0');
+                if (mantissa != 0)
+                    ++significant_digit_count;
+            }
+            else
+            {
+                ++exponent;
+            }
+        }
+
+        if (at < end && *at == '.')
+        {
+            for (++at; at < end && IsDigit(*at); ++at, ++digit_count)
+            {
+                if (significant_digit_count < 19)
+                {
+                    mantissa = mantissa * 10 + static_cast<u64>(*at - '0');
+                    if (mantissa != 0)
+                        ++significant_digit_count;
+                    --exponent;
+                }
+            }
+        }
+
+        if (digit_count == 0)
+            ThrowParseError(cursor, "expected a number.");
+
+        if (at < end && (*at == 'e' || *at == 'E'))
+        {
+            ++at;
+            bool negative_exponent = false;
+            if (at < end && (*at == '-' || *at == '+'))
+                negative_exponent = (*at++ == '-');
+
+            if (at == end || !IsDigit(*at))
+                ThrowParseError(cursor, "expected an exponent.");
+
+            int explicit_exponent = 0;
+            for (; at < end && IsDigit(*at); ++at)
+            {
+                // Anything this large is an infinity or a zero anyway.
+                if (explicit_exponent < 10000)
+                    explicit_exponent = explicit_exponent * 10 + (*at - '0');
+            }
+            exponent += negative_exponent ? -explicit_exponent : explicit_exponent;
+        }
+
+        cursor.at = at;
+
+        const double value = ScaleByPowerOf10(static_cast<double>(mantissa), exponent);
+        return static_cast<float>(negative ? -value : value);
+    }
+
+    // Parse an optionally signed integer, without any blank before it.
+    static i32
+    ParseInt(LineCursor & cursor)
+    {
+        const char * at = cursor.at;
+        const char * end = cursor.end;
+
+        bool negative = false;
+        if (at < end && (*at == '-' || *at == '+'))
+            negative = (*at++ == '-');
+
+        if (at == end || !IsDigit(*at))
+            ThrowParseError(cursor, "expected an index.");
+
+        i32 value = 0;
+        for (; at < end && IsDigit(*at); ++at)
+        {
+            if (value > (0x7FFFFFFF - 9) / 10)
+                ThrowParseError(cursor, "index out of range.");
+            value = value * 10 + (*at - '0');
+        }
+
+        cursor.at = at;
+        return negative ? -value : value;
+    }
+
+    // Turn an index as written in the file into a 0-based one. OBJ
+    // indices start at 1, and negative ones count backward from the
+    // last element declared so far.
+    static u32
+    ResolveIndex(const LineCursor & cursor, i32 index, size_t count)
+    {
+        i64 resolved = (index > 0)
+            ? static_cast<i64>(index) - 1
+            : static_cast<i64>(count) + index;
+
+        if (index == 0 || resolved < 0 || resolved >= static_cast<i64>(count))
+            ThrowParseError(cursor, "index out of range.");
+
+        return static_cast<u32>(resolved);
+    }
+
+    // Parse one `v`, `v/t`, `v/t/n` or `v//n` entry of a face.
+    //
+    // Indices are resolved against everything declared so far: the
+    // records of `data`, on top of the ones of the text before it,
+    // counted by `base`.
+    static Corner
+    ParseCorner(LineCursor & cursor, const ObjCounts & base, const ObjData & data)
+    {
+        Corner corner;
+        corner.position = ResolveIndex(cursor, ParseInt(cursor),
+            base.positions + data.positions.size());
+        corner.tex_coord = kNoIndex;
+        corner.normal = kNoIndex;
+
+        if (cursor.at < cursor.end && *cursor.at == '/')
+        {
+            ++cursor.at;
+            if (cursor.at < cursor.end && *cursor.at != '/')
+            {
+                corner.tex_coord = ResolveIndex(cursor, ParseInt(cursor),
+                    base.tex_coords + data.tex_coords.size());
+            }
+
+            if (cursor.at < cursor.end && *cursor.at == '/')
+            {
+                ++cursor.at;
+                corner.normal = ResolveIndex(cursor, ParseInt(cursor),
+                    base.normals + data.normals.size());
+            }
+        }
+
+        if (cursor.at < cursor.end && !IsBlank(*cursor.at))
+            ThrowParseError(cursor, "malformed face.");
+
+        return corner;
+    }
+
+    // Read the keyword at the start of a line, such as `v` or `vt`.
+    static bool
+    MatchKeyword(LineCursor & cursor, const char * keyword, size_t length)
+    {
+        if (static_cast<size_t>(cursor.end - cursor.at) < length ||
+            std::memcmp(cursor.at, keyword, length) != 0)
+        {
+            return false;
+        }
+
+        const char * after = cursor.at + length;
+        if (after != cursor.end && !IsBlank(*after))
+            return false;
+
+        cursor.at = after;
+        return true;
+    }
+
+    // Point `cursor` at the line that starts at `line`, and return
+    // where the next line starts.
+    static const char *
+    NextLine(LineCursor & cursor, const char * line, const char * end)
+    {
+        const char * line_end = static_cast<const char *>(
+            std::memchr(line, '\n', end - line));
+        if (!line_end)
+            line_end = end;
+
+        cursor.at = line;
+        cursor.end = line_end;
+        ++cursor.line_number;
+        return line_end + 1;
+    }
+
+    // Count the lines and vertex records in `[begin, end)`, without
+    // parsing any of them.
+    static ObjCounts
+    Count(const char * begin, const char * end)
+    {
+        ObjCounts counts = { 0, 0, 0, 0 };
+
+        LineCursor cursor;
+        cursor.line_number = 0;
+
+        for (const char * line = begin; line < end; )
+        {
+            line = NextLine(cursor, line, end);
+
+            SkipBlanks(cursor);
+            if (MatchKeyword(cursor, "v", 1))
+                ++counts.positions;
+            else if (MatchKeyword(cursor, "vt", 2))
+                ++counts.tex_coords;
+            else if (MatchKeyword(cursor, "vn", 2))
+                ++counts.normals;
+        }
+
+        counts.lines = cursor.line_number;
+        return counts;
+    }
+
+    // Parse the OBJ text in `[begin, end)`, and append what it declares
+    // to `data`. Only positions, texture coordinates, normals, faces
+    // and groups are read; everything else, such as materials or
+    // smoothing groups, is skipped.
+    //
+    // The text may be a piece of a larger file, in which case `base`
+    // counts what the text before it declares, so indices and line
+    // numbers are the same as when parsing the whole file.
+    static void
+    Parse(const char * begin, const char * end, const ObjCounts & base, ObjData & data)
+    {
+        // Corners of the face being read, reused from one face to the
+        // next so faces don't allocate.
+        std::vector<Corner> face;
+
+        LineCursor cursor;
+        cursor.line_number = base.lines;
+
+        for (const char * line = begin; line < end; )
+        {
+            line = NextLine(cursor, line, end);
+
+            SkipBlanks(cursor);
+            if (AtEndOfLine(cursor) || *cursor.at == '#')
+                continue;
+
+            if (MatchKeyword(cursor, "v", 1))
+            {
+                // Vertex position. A fourth `w` coordinate, if any, is
+                // ignored.
+                // Sample:
+                // v  0.4000 -0.4000 0.0000
+                Float3 position;
+                position.x = ParseFloat(cursor);
+                position.y = ParseFloat(cursor);
+                position.z = ParseFloat(cursor);
+                data.positions.push_back(position);
+            }
+            else if (MatchKeyword(cursor, "vt", 2))
+            {
+                // Vertex texture coordinate. The third coordinate, if
+                // any, is ignored.
+                // Sample:
+                // vt 0.6119 0.8867 0.0000
+                Float2 tex_coord;
+                tex_coord.u = ParseFloat(cursor);
+                tex_coord.v = ParseFloat(cursor);
+                data.tex_coords.push_back(tex_coord);
+            }
+            else if (MatchKeyword(cursor, "vn", 2))
+            {
+                // Vertex normal.
+                // Sample:
+                // vn 0.0000 0.0000 1.0000
+                Float3 normal;
+                normal.x = ParseFloat(cursor);
+                normal.y = ParseFloat(cursor);
+                normal.z = ParseFloat(cursor);
+                data.normals.push_back(normal);
+            }
+            else if (MatchKeyword(cursor, "f", 1))
+            {
+                // Face. Polygons with more than three corners are
+                // split into a fan of triangles.
+                // Sample:
+                // f 1/1/1 2/2/2 3/3/3
+                face.clear();
+                for (SkipBlanks(cursor); !AtEndOfLine(cursor); SkipBlanks(cursor))
+                    face.push_back(ParseCorner(cursor, base, data));
+
+                if (face.size() < 3)
+                    ThrowParseError(cursor, "a face needs at least three corners.");
+
+                for (size_t i = 2; i < face.size(); ++i)
+                {
+                    data.corners.push_back(face[0]);
+                    data.corners.push_back(face[i - 1]);
+                    data.corners.push_back(face[i]);
+                }
+            }
+            else if (MatchKeyword(cursor, "g", 1))
+            {
+                // Every face from here on belongs to the named group,
+                // until the next 'g'. A 'g' without any name goes back
+                // to the default group.
+                // Sample:
+                // g Box02
+                SkipBlanks(cursor);
+                const char * name_end = cursor.at;
+                while (name_end < cursor.end && !IsBlank(*name_end))
+                    ++name_end;
+
+                std::string name = (name_end == cursor.at)
+                    ? std::string("default")
+                    : std::string(cursor.at, name_end);
+                data.group_starts.push_back(std::make_tuple(
+                    name, static_cast<u32>(data.corners.size())));
+            }
+        }
+    }
+
+    // Parse `[begin, end)` split in `chunk_count` pieces, spread over
+    // `thread_count` threads.
+    //
+    // Pieces end on line boundaries. A first pass counts the records of
+    // each piece, and a prefix sum over these counts gives each piece
+    // everything declared before it, so the pieces can then be parsed
+    // independently and merged into the same data as a serial parse.
+    static void
+    ParseChunks(const char * begin, const char * end, u32 chunk_count,
+        u32 thread_count, ObjData & data)
+    {
+        std::vector<const char *> splits(chunk_count + 1);
+        splits[0] = begin;
+        splits[chunk_count] = end;
+        for (u32 i = 1; i < chunk_count; ++i)
+        {
+            const char * split = std::max(
+                begin + (end - begin) * static_cast<i64>(i) / chunk_count,
+                splits[i - 1]);
+            const char * line_end = static_cast<const char *>(
+                std::memchr(split, '\n', end - split));
+            splits[i] = line_end ? line_end + 1 : end;
+        }
 
-        // Determine what kind of info the line contains of.
-        std::string attr;
-        std::stringstream ss(line.c_str());
-        ss >> attr;
-        const char* attr_cstr = attr.c_str();
+        std::vector<ObjCounts> bases(chunk_count);
+        ParallelFor(chunk_count, 1, thread_count,
+            [&](u32 first, u32 last)
+            {
+                for (u32 i = first; i < last; ++i)
+                    bases[i] = Count(splits[i], splits[i + 1]);
+            });
 
-        switch (attr_cstr[0])
+        ObjCounts total = { 0, 0, 0, 0 };
+        for (u32 i = 0; i < chunk_count; ++i)
         {
-        case '#' :
-            // The line that starts with '#' is comment line. So, do nothing.
-            break;
-        case 'v' :
+            const ObjCounts counts = bases[i];
+            bases[i] = total;
+            total.lines      += counts.lines;
+            total.positions  += counts.positions;
+            total.tex_coords += counts.tex_coords;
+            total.normals    += counts.normals;
+        }
+
+        // When several pieces are malformed, the error of the first one
+        // is thrown, which is the one a serial parse would throw.
+        std::vector<ObjData> chunks(chunk_count);
+        std::vector<std::runtime_error *> errors(chunk_count, nullptr);
+        chunks[0].group_starts.swap(data.group_starts);
+
+        ParallelFor(chunk_count, 1, thread_count,
+            [&](u32 first, u32 last)
             {
-                switch (attr_cstr[1])
+                for (u32 i = first; i < last; ++i)
                 {
-                case '\0' :
-                    // Found 'v' at this point. So, it's vertex position
-                    // information.
-                    // Sample:
-                    // v  0.4000 -0.4000 0.0000
+                    try
                     {
-                        V3 v3;
-                        ss >> v3.x >> v3.y >> v3.z;
-                        vertices_position.push_back(v3);
+                        Parse(splits[i], splits[i + 1], bases[i], chunks[i]);
                     }
-                    break;
-                case 't' :
-                    // Found 'vt' at this point. So, it's vertex texture
-                    // coordinate information.
-                    // Sample:
-                    // vt 0.6119 0.8867 0.0000
+                    catch (std::runtime_error * error)
                     {
-                        V2 v2;
-                        ss >> v2.u >> v2.v;
-                        vertices_tex_coord.push_back(v2);
+                        errors[i] = error;
                     }
-                default:
-                    break;
                 }
+            });
+
+        std::runtime_error * first_error = nullptr;
+        for (u32 i = 0; i < chunk_count; ++i)
+        {
+            if (first_error)
+                delete errors[i];
+            else
+                first_error = errors[i];
+        }
+        if (first_error)
+            throw first_error;
+
+        ///
+        // Merge the pieces. Their indices are already relative to the
+        // whole file; only group starts are relative to the piece.
+        ///
+
+        size_t corner_count = 0;
+        for (u32 i = 0; i < chunk_count; ++i)
+            corner_count += chunks[i].corners.size();
+
+        data.positions.reserve(total.positions);
+        data.tex_coords.reserve(total.tex_coords);
+        data.normals.reserve(total.normals);
+        data.corners.reserve(corner_count);
+
+        for (u32 i = 0; i < chunk_count; ++i)
+        {
+            const ObjData & chunk = chunks[i];
+            const u32 first_corner = static_cast<u32>(data.corners.size());
+
+            data.positions.insert(data.positions.end(),
+                chunk.positions.begin(), chunk.positions.end());
+            data.tex_coords.insert(data.tex_coords.end(),
+                chunk.tex_coords.begin(), chunk.tex_coords.end());
+            data.normals.insert(data.normals.end(),
+                chunk.normals.begin(), chunk.normals.end());
+            data.corners.insert(data.corners.end(),
+                chunk.corners.begin(), chunk.corners.end());
+
+            for (size_t g = 0; g < chunk.group_starts.size(); ++g)
+            {
+                data.group_starts.push_back(std::make_tuple(
+                    std::get<0>(chunk.group_starts[g]),
+                    std::get<1>(chunk.group_starts[g]) + first_corner));
             }
-            break;
-        case 'f' :
+        }
+    }
+
+    // Open-addressing hash table from the distinct corners of a file to
+    // the vertex made for each of them. Vertices are numbered in the
+    // order their corner first appears.
+    class CornerTable
+    {
+    private:
+        std::vector<u32>    slots_;
+        u32                 mask_;
+        std::vector<Corner> & vertices_;
+
+        static u32
+        Hash(const Corner & corner)
+        {
+            u32 hash = corner.position * 0x9E3779B1u;
+            hash ^= corner.tex_coord * 0x85EBCA77u;
+            hash ^= corner.normal * 0xC2B2AE3Du;
+            return hash ^ (hash >> 15);
+        }
+
+        static bool
+        Equal(const Corner & lhs, const Corner & rhs)
+        {
+            return lhs.position == rhs.position &&
+                lhs.tex_coord == rhs.tex_coord &&
+                lhs.normal == rhs.normal;
+        }
+
+        // Disallow copy and assign.
+        CornerTable(const CornerTable & rhs);
+        CornerTable & operator=(const CornerTable & rhs);
+
+    public:
+        // `vertices` receives the corner of each vertex. There are at
+        // most `max_count` distinct corners, which keeps the table at
+        // most half full.
+        CornerTable(u32 max_count, std::vector<Corner> & vertices) :
+            slots_(),
+            mask_(0),
+            vertices_(vertices)
+        {
+            u32 capacity = 16;
+            while (capacity < 2 * max_count)
+                capacity *= 2;
+            slots_.assign(capacity, kNoIndex);
+            mask_ = capacity - 1;
+            vertices_.reserve(max_count);
+        }
+
+        u32
+        Insert(const Corner & corner)
+        {
+            for (u32 slot = Hash(corner) & mask_; ; slot = (slot + 1) & mask_)
             {
-                // Found 'f'. It means "face" information is found.
-                // So, we're gonna construct complete set of vertex
-                // attributes. By the time execution goes to this
-                // point, all vertex attributes has had to be parsed.
-                // Sample:
-                // f 1/1 2/2 3/3
-                std::string face_entry;
-                while (ss >> face_entry)
+                const u32 vertex = slots_[slot];
+                if (vertex == kNoIndex)
                 {
-                    int indices[3];
-                    std::tuple<u32, u32> vertex_mapping;
-
-                    // Although the specified format is `%d/%d/%d` below,
-                    // `%d/%d` will also be read successfully.
-                    int element_count = std::sscanf(
-                        face_entry.c_str(),
-                        "%d/%d/%d",
-                        &indices[0],
-                        &indices[1],
-                        &indices[2]);
-
-                    if (element_count == 2)
+                    slots_[slot] = static_cast<u32>(vertices_.size());
+                    vertices_.push_back(corner);
+                    return slots_[slot];
+                }
+                if (Equal(vertices_[vertex], corner))
+                    return vertex;
+            }
+        }
+    };
+
+    // Vertex of an OBJ model, in the layout `CreateVertexLayout`
+    // describes. The tangent is only there when tangents are wanted,
+    // so vertices are `VertexLayout::stride()` bytes apart rather than
+    // `sizeof(PackedVertex)`.
+    struct PackedVertex
+    {
+        float position[3];
+        float tex_coord[2];
+        float normal[3];
+        float tangent[4];
+    };
+
+    static VertexLayout
+    CreateVertexLayout(bool tangents)
+    {
+        VertexLayout layout;
+        layout.Add(VertexAttributeUsage::kPosition, VertexAttributeFormat::kFloat3);
+        layout.Add(VertexAttributeUsage::kTexCoord, VertexAttributeFormat::kFloat2);
+        layout.Add(VertexAttributeUsage::kNormal, VertexAttributeFormat::kFloat3);
+        if (tangents)
+            layout.Add(VertexAttributeUsage::kTangent, VertexAttributeFormat::kFloat4);
+        return layout;
+    }
+
+    static PackedVertex *
+    VertexAt(std::vector<u8> & vertex_data, u32 stride, u32 index)
+    {
+        return reinterpret_cast<PackedVertex *>(&vertex_data[index * stride]);
+    }
+
+    static const PackedVertex *
+    VertexAt(const std::vector<u8> & vertex_data, u32 stride, u32 index)
+    {
+        return reinterpret_cast<const PackedVertex *>(&vertex_data[index * stride]);
+    }
+
+    // Smooth normals of the positions of the file, for the corners
+    // that don't have any normal. Empty when every corner has one.
+    static std::vector<Float3>
+    GenerateNormals(const ObjData & data, u32 thread_count)
+    {
+        const u32 corner_count = static_cast<u32>(data.corners.size());
+
+        u32 first_missing = 0;
+        while (first_missing < corner_count && data.corners[first_missing].normal != kNoIndex)
+            ++first_missing;
+        if (first_missing == corner_count)
+            return std::vector<Float3>();
+
+        std::vector<u32> indices(corner_count);
+        for (u32 i = 0; i < corner_count; ++i)
+            indices[i] = data.corners[i].position;
+
+        std::vector<Float3> normals(data.positions.size());
+        ComputeNormals(&data.positions[0].x, static_cast<u32>(data.positions.size()),
+            &indices[0], corner_count, &normals[0].x, 0, thread_count);
+        return normals;
+    }
+
+    // Turn each corner into an interleaved vertex of `stride` bytes.
+    // Corners without a normal take the one generated for their
+    // position. Tangents, if any, are left to zero.
+    static std::vector<u8>
+    CreateVertexData(const ObjData & data, const std::vector<Float3> & generated_normals,
+        const std::vector<Corner> & corners, u32 stride, u32 thread_count)
+    {
+        const u32 vertex_count = static_cast<u32>(corners.size());
+
+        std::vector<u8> vertex_data(vertex_count * stride);
+
+        ParallelFor(vertex_count, kMinVerticesPerThread, thread_count,
+            [&](u32 begin, u32 end)
+            {
+                for (u32 i = begin; i < end; ++i)
+                {
+                    const Corner & corner = corners[i];
+                    PackedVertex & vertex = *VertexAt(vertex_data, stride, i);
+
+                    const Float3 & position = data.positions[corner.position];
+                    vertex.position[0] = position.x;
+                    vertex.position[1] = position.y;
+                    vertex.position[2] = position.z;
+
+                    if (corner.tex_coord != kNoIndex)
                     {
-                        // If the element count is 2, then it means the
-                        // face contains position and texcoord.
-                        vertex_mapping = std::make_tuple(indices[0], indices[1]);
+                        const Float2 & tex_coord = data.tex_coords[corner.tex_coord];
+                        vertex.tex_coord[0] = tex_coord.u;
+                        vertex.tex_coord[1] = tex_coord.v;
                     }
-                    else if (element_count == 3)
+                    else
                     {
-                        // If the element count is 3, then it means the
-                        // face contains position, normal, and texcoord.
-                        // For now, we only need position and texcoord,
-                        // which means we need to take first and third
-                        // indices.
-                        vertex_mapping = std::make_tuple(indices[0], indices[2]);
+                        vertex.tex_coord[0] = 0.0f;
+                        vertex.tex_coord[1] = 0.0f;
                     }
 
-                    vertex_mappings.push_back(vertex_mapping);
+                    const Float3 & normal = (corner.normal != kNoIndex)
+                        ? data.normals[corner.normal]
+                        : generated_normals[corner.position];
+                    vertex.normal[0] = normal.x;
+                    vertex.normal[1] = normal.y;
+                    vertex.normal[2] = normal.z;
                 }
-            }
-        default :
-            break;
+            });
+
+        return vertex_data;
+    }
+
+    // One vertex per index, copied from the vertex it refers to.
+    static std::vector<u8>
+    ExpandVertexData(const std::vector<u8> & vertex_data,
+        const std::vector<u32> & indices, u32 stride)
+    {
+        std::vector<u8> expanded(indices.size() * stride);
+        for (size_t i = 0; i < indices.size(); ++i)
+            std::memcpy(&expanded[i * stride], &vertex_data[indices[i] * stride], stride);
+        return expanded;
+    }
+
+    // Bounds of the vertices that `count` indices refer to.
+    static Bounds
+    ComputeIndexedBounds(const std::vector<u8> & vertex_data, u32 stride,
+        const u32 * indices, u32 count)
+    {
+        std::vector<float> positions(3 * count);
+        for (u32 i = 0; i < count; ++i)
+        {
+            const float * position = VertexAt(vertex_data, stride, indices[i])->position;
+            positions[3 * i + 0] = position[0];
+            positions[3 * i + 1] = position[1];
+            positions[3 * i + 2] = position[2];
         }
+        return ComputeBounds(positions.empty() ? nullptr : &positions[0], count);
     }
 
-    for (auto vertex_mapping : vertex_mappings)
+    // Build the `Model`. Without indices, there is one vertex per
+    // corner. With indices, there is one vertex per distinct corner,
+    // and the indices refer to them in the order of the corners.
+    static std::shared_ptr<Model>
+    BuildModel(const ObjData & data, bool indexed, bool tangents, u32 thread_count)
     {
-        u32 position_index = std::get<0>(vertex_mapping);
-        u32 texture_index  = std::get<1>(vertex_mapping);
+        const u32 corner_count = static_cast<u32>(data.corners.size());
+        const VertexLayout layout = CreateVertexLayout(tangents);
+        const u32 stride = layout.stride();
+        const std::vector<Float3> generated_normals = GenerateNormals(data, thread_count);
 
-        ///
-        // Process vertex position information.
-        ///
+        std::vector<u32> indices;
+        std::vector<u8> vertex_data;
+        if (indexed || tangents)
+        {
+            // The tangent of a vertex sums what every triangle that
+            // uses it contributes, so tangents are computed on shared
+            // vertices even when the model isn't indexed.
+            std::vector<Corner> vertices;
+            CornerTable table(corner_count, vertices);
 
-        VertexAttributeData va_position_data;
+            indices.resize(corner_count);
+            for (u32 i = 0; i < corner_count; ++i)
+                indices[i] = table.Insert(data.corners[i]);
 
-        va_position_data.float_3[0] = vertices_position[position_index - 1].x;
-        va_position_data.float_3[1] = vertices_position[position_index - 1].y;
-        va_position_data.float_3[2] = vertices_position[position_index - 1].z;
+            vertex_data = CreateVertexData(data, generated_normals, vertices, stride,
+                thread_count);
 
-        VertexAttribute va_position;
-        va_position.format = VertexAttributeFormat::kFloat3;
-        va_position.data   = va_position_data;
+            if (tangents && !vertices.empty())
+            {
+                PackedVertex * first = VertexAt(vertex_data, stride, 0);
+                ComputeTangents(first->position, first->normal, first->tex_coord,
+                    static_cast<u32>(vertices.size()), &indices[0], corner_count,
+                    first->tangent, stride, thread_count);
+            }
 
-        vertex_attributes.push_back(va_position);
+            if (!indexed)
+            {
+                vertex_data = ExpandVertexData(vertex_data, indices, stride);
+                indices.clear();
+            }
+        }
+        else
+        {
+            vertex_data = CreateVertexData(data, generated_normals, data.corners, stride,
+                thread_count);
+        }
 
         ///
-        // Process vertex texture coordinate information.
+        // Compute the bounds of the whole model and of each group.
         ///
 
-        VertexAttributeData va_tex_coord_data;
+        const u32 vertex_count = static_cast<u32>(vertex_data.size() / stride);
+
+        std::vector<ModelGroup> groups;
+        for (size_t i = 0; i < data.group_starts.size(); ++i)
+        {
+            u32 first = std::get<1>(data.group_starts[i]);
+            u32 end = (i + 1 < data.group_starts.size())
+                ? std::get<1>(data.group_starts[i + 1])
+                : corner_count;
+
+            // Skip groups without any face.
+            if (end == first)
+                continue;
+
+            ModelGroup group;
+            group.name         = std::get<0>(data.group_starts[i]);
+            group.first_vertex = first;
+            group.vertex_count = end - first;
+            group.bounds       = indexed
+                ? ComputeIndexedBounds(vertex_data, stride, &indices[first], end - first)
+                : ComputeBounds(VertexAt(vertex_data, stride, first)->position,
+                    end - first, stride);
+            groups.push_back(group);
+        }
+
+        const Bounds bounds = ComputeBounds(
+            vertex_count ? VertexAt(vertex_data, stride, 0)->position : nullptr,
+            vertex_count, stride);
+
+        if (indexed)
+        {
+            return std::make_shared<Model>(
+                layout,
+                std::move(vertex_data),
+                indices,
+                bounds,
+                std::move(groups));
+        }
+
+        return std::make_shared<Model>(
+            layout,
+            std::move(vertex_data),
+            bounds,
+            std::move(groups));
+    }
+}
+
+ModelLoaderOBJ::ModelLoaderOBJ(u32 thread_count) :
+    thread_count_(thread_count),
+    indexed_(false),
+    tangents_(false)
+{
+}
+
+ModelLoaderOBJ &
+ModelLoaderOBJ::SetIndexed(bool indexed)
+{
+    indexed_ = indexed;
+    return *this;
+}
 
-        va_tex_coord_data.float_2[0] = vertices_tex_coord[texture_index - 1].u;
-        va_tex_coord_data.float_2[1] = vertices_tex_coord[texture_index - 1].v;
+ModelLoaderOBJ &
+ModelLoaderOBJ::SetTangents(bool tangents)
+{
+    tangents_ = tangents;
+    return *this;
+}
+
+bool
+ModelLoaderOBJ::CanLoad(std::istream & stream)
+{
+    // Statements an OBJ file can start with. Anything else, binary data
+    // included, isn't OBJ.
+    static const char * const kKeywords[] = {
+        "v", "vt", "vn", "vp", "f", "l", "p", "g", "o", "s", "mtllib", "usemtl"
+    };
+    static const size_t kMaxLines = 256;
+
+    std::string line;
+    for (size_t i = 0; i < kMaxLines && std::getline(stream, line); ++i)
+    {
+        const size_t begin = line.find_first_not_of(" \t\r");
+        if (begin == std::string::npos || line[begin] == '#')
+            continue;
 
-        VertexAttribute va_texture;
-        va_texture.format = VertexAttributeFormat::kFloat2;
-        va_texture.data   = va_tex_coord_data;
+        const size_t end = line.find_first_of(" \t\r", begin);
+        const std::string keyword = line.substr(begin, end - begin);
+        for (size_t k = 0; k < sizeof(kKeywords) / sizeof(kKeywords[0]); ++k)
+        {
+            if (keyword == kKeywords[k])
+                return true;
+        }
+        return false;
+    }
+    return false;
+}
 
-        vertex_attributes.push_back(va_texture);
+std::shared_ptr<Model>
+ModelLoaderOBJ::Load(std::istream & stream)
+{
+    // Read everything in one go, and parse it from memory.
+    static const size_t kBlockSize = 64 * 1024;
+
+    std::vector<char> content;
+    size_t size = 0;
+    while (stream)
+    {
+        content.resize(size + kBlockSize);
+        stream.read(&content[size], kBlockSize);
+        size += static_cast<size_t>(stream.gcount());
+    }
+
+    return Load(content.empty() ? nullptr : &content[0], size);
+}
+
+std::shared_ptr<Model>
+ModelLoaderOBJ::Load(const std::string & path)
+{
+    MappedFile file(path);
+    return Load(file.data(), file.size());
+}
+
+std::shared_ptr<Model>
+ModelLoaderOBJ::Load(const char * data, size_t size)
+{
+    const u32 thread_count = (thread_count_ == 0) ? HardwareThreadCount() : thread_count_;
+    const u32 chunk_count = static_cast<u32>(
+        std::min<size_t>(thread_count, size / kMinBytesPerThread));
+
+    ObjData obj;
+    obj.group_starts.push_back(std::make_tuple(std::string("default"), 0u));
+
+    if (chunk_count > 1)
+    {
+        ParseChunks(data, data + size, chunk_count, thread_count, obj);
+    }
+    else
+    {
+        const ObjCounts base = { 0, 0, 0, 0 };
+        Parse(data, data + size, base, obj);
     }
 
-    return std::make_shared<Model>(vertex_attributes);
+    return BuildModel(obj, indexed_, tangents_, thread_count);
 }
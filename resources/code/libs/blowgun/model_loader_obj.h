@@ -1,21 +1,83 @@
 #ifndef BLOWGUN_MODEL_LOADER_OBJ_H_
 #define BLOWGUN_MODEL_LOADER_OBJ_H_
 
-#include <string>
+#include <cstddef>
+#include <istream>
 #include <memory>
+#include <string>
 
 #include "model.h"
+#include "model_loader.h"
+#include "types.h"
 
 namespace blowgun
 {
 
-class ModelLoaderOBJ
+class ModelLoaderOBJ : public ModelLoader
 {
 public:
-    explicit ModelLoaderOBJ();
-    std::shared_ptr<Model> Load(std::istream & stream);
+    /**
+     * @param   thread_count
+     *          Upper bound of threads to parse large files with,
+     *          including the calling one. Zero means
+     *          `HardwareThreadCount()`. The result is the same whatever
+     *          the number of threads.
+     */
+    explicit ModelLoaderOBJ(u32 thread_count = 1);
+
+    /**
+     * Choose whether to load indexed models. An indexed model has one
+     * vertex per distinct position, texture coordinate and normal
+     * triple of the file, and an index buffer for `glDrawElements`,
+     * instead of one vertex per corner of each face.
+     *
+     * Models aren't indexed by default.
+     */
+    ModelLoaderOBJ & SetIndexed(bool indexed);
+
+    /**
+     * Choose whether vertices have a tangent, for normal mapping. The
+     * tangent has a fourth component, the handedness, so the bitangent
+     * is `w * cross(normal, tangent)`.
+     *
+     * Vertices have no tangent by default.
+     */
+    ModelLoaderOBJ & SetTangents(bool tangents);
+
+    /**
+     * Check whether the first line of `stream` that isn't blank or a
+     * comment starts with an OBJ keyword.
+     */
+    virtual bool CanLoad(std::istream & stream);
+
+    /**
+     * Load a model from the whole content of `stream`.
+     *
+     * Faces with more than three corners are split into triangles.
+     * Every vertex has a normal: corners without one in the file get
+     * a smooth normal, computed from the faces around their position.
+     * Throws when the content is malformed or refers to a vertex that
+     * doesn't exist.
+     */
+    virtual std::shared_ptr<Model> Load(std::istream & stream);
+
+    /**
+     * Load a model from the file at `path`, which is mapped in memory
+     * rather than read through a stream.
+     */
+    std::shared_ptr<Model> Load(const std::string & path);
+
+    /**
+     * Load a model from `size` bytes of OBJ text, which don't need to
+     * be null-terminated.
+     */
+    std::shared_ptr<Model> Load(const char * data, std::size_t size);
 
 private:
+    u32  thread_count_;
+    bool indexed_;
+    bool tangents_;
+
 	ModelLoaderOBJ(const ModelLoaderOBJ &); // = delete;
     ModelLoaderOBJ & operator=(const ModelLoaderOBJ &); // = delete;
 };
@@ -1,3 +1,5 @@
+#include <cmath>
+#include <cstring>
 #include <fstream>
 #include <iostream>
 #include <sstream>
@@ -23,9 +25,9 @@ TEST(ModelLoaderOBJTest, ParseSimpleObj)
 
     ModelLoaderOBJ loader;
     auto model = loader.Load(simpleObjStream);
-    auto vertices_attributes = model->vertex_attributes();
 
-    EXPECT_EQ(6, (int) vertices_attributes.size());
+    EXPECT_EQ(3u, model->vertex_count());
+    EXPECT_EQ(3u * 8u * sizeof(float), model->vertex_data_size());
 }
 
 TEST(ModelLoaderOBJTest, ParseCubeObj)
@@ -33,7 +35,518 @@ TEST(ModelLoaderOBJTest, ParseCubeObj)
     ModelLoaderOBJ loader;
     std::ifstream cubeObjFile("data/cube.obj", std::ios::in);
     auto model = loader.Load(cubeObjFile);
-    auto vertices_attributes = model->vertex_attributes();
 
-    EXPECT_EQ(72, (int) vertices_attributes.size());
-}
\ No newline at end of file
+    EXPECT_EQ(36u, model->vertex_count());
+
+    // Positions, texture coordinates and normals, interleaved and
+    // tightly packed.
+    const VertexLayout & layout = model->vertex_layout();
+    ASSERT_EQ(3u, layout.elements().size());
+    EXPECT_EQ(8u * sizeof(float), layout.stride());
+    ASSERT_NE(nullptr, layout.Find(VertexAttributeUsage::kPosition));
+    EXPECT_EQ(0u, layout.Find(VertexAttributeUsage::kPosition)->offset);
+    EXPECT_EQ(VertexAttributeFormat::kFloat3, layout.Find(VertexAttributeUsage::kPosition)->format);
+    ASSERT_NE(nullptr, layout.Find(VertexAttributeUsage::kTexCoord));
+    EXPECT_EQ(3u * sizeof(float), layout.Find(VertexAttributeUsage::kTexCoord)->offset);
+    ASSERT_NE(nullptr, layout.Find(VertexAttributeUsage::kNormal));
+    EXPECT_EQ(5u * sizeof(float), layout.Find(VertexAttributeUsage::kNormal)->offset);
+    EXPECT_EQ(nullptr, layout.Find(VertexAttributeUsage::kTangent));
+}
+TEST(ModelLoaderOBJTest, CubeBounds)
+{
+    ModelLoaderOBJ loader;
+    std::ifstream cubeObjFile("data/cube.obj", std::ios::in);
+    auto model = loader.Load(cubeObjFile);
+
+    const Bounds & bounds = model->bounds();
+    EXPECT_FLOAT_EQ(-4.0f, bounds.aabb.min.x);
+    EXPECT_FLOAT_EQ(-4.0f, bounds.aabb.min.y);
+    EXPECT_FLOAT_EQ(-4.0f, bounds.aabb.min.z);
+    EXPECT_FLOAT_EQ(4.0f, bounds.aabb.max.x);
+    EXPECT_FLOAT_EQ(4.0f, bounds.aabb.max.y);
+    EXPECT_FLOAT_EQ(4.0f, bounds.aabb.max.z);
+    EXPECT_FLOAT_EQ(std::sqrt(48.0f), bounds.sphere.radius);
+
+    // Without any 'g', everything is in the default group.
+    ASSERT_EQ(1u, model->groups().size());
+    EXPECT_EQ("default", model->groups()[0].name);
+    EXPECT_EQ(36u, model->groups()[0].vertex_count);
+}
+
+TEST(ModelLoaderOBJTest, GroupBounds)
+{
+    const char groupsObjCString[] =
+        "v  0.0  0.0  0.0\n"
+        "v  1.0  0.0  0.0\n"
+        "v  0.0  1.0  0.0\n"
+        "v  5.0  5.0  5.0\n"
+        "v  6.0  5.0  5.0\n"
+        "v  5.0  6.0  7.0\n"
+        "vt 0.0  0.0\n"
+        "g  first\n"
+        "f  1/1  2/1  3/1\n"
+        "g  second\n"
+        "f  4/1  5/1  6/1\n"
+        "f  1/1  5/1  6/1\n"
+        "g\n";
+
+    std::stringstream groupsObjStream(std::string(groupsObjCString), std::ios::in);
+
+    ModelLoaderOBJ loader;
+    auto model = loader.Load(groupsObjStream);
+
+    const std::vector<ModelGroup> & groups = model->groups();
+    ASSERT_EQ(2u, groups.size());
+
+    EXPECT_EQ("first", groups[0].name);
+    EXPECT_EQ(0u, groups[0].first_vertex);
+    EXPECT_EQ(3u, groups[0].vertex_count);
+    EXPECT_FLOAT_EQ(1.0f, groups[0].bounds.aabb.max.x);
+    EXPECT_FLOAT_EQ(0.0f, groups[0].bounds.aabb.max.z);
+
+    EXPECT_EQ("second", groups[1].name);
+    EXPECT_EQ(3u, groups[1].first_vertex);
+    EXPECT_EQ(6u, groups[1].vertex_count);
+    EXPECT_FLOAT_EQ(0.0f, groups[1].bounds.aabb.min.x);
+    EXPECT_FLOAT_EQ(7.0f, groups[1].bounds.aabb.max.z);
+
+    EXPECT_FLOAT_EQ(0.0f, model->bounds().aabb.min.y);
+    EXPECT_FLOAT_EQ(6.0f, model->bounds().aabb.max.y);
+}
+
+namespace
+{
+    std::shared_ptr<Model> LoadString(const char * content)
+    {
+        std::stringstream stream(std::string(content), std::ios::in);
+        ModelLoaderOBJ loader;
+        return loader.Load(stream);
+    }
+
+    const float * Attribute(const Model & model, VertexAttributeUsage::Enum usage, u32 vertex)
+    {
+        const VertexLayout & layout = model.vertex_layout();
+        return reinterpret_cast<const float *>(
+            model.vertex_data() + vertex * layout.stride() + layout.Find(usage)->offset);
+    }
+
+    const float * Position(const Model & model, u32 vertex)
+    {
+        return Attribute(model, VertexAttributeUsage::kPosition, vertex);
+    }
+
+    const float * TexCoord(const Model & model, u32 vertex)
+    {
+        return Attribute(model, VertexAttributeUsage::kTexCoord, vertex);
+    }
+
+    const float * Normal(const Model & model, u32 vertex)
+    {
+        return Attribute(model, VertexAttributeUsage::kNormal, vertex);
+    }
+
+    const float * Tangent(const Model & model, u32 vertex)
+    {
+        return Attribute(model, VertexAttributeUsage::kTangent, vertex);
+    }
+}
+
+TEST(ModelLoaderOBJTest, ParseNumbers)
+{
+    auto model = LoadString(
+        "v 1 -2 +3\n"
+        "v .5 5. -0.25\n"
+        "v 1.5e2 -2.5E-3 1e+1\n"
+        "v 0.000000000000000000001 123456789012345678901234 -0\n"
+        "vt 0.125 0.75\n"
+        "f 1/1 2/1 3/1\n"
+        "f 4/1 1/1 1/1\n");
+    ASSERT_EQ(6u, model->vertex_count());
+
+    EXPECT_FLOAT_EQ(1.0f, Position(*model, 0)[0]);
+    EXPECT_FLOAT_EQ(-2.0f, Position(*model, 0)[1]);
+    EXPECT_FLOAT_EQ(3.0f, Position(*model, 0)[2]);
+    EXPECT_FLOAT_EQ(0.5f, Position(*model, 1)[0]);
+    EXPECT_FLOAT_EQ(5.0f, Position(*model, 1)[1]);
+    EXPECT_FLOAT_EQ(-0.25f, Position(*model, 1)[2]);
+    EXPECT_FLOAT_EQ(150.0f, Position(*model, 2)[0]);
+    EXPECT_FLOAT_EQ(-0.0025f, Position(*model, 2)[1]);
+    EXPECT_FLOAT_EQ(10.0f, Position(*model, 2)[2]);
+    EXPECT_FLOAT_EQ(1e-21f, Position(*model, 3)[0]);
+    EXPECT_FLOAT_EQ(1.23456789e23f, Position(*model, 3)[1]);
+    EXPECT_FLOAT_EQ(0.0f, Position(*model, 3)[2]);
+
+    EXPECT_FLOAT_EQ(0.125f, TexCoord(*model, 0)[0]);
+    EXPECT_FLOAT_EQ(0.75f, TexCoord(*model, 0)[1]);
+}
+
+TEST(ModelLoaderOBJTest, ParseFaceFormats)
+{
+    // Every corner syntax, negative indices, a quad, Windows line
+    // endings and a trailing line without any end of line.
+    auto model = LoadString(
+        "# comment\r\n"
+        "o object\r\n"
+        "v 0 0 0\r\n"
+        "v 1 0 0\r\n"
+        "v 1 1 0\r\n"
+        "v 0 1 0\r\n"
+        "vt 0.1 0.1\r\n"
+        "vt 0.2 0.2\r\n"
+        "vt 0.3 0.3\r\n"
+        "vn 0 0 1\r\n"
+        "usemtl none\r\n"
+        "s off\r\n"
+        "f 1 2 3\r\n"
+        "f 1//1 2//1 3//1\r\n"
+        "f 1/3/1 2/2/1 3/1/1\r\n"
+        "f -4/-3 -3/-2 -2/-1 -1/-1");
+    ASSERT_EQ(15u, model->vertex_count());
+
+    // No texture coordinate at all.
+    EXPECT_FLOAT_EQ(0.0f, TexCoord(*model, 0)[0]);
+    EXPECT_FLOAT_EQ(0.0f, TexCoord(*model, 5)[1]);
+
+    // The texture coordinate is the second index, even when there is
+    // a normal index after it.
+    EXPECT_FLOAT_EQ(0.3f, TexCoord(*model, 6)[0]);
+    EXPECT_FLOAT_EQ(0.1f, TexCoord(*model, 8)[0]);
+
+    // The quad is split into (1, 2, 3) and (1, 3, 4).
+    EXPECT_FLOAT_EQ(0.0f, Position(*model, 9)[0]);
+    EXPECT_FLOAT_EQ(1.0f, Position(*model, 10)[0]);
+    EXPECT_FLOAT_EQ(1.0f, Position(*model, 11)[1]);
+    EXPECT_FLOAT_EQ(0.0f, Position(*model, 12)[0]);
+    EXPECT_FLOAT_EQ(1.0f, Position(*model, 13)[0]);
+    EXPECT_FLOAT_EQ(0.0f, Position(*model, 14)[0]);
+    EXPECT_FLOAT_EQ(1.0f, Position(*model, 14)[1]);
+    EXPECT_FLOAT_EQ(0.1f, TexCoord(*model, 9)[0]);
+    EXPECT_FLOAT_EQ(0.3f, TexCoord(*model, 14)[0]);
+}
+
+TEST(ModelLoaderOBJTest, ParseErrors)
+{
+    EXPECT_THROW(LoadString("v 0 0 0\nf 1 1 2\n"), std::runtime_error *);
+    EXPECT_THROW(LoadString("v 0 0 0\nf 1 1 0\n"), std::runtime_error *);
+    EXPECT_THROW(LoadString("v 0 0 0\nf 1 1 -2\n"), std::runtime_error *);
+    EXPECT_THROW(LoadString("v 0 0 0\nvt 0 0\nf 1/2 1/1 1/1\n"), std::runtime_error *);
+    EXPECT_THROW(LoadString("v 0 0 0\nf 1 1\n"), std::runtime_error *);
+    EXPECT_THROW(LoadString("v 0 0 0\nf 1 1 1x\n"), std::runtime_error *);
+    EXPECT_THROW(LoadString("v 0 zero 0\n"), std::runtime_error *);
+    EXPECT_THROW(LoadString("v 0 1e 0\n"), std::runtime_error *);
+    EXPECT_THROW(LoadString("v 0 0\n"), std::runtime_error *);
+
+    EXPECT_EQ(0u, LoadString("")->vertex_count());
+}
+
+TEST(ModelLoaderOBJTest, LoadFromPath)
+{
+    ModelLoaderOBJ loader;
+    std::ifstream cubeObjFile("data/cube.obj", std::ios::in | std::ios::binary);
+    auto from_stream = loader.Load(cubeObjFile);
+    auto from_path = loader.Load(std::string("data/cube.obj"));
+
+    ASSERT_EQ(from_stream->vertex_data_size(), from_path->vertex_data_size());
+    EXPECT_EQ(0, std::memcmp(from_stream->vertex_data(), from_path->vertex_data(),
+        from_path->vertex_data_size()));
+
+    EXPECT_THROW(loader.Load(std::string("data/missing.obj")), std::runtime_error *);
+}
+
+TEST(ModelLoaderOBJTest, BananaTexCoords)
+{
+    // Banana has as many normals as positions but more texture
+    // coordinates, so taking the wrong index of `v/t/n` shows.
+    ModelLoaderOBJ loader;
+    auto model = loader.Load(std::string("data/banana.obj"));
+    ASSERT_EQ(3u * 8056u, model->vertex_count());
+
+    // f 231/242/231 ...
+    EXPECT_FLOAT_EQ(3273.670654f, Position(*model, 0)[0]);
+    EXPECT_FLOAT_EQ(0.077604f, TexCoord(*model, 0)[0]);
+    EXPECT_FLOAT_EQ(0.863815f, TexCoord(*model, 0)[1]);
+
+    // The 4000th face: f 1990/2184/1990 ...
+    EXPECT_FLOAT_EQ(0.170606f, TexCoord(*model, 3 * 3999)[0]);
+    EXPECT_FLOAT_EQ(0.547047f, TexCoord(*model, 3 * 3999)[1]);
+}
+
+namespace
+{
+    // A large file, with every kind of record, quads, negative indices
+    // and Windows line endings, so that it gets split in many pieces
+    // and faces refer to vertices of other pieces.
+    std::string CreateLargeObj()
+    {
+        std::ostringstream obj;
+        for (u32 i = 0; i < 40000; ++i)
+        {
+            if (i % 10000 == 0)
+                obj << "g group" << i / 10000 << "\r\n";
+
+            obj << "v " << i * 0.25f << " " << -(i % 97) * 1.5f << " " << i % 13 << "\r\n";
+            obj << "vt " << (i % 100) * 0.01f << " " << (i % 7) * 0.125f << "\r\n";
+            obj << "vn 0 0 1\r\n";
+
+            if (i % 4 == 3)
+                obj << "f " << i - 2 << "/" << i - 2 << "/1 "
+                    << i - 1 << "/" << i << "/1 "
+                    << "-1/-1/-1 -4/-3/-1\r\n";
+            if (i >= 20000 && i % 5 == 0)
+                obj << "f 1/1 " << i / 2 << "/" << i / 3 << " -1/-2\r\n";
+        }
+        return obj.str();
+    }
+
+    std::string LoadError(const std::string & content, u32 thread_count)
+    {
+        ModelLoaderOBJ loader(thread_count);
+        try
+        {
+            loader.Load(content.data(), content.size());
+        }
+        catch (std::runtime_error * error)
+        {
+            std::string what = error->what();
+            delete error;
+            return what;
+        }
+        return std::string();
+    }
+
+    void ExpectSameModel(const Model & expected, const Model & actual)
+    {
+        ASSERT_TRUE(expected.vertex_layout() == actual.vertex_layout());
+        ASSERT_EQ(expected.vertex_data_size(), actual.vertex_data_size());
+        ASSERT_EQ(0, std::memcmp(expected.vertex_data(), actual.vertex_data(),
+            expected.vertex_data_size()));
+
+        ASSERT_EQ(expected.groups().size(), actual.groups().size());
+        for (size_t i = 0; i < expected.groups().size(); ++i)
+        {
+            EXPECT_EQ(expected.groups()[i].name, actual.groups()[i].name);
+            EXPECT_EQ(expected.groups()[i].first_vertex, actual.groups()[i].first_vertex);
+            EXPECT_EQ(expected.groups()[i].vertex_count, actual.groups()[i].vertex_count);
+        }
+        EXPECT_EQ(0, std::memcmp(&expected.bounds(), &actual.bounds(), sizeof(Bounds)));
+    }
+}
+
+TEST(ModelLoaderOBJTest, ThreadedLoadMatchesSerial)
+{
+    const std::string obj = CreateLargeObj();
+    ModelLoaderOBJ serial_loader;
+    auto serial = serial_loader.Load(obj.data(), obj.size());
+    ASSERT_EQ(4u, serial->groups().size());
+
+    const u32 thread_counts[] = { 2, 3, 8, 0 };
+    for (u32 i = 0; i < sizeof(thread_counts) / sizeof(thread_counts[0]); ++i)
+    {
+        ModelLoaderOBJ loader(thread_counts[i]);
+        ExpectSameModel(*serial, *loader.Load(obj.data(), obj.size()));
+    }
+
+    ModelLoaderOBJ threaded_loader(4);
+    ExpectSameModel(
+        *serial_loader.Load(std::string("data/banana.obj")),
+        *threaded_loader.Load(std::string("data/banana.obj")));
+}
+
+TEST(ModelLoaderOBJTest, ThreadedLoadReportsFirstError)
+{
+    // Two malformed lines far apart: the threaded loader must report
+    // the first one, with the same line number as the serial loader.
+    std::string obj = CreateLargeObj();
+    const size_t first = obj.find("\nv ", obj.size() / 3);
+    const size_t second = obj.find("\nv ", 2 * obj.size() / 3);
+    obj.insert(second + 3, "x");
+    obj.insert(first + 3, "x");
+
+    const std::string serial_error = LoadError(obj, 1);
+    EXPECT_NE(std::string::npos, serial_error.find("line "));
+    EXPECT_EQ(serial_error, LoadError(obj, 8));
+}
+
+namespace
+{
+    // Expand an indexed model back into one vertex per index.
+    std::vector<u8> Expand(const Model & model)
+    {
+        const u32 stride = model.vertex_layout().stride();
+        std::vector<u8> expanded;
+        for (u32 i = 0; i < model.index_count(); ++i)
+        {
+            const u32 index = (model.index_format() == IndexFormat::kUnsignedInt)
+                ? static_cast<const u32 *>(model.index_data())[i]
+                : static_cast<const u16 *>(model.index_data())[i];
+            EXPECT_GT(model.vertex_count(), index);
+            const u8 * vertex = model.vertex_data() + index * stride;
+            expanded.insert(expanded.end(), vertex, vertex + stride);
+        }
+        return expanded;
+    }
+
+    std::vector<u8> VertexData(const Model & model)
+    {
+        return std::vector<u8>(model.vertex_data(),
+            model.vertex_data() + model.vertex_data_size());
+    }
+}
+
+TEST(ModelLoaderOBJTest, IndexedCube)
+{
+    ModelLoaderOBJ loader;
+    auto expanded = loader.Load(std::string("data/cube.obj"));
+    EXPECT_EQ(0u, expanded->index_count());
+    EXPECT_EQ(nullptr, expanded->index_data());
+
+    loader.SetIndexed(true);
+    auto indexed = loader.Load(std::string("data/cube.obj"));
+
+    // 24 distinct corners: each of the 6 faces has its own 4 corners.
+    EXPECT_EQ(24u, indexed->vertex_count());
+    EXPECT_EQ(36u, indexed->index_count());
+    EXPECT_EQ(IndexFormat::kUnsignedShort, indexed->index_format());
+    EXPECT_EQ(VertexData(*expanded), Expand(*indexed));
+
+    EXPECT_EQ(0, std::memcmp(&expanded->bounds(), &indexed->bounds(), sizeof(Bounds)));
+    ASSERT_EQ(1u, indexed->groups().size());
+    EXPECT_EQ(0u, indexed->groups()[0].first_vertex);
+    EXPECT_EQ(36u, indexed->groups()[0].vertex_count);
+}
+
+TEST(ModelLoaderOBJTest, IndexedMatchesExpanded)
+{
+    ModelLoaderOBJ loader(4);
+    auto expanded = loader.Load(std::string("data/banana.obj"));
+    auto indexed = loader.SetIndexed(true).Load(std::string("data/banana.obj"));
+
+    // Banana uses the same index for positions and normals, so there is
+    // one vertex per distinct position and texture coordinate pair.
+    EXPECT_EQ(4420u, indexed->vertex_count());
+    EXPECT_EQ(IndexFormat::kUnsignedShort, indexed->index_format());
+    EXPECT_EQ(VertexData(*expanded), Expand(*indexed));
+
+    ASSERT_EQ(expanded->groups().size(), indexed->groups().size());
+    for (size_t i = 0; i < expanded->groups().size(); ++i)
+    {
+        const ModelGroup & expected = expanded->groups()[i];
+        const ModelGroup & actual = indexed->groups()[i];
+        EXPECT_EQ(expected.name, actual.name);
+        EXPECT_EQ(expected.first_vertex, actual.first_vertex);
+        EXPECT_EQ(expected.vertex_count, actual.vertex_count);
+        EXPECT_EQ(0, std::memcmp(&expected.bounds.aabb, &actual.bounds.aabb, sizeof(AABB)));
+    }
+}
+
+TEST(ModelLoaderOBJTest, IndexedLargeModelUses32BitIndices)
+{
+    // More distinct corners than 16-bit indices can address.
+    std::ostringstream obj;
+    for (u32 i = 0; i < 70000; ++i)
+        obj << "v " << i << " 0 0\n";
+    for (u32 i = 1; i + 2 <= 70000; i += 3)
+        obj << "f " << i << " " << i + 1 << " " << i + 2 << "\n";
+    obj << "f 1 2 70000\n";
+
+    const std::string content = obj.str();
+    ModelLoaderOBJ loader;
+    auto model = loader.SetIndexed(true).Load(content.data(), content.size());
+
+    EXPECT_EQ(IndexFormat::kUnsignedInt, model->index_format());
+    EXPECT_EQ(70000u, model->vertex_count());
+    ASSERT_EQ(3u * 23334u, model->index_count());
+
+    const u32 * indices = static_cast<const u32 *>(model->index_data());
+    EXPECT_EQ(0u, indices[3 * 23333 + 0]);
+    EXPECT_EQ(1u, indices[3 * 23333 + 1]);
+    EXPECT_EQ(69999u, indices[3 * 23333 + 2]);
+}
+
+TEST(ModelLoaderOBJTest, GeneratedNormals)
+{
+    // Corners without a normal get the sum of the normals of the faces
+    // around their position, weighted by area: the face in the yz
+    // plane is twice as large as the one in the xy plane. Corners with
+    // a normal keep it.
+    auto model = LoadString(
+        "v 0 0 0\n"
+        "v 1 0 0\n"
+        "v 0 1 0\n"
+        "v 0 0 2\n"
+        "v 5 0 0\n"
+        "v 6 0 0\n"
+        "v 5 1 0\n"
+        "vn 0 1 0\n"
+        "f 1 2 3\n"
+        "f 1 3 4\n"
+        "f 5//1 6//1 7//1\n");
+    ASSERT_EQ(9u, model->vertex_count());
+
+    const float shared[3] = { 2.0f / std::sqrt(5.0f), 0.0f, 1.0f / std::sqrt(5.0f) };
+    for (u32 i = 0; i < 3; ++i)
+    {
+        EXPECT_NEAR(shared[i], Normal(*model, 0)[i], 1e-6f);
+        EXPECT_NEAR(shared[i], Normal(*model, 3)[i], 1e-6f);
+    }
+    EXPECT_FLOAT_EQ(1.0f, Normal(*model, 1)[2]);
+    EXPECT_FLOAT_EQ(1.0f, Normal(*model, 5)[0]);
+    EXPECT_FLOAT_EQ(1.0f, Normal(*model, 7)[1]);
+    EXPECT_FLOAT_EQ(0.0f, Normal(*model, 7)[2]);
+}
+
+TEST(ModelLoaderOBJTest, Tangents)
+{
+    // Two quads in the xy plane. The texture of the second one is
+    // mirrored along u, which flips its tangent and its handedness.
+    const char * content =
+        "v 0 0 0\nv 1 0 0\nv 1 1 0\nv 0 1 0\n"
+        "v 2 0 0\nv 3 0 0\nv 3 1 0\nv 2 1 0\n"
+        "vt 0 0\nvt 1 0\nvt 1 1\nvt 0 1\n"
+        "f 1/1 2/2 3/3 4/4\n"
+        "f 5/2 6/1 7/4 8/3\n";
+
+    std::stringstream stream(std::string(content), std::ios::in);
+    ModelLoaderOBJ loader;
+    auto model = loader.SetTangents(true).Load(stream);
+    ASSERT_EQ(12u, model->vertex_count());
+
+    const VertexLayout & layout = model->vertex_layout();
+    EXPECT_EQ(12u * sizeof(float), layout.stride());
+    ASSERT_NE(nullptr, layout.Find(VertexAttributeUsage::kTangent));
+    EXPECT_EQ(VertexAttributeFormat::kFloat4, layout.Find(VertexAttributeUsage::kTangent)->format);
+
+    for (u32 i = 0; i < 12; ++i)
+    {
+        const float * tangent = Tangent(*model, i);
+        const float expected = (i < 6) ? 1.0f : -1.0f;
+        EXPECT_NEAR(expected, tangent[0], 1e-6f);
+        EXPECT_NEAR(0.0f, tangent[1], 1e-6f);
+        EXPECT_NEAR(0.0f, tangent[2], 1e-6f);
+        EXPECT_EQ(expected, tangent[3]);
+    }
+
+    // The same vertices when indexed.
+    std::stringstream indexed_stream(std::string(content), std::ios::in);
+    auto indexed = loader.SetIndexed(true).Load(indexed_stream);
+    EXPECT_EQ(8u, indexed->vertex_count());
+    EXPECT_EQ(VertexData(*model), Expand(*indexed));
+}
+
+TEST(ModelLoaderOBJTest, ThreadedTangentsMatchSerial)
+{
+    // Some faces of the large model have no normal, so both generated
+    // normals and tangents are summed over threads.
+    const std::string obj = CreateLargeObj();
+    ModelLoaderOBJ serial_loader;
+    ModelLoaderOBJ threaded_loader(4);
+    serial_loader.SetTangents(true);
+    threaded_loader.SetTangents(true);
+
+    ExpectSameModel(
+        *serial_loader.Load(obj.data(), obj.size()),
+        *threaded_loader.Load(obj.data(), obj.size()));
+    ExpectSameModel(
+        *serial_loader.Load(std::string("data/banana.obj")),
+        *threaded_loader.Load(std::string("data/banana.obj")));
+}
@@ -0,0 +1,39 @@
+#include <memory>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "model.h"
+
+using namespace blowgun;
+
+namespace
+{
+    std::shared_ptr<Model> IndexedModel(const std::vector<u32> & indices, u32 vertex_count)
+    {
+        VertexLayout layout;
+        layout.Add(VertexAttributeUsage::kPosition, VertexAttributeFormat::kFloat3);
+        return std::make_shared<Model>(layout,
+            std::vector<u8>(vertex_count * layout.stride()), indices, Bounds(),
+            std::vector<ModelGroup>());
+    }
+}
+
+TEST(ModelTest, ReadIndices)
+{
+    const u32 small[] = { 0, 1, 2, 2, 1, 3 };
+    std::shared_ptr<Model> model =
+        IndexedModel(std::vector<u32>(small, small + 6), 4);
+    EXPECT_EQ(IndexFormat::kUnsignedShort, model->index_format());
+    EXPECT_EQ(std::vector<u32>(small, small + 6), model->ReadIndices());
+    EXPECT_EQ(std::vector<u32>(small, small + 6),
+        WidenIndices(model->index_format(), model->index_data(), model->index_count()));
+
+    const u32 large[] = { 0, 70000, 1 };
+    model = IndexedModel(std::vector<u32>(large, large + 3), 70001);
+    EXPECT_EQ(IndexFormat::kUnsignedInt, model->index_format());
+    EXPECT_EQ(std::vector<u32>(large, large + 3), model->ReadIndices());
+    EXPECT_EQ(std::vector<u32>(large, large + 3),
+        WidenIndices(model->index_format(), model->index_data(), model->index_count()));
+
+    EXPECT_TRUE(Model().ReadIndices().empty());
+}
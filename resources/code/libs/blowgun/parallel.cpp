@@ -0,0 +1,91 @@
+#include "parallel.h"
+
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace blowgun;
+
+u32
+blowgun::HardwareThreadCount()
+{
+	u32 count = std::thread::hardware_concurrency();
+	return count > 0 ? count : 1;
+}
+
+u32
+blowgun::ParallelRangeCount(u32 count, u32 min_range, u32 thread_count)
+{
+	if (count == 0)
+		return 0;
+
+	if (thread_count == 0)
+		thread_count = HardwareThreadCount();
+	if (min_range == 0)
+		min_range = 1;
+
+	// Don't spawn threads that would only get a handful of items.
+	u32 max_useful_threads = (count + min_range - 1) / min_range;
+	return thread_count < max_useful_threads ? thread_count : max_useful_threads;
+}
+
+void
+blowgun::ParallelFor(
+	u32 count,
+	u32 min_range,
+	u32 thread_count,
+	const std::function<void (u32 begin, u32 end)> & func)
+{
+	if (count == 0)
+		return;
+
+	thread_count = ParallelRangeCount(count, min_range, thread_count);
+	if (thread_count <= 1)
+	{
+		func(0, count);
+		return;
+	}
+
+	std::exception_ptr first_error;
+	std::mutex error_mutex;
+
+	auto run_range = [&](u32 begin, u32 end)
+	{
+		try
+		{
+			func(begin, end);
+		}
+		catch (...)
+		{
+			std::lock_guard<std::mutex> lock(error_mutex);
+			if (!first_error)
+				first_error = std::current_exception();
+		}
+	};
+
+	// Spread the remainder over the first ranges, so no range is more
+	// than one item bigger than another.
+	u32 range_size = count / thread_count;
+	u32 remainder  = count % thread_count;
+
+	std::vector<std::thread> workers;
+	workers.reserve(thread_count - 1);
+
+	u32 first_end = range_size + (remainder > 0 ? 1 : 0);
+	u32 begin = first_end;
+	for (u32 i = 1; i < thread_count; ++i)
+	{
+		u32 end = begin + range_size + (i < remainder ? 1 : 0);
+		workers.push_back(std::thread(run_range, begin, end));
+		begin = end;
+	}
+
+	run_range(0, first_end);
+
+	for (auto worker = workers.begin(); worker != workers.end(); ++worker)
+		worker->join();
+
+	if (first_error)
+		std::rethrow_exception(first_error);
+}
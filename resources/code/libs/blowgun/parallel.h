@@ -0,0 +1,53 @@
+#ifndef BLOWGUN_PARALLEL_H_
+#define BLOWGUN_PARALLEL_H_
+
+#include <functional>
+
+#include "types.h"
+
+namespace blowgun
+{
+
+/**
+ * Get the number of threads the hardware can run concurrently.
+ *
+ * Never returns less than 1.
+ */
+u32 HardwareThreadCount();
+
+/**
+ * Get the number of ranges, and so of threads, `ParallelFor` splits
+ * `count` items into with the same arguments. When it is one, callers
+ * that must not allocate can call their function directly instead:
+ * wrapping it in a `std::function` may allocate.
+ */
+u32 ParallelRangeCount(u32 count, u32 min_range, u32 thread_count);
+
+/**
+ * Split `[0, count)` into contiguous ranges and call `func(begin, end)`
+ * once for each range, spread over several threads.
+ *
+ * The calling thread processes the first range itself, and the call
+ * returns only after every range is done. If `func` throws, the first
+ * exception is rethrown on the calling thread.
+ *
+ * @param   count
+ *          Total number of items.
+ * @param   min_range
+ *          The smallest number of items worth handing to a thread.
+ *          Small inputs are processed entirely on the calling thread.
+ * @param   thread_count
+ *          Upper bound of threads to use, including the calling one.
+ *          Zero means `HardwareThreadCount()`.
+ * @param   func
+ *          The work for one range.
+ */
+void ParallelFor(
+	u32 count,
+	u32 min_range,
+	u32 thread_count,
+	const std::function<void (u32 begin, u32 end)> & func);
+
+}
+
+#endif // BLOWGUN_PARALLEL_H_
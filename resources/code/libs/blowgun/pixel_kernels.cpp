@@ -0,0 +1,476 @@
+#include "pixel_kernels.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <mutex>
+
+#include "simd.h"
+
+#if defined(BLOWGUN_SIMD_SSE) && defined(__SSSE3__)
+#	define BLOWGUN_PIXEL_SSSE3 1
+#	include <tmmintrin.h>
+#endif
+
+using namespace blowgun;
+
+// Utility
+namespace
+{
+#if defined(BLOWGUN_SIMD_SSE) && !defined(BLOWGUN_PIXEL_SSSE3)
+    // 0xFF at the first byte of every 3-byte pixel. The 16 bytes at
+    // `16 * k`, `16 * k + 2` and `16 * k + 1` mask the first, middle and
+    // last bytes of the pixels in register `k` of a block of 16 pixels.
+    static const u8 kFirstBytes[50] = {
+        0xFF, 0, 0, 0xFF, 0, 0, 0xFF, 0, 0, 0xFF, 0, 0, 0xFF, 0, 0, 0xFF, 0, 0,
+        0xFF, 0, 0, 0xFF, 0, 0, 0xFF, 0, 0, 0xFF, 0, 0, 0xFF, 0, 0, 0xFF, 0, 0,
+        0xFF, 0, 0, 0xFF, 0, 0, 0xFF, 0, 0, 0xFF, 0, 0, 0xFF, 0 };
+
+    static inline __m128i
+    LoadMask(u32 offset)
+    {
+        return _mm_loadu_si128(reinterpret_cast<const __m128i *>(kFirstBytes + offset));
+    }
+#endif
+
+    // Linear values of the 8-bit sRGB colors, from 0 to 65535.
+    static u16 to_linear[256];
+
+    // sRGB colors of the linear values, by steps of 16.
+    static u8 to_srgb[4096];
+
+    static std::once_flag gamma_tables_flag;
+
+    static void
+    BuildGammaTables()
+    {
+        for (u32 i = 0; i < 256; ++i)
+        {
+            const double srgb = i / 255.0;
+            const double linear = (srgb <= 0.04045) ?
+                srgb / 12.92 : std::pow((srgb + 0.055) / 1.055, 2.4);
+            to_linear[i] = static_cast<u16>(linear * 65535.0 + 0.5);
+        }
+
+        // Sample the middle of each step, which is closer than half a
+        // step to every color it holds: a color always comes back.
+        for (u32 i = 0; i < 4096; ++i)
+        {
+            const double linear = (i * 16 + 8) / 65535.0;
+            const double srgb = (linear <= 0.0031308) ?
+                linear * 12.92 : 1.055 * std::pow(linear, 1.0 / 2.4) - 0.055;
+            to_srgb[i] = static_cast<u8>(std::min(255.0, srgb * 255.0 + 0.5));
+        }
+    }
+
+#if defined(BLOWGUN_SIMD_NEON)
+    // Average two rows of 16 bytes of one channel into 8.
+    static inline uint8x8_t
+    Average2x2(uint8x16_t row0, uint8x16_t row1)
+    {
+        return vrshrn_n_u16(vaddq_u16(vpaddlq_u8(row0), vpaddlq_u8(row1)), 2);
+    }
+#endif
+}
+
+void
+blowgun::kernels::SwapRedBlue24(const u8 * source, u8 * destination, u32 pixel_count)
+{
+    const u32 size = pixel_count * 3;
+    u32 i = 0;
+
+#if defined(BLOWGUN_PIXEL_SSSE3)
+    // Sixteen pixels in three registers. Every register is loaded before
+    // any is stored, so this works in place, and pixels that straddle two
+    // registers are gathered from both. An index of -128 clears a byte.
+    const __m128i shuffle_0_0 = _mm_setr_epi8(
+        2, 1, 0, 5, 4, 3, 8, 7,
+        6, 11, 10, 9, 14, 13, 12, -128);
+    const __m128i shuffle_0_1 = _mm_setr_epi8(
+        -128, -128, -128, -128, -128, -128, -128, -128,
+        -128, -128, -128, -128, -128, -128, -128, 1);
+    const __m128i shuffle_1_0 = _mm_setr_epi8(
+        -128, 15, -128, -128, -128, -128, -128, -128,
+        -128, -128, -128, -128, -128, -128, -128, -128);
+    const __m128i shuffle_1_1 = _mm_setr_epi8(
+        0, -128, 4, 3, 2, 7, 6, 5,
+        10, 9, 8, 13, 12, 11, -128, 15);
+    const __m128i shuffle_1_2 = _mm_setr_epi8(
+        -128, -128, -128, -128, -128, -128, -128, -128,
+        -128, -128, -128, -128, -128, -128, 0, -128);
+    const __m128i shuffle_2_1 = _mm_setr_epi8(
+        14, -128, -128, -128, -128, -128, -128, -128,
+        -128, -128, -128, -128, -128, -128, -128, -128);
+    const __m128i shuffle_2_2 = _mm_setr_epi8(
+        -128, 3, 2, 1, 6, 5, 4, 9,
+        8, 7, 12, 11, 10, 15, 14, 13);
+    for (; i + 48 <= size; i += 48)
+    {
+        const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(source + i));
+        const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(source + i + 16));
+        const __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i *>(source + i + 32));
+
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(destination + i), _mm_or_si128(
+            _mm_shuffle_epi8(a, shuffle_0_0), _mm_shuffle_epi8(b, shuffle_0_1)));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(destination + i + 16), _mm_or_si128(
+            _mm_or_si128(_mm_shuffle_epi8(a, shuffle_1_0), _mm_shuffle_epi8(b, shuffle_1_1)),
+            _mm_shuffle_epi8(c, shuffle_1_2)));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(destination + i + 32), _mm_or_si128(
+            _mm_shuffle_epi8(b, shuffle_2_1), _mm_shuffle_epi8(c, shuffle_2_2)));
+    }
+#elif defined(BLOWGUN_SIMD_NEON)
+    // Sixteen pixels at once, split into one register per channel.
+    for (; i + 48 <= size; i += 48)
+    {
+        uint8x16x3_t pixels = vld3q_u8(source + i);
+        const uint8x16_t first = pixels.val[0];
+        pixels.val[0] = pixels.val[2];
+        pixels.val[2] = first;
+        vst3q_u8(destination + i, pixels);
+    }
+#elif defined(BLOWGUN_SIMD_SSE)
+    // Sixteen pixels in three registers, without byte shuffles: within a
+    // pixel, red and blue are two bytes apart, so each byte is picked
+    // from the pixels shifted by two bytes either way, or kept. Bytes
+    // shifted in from the neighbouring register are only ever picked
+    // within the 48 bytes of the block.
+    const __m128i first_0 = LoadMask(0), first_1 = LoadMask(16), first_2 = LoadMask(32);
+    const __m128i middle_0 = LoadMask(2), middle_1 = LoadMask(18), middle_2 = LoadMask(34);
+    const __m128i last_0 = LoadMask(1), last_1 = LoadMask(17), last_2 = LoadMask(33);
+    for (; i + 48 <= size; i += 48)
+    {
+        const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(source + i));
+        const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(source + i + 16));
+        const __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i *>(source + i + 32));
+
+        // The bytes two further, for the first byte of each pixel...
+        const __m128i next_a = _mm_or_si128(_mm_srli_si128(a, 2), _mm_slli_si128(b, 14));
+        const __m128i next_b = _mm_or_si128(_mm_srli_si128(b, 2), _mm_slli_si128(c, 14));
+        const __m128i next_c = _mm_srli_si128(c, 2);
+
+        // ...and the bytes two before, for the last one.
+        const __m128i previous_a = _mm_slli_si128(a, 2);
+        const __m128i previous_b = _mm_or_si128(_mm_slli_si128(b, 2), _mm_srli_si128(a, 14));
+        const __m128i previous_c = _mm_or_si128(_mm_slli_si128(c, 2), _mm_srli_si128(b, 14));
+
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(destination + i), _mm_or_si128(
+            _mm_or_si128(_mm_and_si128(next_a, first_0), _mm_and_si128(a, middle_0)),
+            _mm_and_si128(previous_a, last_0)));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(destination + i + 16), _mm_or_si128(
+            _mm_or_si128(_mm_and_si128(next_b, first_1), _mm_and_si128(b, middle_1)),
+            _mm_and_si128(previous_b, last_1)));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(destination + i + 32), _mm_or_si128(
+            _mm_or_si128(_mm_and_si128(next_c, first_2), _mm_and_si128(c, middle_2)),
+            _mm_and_si128(previous_c, last_2)));
+    }
+#endif
+
+    for (; i < size; i += 3)
+    {
+        const u8 first = source[i];
+        destination[i + 1] = source[i + 1];
+        destination[i] = source[i + 2];
+        destination[i + 2] = first;
+    }
+}
+
+void
+blowgun::kernels::SwapRedBlue32(const u8 * source, u8 * destination, u32 pixel_count)
+{
+    const u32 size = pixel_count * 4;
+    u32 i = 0;
+
+#if defined(BLOWGUN_SIMD_SSE)
+    // Four pixels per register, each one in a 32-bit lane, where red and
+    // blue are two bytes apart.
+    const __m128i keep = _mm_set1_epi32(0xFF00FF00);
+    const __m128i first = _mm_set1_epi32(0x000000FF);
+    const __m128i third = _mm_set1_epi32(0x00FF0000);
+    for (; i + 16 <= size; i += 16)
+    {
+        const __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i *>(source + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(destination + i), _mm_or_si128(
+            _mm_and_si128(pixels, keep),
+            _mm_or_si128(_mm_and_si128(_mm_srli_epi32(pixels, 16), first),
+                _mm_and_si128(_mm_slli_epi32(pixels, 16), third))));
+    }
+#elif defined(BLOWGUN_SIMD_NEON)
+    for (; i + 64 <= size; i += 64)
+    {
+        uint8x16x4_t pixels = vld4q_u8(source + i);
+        const uint8x16_t first = pixels.val[0];
+        pixels.val[0] = pixels.val[2];
+        pixels.val[2] = first;
+        vst4q_u8(destination + i, pixels);
+    }
+#endif
+
+    for (; i < size; i += 4)
+    {
+        const u8 first = source[i];
+        destination[i + 1] = source[i + 1];
+        destination[i] = source[i + 2];
+        destination[i + 2] = first;
+        destination[i + 3] = source[i + 3];
+    }
+}
+
+void
+blowgun::kernels::FillPixels(u8 * destination, const u8 * pixel, u32 pixel_size, u32 count)
+{
+    const u32 size = pixel_size * count;
+    u32 i = 0;
+
+#if defined(BLOWGUN_SIMD_SSE) || defined(BLOWGUN_SIMD_NEON)
+    // 48 bytes hold a whole number of pixels of every size, so long runs
+    // are written 48 bytes at a time from three registers. Short ones
+    // aren't worth building them.
+    if (size >= 64)
+    {
+        BLOWGUN_ALIGN(16) u8 pattern[48];
+        for (u32 k = 0; k < sizeof(pattern); k += pixel_size)
+            std::memcpy(pattern + k, pixel, pixel_size);
+
+#	if defined(BLOWGUN_SIMD_SSE)
+        const __m128i a = _mm_load_si128(reinterpret_cast<const __m128i *>(pattern));
+        const __m128i b = _mm_load_si128(reinterpret_cast<const __m128i *>(pattern + 16));
+        const __m128i c = _mm_load_si128(reinterpret_cast<const __m128i *>(pattern + 32));
+        for (; i + 48 <= size; i += 48)
+        {
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(destination + i), a);
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(destination + i + 16), b);
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(destination + i + 32), c);
+        }
+#	else
+        const uint8x16_t a = vld1q_u8(pattern);
+        const uint8x16_t b = vld1q_u8(pattern + 16);
+        const uint8x16_t c = vld1q_u8(pattern + 32);
+        for (; i + 48 <= size; i += 48)
+        {
+            vst1q_u8(destination + i, a);
+            vst1q_u8(destination + i + 16, b);
+            vst1q_u8(destination + i + 32, c);
+        }
+#	endif
+
+        // The rest starts on a pixel boundary too.
+        std::memcpy(destination + i, pattern, size - i);
+        return;
+    }
+#endif
+
+    // One loop per size, so each copy is a single move.
+    switch (pixel_size)
+    {
+    case 1 :
+        std::memset(destination, pixel[0], size);
+        break;
+    case 2 :
+    {
+        u16 value;
+        std::memcpy(&value, pixel, sizeof(value));
+        for (; i < size; i += sizeof(value))
+            std::memcpy(destination + i, &value, sizeof(value));
+        break;
+    }
+    case 3 :
+        for (; i < size; i += 3)
+        {
+            destination[i] = pixel[0];
+            destination[i + 1] = pixel[1];
+            destination[i + 2] = pixel[2];
+        }
+        break;
+    default :
+    {
+        u32 value;
+        std::memcpy(&value, pixel, sizeof(value));
+        for (; i < size; i += sizeof(value))
+            std::memcpy(destination + i, &value, sizeof(value));
+        break;
+    }
+    }
+}
+
+void
+blowgun::kernels::DownsampleRows(const u8 * row0, const u8 * row1, u32 source_width,
+    u32 channel_count, u8 * destination)
+{
+    if (source_width == 1)
+    {
+        for (u32 k = 0; k < channel_count; ++k)
+            destination[k] = static_cast<u8>((row0[k] + row1[k] + 1) >> 1);
+        return;
+    }
+
+    // Output bytes done, and the input bytes they come from.
+    const u32 size = source_width / 2 * channel_count;
+    u32 i = 0;
+
+#if defined(BLOWGUN_SIMD_SSE)
+    // Once widened to 16 bits and summed across rows, the two pixels of
+    // each pair are summed by moving the second one over the first.
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i two = _mm_set1_epi16(2);
+    if (channel_count == 3)
+    {
+        // Two pixels out of four from each row. The second pair starts
+        // 6 bytes in, and the 8-byte store spills 2 bytes that the next
+        // one overwrites.
+        const __m128i first_pixel = _mm_setr_epi16(-1, -1, -1, 0, 0, 0, 0, 0);
+        for (; i + 8 <= size; i += 6)
+        {
+            const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row0 + i * 2));
+            const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row1 + i * 2));
+            const __m128i low = _mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero));
+            const __m128i high = _mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero));
+            const __m128i second = _mm_or_si128(_mm_srli_si128(low, 12), _mm_slli_si128(high, 4));
+
+            const __m128i sums = _mm_or_si128(
+                _mm_and_si128(_mm_add_epi16(low, _mm_srli_si128(low, 6)), first_pixel),
+                _mm_slli_si128(_mm_add_epi16(second, _mm_srli_si128(second, 6)), 6));
+
+            const __m128i average = _mm_srli_epi16(_mm_add_epi16(sums, two), 2);
+            _mm_storel_epi64(reinterpret_cast<__m128i *>(destination + i),
+                _mm_packus_epi16(average, average));
+        }
+    }
+    else
+    {
+        // Eight bytes out of 16 from each row.
+        const __m128i one = _mm_set1_epi16(1);
+        for (; i + 8 <= size; i += 8)
+        {
+            const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row0 + i * 2));
+            const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row1 + i * 2));
+            __m128i low = _mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero));
+            __m128i high = _mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero));
+
+            __m128i sums;
+            if (channel_count == 1)
+            {
+                sums = _mm_packs_epi32(_mm_madd_epi16(low, one), _mm_madd_epi16(high, one));
+            }
+            else
+            {
+                if (channel_count == 2)
+                {
+                    // Pixels 0 2 1 3, so that 1 and 3 are 8 bytes away.
+                    low = _mm_shuffle_epi32(low, _MM_SHUFFLE(3, 1, 2, 0));
+                    high = _mm_shuffle_epi32(high, _MM_SHUFFLE(3, 1, 2, 0));
+                }
+                sums = _mm_unpacklo_epi64(
+                    _mm_add_epi16(low, _mm_srli_si128(low, 8)),
+                    _mm_add_epi16(high, _mm_srli_si128(high, 8)));
+            }
+
+            const __m128i average = _mm_srli_epi16(_mm_add_epi16(sums, two), 2);
+            _mm_storel_epi64(reinterpret_cast<__m128i *>(destination + i),
+                _mm_packus_epi16(average, average));
+        }
+    }
+#elif defined(BLOWGUN_SIMD_NEON)
+    // Sixteen pixels at once, split into one register per channel, whose
+    // neighbours are summed pairwise.
+    switch (channel_count)
+    {
+    case 1 :
+        for (; i + 8 <= size; i += 8)
+            vst1_u8(destination + i, Average2x2(vld1q_u8(row0 + i * 2), vld1q_u8(row1 + i * 2)));
+        break;
+    case 2 :
+        for (; i + 16 <= size; i += 16)
+        {
+            const uint8x16x2_t a = vld2q_u8(row0 + i * 2);
+            const uint8x16x2_t b = vld2q_u8(row1 + i * 2);
+            uint8x8x2_t average;
+            average.val[0] = Average2x2(a.val[0], b.val[0]);
+            average.val[1] = Average2x2(a.val[1], b.val[1]);
+            vst2_u8(destination + i, average);
+        }
+        break;
+    case 3 :
+        for (; i + 24 <= size; i += 24)
+        {
+            const uint8x16x3_t a = vld3q_u8(row0 + i * 2);
+            const uint8x16x3_t b = vld3q_u8(row1 + i * 2);
+            uint8x8x3_t average;
+            average.val[0] = Average2x2(a.val[0], b.val[0]);
+            average.val[1] = Average2x2(a.val[1], b.val[1]);
+            average.val[2] = Average2x2(a.val[2], b.val[2]);
+            vst3_u8(destination + i, average);
+        }
+        break;
+    default :
+        for (; i + 32 <= size; i += 32)
+        {
+            const uint8x16x4_t a = vld4q_u8(row0 + i * 2);
+            const uint8x16x4_t b = vld4q_u8(row1 + i * 2);
+            uint8x8x4_t average;
+            average.val[0] = Average2x2(a.val[0], b.val[0]);
+            average.val[1] = Average2x2(a.val[1], b.val[1]);
+            average.val[2] = Average2x2(a.val[2], b.val[2]);
+            average.val[3] = Average2x2(a.val[3], b.val[3]);
+            vst4_u8(destination + i, average);
+        }
+        break;
+    }
+#endif
+
+    // Output pixel `x` comes from input pixels `2 * x` and `2 * x + 1`.
+    for (; i < size; i += channel_count)
+    {
+        const u8 * a = row0 + i * 2;
+        const u8 * b = row1 + i * 2;
+        for (u32 k = 0; k < channel_count; ++k)
+        {
+            destination[i + k] = static_cast<u8>(
+                (a[k] + a[k + channel_count] + b[k] + b[k + channel_count] + 2) >> 2);
+        }
+    }
+}
+
+void
+blowgun::kernels::DownsampleRowsSRGB(const u8 * row0, const u8 * row1, u32 source_width,
+    u32 channel_count, u8 * destination)
+{
+    std::call_once(gamma_tables_flag, BuildGammaTables);
+
+    // Alpha is the last channel of 2 and 4-channel pixels.
+    const u32 color_count = (channel_count == 2 || channel_count == 4) ?
+        channel_count - 1 : channel_count;
+    const u32 next = (source_width == 1) ? 0 : channel_count;
+    const u32 size = std::max(1u, source_width / 2) * channel_count;
+
+    // Not vectorized: each color is four lookups in `to_linear` and one
+    // in `to_srgb`, and neither SSE2 nor NEON can gather from a table.
+    // Only the additions between them would run in parallel.
+    for (u32 i = 0; i < size; i += channel_count)
+    {
+        const u8 * a = row0 + i * 2;
+        const u8 * b = row1 + i * 2;
+        for (u32 k = 0; k < color_count; ++k)
+        {
+            const u32 linear = to_linear[a[k]] + to_linear[a[k + next]] +
+                to_linear[b[k]] + to_linear[b[k + next]];
+            destination[i + k] = to_srgb[(linear + 2) >> 6];
+        }
+        for (u32 k = color_count; k < channel_count; ++k)
+        {
+            destination[i + k] = static_cast<u8>(
+                (a[k] + a[k + next] + b[k] + b[k + next] + 2) >> 2);
+        }
+    }
+}
+
+void
+blowgun::kernels::FlipRows(u8 * data, u32 row_size, u32 row_count)
+{
+    for (u32 top = 0, bottom = row_count; top + 1 < bottom; ++top)
+    {
+        --bottom;
+        u8 * top_row = data + static_cast<size_t>(top) * row_size;
+        std::swap_ranges(top_row, top_row + row_size,
+            data + static_cast<size_t>(bottom) * row_size);
+    }
+}
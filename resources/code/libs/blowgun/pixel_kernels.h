@@ -0,0 +1,73 @@
+#ifndef BLOWGUN_PIXEL_KERNELS_H_
+#define BLOWGUN_PIXEL_KERNELS_H_
+
+#include "types.h"
+
+namespace blowgun
+{
+
+/*
+ * Raw kernels over arrays of 8-bit pixels, shared by the image loaders
+ * and the code that prepares pixels for textures.
+ *
+ * They follow the backend of "simd.h", and byte shuffles are used on
+ * x86 when the compiler targets SSSE3 (`-mssse3`, or the x86 Android
+ * ABI). Define `BLOWGUN_DISABLE_SIMD` to force the plain code.
+ */
+namespace kernels
+{
+
+/**
+ * Swap the first and third bytes of `pixel_count` 3-byte pixels, e.g.
+ * BGR to RGB. `destination` may be `source` itself, but not overlap it
+ * otherwise.
+ */
+void SwapRedBlue24(const u8 * source, u8 * destination, u32 pixel_count);
+
+/**
+ * Swap the first and third bytes of `pixel_count` 4-byte pixels, e.g.
+ * BGRA to RGBA. `destination` may be `source` itself, but not overlap it
+ * otherwise.
+ */
+void SwapRedBlue32(const u8 * source, u8 * destination, u32 pixel_count);
+
+/**
+ * Write `count` copies of the `pixel_size` bytes at `pixel`, from 1 to
+ * 4 of them, one after the other at `destination`.
+ */
+void FillPixels(u8 * destination, const u8 * pixel, u32 pixel_size, u32 count);
+
+/**
+ * Average each 2x2 block of pixels of two rows into one pixel of
+ * `destination`, rounding to the nearest, for the next level of a
+ * mipmap chain.
+ *
+ * Rows are `source_width` pixels of `channel_count` bytes, from 1 to 4.
+ * `destination` gets `max(1, source_width / 2)` pixels: the last pixel
+ * of an odd row is left out, and a row of one pixel is averaged with
+ * itself. `row1` may be `row0`, to halve a single row.
+ */
+void DownsampleRows(const u8 * row0, const u8 * row1, u32 source_width, u32 channel_count,
+	u8 * destination);
+
+/**
+ * Same as `DownsampleRows`, but for sRGB colors, averaged as light:
+ * they are converted to linear values and back. The alpha channel of 2
+ * and 4-channel pixels stays linear.
+ *
+ * Unlike the other kernels, this one is plain code on every backend.
+ */
+void DownsampleRowsSRGB(const u8 * row0, const u8 * row1, u32 source_width, u32 channel_count,
+	u8 * destination);
+
+/**
+ * Reverse the order of `row_count` rows of `row_size` bytes in place,
+ * to turn a bottom-up image into a top-down one.
+ */
+void FlipRows(u8 * data, u32 row_size, u32 row_count);
+
+}
+
+}
+
+#endif // BLOWGUN_PIXEL_KERNELS_H_
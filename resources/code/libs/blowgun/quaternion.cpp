@@ -0,0 +1,84 @@
+#include "quaternion.h"
+
+#include <cmath>
+
+#include "matrix.h"
+
+#define PI 3.1415926535897932384626433832795f
+
+using namespace blowgun;
+
+Quat
+Quat::FromAxisAngle(float angle, float axis_x, float axis_y, float axis_z)
+{
+    float mag = std::sqrt(
+        axis_x * axis_x +
+        axis_y * axis_y +
+        axis_z * axis_z
+        );
+
+    if (mag <= 0.0f)
+        return Quat();
+
+    float half_angle = angle * PI / 360.0f;
+    float s = std::sin(half_angle) / mag;
+
+    return Quat(axis_x * s, axis_y * s, axis_z * s, std::cos(half_angle));
+}
+
+void
+Quat::ToRotation3(float * out) const
+{
+    float x2 = x + x;
+    float y2 = y + y;
+    float z2 = z + z;
+
+    float xx = x * x2, yy = y * y2, zz = z * z2;
+    float xy = x * y2, yz = y * z2, zx = z * x2;
+    float wx = w * x2, wy = w * y2, wz = w * z2;
+
+    out[0] = 1.0f - (yy + zz);
+    out[1] = xy - wz;
+    out[2] = zx + wy;
+
+    out[3] = xy + wz;
+    out[4] = 1.0f - (xx + zz);
+    out[5] = yz - wx;
+
+    out[6] = zx - wy;
+    out[7] = yz + wx;
+    out[8] = 1.0f - (xx + yy);
+}
+
+const Matrix
+Quat::ToMatrix() const
+{
+    return Matrix().Rotate(*this);
+}
+
+Quat
+blowgun::Slerp(const Quat & a, const Quat & b, float t)
+{
+    // `b` and `-b` are the same rotation; pick the closer one.
+    float cos_theta = Dot(a, b);
+    Quat target = b;
+    if (cos_theta < 0.0f)
+    {
+        cos_theta = -cos_theta;
+        target = Quat(-b.x, -b.y, -b.z, -b.w);
+    }
+
+    // When both rotations are very close, sin(theta) gets too small to
+    // divide by. Linear interpolation is precise enough there.
+    if (cos_theta > 0.9995f)
+        return Nlerp(a, target, t);
+
+    float theta = std::acos(cos_theta);
+    float sin_theta = std::sin(theta);
+    float weight_a = std::sin((1.0f - t) * theta) / sin_theta;
+    float weight_b = std::sin(t * theta) / sin_theta;
+
+    using namespace simd;
+    return Quat::Store(MulAdd(a.Load(), Splat(weight_a),
+        Mul(target.Load(), Splat(weight_b))));
+}
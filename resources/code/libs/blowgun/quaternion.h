@@ -0,0 +1,117 @@
+#ifndef BLOWGUN_QUATERNION_H_
+#define BLOWGUN_QUATERNION_H_
+
+#include "simd.h"
+#include "vector.h"
+
+namespace blowgun
+{
+
+class Matrix;
+
+/**
+ * Rotation stored as a unit quaternion.
+ *
+ * Quaternions follow the same ordering as `Matrix`: rotating a Matrix
+ * by `a * b` is the same as rotating it by `b` first and then by `a`,
+ * so `m.Rotate(b).Rotate(a)` equals `m.Rotate(a * b)`.
+ */
+struct BLOWGUN_ALIGN(16) Quat
+{
+	float x;
+	float y;
+	float z;
+	float w;
+
+	/**
+	 * Create identity rotation.
+	 */
+	Quat() : x(0.0f), y(0.0f), z(0.0f), w(1.0f) {}
+	Quat(float x, float y, float z, float w) : x(x), y(y), z(z), w(w) {}
+
+	/**
+	 * Create a rotation of `angle` degrees around the given axis.
+	 *
+	 * `Quat::FromAxisAngle(a, x, y, z).ToMatrix()` gives the same
+	 * matrix as `Matrix().Rotate(a, x, y, z)`. A zero axis gives
+	 * the identity rotation.
+	 */
+	static Quat FromAxisAngle(float angle, float axis_x, float axis_y, float axis_z);
+
+	/**
+	 * Get the rotation as a 4x4 Matrix.
+	 */
+	const Matrix ToMatrix() const;
+
+	/**
+	 * Write the 3x3 rotation (three rows of three floats, in the same
+	 * order as the upper-left part of `Matrix::values()`) to `out`.
+	 */
+	void ToRotation3(float * out) const;
+
+	simd::Float4 Load() const { return simd::Load(&x); }
+
+	static Quat Store(simd::Float4 v)
+	{
+		Quat result;
+		simd::Store(&result.x, v);
+		return result;
+	}
+};
+
+/**
+ * Combine two rotations: `b` is applied first, then `a`.
+ */
+inline Quat operator*(const Quat & a, const Quat & b)
+{
+	using namespace simd;
+
+	Float4 r = Mul(Splat(a.w), b.Load());
+	r = MulAdd(Splat(a.x), Set( b.w, -b.z,  b.y, -b.x), r);
+	r = MulAdd(Splat(a.y), Set( b.z,  b.w, -b.x, -b.y), r);
+	r = MulAdd(Splat(a.z), Set(-b.y,  b.x,  b.w, -b.z), r);
+	return Quat::Store(r);
+}
+
+inline float Dot(const Quat & a, const Quat & b)
+{
+	return simd::Sum(simd::Mul(a.Load(), b.Load()));
+}
+
+/**
+ * Bring the quaternion back to unit length. Accumulating rotations
+ * slowly drifts away from it, so do this every now and then.
+ */
+inline Quat Normalize(const Quat & q)
+{
+	float length_squared = Dot(q, q);
+	if (length_squared <= 0.0f)
+		return Quat();
+	return Quat::Store(simd::Mul(q.Load(), simd::Splat(1.0f / std::sqrt(length_squared))));
+}
+
+/**
+ * Normalized linear interpolation, taking the shortest path.
+ *
+ * Cheaper than `Slerp`, but the angular velocity is not constant
+ * over `t`.
+ */
+inline Quat Nlerp(const Quat & a, const Quat & b, float t)
+{
+	using namespace simd;
+
+	// `b` and `-b` are the same rotation; pick the closer one.
+	float sign = Dot(a, b) < 0.0f ? -1.0f : 1.0f;
+	Float4 va = a.Load();
+	Float4 vb = Mul(b.Load(), Splat(sign));
+	return Normalize(Quat::Store(MulAdd(Sub(vb, va), Splat(t), va)));
+}
+
+/**
+ * Spherical linear interpolation, taking the shortest path.
+ */
+Quat Slerp(const Quat & a, const Quat & b, float t);
+
+}
+
+#endif // BLOWGUN_QUATERNION_H_
@@ -0,0 +1,96 @@
+#include <cmath>
+
+#include <gtest/gtest.h>
+#include "matrix.h"
+#include "quaternion.h"
+
+using namespace blowgun;
+
+namespace
+{
+    void ExpectMatrixNear(const Matrix & expected, const Matrix & actual)
+    {
+        for (int i = 0; i < 16; ++i)
+            EXPECT_NEAR(expected.values()[i], actual.values()[i], 1e-5f) << "index " << i;
+    }
+
+    void ExpectQuatNear(const Quat & expected, const Quat & actual)
+    {
+        EXPECT_NEAR(expected.x, actual.x, 1e-5f);
+        EXPECT_NEAR(expected.y, actual.y, 1e-5f);
+        EXPECT_NEAR(expected.z, actual.z, 1e-5f);
+        EXPECT_NEAR(expected.w, actual.w, 1e-5f);
+    }
+}
+
+TEST(QuaternionTest, ToMatrixMatchesMatrixRotate)
+{
+    ExpectMatrixNear(
+        Matrix().Rotate(37.0f, 1.0f, -2.0f, 0.5f),
+        Quat::FromAxisAngle(37.0f, 1.0f, -2.0f, 0.5f).ToMatrix());
+}
+
+TEST(QuaternionTest, ProductMatchesRotateChain)
+{
+    const Quat x = Quat::FromAxisAngle(20.0f, 1.0f, 0.0f, 0.0f);
+    const Quat y = Quat::FromAxisAngle(30.0f, 0.0f, 1.0f, 0.0f);
+    const Quat z = Quat::FromAxisAngle(40.0f, 0.0f, 0.0f, 1.0f);
+
+    const Matrix base = Matrix().Translate(1.0f, 2.0f, 3.0f);
+
+    ExpectMatrixNear(
+        base.Rotate(20.0f, 1.0f, 0.0f, 0.0f)
+            .Rotate(30.0f, 0.0f, 1.0f, 0.0f)
+            .Rotate(40.0f, 0.0f, 0.0f, 1.0f),
+        base.Rotate(z * y * x));
+}
+
+TEST(QuaternionTest, CreateTransformMatchesChain)
+{
+    const Vec3 translation(1.0f, -2.0f, 3.0f);
+    const Quat rotation = Quat::FromAxisAngle(75.0f, 0.2f, 1.0f, -0.3f);
+    const Vec3 scale(2.0f, 0.5f, 3.0f);
+
+    ExpectMatrixNear(
+        Matrix()
+            .Translate(translation.x, translation.y, translation.z)
+            .Rotate(rotation)
+            .Scale(scale.x, scale.y, scale.z),
+        Matrix::CreateTransform(translation, rotation, scale));
+}
+
+TEST(QuaternionTest, SlerpEndpointsAndMidpoint)
+{
+    const Quat a = Quat::FromAxisAngle(0.0f, 0.0f, 1.0f, 0.0f);
+    const Quat b = Quat::FromAxisAngle(90.0f, 0.0f, 1.0f, 0.0f);
+
+    ExpectQuatNear(a, Slerp(a, b, 0.0f));
+    ExpectQuatNear(b, Slerp(a, b, 1.0f));
+    ExpectQuatNear(Quat::FromAxisAngle(45.0f, 0.0f, 1.0f, 0.0f), Slerp(a, b, 0.5f));
+}
+
+TEST(QuaternionTest, NlerpTakesShortestPath)
+{
+    const Quat a = Quat::FromAxisAngle(10.0f, 0.0f, 0.0f, 1.0f);
+    const Quat b = Quat::FromAxisAngle(30.0f, 0.0f, 0.0f, 1.0f);
+    const Quat negated_b(-b.x, -b.y, -b.z, -b.w);
+
+    const Quat expected = Nlerp(a, b, 0.5f);
+    ExpectQuatNear(expected, Nlerp(a, negated_b, 0.5f));
+    EXPECT_NEAR(1.0f, Dot(expected, expected), 1e-5f);
+}
+
+TEST(VectorTest, Vec4Operations)
+{
+    const Vec4 a(1.0f, 2.0f, 3.0f, 4.0f);
+    const Vec4 b(4.0f, 3.0f, 2.0f, 1.0f);
+
+    EXPECT_FLOAT_EQ(20.0f, Dot(a, b));
+
+    const Vec4 mid = Lerp(a, b, 0.5f);
+    EXPECT_FLOAT_EQ(2.5f, mid.x);
+    EXPECT_FLOAT_EQ(2.5f, mid.w);
+
+    EXPECT_NEAR(1.0f, Length(Normalize(a)), 1e-6f);
+    EXPECT_FLOAT_EQ(0.0f, Dot(Cross(Vec3(1.0f, 0.0f, 0.0f), Vec3(0.0f, 1.0f, 0.0f)), Vec3(1.0f, 1.0f, 0.0f)));
+}
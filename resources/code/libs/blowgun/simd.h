@@ -0,0 +1,207 @@
+#ifndef BLOWGUN_SIMD_H_
+#define BLOWGUN_SIMD_H_
+
+/*
+ * Thin 4-wide float abstraction used by the math kernels.
+ *
+ * Exactly one backend is chosen at compile time:
+ * - SSE2 on x86 and x86-64,
+ * - NEON on ARM,
+ * - plain scalar code everywhere else.
+ *
+ * Define `BLOWGUN_DISABLE_SIMD` to force the scalar backend (handy
+ * to compare results between backends).
+ *
+ * All loads and stores are unaligned ones, so the kernels can be fed
+ * any caller-provided float array.
+ */
+
+#if !defined(BLOWGUN_DISABLE_SIMD)
+#	if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#		define BLOWGUN_SIMD_SSE 1
+#	elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+#		define BLOWGUN_SIMD_NEON 1
+#	endif
+#endif
+
+#if defined(BLOWGUN_SIMD_SSE)
+#	include <emmintrin.h>
+#elif defined(BLOWGUN_SIMD_NEON)
+#	include <arm_neon.h>
+#endif
+
+#if defined(_MSC_VER)
+#	define BLOWGUN_ALIGN(n) __declspec(align(n))
+#else
+#	define BLOWGUN_ALIGN(n) __attribute__((aligned(n)))
+#endif
+
+namespace blowgun
+{
+
+namespace simd
+{
+
+#if defined(BLOWGUN_SIMD_SSE)
+
+typedef __m128 Float4;
+
+inline Float4 Load(const float * p) { return _mm_loadu_ps(p); }
+inline void Store(float * p, Float4 v) { _mm_storeu_ps(p, v); }
+inline Float4 Set(float x, float y, float z, float w) { return _mm_setr_ps(x, y, z, w); }
+inline Float4 Splat(float s) { return _mm_set1_ps(s); }
+
+inline Float4 Add(Float4 a, Float4 b) { return _mm_add_ps(a, b); }
+inline Float4 Sub(Float4 a, Float4 b) { return _mm_sub_ps(a, b); }
+inline Float4 Mul(Float4 a, Float4 b) { return _mm_mul_ps(a, b); }
+inline Float4 Min(Float4 a, Float4 b) { return _mm_min_ps(a, b); }
+inline Float4 Max(Float4 a, Float4 b) { return _mm_max_ps(a, b); }
+
+/**
+ * Compute `a * b + c`.
+ */
+inline Float4 MulAdd(Float4 a, Float4 b, Float4 c) { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+
+/**
+ * Add the four lanes together.
+ */
+inline float Sum(Float4 v)
+{
+	__m128 shuffled = _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1));
+	__m128 sums = _mm_add_ps(v, shuffled);
+	shuffled = _mm_movehl_ps(shuffled, sums);
+	return _mm_cvtss_f32(_mm_add_ss(sums, shuffled));
+}
+
+/**
+ * Transpose four rows in place.
+ */
+inline void Transpose(Float4 & r0, Float4 & r1, Float4 & r2, Float4 & r3)
+{
+	_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+}
+
+/**
+ * Rearrange the lanes of `v`, e.g. `Swizzle<1, 2, 0, 3>(v)` gives
+ * `(v.y, v.z, v.x, v.w)`.
+ */
+template <int X, int Y, int Z, int W>
+inline Float4 Swizzle(Float4 v)
+{
+	return _mm_shuffle_ps(v, v, _MM_SHUFFLE(W, Z, Y, X));
+}
+
+#elif defined(BLOWGUN_SIMD_NEON)
+
+typedef float32x4_t Float4;
+
+inline Float4 Load(const float * p) { return vld1q_f32(p); }
+inline void Store(float * p, Float4 v) { vst1q_f32(p, v); }
+inline Float4 Set(float x, float y, float z, float w)
+{
+	const float v[4] = { x, y, z, w };
+	return vld1q_f32(v);
+}
+inline Float4 Splat(float s) { return vdupq_n_f32(s); }
+
+inline Float4 Add(Float4 a, Float4 b) { return vaddq_f32(a, b); }
+inline Float4 Sub(Float4 a, Float4 b) { return vsubq_f32(a, b); }
+inline Float4 Mul(Float4 a, Float4 b) { return vmulq_f32(a, b); }
+inline Float4 Min(Float4 a, Float4 b) { return vminq_f32(a, b); }
+inline Float4 Max(Float4 a, Float4 b) { return vmaxq_f32(a, b); }
+
+inline Float4 MulAdd(Float4 a, Float4 b, Float4 c) { return vmlaq_f32(c, a, b); }
+
+inline float Sum(Float4 v)
+{
+	float32x2_t pairs = vadd_f32(vget_low_f32(v), vget_high_f32(v));
+	return vget_lane_f32(vpadd_f32(pairs, pairs), 0);
+}
+
+inline void Transpose(Float4 & r0, Float4 & r1, Float4 & r2, Float4 & r3)
+{
+	float32x4x2_t t01 = vtrnq_f32(r0, r1);
+	float32x4x2_t t23 = vtrnq_f32(r2, r3);
+	r0 = vcombine_f32(vget_low_f32(t01.val[0]), vget_low_f32(t23.val[0]));
+	r1 = vcombine_f32(vget_low_f32(t01.val[1]), vget_low_f32(t23.val[1]));
+	r2 = vcombine_f32(vget_high_f32(t01.val[0]), vget_high_f32(t23.val[0]));
+	r3 = vcombine_f32(vget_high_f32(t01.val[1]), vget_high_f32(t23.val[1]));
+}
+
+template <int X, int Y, int Z, int W>
+inline Float4 Swizzle(Float4 v)
+{
+	return Set(vgetq_lane_f32(v, X), vgetq_lane_f32(v, Y),
+		vgetq_lane_f32(v, Z), vgetq_lane_f32(v, W));
+}
+
+#else
+
+struct Float4
+{
+	float v[4];
+};
+
+inline Float4 Load(const float * p)
+{
+	Float4 r = {{ p[0], p[1], p[2], p[3] }};
+	return r;
+}
+inline void Store(float * p, Float4 a)
+{
+	p[0] = a.v[0]; p[1] = a.v[1]; p[2] = a.v[2]; p[3] = a.v[3];
+}
+inline Float4 Set(float x, float y, float z, float w)
+{
+	Float4 r = {{ x, y, z, w }};
+	return r;
+}
+inline Float4 Splat(float s) { return Set(s, s, s, s); }
+
+#define BLOWGUN_SIMD_SCALAR_OP(name, expr) \
+	inline Float4 name(Float4 a, Float4 b) \
+	{ \
+		Float4 r; \
+		for (int i = 0; i < 4; ++i) \
+		{ \
+			const float x = a.v[i]; \
+			const float y = b.v[i]; \
+			r.v[i] = (expr); \
+		} \
+		return r; \
+	}
+
+BLOWGUN_SIMD_SCALAR_OP(Add, x + y)
+BLOWGUN_SIMD_SCALAR_OP(Sub, x - y)
+BLOWGUN_SIMD_SCALAR_OP(Mul, x * y)
+BLOWGUN_SIMD_SCALAR_OP(Min, x < y ? x : y)
+BLOWGUN_SIMD_SCALAR_OP(Max, x > y ? x : y)
+
+#undef BLOWGUN_SIMD_SCALAR_OP
+
+inline Float4 MulAdd(Float4 a, Float4 b, Float4 c) { return Add(Mul(a, b), c); }
+
+inline float Sum(Float4 v) { return (v.v[0] + v.v[1]) + (v.v[2] + v.v[3]); }
+
+inline void Transpose(Float4 & r0, Float4 & r1, Float4 & r2, Float4 & r3)
+{
+	Float4 t0 = {{ r0.v[0], r1.v[0], r2.v[0], r3.v[0] }};
+	Float4 t1 = {{ r0.v[1], r1.v[1], r2.v[1], r3.v[1] }};
+	Float4 t2 = {{ r0.v[2], r1.v[2], r2.v[2], r3.v[2] }};
+	Float4 t3 = {{ r0.v[3], r1.v[3], r2.v[3], r3.v[3] }};
+	r0 = t0; r1 = t1; r2 = t2; r3 = t3;
+}
+
+template <int X, int Y, int Z, int W>
+inline Float4 Swizzle(Float4 v)
+{
+	return Set(v.v[X], v.v[Y], v.v[Z], v.v[W]);
+}
+
+#endif
+
+}
+
+}
+
+#endif // BLOWGUN_SIMD_H_
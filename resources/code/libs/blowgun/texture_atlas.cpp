@@ -0,0 +1,475 @@
+#include "texture_atlas.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+#include <GLES2/gl2.h>
+
+#include "texture.h"
+#include "texture_builder.h"
+#include "vertex_quantization.h"
+
+using namespace blowgun;
+
+// Utility
+namespace
+{
+    // Rows of the smallest atlas are a multiple of 4 bytes, as
+    // `glTexImage2D` reads them by default.
+    static const u32 kMinSize = 4;
+
+    // `Image` sizes are 16-bit.
+    static const u32 kLargestSize = 32768;
+
+    struct Rect
+    {
+        u32 x;
+        u32 y;
+        u32 width;
+        u32 height;
+    };
+
+    static Rect
+    MakeRect(u32 x, u32 y, u32 width, u32 height)
+    {
+        Rect rect = { x, y, width, height };
+        return rect;
+    }
+
+    static bool
+    Contains(const Rect & outer, const Rect & inner)
+    {
+        return inner.x >= outer.x && inner.y >= outer.y &&
+            inner.x + inner.width <= outer.x + outer.width &&
+            inner.y + inner.height <= outer.y + outer.height;
+    }
+
+    static bool
+    Intersects(const Rect & a, const Rect & b)
+    {
+        return a.x < b.x + b.width && b.x < a.x + a.width &&
+            a.y < b.y + b.height && b.y < a.y + a.height;
+    }
+
+    static u32
+    Align(u32 value, u32 alignment)
+    {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    static u32
+    NextPowerOfTwo(u32 value)
+    {
+        u32 power = 1;
+        while (power < value)
+            power *= 2;
+        return power;
+    }
+
+    // Place the `cells`, in `order`, in a `width` by `height` area with
+    // the MaxRects algorithm: the free space is kept as the list of the
+    // largest rectangles it holds, overlapping each other, and each cell
+    // goes into the one that leaves the shortest side free. Returns
+    // false when a cell doesn't fit.
+    static bool
+    PackMaxRects(const std::vector<Rect> & cells, const std::vector<u32> & order,
+        u32 width, u32 height, std::vector<Rect> & placed)
+    {
+        std::vector<Rect> free_rects(1, MakeRect(0, 0, width, height));
+        std::vector<Rect> split;
+        placed.resize(cells.size());
+
+        for (size_t i = 0; i < order.size(); ++i)
+        {
+            const Rect & cell = cells[order[i]];
+
+            size_t best = free_rects.size();
+            u32 best_short_side = ~0u;
+            u32 best_long_side = ~0u;
+            for (size_t f = 0; f < free_rects.size(); ++f)
+            {
+                const Rect & free_rect = free_rects[f];
+                if (free_rect.width < cell.width || free_rect.height < cell.height)
+                    continue;
+
+                const u32 left_x = free_rect.width - cell.width;
+                const u32 left_y = free_rect.height - cell.height;
+                const u32 short_side = std::min(left_x, left_y);
+                const u32 long_side = std::max(left_x, left_y);
+                if (short_side < best_short_side ||
+                    (short_side == best_short_side && long_side < best_long_side))
+                {
+                    best = f;
+                    best_short_side = short_side;
+                    best_long_side = long_side;
+                }
+            }
+            if (best == free_rects.size())
+                return false;
+
+            const Rect used = MakeRect(free_rects[best].x, free_rects[best].y,
+                cell.width, cell.height);
+            placed[order[i]] = used;
+
+            // Replace every free rectangle the cell overlaps by the up to
+            // 4 largest ones around it.
+            split.clear();
+            for (size_t f = 0; f < free_rects.size(); ++f)
+            {
+                const Rect & r = free_rects[f];
+                if (!Intersects(r, used))
+                {
+                    split.push_back(r);
+                    continue;
+                }
+
+                if (used.x > r.x)
+                    split.push_back(MakeRect(r.x, r.y, used.x - r.x, r.height));
+                if (used.x + used.width < r.x + r.width)
+                {
+                    split.push_back(MakeRect(used.x + used.width, r.y,
+                        r.x + r.width - used.x - used.width, r.height));
+                }
+                if (used.y > r.y)
+                    split.push_back(MakeRect(r.x, r.y, r.width, used.y - r.y));
+                if (used.y + used.height < r.y + r.height)
+                {
+                    split.push_back(MakeRect(r.x, used.y + used.height,
+                        r.width, r.y + r.height - used.y - used.height));
+                }
+            }
+
+            // Then drop the ones inside another, keeping one of equal
+            // ones.
+            free_rects.clear();
+            for (size_t a = 0; a < split.size(); ++a)
+            {
+                bool contained = false;
+                for (size_t b = 0; b < split.size() && !contained; ++b)
+                {
+                    contained = b != a && Contains(split[b], split[a]) &&
+                        (b < a || !Contains(split[a], split[b]));
+                }
+                if (!contained)
+                    free_rects.push_back(split[a]);
+            }
+        }
+        return true;
+    }
+
+    // Get the row or column of an image of `size` pixels that lands at
+    // `position` of its cell, repeating the edges over the padding.
+    static u32
+    SourcePosition(u32 position, u32 padding, u32 size)
+    {
+        return (position < padding) ? 0 : std::min(position - padding, size - 1);
+    }
+
+    // Convert a pixel of `source_count` channels to `count` channels.
+    static void
+    ConvertPixel(const byte * source, u32 source_count, byte * destination, u32 count)
+    {
+        const bool color = source_count >= 3;
+        const byte alpha = (source_count == 2 || source_count == 4) ? source[source_count - 1] : 255;
+        destination[0] = source[0];
+        if (count == 2)
+        {
+            destination[1] = alpha;
+        }
+        else if (count >= 3)
+        {
+            destination[1] = color ? source[1] : source[0];
+            destination[2] = color ? source[2] : source[0];
+            if (count == 4)
+                destination[3] = alpha;
+        }
+    }
+}
+
+TextureAtlas::TextureAtlas(std::shared_ptr<Image> image, std::vector<AtlasRegion> regions,
+    bool mipmaps) :
+    image_(std::move(image)),
+    regions_(std::move(regions)),
+    mipmaps_(mipmaps)
+{
+}
+
+const std::shared_ptr<Image> &
+TextureAtlas::image() const
+{
+    return image_;
+}
+
+const std::vector<AtlasRegion> &
+TextureAtlas::regions() const
+{
+    return regions_;
+}
+
+std::unique_ptr<Texture>
+TextureAtlas::CreateTexture() const
+{
+    static const GLenum kFormats[4] = { GL_LUMINANCE, GL_LUMINANCE_ALPHA, GL_RGB, GL_RGBA };
+
+    return TextureBuilder().
+        SetTarget(GL_TEXTURE_2D).
+        SetLevelOfDetail(0).
+        SetFormat(kFormats[image_->bpp / 8 - 1]).
+        SetWidth(image_->width).
+        SetHeight(image_->height).
+        SetType(GL_UNSIGNED_BYTE).
+        SetData(image_->data).
+        SetMipmaps(mipmaps_).
+        AddParameter(GL_TEXTURE_MIN_FILTER, mipmaps_ ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR).
+        AddParameter(GL_TEXTURE_MAG_FILTER, GL_LINEAR).
+        AddParameter(GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE).
+        AddParameter(GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE).
+        Build();
+}
+
+TextureAtlasBuilder::TextureAtlasBuilder() :
+    images_(),
+    padding_(1),
+    safe_mipmap_levels_(0),
+    max_size_(2048)
+{
+}
+
+TextureAtlasBuilder &
+TextureAtlasBuilder::Add(const std::shared_ptr<Image> & image)
+{
+    images_.push_back(image);
+    return *this;
+}
+
+TextureAtlasBuilder &
+TextureAtlasBuilder::SetPadding(u32 padding)
+{
+    padding_ = padding;
+    return *this;
+}
+
+TextureAtlasBuilder &
+TextureAtlasBuilder::SetSafeMipmapLevels(u32 level_count)
+{
+    safe_mipmap_levels_ = level_count;
+    return *this;
+}
+
+TextureAtlasBuilder &
+TextureAtlasBuilder::SetMaxSize(u32 max_size)
+{
+    max_size_ = max_size;
+    return *this;
+}
+
+std::unique_ptr<TextureAtlas>
+TextureAtlasBuilder::Build() const
+{
+    const u32 max_size = std::min(max_size_, kLargestSize);
+    if (safe_mipmap_levels_ >= 16 || (1u << safe_mipmap_levels_) > max_size)
+        throw new std::runtime_error("Images don't fit in a texture atlas");
+
+    ///
+    // Size each image with its padding, in steps of `alignment`, and pick
+    // the format.
+    ///
+
+    const u32 alignment = 1u << safe_mipmap_levels_;
+
+    bool color = false;
+    bool alpha = false;
+    std::vector<Rect> cells(images_.size());
+    std::vector<u32> order(images_.size());
+    u64 area = 0;
+    u32 min_width = std::max(kMinSize, alignment);
+    u32 min_height = min_width;
+    for (size_t i = 0; i < images_.size(); ++i)
+    {
+        const Image & image = *images_[i];
+        switch (image.bpp)
+        {
+        case 8  : break;
+        case 16 : alpha = true; break;
+        case 24 : color = true; break;
+        case 32 : color = true; alpha = true; break;
+        default : throw new std::runtime_error("Texture atlases need images of 8 to 32 bits");
+        }
+
+        const u32 width = Align(image.width + 2 * padding_, alignment);
+        const u32 height = Align(image.height + 2 * padding_, alignment);
+        if (width > max_size || height > max_size)
+            throw new std::runtime_error("Images don't fit in a texture atlas");
+
+        cells[i] = MakeRect(0, 0, width / alignment, height / alignment);
+        order[i] = static_cast<u32>(i);
+        area += static_cast<u64>(width) * height;
+        min_width = std::max(min_width, NextPowerOfTwo(width));
+        min_height = std::max(min_height, NextPowerOfTwo(height));
+    }
+    const u32 channel_count = color ? (alpha ? 4 : 3) : (alpha ? 2 : 1);
+
+    // Largest first, by their longest side, then by area.
+    std::sort(order.begin(), order.end(), [&cells](u32 a, u32 b)
+    {
+        const u32 side_a = std::max(cells[a].width, cells[a].height);
+        const u32 side_b = std::max(cells[b].width, cells[b].height);
+        if (side_a != side_b)
+            return side_a > side_b;
+        return cells[a].width * cells[a].height > cells[b].width * cells[b].height;
+    });
+
+    ///
+    // Grow the atlas, the narrower side first, until everything fits.
+    ///
+
+    u32 width = min_width;
+    u32 height = min_height;
+    std::vector<Rect> placed;
+    for (;;)
+    {
+        if (static_cast<u64>(width) * height >= area &&
+            PackMaxRects(cells, order, width / alignment, height / alignment, placed))
+        {
+            break;
+        }
+
+        if (width <= height)
+            width *= 2;
+        else
+            height *= 2;
+        if (width > max_size || height > max_size)
+            throw new std::runtime_error("Images don't fit in a texture atlas");
+    }
+
+    ///
+    // Copy each image in its cell, repeating its edges all around.
+    ///
+
+    std::vector<byte> pixels(static_cast<size_t>(width) * height * channel_count);
+    std::vector<AtlasRegion> regions(images_.size());
+    std::vector<byte> row;
+    for (size_t i = 0; i < images_.size(); ++i)
+    {
+        const Image & image = *images_[i];
+        const u32 source_count = image.bpp / 8;
+        const u32 cell_x = placed[i].x * alignment;
+        const u32 cell_y = placed[i].y * alignment;
+        const u32 cell_width = placed[i].width * alignment;
+        const u32 cell_height = placed[i].height * alignment;
+
+        AtlasRegion & region = regions[i];
+        region.x = cell_x + padding_;
+        region.y = cell_y + padding_;
+        region.width = image.width;
+        region.height = image.height;
+        region.u0 = static_cast<float>(region.x) / width;
+        region.v0 = static_cast<float>(region.y) / height;
+        region.u1 = static_cast<float>(region.x + region.width) / width;
+        region.v1 = static_cast<float>(region.y + region.height) / height;
+
+        if (image.width == 0 || image.height == 0)
+            continue;
+
+        row.resize(cell_width * channel_count);
+        u32 row_y = ~0u;
+        for (u32 y = 0; y < cell_height; ++y)
+        {
+            const u32 source_y = SourcePosition(y, padding_, image.height);
+            if (source_y != row_y)
+            {
+                const byte * source = &image.data[static_cast<size_t>(source_y) *
+                    image.width * source_count];
+                for (u32 x = 0; x < cell_width; ++x)
+                {
+                    const u32 source_x = SourcePosition(x, padding_, image.width);
+                    ConvertPixel(source + source_x * source_count, source_count,
+                        &row[x * channel_count], channel_count);
+                }
+                row_y = source_y;
+            }
+
+            std::memcpy(&pixels[(static_cast<size_t>(cell_y + y) * width + cell_x) * channel_count],
+                row.data(), row.size());
+        }
+    }
+
+    std::shared_ptr<Image> image = std::make_shared<Image>(static_cast<u16>(width),
+        static_cast<u16>(height), static_cast<byte>(channel_count * 8), std::move(pixels));
+    return std::unique_ptr<TextureAtlas>(
+        new TextureAtlas(image, std::move(regions), safe_mipmap_levels_ > 0));
+}
+
+std::shared_ptr<Model>
+blowgun::RemapTexCoords(const Model & model, const AtlasRegion & region)
+{
+    const VertexLayout & layout = model.vertex_layout();
+    const VertexElement * tex_coord = layout.Find(VertexAttributeUsage::kTexCoord);
+    if (!tex_coord)
+        throw new std::runtime_error("Can't remap a model without texture coordinates.");
+
+    const VertexAttributeFormat::Enum format = tex_coord->format;
+    if (format != VertexAttributeFormat::kFloat2 &&
+        format != VertexAttributeFormat::kHalf2 &&
+        format != VertexAttributeFormat::kUnsignedShort2Normalized)
+    {
+        throw new std::runtime_error("Can't remap texture coordinates of this format.");
+    }
+
+    const float offsets[2] = { region.u0, region.v0 };
+    const float scales[2] = { region.u1 - region.u0, region.v1 - region.v0 };
+
+    const u32 stride = layout.stride();
+    std::vector<u8> vertex_data(model.vertex_data(),
+        model.vertex_data() + model.vertex_data_size());
+    for (u32 i = 0; i < model.vertex_count(); ++i)
+    {
+        u8 * attribute = &vertex_data[i * stride + tex_coord->offset];
+        for (u32 k = 0; k < 2; ++k)
+        {
+            if (format == VertexAttributeFormat::kFloat2)
+            {
+                float value;
+                std::memcpy(&value, attribute + k * sizeof(value), sizeof(value));
+                value = offsets[k] + scales[k] * value;
+                std::memcpy(attribute + k * sizeof(value), &value, sizeof(value));
+            }
+            else
+            {
+                u16 value;
+                std::memcpy(&value, attribute + k * sizeof(value), sizeof(value));
+                if (format == VertexAttributeFormat::kHalf2)
+                {
+                    value = FloatToHalf(offsets[k] + scales[k] * HalfToFloat(value));
+                }
+                else
+                {
+                    // The region is inside [0, 1], and so are the results.
+                    const float remapped = offsets[k] + scales[k] * (value / 65535.0f);
+                    value = static_cast<u16>(std::floor(
+                        std::min(std::max(remapped, 0.0f), 1.0f) * 65535.0f + 0.5f));
+                }
+                std::memcpy(attribute + k * sizeof(value), &value, sizeof(value));
+            }
+        }
+    }
+
+    std::shared_ptr<Model> result;
+    if (model.index_count() == 0)
+    {
+        result = std::make_shared<Model>(layout, std::move(vertex_data),
+            model.bounds(), model.groups());
+    }
+    else
+    {
+        const std::vector<u32> indices = model.ReadIndices();
+        result = std::make_shared<Model>(layout, std::move(vertex_data), indices,
+            model.bounds(), model.groups());
+    }
+
+    result->SetPositionDequantization(model.position_offset(), model.position_scale());
+    return result;
+}
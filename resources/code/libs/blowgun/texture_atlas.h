@@ -0,0 +1,152 @@
+#ifndef BLOWGUN_TEXTURE_ATLAS_H_
+#define BLOWGUN_TEXTURE_ATLAS_H_
+
+#include <memory>
+#include <vector>
+
+#include "image.h"
+#include "model.h"
+#include "types.h"
+
+namespace blowgun
+{
+
+class Texture;
+
+/**
+ * Where one image landed in a `TextureAtlas`, padding excluded.
+ */
+struct AtlasRegion
+{
+	/**
+	 * In pixels of the atlas.
+	 */
+	u32   x;
+	u32   y;
+	u32   width;
+	u32   height;
+
+	/**
+	 * The same, in texture coordinates: the corners of the image in
+	 * the atlas, rather than the centers of its corner pixels, so that
+	 * (0, 0) to (1, 1) in the image maps to (u0, v0) to (u1, v1).
+	 */
+	float u0;
+	float v0;
+	float u1;
+	float v1;
+};
+
+/**
+ * Many images packed into a single one, so objects that each had their
+ * own texture can share one, and be drawn without binding another.
+ */
+class TextureAtlas
+{
+private:
+	std::shared_ptr<Image>   image_;
+	std::vector<AtlasRegion> regions_;
+	bool                     mipmaps_;
+
+	// Disallow copy and assign.
+	TextureAtlas(const TextureAtlas & rhs);
+	TextureAtlas & operator=(const TextureAtlas & rhs);
+
+public:
+	TextureAtlas(std::shared_ptr<Image> image, std::vector<AtlasRegion> regions,
+		bool mipmaps);
+
+	/**
+	 * Get the packed pixels, whose sizes are powers of two.
+	 */
+	const std::shared_ptr<Image> & image() const;
+
+	/**
+	 * Get the region of each image, in the order they were added.
+	 */
+	const std::vector<AtlasRegion> & regions() const;
+
+	/**
+	 * Create a `GL_TEXTURE_2D` out of the packed pixels, with a mipmap
+	 * chain if the builder kept any level safe, and linear filtering
+	 * either way. Must be called from the thread that owns the OpenGL
+	 * context.
+	 */
+	std::unique_ptr<Texture> CreateTexture() const;
+};
+
+/**
+ * Packs images into a `TextureAtlas`, with the MaxRects algorithm: each
+ * image, largest first, goes into the free rectangle it fits the most
+ * tightly, and the atlas grows, in powers of two, until all of them
+ * fit.
+ *
+ * Images of 8, 16, 24 and 32 bits can be mixed: the atlas has color if
+ * any of them does, and alpha if any of them does. Gray images become
+ * gray colors, and images without alpha are opaque.
+ */
+class TextureAtlasBuilder
+{
+private:
+	std::vector<std::shared_ptr<Image>> images_;
+	u32 padding_;
+	u32 safe_mipmap_levels_;
+	u32 max_size_;
+
+	// Disallow copy and assign.
+	TextureAtlasBuilder(const TextureAtlasBuilder & rhs);
+	TextureAtlasBuilder & operator=(const TextureAtlasBuilder & rhs);
+
+public:
+	TextureAtlasBuilder();
+
+	/**
+	 * Add an image, whose region is the next one of the atlas.
+	 */
+	TextureAtlasBuilder & Add(const std::shared_ptr<Image> & image);
+
+	/**
+	 * Pixels around each image, filled by repeating its edges, so that
+	 * linear filtering along an edge doesn't pick up the neighbor. One
+	 * by default.
+	 */
+	TextureAtlasBuilder & SetPadding(u32 padding);
+
+	/**
+	 * Keep images apart in the first `level_count` levels of a mipmap
+	 * chain below the atlas: each image and its padding are placed at
+	 * multiples of 2^`level_count` pixels, and their sizes rounded up
+	 * to such a multiple, the rest being filled by repeating the edges.
+	 * The atlas then has mipmaps, and the levels below those mix
+	 * neighbors. Zero, the default, means no mipmaps.
+	 */
+	TextureAtlasBuilder & SetSafeMipmapLevels(u32 level_count);
+
+	/**
+	 * Largest width and height of the atlas. 2048 by default, which
+	 * most OpenGL ES 2.0 devices support; the specification only
+	 * guarantees 64.
+	 */
+	TextureAtlasBuilder & SetMaxSize(u32 max_size);
+
+	/**
+	 * Pack the images. Throws when they don't fit in the largest size,
+	 * or when one isn't of 8, 16, 24 or 32 bits.
+	 */
+	std::unique_ptr<TextureAtlas> Build() const;
+};
+
+/**
+ * Copy `model` with its texture coordinates moved into `region`, so it
+ * can be drawn with the atlas instead of its own texture.
+ *
+ * Coordinates outside [0, 1], which repeat a texture, don't repeat in
+ * an atlas: they reach into the padding, then the neighbors. Throws
+ * when `model` has no texture coordinates, or stores them in a format
+ * other than `kFloat2`, `kHalf2` or `kUnsignedShort2Normalized`.
+ */
+std::shared_ptr<Model> RemapTexCoords(const Model & model, const AtlasRegion & region);
+
+}
+
+#endif // BLOWGUN_TEXTURE_ATLAS_H_
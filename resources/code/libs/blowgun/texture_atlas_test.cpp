@@ -0,0 +1,256 @@
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "mipmap.h"
+#include "model_loader_obj.h"
+#include "texture_atlas.h"
+#include "vertex_quantization.h"
+
+using namespace blowgun;
+
+namespace
+{
+    // Image whose pixel (x, y) holds `seed + x + y * width` in each
+    // channel, so every pixel of every image is told apart.
+    std::shared_ptr<Image> CreateImage(u32 width, u32 height, u32 bpp, u32 seed)
+    {
+        const u32 channel_count = bpp / 8;
+        std::vector<byte> pixels(width * height * channel_count);
+        for (u32 i = 0; i < width * height; ++i)
+        {
+            for (u32 c = 0; c < channel_count; ++c)
+                pixels[i * channel_count + c] = static_cast<byte>(seed + i + c);
+        }
+        return std::make_shared<Image>(static_cast<u16>(width), static_cast<u16>(height),
+            static_cast<byte>(bpp), pixels);
+    }
+
+    const byte * Pixel(const Image & image, u32 x, u32 y)
+    {
+        return &image.data[(y * image.width + x) * (image.bpp / 8)];
+    }
+
+    bool Overlap(const AtlasRegion & a, const AtlasRegion & b, u32 padding)
+    {
+        return a.x < b.x + b.width + 2 * padding && b.x < a.x + a.width + 2 * padding &&
+            a.y < b.y + b.height + 2 * padding && b.y < a.y + a.height + 2 * padding;
+    }
+
+    float ReadTexCoord(const Model & model, u32 vertex, u32 component)
+    {
+        const VertexElement * element = model.vertex_layout().Find(VertexAttributeUsage::kTexCoord);
+        const u8 * data = model.vertex_data() + vertex * model.vertex_layout().stride() +
+            element->offset;
+        if (element->format == VertexAttributeFormat::kFloat2)
+        {
+            float value;
+            std::memcpy(&value, data + component * sizeof(value), sizeof(value));
+            return value;
+        }
+
+        u16 value;
+        std::memcpy(&value, data + component * sizeof(value), sizeof(value));
+        return (element->format == VertexAttributeFormat::kHalf2)
+            ? HalfToFloat(value)
+            : value / 65535.0f;
+    }
+}
+
+TEST(TextureAtlasTest, Pack)
+{
+    TextureAtlasBuilder builder;
+    std::vector<std::shared_ptr<Image>> images;
+    u32 seed = 1;
+    for (u32 i = 0; i < 60; ++i)
+    {
+        seed = seed * 1664525 + 1013904223;
+        images.push_back(CreateImage(1 + (seed >> 8) % 40, 1 + (seed >> 20) % 40, 24, i));
+        builder.Add(images.back());
+    }
+    builder.SetPadding(2);
+
+    std::unique_ptr<TextureAtlas> atlas = builder.Build();
+    const Image & image = *atlas->image();
+    EXPECT_EQ(24, image.bpp);
+    EXPECT_EQ(0, image.width & (image.width - 1));
+    EXPECT_EQ(0, image.height & (image.height - 1));
+    EXPECT_LE(image.width * image.height, 4 * 256 * 256);
+
+    const std::vector<AtlasRegion> & regions = atlas->regions();
+    ASSERT_EQ(images.size(), regions.size());
+    for (size_t i = 0; i < regions.size(); ++i)
+    {
+        const AtlasRegion & region = regions[i];
+        const Image & source = *images[i];
+        EXPECT_EQ(source.width, region.width);
+        EXPECT_EQ(source.height, region.height);
+        EXPECT_GE(region.x, 2u);
+        EXPECT_GE(region.y, 2u);
+        EXPECT_LE(region.x + region.width + 2, image.width);
+        EXPECT_LE(region.y + region.height + 2, image.height);
+        EXPECT_FLOAT_EQ(static_cast<float>(region.x) / image.width, region.u0);
+        EXPECT_FLOAT_EQ(static_cast<float>(region.y + region.height) / image.height, region.v1);
+
+        for (size_t j = 0; j < i; ++j)
+            EXPECT_FALSE(Overlap(region, regions[j], 2));
+
+        // Every pixel, then the padding repeating the corners.
+        for (u32 y = 0; y < source.height; ++y)
+        {
+            for (u32 x = 0; x < source.width; ++x)
+            {
+                EXPECT_EQ(0, std::memcmp(Pixel(source, x, y),
+                    Pixel(image, region.x + x, region.y + y), 3));
+            }
+        }
+        EXPECT_EQ(0, std::memcmp(Pixel(source, 0, 0),
+            Pixel(image, region.x - 2, region.y - 2), 3));
+        EXPECT_EQ(0, std::memcmp(Pixel(source, source.width - 1, source.height - 1),
+            Pixel(image, region.x + region.width + 1, region.y + region.height + 1), 3));
+    }
+}
+
+TEST(TextureAtlasTest, Formats)
+{
+    std::unique_ptr<TextureAtlas> atlas = TextureAtlasBuilder().
+        Add(CreateImage(3, 2, 8, 10)).
+        Add(CreateImage(5, 5, 24, 20)).
+        Build();
+    EXPECT_EQ(24, atlas->image()->bpp);
+
+    // Gray becomes gray colors.
+    const AtlasRegion & gray = atlas->regions()[0];
+    const byte * pixel = Pixel(*atlas->image(), gray.x + 1, gray.y + 1);
+    EXPECT_EQ(10 + 4, pixel[0]);
+    EXPECT_EQ(10 + 4, pixel[1]);
+    EXPECT_EQ(10 + 4, pixel[2]);
+
+    atlas = TextureAtlasBuilder().
+        Add(CreateImage(3, 2, 16, 10)).
+        Add(CreateImage(5, 5, 24, 20)).
+        Build();
+    EXPECT_EQ(32, atlas->image()->bpp);
+
+    // Alpha comes from the gray and alpha image, and the color one is
+    // opaque.
+    const AtlasRegion & color = atlas->regions()[1];
+    EXPECT_EQ(10 + 1, Pixel(*atlas->image(), atlas->regions()[0].x, atlas->regions()[0].y)[3]);
+    EXPECT_EQ(255, Pixel(*atlas->image(), color.x, color.y)[3]);
+
+    atlas = TextureAtlasBuilder().Add(CreateImage(4, 4, 8, 0)).SetPadding(0).Build();
+    EXPECT_EQ(8, atlas->image()->bpp);
+    EXPECT_EQ(4, atlas->image()->width);
+    EXPECT_EQ(0u, atlas->regions()[0].x);
+    EXPECT_EQ(1.0f, atlas->regions()[0].u1);
+}
+
+TEST(TextureAtlasTest, SafeMipmaps)
+{
+    // Solid images, so the safe levels only hold their colors.
+    const u32 level_count = 3;
+    TextureAtlasBuilder builder;
+    builder.SetSafeMipmapLevels(level_count).SetPadding(1);
+    const u32 sizes[] = { 13, 6, 20, 1, 9, 16, 3 };
+    for (u32 i = 0; i < 7; ++i)
+    {
+        std::vector<byte> pixels(sizes[i] * sizes[6 - i] * 3, static_cast<byte>(30 * i));
+        builder.Add(std::make_shared<Image>(static_cast<u16>(sizes[i]),
+            static_cast<u16>(sizes[6 - i]), 24, pixels));
+    }
+
+    std::unique_ptr<TextureAtlas> atlas = builder.Build();
+    const Image & image = *atlas->image();
+    const std::vector<std::vector<byte>> levels =
+        GenerateMipmaps(image.data.data(), image.width, image.height, 3, false, 1);
+
+    for (u32 i = 0; i < 7; ++i)
+    {
+        const AtlasRegion & region = atlas->regions()[i];
+        EXPECT_EQ(0u, (region.x - 1) % (1 << level_count));
+        EXPECT_EQ(0u, (region.y - 1) % (1 << level_count));
+
+        for (u32 level = 1; level <= level_count; ++level)
+        {
+            const u32 level_width = image.width >> level;
+            const u32 x0 = region.x >> level;
+            const u32 y0 = region.y >> level;
+            const u32 x1 = (region.x + region.width - 1) >> level;
+            const u32 y1 = (region.y + region.height - 1) >> level;
+            for (u32 y = y0; y <= y1; ++y)
+            {
+                for (u32 x = x0; x <= x1; ++x)
+                    EXPECT_EQ(30 * i, levels[level - 1][(y * level_width + x) * 3]);
+            }
+        }
+    }
+}
+
+TEST(TextureAtlasTest, Errors)
+{
+    std::unique_ptr<TextureAtlas> empty = TextureAtlasBuilder().Build();
+    EXPECT_TRUE(empty->regions().empty());
+
+    EXPECT_THROW(TextureAtlasBuilder().Add(CreateImage(100, 4, 24, 0)).SetMaxSize(64).Build(),
+        std::runtime_error *);
+
+    TextureAtlasBuilder builder;
+    builder.SetMaxSize(64);
+    for (u32 i = 0; i < 5; ++i)
+        builder.Add(CreateImage(30, 30, 24, i));
+    EXPECT_THROW(builder.Build(), std::runtime_error *);
+
+    std::vector<byte> pixels(4 * 4 * 6);
+    EXPECT_THROW(TextureAtlasBuilder().Add(std::make_shared<Image>(4, 4, 48, pixels)).Build(),
+        std::runtime_error *);
+}
+
+TEST(TextureAtlasTest, RemapTexCoords)
+{
+    AtlasRegion region;
+    region.x = 16;
+    region.y = 8;
+    region.width = 32;
+    region.height = 16;
+    region.u0 = 0.25f;
+    region.v0 = 0.125f;
+    region.u1 = 0.75f;
+    region.v1 = 0.375f;
+
+    ModelLoaderOBJ loader;
+    std::shared_ptr<Model> cube = loader.Load(std::string("data/cube.obj"));
+    std::shared_ptr<Model> remapped = RemapTexCoords(*cube, region);
+    ASSERT_EQ(cube->vertex_count(), remapped->vertex_count());
+    EXPECT_TRUE(cube->vertex_layout() == remapped->vertex_layout());
+
+    std::shared_ptr<Model> quantized = QuantizeModel(*cube);
+    std::shared_ptr<Model> remapped_quantized = RemapTexCoords(*quantized, region);
+    EXPECT_EQ(quantized->position_scale(), remapped_quantized->position_scale());
+
+    for (u32 i = 0; i < cube->vertex_count(); ++i)
+    {
+        const float u = ReadTexCoord(*cube, i, 0);
+        const float v = ReadTexCoord(*cube, i, 1);
+        EXPECT_FLOAT_EQ(0.25f + 0.5f * u, ReadTexCoord(*remapped, i, 0));
+        EXPECT_FLOAT_EQ(0.125f + 0.25f * v, ReadTexCoord(*remapped, i, 1));
+        EXPECT_NEAR(0.25f + 0.5f * u, ReadTexCoord(*remapped_quantized, i, 0), 1.0f / 65535);
+        EXPECT_NEAR(0.125f + 0.25f * v, ReadTexCoord(*remapped_quantized, i, 1), 1.0f / 65535);
+    }
+
+    // Indices come along.
+    std::shared_ptr<Model> banana = loader.SetIndexed(true).Load(std::string("data/banana.obj"));
+    std::shared_ptr<Model> remapped_banana = RemapTexCoords(*QuantizeModel(*banana, true), region);
+    ASSERT_EQ(banana->index_count(), remapped_banana->index_count());
+    EXPECT_EQ(VertexAttributeFormat::kHalf2,
+        remapped_banana->vertex_layout().Find(VertexAttributeUsage::kTexCoord)->format);
+    EXPECT_NEAR(0.25f + 0.5f * ReadTexCoord(*banana, 5, 0),
+        ReadTexCoord(*remapped_banana, 5, 0), 1e-3f);
+
+    VertexLayout layout;
+    layout.Add(VertexAttributeUsage::kPosition, VertexAttributeFormat::kFloat3);
+    Model untextured(layout, std::vector<u8>(), Bounds(), std::vector<ModelGroup>());
+    EXPECT_THROW(RemapTexCoords(untextured, region), std::runtime_error *);
+}
@@ -1,12 +1,20 @@
 #include "texture_builder.h"
 
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+#include "ktx.h"
+#include "mipmap.h"
 #include "texture.h"
 
 using namespace blowgun;
 
 TextureBuilder::TextureBuilder() :
 	target_(), level_of_detail_(), format_(),
-	type_(), width_(), height_(), data_(), params_()
+	type_(), width_(), height_(), data_(), params_(),
+	mipmaps_(false), srgb_mipmaps_(false), thread_count_(0),
+	compressed_format_(0), levels_()
 {
 }
 
@@ -61,7 +69,7 @@ TextureBuilder::SetType(GLenum type)
 TextureBuilder &
 TextureBuilder::SetData(std::vector<byte> data)
 {
-	data_ = data;
+	data_ = std::move(data);
 	return *this;
 }
 
@@ -72,11 +80,89 @@ TextureBuilder::AddParameter(GLenum param_name, u32 param_value)
 	return *this;
 }
 
+TextureBuilder &
+TextureBuilder::SetMipmaps(bool mipmaps)
+{
+	mipmaps_ = mipmaps;
+	return *this;
+}
+
+TextureBuilder &
+TextureBuilder::SetGammaCorrectMipmaps(bool gamma_correct)
+{
+	srgb_mipmaps_ = gamma_correct;
+	return *this;
+}
+
+TextureBuilder &
+TextureBuilder::SetThreadCount(u32 thread_count)
+{
+	thread_count_ = thread_count;
+	return *this;
+}
+
+TextureBuilder &
+TextureBuilder::SetCompressedFormat(GLenum internal_format)
+{
+	compressed_format_ = internal_format;
+	return *this;
+}
+
+TextureBuilder &
+TextureBuilder::AddLevel(const void * data, u32 size)
+{
+	levels_.push_back(std::make_pair(data, size));
+	return *this;
+}
+
+TextureBuilder &
+TextureBuilder::SetKTX(const KTXFile & file)
+{
+	width_ = file.width();
+	height_ = file.height();
+	format_ = file.format();
+	type_ = file.type();
+	compressed_format_ = file.compressed() ? file.internal_format() : 0;
+
+	const std::vector<KTXLevel> & levels = file.levels();
+	for (size_t i = 0; i < levels.size(); ++i)
+		AddLevel(levels[i].data, levels[i].size);
+	return *this;
+}
+
 std::unique_ptr<Texture>
 TextureBuilder::Build()
 {
 	// TODO: ASSERT every parameters
 
+	if (mipmaps_ && (compressed_format_ != 0 || !levels_.empty()))
+		throw new std::runtime_error("Mipmaps can't be generated for compressed or added levels");
+
+	// Generate the mipmaps before touching OpenGL, so a failure leaves
+	// nothing behind.
+	std::vector<std::vector<byte>> mipmaps;
+	if (mipmaps_)
+	{
+		u32 channel_count = 0;
+		switch (format_)
+		{
+		case GL_LUMINANCE       : channel_count = 1; break;
+		case GL_LUMINANCE_ALPHA : channel_count = 2; break;
+		case GL_RGB             : channel_count = 3; break;
+		case GL_RGBA            : channel_count = 4; break;
+		}
+		if (channel_count == 0 || type_ != GL_UNSIGNED_BYTE)
+			throw new std::runtime_error("Mipmaps need 8-bit luminance or color channels");
+		if (data_.size() < static_cast<size_t>(width_) * height_ * channel_count)
+			throw new std::runtime_error("Not enough texture data");
+
+		mipmaps = GenerateMipmaps(data_.data(), width_, height_, channel_count,
+			srgb_mipmaps_, thread_count_);
+
+		if (params_.find(GL_TEXTURE_MIN_FILTER) == params_.end())
+			params_[GL_TEXTURE_MIN_FILTER] = GL_LINEAR_MIPMAP_LINEAR;
+	}
+
 	// Generate a name for the texture
 	u32 name;
 	glGenTextures(1, &name);
@@ -97,9 +183,53 @@ TextureBuilder::Build()
 		glTexParameteri(target_, param_name, param_value);
 	}
 
-	// Last, upload the texture to GPU.
-	glTexImage2D(target_, level_of_detail_, format_,
-		width_, height_, 0, format_, type_, &data_[0]);
+	// Last, upload the texture to GPU, level by level: the data, if
+	// any, then the levels added.
+	std::vector<std::pair<const void *, u32>> levels;
+	if (!data_.empty() || levels_.empty())
+	{
+		levels.push_back(std::pair<const void *, u32>(
+			data_.empty() ? nullptr : &data_[0], static_cast<u32>(data_.size())));
+	}
+	levels.insert(levels.end(), levels_.begin(), levels_.end());
+
+	u32 level = level_of_detail_;
+	u32 width = width_;
+	u32 height = height_;
+	for (size_t i = 0; i < levels.size(); ++i, ++level)
+	{
+		if (compressed_format_ != 0)
+		{
+			glCompressedTexImage2D(target_, level, compressed_format_,
+				width, height, 0, levels[i].second, levels[i].first);
+		}
+		else
+		{
+			glTexImage2D(target_, level, format_,
+				width, height, 0, format_, type_, levels[i].first);
+		}
+		width = std::max(1u, width / 2);
+		height = std::max(1u, height / 2);
+	}
+
+	// Then the generated levels, if any. Their rows are packed, whatever
+	// their size.
+	if (!mipmaps.empty())
+	{
+		GLint alignment;
+		glGetIntegerv(GL_UNPACK_ALIGNMENT, &alignment);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+		for (size_t i = 0; i < mipmaps.size(); ++i, ++level)
+		{
+			glTexImage2D(target_, level, format_,
+				width, height, 0, format_, type_, mipmaps[i].data());
+			width = std::max(1u, width / 2);
+			height = std::max(1u, height / 2);
+		}
+
+		glPixelStorei(GL_UNPACK_ALIGNMENT, alignment);
+	}
 
 	return std::unique_ptr<Texture>(new Texture(target_, name));
 }
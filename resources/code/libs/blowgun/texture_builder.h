@@ -4,6 +4,7 @@
 #include <vector>
 #include <map>
 #include <memory>
+#include <utility>
 
 #include <GLES2/gl2.h>
 
@@ -12,6 +13,7 @@
 namespace blowgun
 {
 
+class KTXFile;
 class Texture;
 
 class TextureBuilder
@@ -25,6 +27,11 @@ private:
 	u32 height_;
 	std::vector<byte> data_;
 	std::map<GLenum, u32> params_;
+	bool mipmaps_;
+	bool srgb_mipmaps_;
+	u32 thread_count_;
+	GLenum compressed_format_;
+	std::vector<std::pair<const void *, u32>> levels_;
 
 public:
 	explicit TextureBuilder();
@@ -36,6 +43,58 @@ public:
 	TextureBuilder & SetType(GLenum type);
 	TextureBuilder & SetData(std::vector<byte> data);
 	TextureBuilder & AddParameter(GLenum param_name, u32 param_value);
+
+	/**
+	 * Generate the whole mipmap chain of the data on the CPU, and upload
+	 * every level in `Build`, from the level of detail set upward.
+	 * Needs `GL_UNSIGNED_BYTE` data in `GL_LUMINANCE`, `GL_LUMINANCE_ALPHA`,
+	 * `GL_RGB` or `GL_RGBA`. Unless a `GL_TEXTURE_MIN_FILTER` parameter
+	 * is added, the texture is then filtered with
+	 * `GL_LINEAR_MIPMAP_LINEAR`.
+	 *
+	 * OpenGL ES 2.0 only allows mipmaps of textures whose sizes are
+	 * powers of two, unless `GL_OES_texture_npot` is supported.
+	 */
+	TextureBuilder & SetMipmaps(bool mipmaps);
+
+	/**
+	 * Average sRGB colors as light when generating mipmaps, see
+	 * `GenerateMipmaps`. Off by default.
+	 */
+	TextureBuilder & SetGammaCorrectMipmaps(bool gamma_correct);
+
+	/**
+	 * Upper bound of threads generating mipmaps. Zero, the default,
+	 * means `HardwareThreadCount()`.
+	 */
+	TextureBuilder & SetThreadCount(u32 thread_count);
+
+	/**
+	 * Upload the data as compressed blocks of `internal_format`, such as
+	 * `GL_ETC1_RGB8_OES`, with `glCompressedTexImage2D`. The format and
+	 * type set are then ignored, and mipmaps can't be generated: the
+	 * smaller levels have to be compressed too, and added with
+	 * `AddLevel`.
+	 *
+	 * ETC1 needs `GL_OES_compressed_ETC1_RGB8_texture`, supported by
+	 * most OpenGL ES 2.0 devices.
+	 */
+	TextureBuilder & SetCompressedFormat(GLenum internal_format);
+
+	/**
+	 * Add a level of `size` bytes, uploaded after the data and the
+	 * levels added before it, each half the size of the previous one.
+	 * `data` is used in place, so it must stay valid until `Build`.
+	 */
+	TextureBuilder & AddLevel(const void * data, u32 size);
+
+	/**
+	 * Set the size, formats and levels of `file`, whose levels are used
+	 * in place, as `AddLevel` does. Compressed ones set the compressed
+	 * format.
+	 */
+	TextureBuilder & SetKTX(const KTXFile & file);
+
 	std::unique_ptr<Texture> Build();
 };
 
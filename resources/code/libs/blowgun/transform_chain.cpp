@@ -0,0 +1,236 @@
+#include "transform_chain.h"
+
+#include <cmath>
+
+#include "matrix_kernels.h"
+
+#define PI 3.1415926535897932384626433832795f
+
+using namespace blowgun;
+
+// Utility
+namespace
+{
+    static void SetIdentity3(float * m)
+    {
+        m[0] = 1.0f; m[1] = 0.0f; m[2] = 0.0f;
+        m[3] = 0.0f; m[4] = 1.0f; m[5] = 0.0f;
+        m[6] = 0.0f; m[7] = 0.0f; m[8] = 1.0f;
+    }
+
+    // Whether the last value of the first three rows is zero, as it is
+    // for every combination of translations, rotations and scales.
+    static bool HasZeroLastColumn(const Matrix & m)
+    {
+        const float * v = m.values();
+        return v[3] == 0.0f && v[7] == 0.0f && v[11] == 0.0f;
+    }
+
+    // Compute `out = a * b` for 3x3 matrices. `out` may alias `b`.
+    static void Multiply3(const float * a, const float * b, float * out)
+    {
+        float result[9];
+        for (int i = 0; i < 3; ++i)
+        {
+            for (int j = 0; j < 3; ++j)
+            {
+                result[i * 3 + j] =
+                    a[i * 3 + 0] * b[0 + j] +
+                    a[i * 3 + 1] * b[3 + j] +
+                    a[i * 3 + 2] * b[6 + j];
+            }
+        }
+        for (int i = 0; i < 9; ++i)
+            out[i] = result[i];
+    }
+}
+
+TransformChain::TransformChain() :
+    result_(), result_is_identity_(true),
+    linear_(), translation_(), affine_pending_(false),
+    rotation_(), rotation_pending_(false)
+{
+}
+
+TransformChain::TransformChain(const Matrix & start) :
+    result_(start), result_is_identity_(false),
+    linear_(), translation_(), affine_pending_(false),
+    rotation_(), rotation_pending_(false)
+{
+}
+
+void
+TransformChain::FlushRotation() const
+{
+    if (!rotation_pending_)
+        return;
+
+    float rotation[9];
+    rotation_.ToRotation3(rotation);
+
+    if (affine_pending_)
+    {
+        // Rotation only touches the linear part.
+        Multiply3(rotation, linear_, linear_);
+    }
+    else
+    {
+        for (int i = 0; i < 9; ++i)
+            linear_[i] = rotation[i];
+        translation_[0] = translation_[1] = translation_[2] = 0.0f;
+        affine_pending_ = true;
+    }
+
+    rotation_pending_ = false;
+}
+
+void
+TransformChain::Flush() const
+{
+    FlushRotation();
+
+    if (!affine_pending_)
+        return;
+
+    const float * l = linear_;
+    const float * t = translation_;
+
+    if (result_is_identity_)
+    {
+        // Applying the transform to the identity is the transform itself.
+        result_ = Matrix(
+            l[0], l[1], l[2], 0.0f,
+            l[3], l[4], l[5], 0.0f,
+            l[6], l[7], l[8], 0.0f,
+            t[0], t[1], t[2], 1.0f);
+    }
+    else
+    {
+        // The translation reads the rows before the linear part
+        // replaces them, so it goes first.
+        float * values = result_.values_;
+        kernels::Translate(values, t[0], t[1], t[2], values);
+        kernels::MultiplyLinear3(l, values, values);
+    }
+
+    result_is_identity_ = false;
+    affine_pending_ = false;
+}
+
+TransformChain &
+TransformChain::Multiply(const Matrix & other)
+{
+    Flush();
+    result_ = result_is_identity_ ? other : result_.Multiply(other);
+    result_is_identity_ = false;
+    return *this;
+}
+
+TransformChain &
+TransformChain::Scale(float factor_x, float factor_y, float factor_z)
+{
+    // `Matrix::Scale` leaves the last value of each row alone. Folding
+    // the scale into the pending transform only gives the same result
+    // while those values are zero, which isn't the case for
+    // projections, so those get scaled right away.
+    if (!result_is_identity_ && !HasZeroLastColumn(result_))
+    {
+        Flush();
+        result_ = result_.Scale(factor_x, factor_y, factor_z);
+        return *this;
+    }
+
+    FlushRotation();
+
+    if (!affine_pending_)
+    {
+        SetIdentity3(linear_);
+        translation_[0] = translation_[1] = translation_[2] = 0.0f;
+        affine_pending_ = true;
+    }
+
+    linear_[0] *= factor_x; linear_[1] *= factor_x; linear_[2] *= factor_x;
+    linear_[3] *= factor_y; linear_[4] *= factor_y; linear_[5] *= factor_y;
+    linear_[6] *= factor_z; linear_[7] *= factor_z; linear_[8] *= factor_z;
+    return *this;
+}
+
+TransformChain &
+TransformChain::Translate(float factor_x, float factor_y, float factor_z)
+{
+    FlushRotation();
+
+    if (!affine_pending_)
+    {
+        SetIdentity3(linear_);
+        translation_[0] = factor_x;
+        translation_[1] = factor_y;
+        translation_[2] = factor_z;
+        affine_pending_ = true;
+        return *this;
+    }
+
+    for (int j = 0; j < 3; ++j)
+    {
+        translation_[j] +=
+            factor_x * linear_[0 + j] +
+            factor_y * linear_[3 + j] +
+            factor_z * linear_[6 + j];
+    }
+    return *this;
+}
+
+TransformChain &
+TransformChain::Rotate(float angle, float axis_x, float axis_y, float axis_z)
+{
+    return Rotate(Quat::FromAxisAngle(angle, axis_x, axis_y, axis_z));
+}
+
+TransformChain &
+TransformChain::Rotate(const Quat & rotation)
+{
+    rotation_ = rotation_pending_ ? rotation * rotation_ : rotation;
+    rotation_pending_ = true;
+    return *this;
+}
+
+TransformChain &
+TransformChain::Frustum(float left, float right, float bottom, float top,
+    float near_z, float far_z)
+{
+    Flush();
+
+    if (result_is_identity_)
+        result_ = Matrix::CreateFrustum(left, right, bottom, top, near_z, far_z);
+    else
+        result_ = result_.Frustum(left, right, bottom, top, near_z, far_z);
+
+    result_is_identity_ = false;
+    return *this;
+}
+
+TransformChain &
+TransformChain::Perspective(float fov_y, float aspect,
+    float near_z, float far_z)
+{
+    // Same as `Matrix::Perspective`.
+    float frustum_h = tanf(fov_y / 360.0f * PI) * near_z;
+    float frustum_w = frustum_h * aspect;
+
+    return Frustum(
+        -frustum_w, frustum_w, -frustum_h, frustum_h, near_z, far_z
+        );
+}
+
+const Matrix &
+TransformChain::ToMatrix() const
+{
+    Flush();
+    return result_;
+}
+
+const float *
+TransformChain::values() const
+{
+    return ToMatrix().values();
+}
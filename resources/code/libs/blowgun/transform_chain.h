@@ -0,0 +1,84 @@
+#ifndef BLOWGUN_TRANSFORM_CHAIN_H_
+#define BLOWGUN_TRANSFORM_CHAIN_H_
+
+#include "matrix.h"
+#include "quaternion.h"
+
+namespace blowgun
+{
+
+/**
+ * Lazy builder for long chains of `Matrix` operations.
+ *
+ * `TransformChain(m).Translate(...).Rotate(...).Scale(...)` gives the
+ * same result as `m.Translate(...).Rotate(...).Scale(...)`, but no
+ * intermediate Matrix is produced:
+ *
+ * - Consecutive rotations are combined as quaternions, and only turned
+ *   into a 3x3 rotation when another kind of operation follows.
+ * - Translations, rotations and scales are folded into one pending
+ *   affine transform, using 3x3 arithmetic only.
+ * - The pending transform is applied to the matrix in a single pass,
+ *   when the result is finally read or when an operation that is not
+ *   affine (`Multiply`, `Frustum`, `Perspective`) comes along.
+ */
+class TransformChain
+{
+private:
+	/**
+	 * Everything applied so far.
+	 */
+	mutable Matrix result_;
+	mutable bool result_is_identity_;
+
+	/**
+	 * Pending affine transform, stored as its 3x3 linear part (three
+	 * rows of three) and translation.
+	 */
+	mutable float linear_[9];
+	mutable float translation_[3];
+	mutable bool affine_pending_;
+
+	/**
+	 * Pending run of consecutive rotations, not yet part of `linear_`.
+	 */
+	mutable Quat rotation_;
+	mutable bool rotation_pending_;
+
+	void FlushRotation() const;
+	void Flush() const;
+
+public:
+	/**
+	 * Start a chain from the identity matrix.
+	 */
+	TransformChain();
+
+	/**
+	 * Start a chain from an existing matrix.
+	 */
+	explicit TransformChain(const Matrix & start);
+
+	TransformChain & Multiply(const Matrix & other);
+	TransformChain & Scale(float factor_x, float factor_y, float factor_z);
+	TransformChain & Translate(float factor_x, float factor_y, float factor_z);
+	TransformChain & Rotate(float angle, float axis_x, float axis_y, float axis_z);
+	TransformChain & Rotate(const Quat & rotation);
+	TransformChain & Frustum(float left, float right, float bottom, float top, float near_z, float far_z);
+	TransformChain & Perspective(float fov_y, float aspect, float near_z, float far_z);
+
+	/**
+	 * Get the resulting Matrix, applying whatever is still pending.
+	 */
+	const Matrix & ToMatrix() const;
+
+	/**
+	 * Same as `ToMatrix().values()`, so the chain can be handed to
+	 * `glUniformMatrix4fv` directly.
+	 */
+	const float * values() const;
+};
+
+}
+
+#endif // BLOWGUN_TRANSFORM_CHAIN_H_
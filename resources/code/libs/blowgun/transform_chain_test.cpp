@@ -0,0 +1,88 @@
+#include <gtest/gtest.h>
+#include "transform_chain.h"
+
+using namespace blowgun;
+
+namespace
+{
+    void ExpectMatrixNear(const Matrix & expected, const Matrix & actual)
+    {
+        for (int i = 0; i < 16; ++i)
+            EXPECT_NEAR(expected.values()[i], actual.values()[i], 1e-4f) << "index " << i;
+    }
+}
+
+TEST(TransformChainTest, EmptyChainIsStart)
+{
+    ExpectMatrixNear(Matrix(), TransformChain().ToMatrix());
+
+    const Matrix start = Matrix().Translate(1.0f, 2.0f, 3.0f);
+    ExpectMatrixNear(start, TransformChain(start).ToMatrix());
+}
+
+TEST(TransformChainTest, AffineChainMatchesMatrix)
+{
+    const Matrix expected = Matrix()
+        .Translate(1.0f, 2.0f, 3.0f)
+        .Rotate(30.0f, 0.0f, 1.0f, 0.0f)
+        .Rotate(45.0f, 1.0f, 0.0f, 0.0f)
+        .Scale(2.0f, 3.0f, 4.0f)
+        .Translate(-1.0f, 0.5f, 0.0f)
+        .Translate(0.0f, 0.0f, 2.0f)
+        .Scale(0.5f, 0.5f, 0.5f)
+        .Rotate(10.0f, 1.0f, 1.0f, 1.0f);
+
+    const TransformChain chain = TransformChain()
+        .Translate(1.0f, 2.0f, 3.0f)
+        .Rotate(30.0f, 0.0f, 1.0f, 0.0f)
+        .Rotate(45.0f, 1.0f, 0.0f, 0.0f)
+        .Scale(2.0f, 3.0f, 4.0f)
+        .Translate(-1.0f, 0.5f, 0.0f)
+        .Translate(0.0f, 0.0f, 2.0f)
+        .Scale(0.5f, 0.5f, 0.5f)
+        .Rotate(10.0f, 1.0f, 1.0f, 1.0f);
+
+    ExpectMatrixNear(expected, chain.ToMatrix());
+}
+
+TEST(TransformChainTest, ProjectionChainMatchesMatrix)
+{
+    const Matrix expected = Matrix()
+        .Perspective(60.0f, 800.0f / 600.0f, 1.0f, 20.0f)
+        .Translate(0.0f, 0.0f, -15.0f)
+        .Rotate(20.0f, 0.0f, 1.0f, 0.0f)
+        .Scale(2.0f, 2.0f, 2.0f)
+        .Rotate(5.0f, 1.0f, 0.0f, 0.0f)
+        .Multiply(Matrix().Translate(1.0f, 1.0f, 1.0f))
+        .Scale(1.0f, 0.5f, 1.0f);
+
+    const TransformChain chain = TransformChain()
+        .Perspective(60.0f, 800.0f / 600.0f, 1.0f, 20.0f)
+        .Translate(0.0f, 0.0f, -15.0f)
+        .Rotate(20.0f, 0.0f, 1.0f, 0.0f)
+        .Scale(2.0f, 2.0f, 2.0f)
+        .Rotate(5.0f, 1.0f, 0.0f, 0.0f)
+        .Multiply(Matrix().Translate(1.0f, 1.0f, 1.0f))
+        .Scale(1.0f, 0.5f, 1.0f);
+
+    ExpectMatrixNear(expected, chain.ToMatrix());
+}
+
+TEST(TransformChainTest, ChainFromStartMatrixMatches)
+{
+    const Matrix start = Matrix().Rotate(15.0f, 0.0f, 0.0f, 1.0f).Translate(3.0f, 0.0f, 0.0f);
+
+    const Matrix expected = start
+        .Scale(2.0f, 1.0f, 1.0f)
+        .Rotate(90.0f, 0.0f, 1.0f, 0.0f)
+        .Translate(0.0f, 1.0f, 0.0f)
+        .Frustum(-1.0f, 1.0f, -1.0f, 1.0f, 1.0f, 10.0f);
+
+    const TransformChain chain = TransformChain(start)
+        .Scale(2.0f, 1.0f, 1.0f)
+        .Rotate(90.0f, 0.0f, 1.0f, 0.0f)
+        .Translate(0.0f, 1.0f, 0.0f)
+        .Frustum(-1.0f, 1.0f, -1.0f, 1.0f, 1.0f, 10.0f);
+
+    ExpectMatrixNear(expected, chain.ToMatrix());
+}
@@ -0,0 +1,175 @@
+#include "transform_hierarchy.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "matrix_kernels.h"
+#include "parallel.h"
+
+using namespace blowgun;
+
+// Utility
+namespace
+{
+    // Number of nodes of one level below which splitting it over
+    // another thread costs more than it saves.
+    static const u32 kMinNodesPerThread = 1024;
+}
+
+TransformHierarchy::TransformHierarchy() :
+    parents_(),
+    depths_(),
+    locals_(),
+    worlds_(),
+    dirty_(),
+    any_dirty_(false),
+    levels_()
+{
+}
+
+u32
+TransformHierarchy::AddNode(u32 parent, const Matrix & local)
+{
+    const u32 node = static_cast<u32>(parents_.size());
+    if (parent != kNoParent && parent >= node)
+        throw new std::runtime_error("Invalid parent node.");
+
+    const u32 depth = (parent == kNoParent) ? 0 : depths_[parent] + 1;
+
+    parents_.push_back(parent);
+    depths_.push_back(depth);
+    locals_.push_back(local);
+    worlds_.push_back(local);
+    dirty_.push_back(1);
+    any_dirty_ = true;
+
+    if (depth >= levels_.size())
+        levels_.resize(depth + 1);
+    levels_[depth].push_back(node);
+
+    return node;
+}
+
+u32
+TransformHierarchy::size() const
+{
+    return static_cast<u32>(parents_.size());
+}
+
+u32
+TransformHierarchy::parent(u32 node) const
+{
+    return parents_[node];
+}
+
+const Matrix &
+TransformHierarchy::local(u32 node) const
+{
+    return locals_[node];
+}
+
+void
+TransformHierarchy::SetLocal(u32 node, const Matrix & local)
+{
+    locals_[node] = local;
+    dirty_[node] = 1;
+    any_dirty_ = true;
+}
+
+u32
+TransformHierarchy::Update(u32 thread_count)
+{
+    if (!any_dirty_)
+        return 0;
+
+    // Matrix is nothing but its 16 floats (see `MultiplyBatch`), so the
+    // arrays can be handled as raw floats by the kernels.
+    const float * locals = reinterpret_cast<const float *>(&locals_[0]);
+    float * worlds = reinterpret_cast<float *>(&worlds_[0]);
+    const u32 * parents = &parents_[0];
+    u8 * dirty = &dirty_[0];
+
+    // A node is recomputed when it changed itself, or when its parent
+    // was recomputed. Parents come first, so by the time a node is
+    // visited, the flag of its parent is final.
+    auto update_node = [=](u32 node) -> bool
+    {
+        const u32 parent = parents[node];
+        if (parent != kNoParent && dirty[parent])
+            dirty[node] = 1;
+        if (!dirty[node])
+            return false;
+
+        if (parent == kNoParent)
+        {
+            for (u32 j = 0; j < 16; ++j)
+                worlds[node * 16 + j] = locals[node * 16 + j];
+        }
+        else
+        {
+            kernels::Multiply(locals + node * 16, worlds + parent * 16, worlds + node * 16);
+        }
+        return true;
+    };
+
+    u32 updated_count = 0;
+
+    if (thread_count == 1)
+    {
+        // Index order already visits parents before children.
+        for (u32 node = 0; node < size(); ++node)
+        {
+            if (update_node(node))
+                ++updated_count;
+        }
+    }
+    else
+    {
+        // Nodes of one level are independent of each other, so each
+        // level is spread over the threads, one after the other.
+        std::vector<u32> level_counts;
+        for (auto level = levels_.begin(); level != levels_.end(); ++level)
+        {
+            const u32 * nodes = &(*level)[0];
+            const u32 level_size = static_cast<u32>(level->size());
+            const u32 range_count = (level_size + kMinNodesPerThread - 1) / kMinNodesPerThread;
+
+            level_counts.assign(range_count, 0);
+            u32 * counts = &level_counts[0];
+
+            ParallelFor(range_count, 1, thread_count,
+                [=](u32 begin, u32 end)
+                {
+                    for (u32 range = begin; range < end; ++range)
+                    {
+                        const u32 first = range * kMinNodesPerThread;
+                        const u32 last = std::min(first + kMinNodesPerThread, level_size);
+                        for (u32 i = first; i < last; ++i)
+                        {
+                            if (update_node(nodes[i]))
+                                ++counts[range];
+                        }
+                    }
+                });
+
+            for (u32 range = 0; range < range_count; ++range)
+                updated_count += level_counts[range];
+        }
+    }
+
+    dirty_.assign(dirty_.size(), 0);
+    any_dirty_ = false;
+    return updated_count;
+}
+
+const Matrix &
+TransformHierarchy::world(u32 node) const
+{
+    return worlds_[node];
+}
+
+const Matrix *
+TransformHierarchy::world_matrices() const
+{
+    return worlds_.empty() ? nullptr : &worlds_[0];
+}
@@ -0,0 +1,96 @@
+#ifndef BLOWGUN_TRANSFORM_HIERARCHY_H_
+#define BLOWGUN_TRANSFORM_HIERARCHY_H_
+
+#include <vector>
+
+#include "types.h"
+#include "matrix.h"
+
+namespace blowgun
+{
+
+/**
+ * Tree of transforms, e.g. vehicle -> wheels -> bolts, whose world
+ * matrices are only recomputed where something changed.
+ *
+ * Nodes live in flat arrays indexed by node, and a node can only be
+ * added after its parent, so parents always come first. The world
+ * matrix of a node is `local.Multiply(parent_world)`, the same
+ * ordering as `model.Multiply(view_projection)`. All world matrices
+ * sit in one contiguous array, ready to be handed to rendering.
+ */
+class TransformHierarchy
+{
+private:
+	std::vector<u32>    parents_;
+	std::vector<u32>    depths_;
+	std::vector<Matrix> locals_;
+	std::vector<Matrix> worlds_;
+
+	/**
+	 * Whether the world matrix of a node has to be recomputed. Set by
+	 * `SetLocal`, and spread to the whole subtree by `Update`.
+	 */
+	std::vector<u8> dirty_;
+	bool any_dirty_;
+
+	/**
+	 * Nodes grouped by depth. Every node of a level only depends on
+	 * nodes of the previous levels, so a level can be updated in
+	 * parallel.
+	 */
+	std::vector<std::vector<u32>> levels_;
+
+	// Disallow copy and assign.
+	TransformHierarchy(const TransformHierarchy & rhs);
+	TransformHierarchy & operator=(const TransformHierarchy & rhs);
+
+public:
+	static const u32 kNoParent = 0xFFFFFFFF;
+
+	TransformHierarchy();
+
+	/**
+	 * Add a node under `parent`, which has to be an existing node or
+	 * `kNoParent` for a root.
+	 *
+	 * @return  The index of the new node.
+	 */
+	u32 AddNode(u32 parent, const Matrix & local);
+
+	u32 size() const;
+	u32 parent(u32 node) const;
+	const Matrix & local(u32 node) const;
+
+	/**
+	 * Replace the local transform of a node. Its world matrix, and
+	 * those of its whole subtree, are recomputed on the next `Update`.
+	 */
+	void SetLocal(u32 node, const Matrix & local);
+
+	/**
+	 * Recompute the world matrices of every changed subtree.
+	 *
+	 * @param   thread_count
+	 *          Upper bound of threads to split large levels of the
+	 *          tree over. The default updates everything on the calling
+	 *          thread; zero means one thread per hardware thread.
+	 *
+	 * @return  The number of world matrices that were recomputed.
+	 */
+	u32 Update(u32 thread_count = 1);
+
+	/**
+	 * Get the world matrix of a node, as of the last `Update`.
+	 */
+	const Matrix & world(u32 node) const;
+
+	/**
+	 * Get the world matrices of every node, indexed by node.
+	 */
+	const Matrix * world_matrices() const;
+};
+
+}
+
+#endif // BLOWGUN_TRANSFORM_HIERARCHY_H_
@@ -0,0 +1,115 @@
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "transform_hierarchy.h"
+
+using namespace blowgun;
+
+namespace
+{
+    void ExpectMatrixNear(const Matrix & expected, const Matrix & actual)
+    {
+        for (int i = 0; i < 16; ++i)
+            EXPECT_NEAR(expected.values()[i], actual.values()[i], 1e-4f) << "index " << i;
+    }
+
+    Matrix CreateLocal(u32 i)
+    {
+        return Matrix()
+            .Translate(i * 0.1f, 1.0f, -0.5f * (i % 3))
+            .Rotate(i * 3.0f, 0.0f, 1.0f, 0.0f);
+    }
+
+    // Compute every world matrix from scratch, the way it used to be
+    // done by hand.
+    Matrix ReferenceWorld(const TransformHierarchy & hierarchy, u32 node)
+    {
+        Matrix world = hierarchy.local(node);
+        for (u32 ancestor = hierarchy.parent(node);
+            ancestor != TransformHierarchy::kNoParent;
+            ancestor = hierarchy.parent(ancestor))
+        {
+            world = world.Multiply(hierarchy.local(ancestor));
+        }
+        return world;
+    }
+
+    // Vehicles made of wheels made of bolts, big enough for each level
+    // to be split over threads.
+    void CreateVehicles(TransformHierarchy & hierarchy, u32 vehicle_count)
+    {
+        for (u32 v = 0; v < vehicle_count; ++v)
+        {
+            const u32 vehicle = hierarchy.AddNode(TransformHierarchy::kNoParent, CreateLocal(v));
+            for (u32 w = 0; w < 4; ++w)
+            {
+                const u32 wheel = hierarchy.AddNode(vehicle, CreateLocal(w));
+                for (u32 b = 0; b < 5; ++b)
+                    hierarchy.AddNode(wheel, CreateLocal(b));
+            }
+        }
+    }
+}
+
+TEST(TransformHierarchyTest, WorldMatchesReference)
+{
+    TransformHierarchy hierarchy;
+    CreateVehicles(hierarchy, 3);
+
+    EXPECT_EQ(hierarchy.size(), hierarchy.Update());
+    for (u32 node = 0; node < hierarchy.size(); ++node)
+        ExpectMatrixNear(ReferenceWorld(hierarchy, node), hierarchy.world(node));
+
+    EXPECT_EQ(&hierarchy.world(5), hierarchy.world_matrices() + 5);
+}
+
+TEST(TransformHierarchyTest, OnlyDirtySubtreesAreUpdated)
+{
+    TransformHierarchy hierarchy;
+    CreateVehicles(hierarchy, 3);
+    hierarchy.Update();
+
+    EXPECT_EQ(0u, hierarchy.Update());
+
+    // A wheel of the second vehicle: the wheel and its 5 bolts.
+    const u32 wheel = 25 + 1 + 6;
+    ASSERT_EQ(25u, hierarchy.parent(wheel));
+    hierarchy.SetLocal(wheel, Matrix().Rotate(45.0f, 1.0f, 0.0f, 0.0f));
+    EXPECT_EQ(6u, hierarchy.Update());
+
+    // The whole first vehicle.
+    hierarchy.SetLocal(0, Matrix().Translate(5.0f, 0.0f, 0.0f));
+    EXPECT_EQ(25u, hierarchy.Update());
+
+    for (u32 node = 0; node < hierarchy.size(); ++node)
+        ExpectMatrixNear(ReferenceWorld(hierarchy, node), hierarchy.world(node));
+}
+
+TEST(TransformHierarchyTest, ThreadedUpdateMatchesSingle)
+{
+    TransformHierarchy single;
+    TransformHierarchy threaded;
+    CreateVehicles(single, 500);
+    CreateVehicles(threaded, 500);
+
+    EXPECT_EQ(single.Update(), threaded.Update(0));
+
+    for (u32 node = 0; node < single.size(); node += 7)
+    {
+        single.SetLocal(node, CreateLocal(node + 1));
+        threaded.SetLocal(node, CreateLocal(node + 1));
+    }
+    EXPECT_EQ(single.Update(), threaded.Update(0));
+
+    for (u32 node = 0; node < single.size(); ++node)
+    {
+        for (u32 j = 0; j < 16; ++j)
+            ASSERT_EQ(single.world(node).values()[j], threaded.world(node).values()[j]);
+    }
+}
+
+TEST(TransformHierarchyTest, InvalidParentThrows)
+{
+    TransformHierarchy hierarchy;
+    EXPECT_THROW(hierarchy.AddNode(0, Matrix()), std::runtime_error *);
+}
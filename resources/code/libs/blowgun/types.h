@@ -13,5 +13,10 @@ typedef posh_i16_t	i16;
 
 typedef posh_u32_t	u32;
 typedef posh_i32_t	i32;
+
+#if defined POSH_64BIT_INTEGER
+typedef posh_u64_t	u64;
+typedef posh_i64_t	i64;
+#endif
 	
 }
@@ -0,0 +1,119 @@
+#ifndef BLOWGUN_VECTOR_H_
+#define BLOWGUN_VECTOR_H_
+
+#include <cmath>
+
+#include "simd.h"
+
+namespace blowgun
+{
+
+/**
+ * 3-component vector of floats.
+ *
+ * Three floats don't fill a SIMD register, and packing/unpacking
+ * would cost more than the arithmetic itself, so Vec3 is plain
+ * scalar code that the compiler is free to inline.
+ */
+struct Vec3
+{
+	float x;
+	float y;
+	float z;
+
+	Vec3() : x(0.0f), y(0.0f), z(0.0f) {}
+	Vec3(float x, float y, float z) : x(x), y(y), z(z) {}
+};
+
+inline Vec3 operator+(const Vec3 & a, const Vec3 & b) { return Vec3(a.x + b.x, a.y + b.y, a.z + b.z); }
+inline Vec3 operator-(const Vec3 & a, const Vec3 & b) { return Vec3(a.x - b.x, a.y - b.y, a.z - b.z); }
+inline Vec3 operator*(const Vec3 & a, float s) { return Vec3(a.x * s, a.y * s, a.z * s); }
+
+inline float Dot(const Vec3 & a, const Vec3 & b)
+{
+	return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+inline Vec3 Cross(const Vec3 & a, const Vec3 & b)
+{
+	return Vec3(
+		a.y * b.z - a.z * b.y,
+		a.z * b.x - a.x * b.z,
+		a.x * b.y - a.y * b.x);
+}
+
+inline float Length(const Vec3 & v)
+{
+	return std::sqrt(Dot(v, v));
+}
+
+/**
+ * Get the unit-length version of `v`. A zero vector stays zero.
+ */
+inline Vec3 Normalize(const Vec3 & v)
+{
+	float length = Length(v);
+	return length > 0.0f ? v * (1.0f / length) : v;
+}
+
+/**
+ * 4-component vector of floats.
+ *
+ * The components are 16-byte aligned and contiguous, so every
+ * operation below is a handful of SIMD instructions.
+ */
+struct BLOWGUN_ALIGN(16) Vec4
+{
+	float x;
+	float y;
+	float z;
+	float w;
+
+	Vec4() : x(0.0f), y(0.0f), z(0.0f), w(0.0f) {}
+	Vec4(float x, float y, float z, float w) : x(x), y(y), z(z), w(w) {}
+	Vec4(const Vec3 & v, float w) : x(v.x), y(v.y), z(v.z), w(w) {}
+
+	const float * values() const { return &x; }
+
+	simd::Float4 Load() const { return simd::Load(&x); }
+
+	static Vec4 Store(simd::Float4 v)
+	{
+		Vec4 result;
+		simd::Store(&result.x, v);
+		return result;
+	}
+};
+
+inline Vec4 operator+(const Vec4 & a, const Vec4 & b) { return Vec4::Store(simd::Add(a.Load(), b.Load())); }
+inline Vec4 operator-(const Vec4 & a, const Vec4 & b) { return Vec4::Store(simd::Sub(a.Load(), b.Load())); }
+inline Vec4 operator*(const Vec4 & a, float s) { return Vec4::Store(simd::Mul(a.Load(), simd::Splat(s))); }
+
+inline float Dot(const Vec4 & a, const Vec4 & b)
+{
+	return simd::Sum(simd::Mul(a.Load(), b.Load()));
+}
+
+inline float Length(const Vec4 & v)
+{
+	return std::sqrt(Dot(v, v));
+}
+
+inline Vec4 Normalize(const Vec4 & v)
+{
+	float length = Length(v);
+	return length > 0.0f ? v * (1.0f / length) : v;
+}
+
+/**
+ * Linear interpolation: `a` when `t` is 0, `b` when `t` is 1.
+ */
+inline Vec4 Lerp(const Vec4 & a, const Vec4 & b, float t)
+{
+	simd::Float4 va = a.Load();
+	return Vec4::Store(simd::MulAdd(simd::Sub(b.Load(), va), simd::Splat(t), va));
+}
+
+}
+
+#endif // BLOWGUN_VECTOR_H_
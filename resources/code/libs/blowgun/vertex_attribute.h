@@ -6,15 +6,31 @@
 namespace blowgun
 {
 
+/**
+ * How the components of an attribute are stored.
+ *
+ * Formats ending in `Normalized` are integers that the GPU maps to
+ * [0, 1] when unsigned and [-1, 1] when signed. `kHalf2` and `kHalf4`
+ * are 16-bit floats, which need `GL_OES_vertex_half_float`.
+ * `kUnsignedByte4` is for integers used as is.
+ */
 namespace VertexAttributeFormat
 {
     enum Enum
     {
-        kFloat1        = 0,
-        kFloat2        = 1,
-        kFloat3        = 2,
-        kFloat4        = 3,
-        kUnsignedByte4 = 4
+        kFloat1                   = 0,
+        kFloat2                   = 1,
+        kFloat3                   = 2,
+        kFloat4                   = 3,
+        kUnsignedByte4            = 4,
+        kUnsignedByte4Normalized  = 5,
+        kByte4Normalized          = 6,
+        kShort2Normalized         = 7,
+        kShort4Normalized         = 8,
+        kUnsignedShort2Normalized = 9,
+        kUnsignedShort4Normalized = 10,
+        kHalf2                    = 11,
+        kHalf4                    = 12
     };
 }
 
@@ -25,6 +41,9 @@ union VertexAttributeData
     float float_3[3];
     float float_4[4];
     u8    u8_4[4];
+    i8    i8_4[4];
+    i16   i16_4[4];
+    u16   u16_4[4];
 };
 
 
@@ -0,0 +1,157 @@
+#include "vertex_layout.h"
+
+#include <cstddef>
+
+#include <GLES2/gl2.h>
+#include <GLES2/gl2ext.h>
+
+using namespace blowgun;
+
+u32
+blowgun::VertexAttributeFormatSize(VertexAttributeFormat::Enum format)
+{
+    switch (format)
+    {
+    case VertexAttributeFormat::kFloat1                    : return 1 * sizeof(float);
+    case VertexAttributeFormat::kFloat2                    : return 2 * sizeof(float);
+    case VertexAttributeFormat::kFloat3                    : return 3 * sizeof(float);
+    case VertexAttributeFormat::kFloat4                    : return 4 * sizeof(float);
+    case VertexAttributeFormat::kUnsignedByte4             : return 4 * sizeof(u8);
+    case VertexAttributeFormat::kUnsignedByte4Normalized   : return 4 * sizeof(u8);
+    case VertexAttributeFormat::kByte4Normalized           : return 4 * sizeof(i8);
+    case VertexAttributeFormat::kShort2Normalized          : return 2 * sizeof(i16);
+    case VertexAttributeFormat::kShort4Normalized          : return 4 * sizeof(i16);
+    case VertexAttributeFormat::kUnsignedShort2Normalized  : return 2 * sizeof(u16);
+    case VertexAttributeFormat::kUnsignedShort4Normalized  : return 4 * sizeof(u16);
+    case VertexAttributeFormat::kHalf2                     : return 2 * sizeof(u16);
+    case VertexAttributeFormat::kHalf4                     : return 4 * sizeof(u16);
+    }
+    return 0;
+}
+
+u32
+blowgun::VertexAttributeFormatComponentCount(VertexAttributeFormat::Enum format)
+{
+    switch (format)
+    {
+    case VertexAttributeFormat::kFloat1                    : return 1;
+    case VertexAttributeFormat::kFloat2                    : return 2;
+    case VertexAttributeFormat::kFloat3                    : return 3;
+    case VertexAttributeFormat::kFloat4                    : return 4;
+    case VertexAttributeFormat::kUnsignedByte4             : return 4;
+    case VertexAttributeFormat::kUnsignedByte4Normalized   : return 4;
+    case VertexAttributeFormat::kByte4Normalized           : return 4;
+    case VertexAttributeFormat::kShort2Normalized          : return 2;
+    case VertexAttributeFormat::kShort4Normalized          : return 4;
+    case VertexAttributeFormat::kUnsignedShort2Normalized  : return 2;
+    case VertexAttributeFormat::kUnsignedShort4Normalized  : return 4;
+    case VertexAttributeFormat::kHalf2                     : return 2;
+    case VertexAttributeFormat::kHalf4                     : return 4;
+    }
+    return 0;
+}
+
+u32
+blowgun::VertexAttributeFormatType(VertexAttributeFormat::Enum format)
+{
+    switch (format)
+    {
+    case VertexAttributeFormat::kFloat1                    : return GL_FLOAT;
+    case VertexAttributeFormat::kFloat2                    : return GL_FLOAT;
+    case VertexAttributeFormat::kFloat3                    : return GL_FLOAT;
+    case VertexAttributeFormat::kFloat4                    : return GL_FLOAT;
+    case VertexAttributeFormat::kUnsignedByte4             : return GL_UNSIGNED_BYTE;
+    case VertexAttributeFormat::kUnsignedByte4Normalized   : return GL_UNSIGNED_BYTE;
+    case VertexAttributeFormat::kByte4Normalized           : return GL_BYTE;
+    case VertexAttributeFormat::kShort2Normalized          : return GL_SHORT;
+    case VertexAttributeFormat::kShort4Normalized          : return GL_SHORT;
+    case VertexAttributeFormat::kUnsignedShort2Normalized  : return GL_UNSIGNED_SHORT;
+    case VertexAttributeFormat::kUnsignedShort4Normalized  : return GL_UNSIGNED_SHORT;
+    case VertexAttributeFormat::kHalf2                     : return GL_HALF_FLOAT_OES;
+    case VertexAttributeFormat::kHalf4                     : return GL_HALF_FLOAT_OES;
+    }
+    return 0;
+}
+
+bool
+blowgun::VertexAttributeFormatIsNormalized(VertexAttributeFormat::Enum format)
+{
+    switch (format)
+    {
+    case VertexAttributeFormat::kUnsignedByte4Normalized   :
+    case VertexAttributeFormat::kByte4Normalized           :
+    case VertexAttributeFormat::kShort2Normalized          :
+    case VertexAttributeFormat::kShort4Normalized          :
+    case VertexAttributeFormat::kUnsignedShort2Normalized  :
+    case VertexAttributeFormat::kUnsignedShort4Normalized  :
+        return true;
+    default:
+        return false;
+    }
+}
+
+VertexLayout::VertexLayout() :
+    elements_(),
+    stride_(0)
+{
+}
+
+VertexLayout &
+VertexLayout::Add(VertexAttributeUsage::Enum usage, VertexAttributeFormat::Enum format)
+{
+    VertexElement element;
+    element.usage  = usage;
+    element.format = format;
+    element.offset = stride_;
+    elements_.push_back(element);
+
+    stride_ += VertexAttributeFormatSize(format);
+    return *this;
+}
+
+const std::vector<VertexElement> &
+VertexLayout::elements() const
+{
+    return elements_;
+}
+
+u32
+VertexLayout::stride() const
+{
+    return stride_;
+}
+
+const VertexElement *
+VertexLayout::Find(VertexAttributeUsage::Enum usage) const
+{
+    for (std::size_t i = 0; i < elements_.size(); ++i)
+    {
+        if (elements_[i].usage == usage)
+            return &elements_[i];
+    }
+    return nullptr;
+}
+
+bool
+VertexLayout::operator==(const VertexLayout & rhs) const
+{
+    if (stride_ != rhs.stride_ || elements_.size() != rhs.elements_.size())
+        return false;
+
+    for (std::size_t i = 0; i < elements_.size(); ++i)
+    {
+        if (elements_[i].usage != rhs.elements_[i].usage ||
+            elements_[i].format != rhs.elements_[i].format ||
+            elements_[i].offset != rhs.elements_[i].offset)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool
+VertexLayout::operator!=(const VertexLayout & rhs) const
+{
+    return !(*this == rhs);
+}
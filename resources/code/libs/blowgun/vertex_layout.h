@@ -0,0 +1,95 @@
+#ifndef BLOWGUN_VERTEX_LAYOUT_H_
+#define BLOWGUN_VERTEX_LAYOUT_H_
+
+#include <vector>
+
+#include "types.h"
+#include "vertex_attribute.h"
+
+namespace blowgun
+{
+
+/**
+ * What an attribute of a vertex is used for.
+ */
+namespace VertexAttributeUsage
+{
+	enum Enum
+	{
+		kPosition = 0,
+		kTexCoord = 1,
+		kNormal   = 2,
+		kTangent  = 3,
+		kColor    = 4
+	};
+}
+
+/**
+ * Get the number of bytes one attribute of `format` takes.
+ */
+u32 VertexAttributeFormatSize(VertexAttributeFormat::Enum format);
+
+/**
+ * Get the number of components of `format`, as `glVertexAttribPointer`
+ * takes it.
+ */
+u32 VertexAttributeFormatComponentCount(VertexAttributeFormat::Enum format);
+
+/**
+ * Get the type of the components of `format`, as `glVertexAttribPointer`
+ * takes it, e.g. `GL_FLOAT` or `GL_HALF_FLOAT_OES`.
+ */
+u32 VertexAttributeFormatType(VertexAttributeFormat::Enum format);
+
+/**
+ * Check whether `format` has to be given to `glVertexAttribPointer`
+ * as normalized.
+ */
+bool VertexAttributeFormatIsNormalized(VertexAttributeFormat::Enum format);
+
+/**
+ * One attribute of an interleaved vertex: what it is, how it is stored,
+ * and where it starts from the beginning of the vertex.
+ */
+struct VertexElement
+{
+	VertexAttributeUsage::Enum  usage;
+	VertexAttributeFormat::Enum format;
+	u32                         offset;
+};
+
+/**
+ * Description of interleaved vertices: the attributes every vertex is
+ * made of, in order and tightly packed, and the number of bytes from
+ * one vertex to the next.
+ */
+class VertexLayout
+{
+private:
+	std::vector<VertexElement> elements_;
+	u32                        stride_;
+
+public:
+	VertexLayout();
+
+	/**
+	 * Append an attribute right after the previous ones.
+	 */
+	VertexLayout & Add(VertexAttributeUsage::Enum usage, VertexAttributeFormat::Enum format);
+
+	const std::vector<VertexElement> & elements() const;
+	u32 stride() const;
+
+	/**
+	 * Get the attribute used for `usage`, or null when vertices don't
+	 * have any.
+	 */
+	const VertexElement * Find(VertexAttributeUsage::Enum usage) const;
+
+	bool operator==(const VertexLayout & rhs) const;
+	bool operator!=(const VertexLayout & rhs) const;
+};
+
+}
+
+#endif // BLOWGUN_VERTEX_LAYOUT_H_
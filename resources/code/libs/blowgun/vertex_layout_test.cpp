@@ -0,0 +1,71 @@
+#include <gtest/gtest.h>
+#include "vertex_layout.h"
+
+using namespace blowgun;
+
+TEST(VertexLayoutTest, AttributesArePacked)
+{
+    VertexLayout layout;
+    layout
+        .Add(VertexAttributeUsage::kPosition, VertexAttributeFormat::kFloat3)
+        .Add(VertexAttributeUsage::kColor, VertexAttributeFormat::kUnsignedByte4)
+        .Add(VertexAttributeUsage::kTexCoord, VertexAttributeFormat::kFloat2);
+
+    EXPECT_EQ(24u, layout.stride());
+    ASSERT_EQ(3u, layout.elements().size());
+    EXPECT_EQ(0u, layout.elements()[0].offset);
+    EXPECT_EQ(12u, layout.elements()[1].offset);
+    EXPECT_EQ(16u, layout.elements()[2].offset);
+
+    ASSERT_NE(nullptr, layout.Find(VertexAttributeUsage::kTexCoord));
+    EXPECT_EQ(16u, layout.Find(VertexAttributeUsage::kTexCoord)->offset);
+    EXPECT_EQ(nullptr, layout.Find(VertexAttributeUsage::kNormal));
+
+    EXPECT_EQ(4u, VertexAttributeFormatComponentCount(VertexAttributeFormat::kUnsignedByte4));
+    EXPECT_EQ(2u, VertexAttributeFormatComponentCount(VertexAttributeFormat::kFloat2));
+}
+
+TEST(VertexLayoutTest, Equality)
+{
+    VertexLayout a;
+    a.Add(VertexAttributeUsage::kPosition, VertexAttributeFormat::kFloat3);
+    VertexLayout b;
+    b.Add(VertexAttributeUsage::kPosition, VertexAttributeFormat::kFloat3);
+
+    EXPECT_TRUE(a == b);
+    EXPECT_TRUE(VertexLayout() == VertexLayout());
+
+    b.Add(VertexAttributeUsage::kTexCoord, VertexAttributeFormat::kFloat2);
+    EXPECT_TRUE(a != b);
+
+    VertexLayout c;
+    c.Add(VertexAttributeUsage::kNormal, VertexAttributeFormat::kFloat3);
+    EXPECT_TRUE(a != c);
+}
+
+TEST(VertexLayoutTest, QuantizedFormats)
+{
+    VertexLayout layout;
+    layout
+        .Add(VertexAttributeUsage::kPosition, VertexAttributeFormat::kUnsignedShort4Normalized)
+        .Add(VertexAttributeUsage::kNormal, VertexAttributeFormat::kShort2Normalized)
+        .Add(VertexAttributeUsage::kTexCoord, VertexAttributeFormat::kHalf2)
+        .Add(VertexAttributeUsage::kColor, VertexAttributeFormat::kUnsignedByte4Normalized);
+
+    EXPECT_EQ(20u, layout.stride());
+    EXPECT_EQ(16u, layout.Find(VertexAttributeUsage::kColor)->offset);
+
+    EXPECT_EQ(2u, VertexAttributeFormatComponentCount(VertexAttributeFormat::kShort2Normalized));
+    EXPECT_EQ(4u, VertexAttributeFormatComponentCount(VertexAttributeFormat::kByte4Normalized));
+    EXPECT_EQ(8u, VertexAttributeFormatSize(VertexAttributeFormat::kHalf4));
+
+    EXPECT_TRUE(VertexAttributeFormatIsNormalized(VertexAttributeFormat::kShort4Normalized));
+    EXPECT_FALSE(VertexAttributeFormatIsNormalized(VertexAttributeFormat::kUnsignedByte4));
+    EXPECT_FALSE(VertexAttributeFormatIsNormalized(VertexAttributeFormat::kHalf2));
+    EXPECT_FALSE(VertexAttributeFormatIsNormalized(VertexAttributeFormat::kFloat3));
+
+    // GL_FLOAT, GL_UNSIGNED_SHORT and GL_HALF_FLOAT_OES.
+    EXPECT_EQ(0x1406u, VertexAttributeFormatType(VertexAttributeFormat::kFloat2));
+    EXPECT_EQ(0x1403u, VertexAttributeFormatType(VertexAttributeFormat::kUnsignedShort2Normalized));
+    EXPECT_EQ(0x8D61u, VertexAttributeFormatType(VertexAttributeFormat::kHalf4));
+}
@@ -0,0 +1,422 @@
+#include "vertex_quantization.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "vector.h"
+
+using namespace blowgun;
+
+// Utility
+namespace
+{
+    static i32
+    Round(float value)
+    {
+        return static_cast<i32>(std::floor(value + 0.5f));
+    }
+
+    // Quantize `value`, in [0, 1], to an unsigned normalized integer
+    // of `max` steps.
+    static u32
+    QuantizeUnsigned(float value, u32 max)
+    {
+        const float clamped = std::min(std::max(value, 0.0f), 1.0f);
+        return static_cast<u32>(Round(clamped * static_cast<float>(max)));
+    }
+
+    // Quantize `value`, in [-1, 1], to a signed normalized integer of
+    // `max` steps on each side of zero.
+    static i32
+    QuantizeSigned(float value, i32 max)
+    {
+        const float clamped = std::min(std::max(value, -1.0f), 1.0f);
+        return Round(clamped * static_cast<float>(max));
+    }
+
+    static float
+    SignNotZero(float value)
+    {
+        return (value < 0.0f) ? -1.0f : 1.0f;
+    }
+
+    // Format each float attribute is converted to, or the same format
+    // when it is kept as is.
+    static VertexAttributeFormat::Enum
+    QuantizedFormat(const VertexElement & element, bool unit_tex_coords, bool half_floats)
+    {
+        switch (element.usage)
+        {
+        case VertexAttributeUsage::kPosition:
+            return VertexAttributeFormat::kUnsignedShort4Normalized;
+
+        case VertexAttributeUsage::kTexCoord:
+            if (element.format != VertexAttributeFormat::kFloat2)
+                return element.format;
+            if (unit_tex_coords)
+                return VertexAttributeFormat::kUnsignedShort2Normalized;
+            return half_floats ? VertexAttributeFormat::kHalf2 : element.format;
+
+        case VertexAttributeUsage::kNormal:
+            return (element.format == VertexAttributeFormat::kFloat3)
+                ? VertexAttributeFormat::kShort2Normalized
+                : element.format;
+
+        case VertexAttributeUsage::kTangent:
+            return (element.format == VertexAttributeFormat::kFloat4)
+                ? VertexAttributeFormat::kByte4Normalized
+                : element.format;
+
+        case VertexAttributeUsage::kColor:
+            return (element.format == VertexAttributeFormat::kFloat3 ||
+                element.format == VertexAttributeFormat::kFloat4)
+                ? VertexAttributeFormat::kUnsignedByte4Normalized
+                : element.format;
+        }
+        return element.format;
+    }
+
+    // Check whether every texture coordinate fits in [0, 1], so they can
+    // be stored as unsigned normalized integers without any offset.
+    static bool
+    AreUnitTexCoords(const Model & model, const VertexElement & element)
+    {
+        const u32 stride = model.vertex_layout().stride();
+        for (u32 i = 0; i < model.vertex_count(); ++i)
+        {
+            float tex_coord[2];
+            std::memcpy(tex_coord, model.vertex_data() + i * stride + element.offset,
+                sizeof(tex_coord));
+            if (!(tex_coord[0] >= 0.0f && tex_coord[0] <= 1.0f &&
+                tex_coord[1] >= 0.0f && tex_coord[1] <= 1.0f))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Convert one attribute from `source`, stored as `element.format`,
+    // to `format` into `destination`.
+    static void
+    QuantizeAttribute(
+        const u8 * source,
+        const VertexElement & element,
+        VertexAttributeFormat::Enum format,
+        const Vec3 & position_offset,
+        float position_inverse_scale,
+        u8 * destination)
+    {
+        if (format == element.format)
+        {
+            std::memcpy(destination, source, VertexAttributeFormatSize(format));
+            return;
+        }
+
+        float values[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+        std::memcpy(values, source, VertexAttributeFormatSize(element.format));
+
+        switch (format)
+        {
+        case VertexAttributeFormat::kUnsignedShort4Normalized:
+            {
+                u16 position[4];
+                position[0] = static_cast<u16>(QuantizeUnsigned(
+                    (values[0] - position_offset.x) * position_inverse_scale, 0xFFFF));
+                position[1] = static_cast<u16>(QuantizeUnsigned(
+                    (values[1] - position_offset.y) * position_inverse_scale, 0xFFFF));
+                position[2] = static_cast<u16>(QuantizeUnsigned(
+                    (values[2] - position_offset.z) * position_inverse_scale, 0xFFFF));
+                position[3] = 0xFFFF;
+                std::memcpy(destination, position, sizeof(position));
+            }
+            break;
+
+        case VertexAttributeFormat::kUnsignedShort2Normalized:
+            {
+                u16 tex_coord[2];
+                tex_coord[0] = static_cast<u16>(QuantizeUnsigned(values[0], 0xFFFF));
+                tex_coord[1] = static_cast<u16>(QuantizeUnsigned(values[1], 0xFFFF));
+                std::memcpy(destination, tex_coord, sizeof(tex_coord));
+            }
+            break;
+
+        case VertexAttributeFormat::kHalf2:
+            {
+                u16 tex_coord[2];
+                tex_coord[0] = FloatToHalf(values[0]);
+                tex_coord[1] = FloatToHalf(values[1]);
+                std::memcpy(destination, tex_coord, sizeof(tex_coord));
+            }
+            break;
+
+        case VertexAttributeFormat::kShort2Normalized:
+            {
+                i16 normal[2];
+                EncodeOctahedral(values, normal);
+                std::memcpy(destination, normal, sizeof(normal));
+            }
+            break;
+
+        case VertexAttributeFormat::kByte4Normalized:
+            {
+                i8 tangent[4];
+                for (u32 k = 0; k < 4; ++k)
+                    tangent[k] = static_cast<i8>(QuantizeSigned(values[k], 127));
+                std::memcpy(destination, tangent, sizeof(tangent));
+            }
+            break;
+
+        case VertexAttributeFormat::kUnsignedByte4Normalized:
+            {
+                u8 color[4];
+                for (u32 k = 0; k < 4; ++k)
+                    color[k] = static_cast<u8>(QuantizeUnsigned(values[k], 0xFF));
+                std::memcpy(destination, color, sizeof(color));
+            }
+            break;
+
+        default:
+            break;
+        }
+    }
+}
+
+u16
+blowgun::FloatToHalf(float value)
+{
+    u32 bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+
+    const u32 sign = (bits >> 16) & 0x8000;
+    const u32 magnitude = bits & 0x7FFFFFFF;
+
+    // Infinities, and NaNs, which stay NaNs.
+    if (magnitude >= 0x7F800000)
+        return static_cast<u16>(sign | 0x7C00 | ((magnitude > 0x7F800000) ? 0x200 : 0));
+
+    // At least 65520, which rounds past the largest half.
+    if (magnitude >= 0x477FF000)
+        return static_cast<u16>(sign | 0x7C00);
+
+    // Below 2^-14, the smallest normal half: denormal, in steps of
+    // 2^-24.
+    if (magnitude < 0x38800000)
+    {
+        float absolute;
+        std::memcpy(&absolute, &magnitude, sizeof(absolute));
+        return static_cast<u16>(sign | static_cast<u32>(Round(absolute * 16777216.0f)));
+    }
+
+    // Rebias the exponent and drop 13 bits of mantissa, rounding to the
+    // nearest, ties to even. A carry out of the mantissa bumps the
+    // exponent, as it should.
+    const u32 rounded = magnitude + 0xFFF + ((magnitude >> 13) & 1);
+    return static_cast<u16>(sign | ((rounded - 0x38000000) >> 13));
+}
+
+float
+blowgun::HalfToFloat(u16 value)
+{
+    const u32 sign = static_cast<u32>(value & 0x8000) << 16;
+    const u32 exponent = (value >> 10) & 0x1F;
+    const u32 mantissa = value & 0x3FF;
+
+    if (exponent == 0)
+    {
+        const float absolute = static_cast<float>(mantissa) / 16777216.0f;
+        return sign ? -absolute : absolute;
+    }
+
+    const u32 bits = (exponent == 0x1F)
+        ? sign | 0x7F800000 | (mantissa << 13)
+        : sign | ((exponent + 112) << 23) | (mantissa << 13);
+
+    float result;
+    std::memcpy(&result, &bits, sizeof(result));
+    return result;
+}
+
+void
+blowgun::EncodeOctahedral(const float * vector, i16 * encoded)
+{
+    const float length = std::fabs(vector[0]) + std::fabs(vector[1]) + std::fabs(vector[2]);
+    if (length == 0.0f)
+    {
+        encoded[0] = 0;
+        encoded[1] = 0;
+        return;
+    }
+
+    float x = vector[0] / length;
+    float y = vector[1] / length;
+
+    // Fold the lower half over the diagonals.
+    if (vector[2] < 0.0f)
+    {
+        const float folded_x = (1.0f - std::fabs(y)) * SignNotZero(x);
+        const float folded_y = (1.0f - std::fabs(x)) * SignNotZero(y);
+        x = folded_x;
+        y = folded_y;
+    }
+
+    encoded[0] = static_cast<i16>(QuantizeSigned(x, 32767));
+    encoded[1] = static_cast<i16>(QuantizeSigned(y, 32767));
+}
+
+void
+blowgun::DecodeOctahedral(const i16 * encoded, float * vector)
+{
+    float x = std::max(encoded[0] / 32767.0f, -1.0f);
+    float y = std::max(encoded[1] / 32767.0f, -1.0f);
+    const float z = 1.0f - std::fabs(x) - std::fabs(y);
+
+    if (z < 0.0f)
+    {
+        const float unfolded_x = (1.0f - std::fabs(y)) * SignNotZero(x);
+        const float unfolded_y = (1.0f - std::fabs(x)) * SignNotZero(y);
+        x = unfolded_x;
+        y = unfolded_y;
+    }
+
+    const Vec3 normal = Normalize(Vec3(x, y, z));
+    vector[0] = normal.x;
+    vector[1] = normal.y;
+    vector[2] = normal.z;
+}
+
+std::shared_ptr<Model>
+blowgun::QuantizeModel(const Model & model, bool half_floats)
+{
+    const VertexLayout & layout = model.vertex_layout();
+    const VertexElement * position = layout.Find(VertexAttributeUsage::kPosition);
+    if (!position || position->format != VertexAttributeFormat::kFloat3)
+        throw new std::runtime_error("Can't quantize a model whose positions aren't floats.");
+
+    ///
+    // Pick the format of each attribute.
+    ///
+
+    const std::vector<VertexElement> & elements = layout.elements();
+    std::vector<VertexAttributeFormat::Enum> formats(elements.size());
+    VertexLayout quantized_layout;
+    for (size_t e = 0; e < elements.size(); ++e)
+    {
+        const bool unit_tex_coords =
+            elements[e].usage == VertexAttributeUsage::kTexCoord &&
+            elements[e].format == VertexAttributeFormat::kFloat2 &&
+            AreUnitTexCoords(model, elements[e]);
+        formats[e] = QuantizedFormat(elements[e], unit_tex_coords, half_floats);
+        quantized_layout.Add(elements[e].usage, formats[e]);
+    }
+
+    // The same scale on every axis, so the dequantization doesn't skew
+    // normals. A flat or empty model gets a scale of one, rather than
+    // zero.
+    const AABB & aabb = model.bounds().aabb;
+    const Vec3 extent = aabb.max - aabb.min;
+    float scale = std::max(extent.x, std::max(extent.y, extent.z));
+    if (!(scale > 0.0f))
+        scale = 1.0f;
+
+    ///
+    // Convert every vertex.
+    ///
+
+    const u32 stride = layout.stride();
+    const u32 quantized_stride = quantized_layout.stride();
+    const std::vector<VertexElement> & quantized_elements = quantized_layout.elements();
+
+    std::vector<u8> vertex_data(model.vertex_count() * quantized_stride);
+    for (u32 i = 0; i < model.vertex_count(); ++i)
+    {
+        const u8 * source = model.vertex_data() + i * stride;
+        u8 * destination = &vertex_data[i * quantized_stride];
+        for (size_t e = 0; e < elements.size(); ++e)
+        {
+            QuantizeAttribute(source + elements[e].offset, elements[e], formats[e],
+                aabb.min, 1.0f / scale, destination + quantized_elements[e].offset);
+        }
+    }
+
+    std::shared_ptr<Model> result;
+    if (model.index_count() == 0)
+    {
+        result = std::make_shared<Model>(quantized_layout, std::move(vertex_data),
+            model.bounds(), model.groups());
+    }
+    else
+    {
+        const std::vector<u32> indices = model.ReadIndices();
+        result = std::make_shared<Model>(quantized_layout, std::move(vertex_data), indices,
+            model.bounds(), model.groups());
+    }
+
+    result->SetPositionDequantization(aabb.min, scale);
+    return result;
+}
+
+std::shared_ptr<Model>
+blowgun::ExpandHalfFloats(const Model & model)
+{
+    const VertexLayout & layout = model.vertex_layout();
+    const std::vector<VertexElement> & elements = layout.elements();
+    VertexLayout expanded_layout;
+    for (size_t e = 0; e < elements.size(); ++e)
+    {
+        VertexAttributeFormat::Enum format = elements[e].format;
+        if (format == VertexAttributeFormat::kHalf2)
+            format = VertexAttributeFormat::kFloat2;
+        else if (format == VertexAttributeFormat::kHalf4)
+            format = VertexAttributeFormat::kFloat4;
+        expanded_layout.Add(elements[e].usage, format);
+    }
+
+    const u32 stride = layout.stride();
+    const u32 expanded_stride = expanded_layout.stride();
+    const std::vector<VertexElement> & expanded_elements = expanded_layout.elements();
+
+    std::vector<u8> vertex_data(model.vertex_count() * expanded_stride);
+    for (u32 i = 0; i < model.vertex_count(); ++i)
+    {
+        const u8 * source = model.vertex_data() + i * stride;
+        u8 * destination = &vertex_data[i * expanded_stride];
+        for (size_t e = 0; e < elements.size(); ++e)
+        {
+            const u8 * attribute = source + elements[e].offset;
+            u8 * expanded = destination + expanded_elements[e].offset;
+            if (elements[e].format == expanded_elements[e].format)
+            {
+                std::memcpy(expanded, attribute, VertexAttributeFormatSize(elements[e].format));
+                continue;
+            }
+
+            for (u32 c = 0; c < VertexAttributeFormatComponentCount(elements[e].format); ++c)
+            {
+                u16 half;
+                std::memcpy(&half, attribute + c * sizeof(half), sizeof(half));
+                const float value = HalfToFloat(half);
+                std::memcpy(expanded + c * sizeof(value), &value, sizeof(value));
+            }
+        }
+    }
+
+    std::shared_ptr<Model> result;
+    if (model.index_count() == 0)
+    {
+        result = std::make_shared<Model>(expanded_layout, std::move(vertex_data),
+            model.bounds(), model.groups());
+    }
+    else
+    {
+        result = std::make_shared<Model>(expanded_layout, std::move(vertex_data),
+            model.ReadIndices(), model.bounds(), model.groups());
+    }
+
+    result->SetPositionDequantization(model.position_offset(), model.position_scale());
+    return result;
+}
@@ -0,0 +1,76 @@
+#ifndef BLOWGUN_VERTEX_QUANTIZATION_H_
+#define BLOWGUN_VERTEX_QUANTIZATION_H_
+
+#include <memory>
+
+#include "model.h"
+#include "types.h"
+
+namespace blowgun
+{
+
+/**
+ * Convert a float to a 16-bit float, rounding to the nearest. Values
+ * too large become infinities.
+ */
+u16 FloatToHalf(float value);
+
+float HalfToFloat(u16 value);
+
+/**
+ * Encode a unit vector into two signed normalized components, by
+ * projecting it on an octahedron unfolded into a square.
+ *
+ * @param   vector
+ *          3 floats. It doesn't have to be normalized. A zero vector
+ *          comes back as +z.
+ * @param   encoded
+ *          Receives 2 components, as `kShort2Normalized` stores them.
+ */
+void EncodeOctahedral(const float * vector, i16 * encoded);
+
+/**
+ * Decode a unit vector encoded by `EncodeOctahedral`, the same way a
+ * vertex shader would:
+ *
+ *     vec3 n = vec3(e.xy, 1.0 - abs(e.x) - abs(e.y));
+ *     if (n.z < 0.0)
+ *         n.xy = (1.0 - abs(n.yx)) * sign(n.xy);
+ *     n = normalize(n);
+ */
+void DecodeOctahedral(const i16 * encoded, float * vector);
+
+/**
+ * Convert the float attributes of `model` to smaller formats, about
+ * halving the bytes each vertex takes:
+ *
+ * - Positions become `kUnsignedShort4Normalized`, relative to the
+ *   bounds of the model, with a fourth component of one. The offset
+ *   and scale that map them back are stored in the model, see
+ *   `Model::position_dequantization`.
+ * - Texture coordinates become `kUnsignedShort2Normalized` when all of
+ *   them are in [0, 1]. Otherwise they become `kHalf2` if
+ *   `half_floats` is set, which needs `GL_OES_vertex_half_float`, and
+ *   stay floats if not.
+ * - Normals become `kShort2Normalized`, octahedral-encoded.
+ * - Tangents become `kByte4Normalized`, the sign of the bitangent
+ *   included.
+ * - Colors become `kUnsignedByte4Normalized`.
+ *
+ * Indices, groups and bounds are kept as they are. Throws when the
+ * positions of `model` aren't 3 floats, e.g. when it is already
+ * quantized.
+ */
+std::shared_ptr<Model> QuantizeModel(const Model & model, bool half_floats = false);
+
+/**
+ * Copy `model` with its `kHalf2` and `kHalf4` attributes converted back
+ * to `kFloat2` and `kFloat4`, for devices without
+ * `GL_OES_vertex_half_float`, which can't draw them. Every other
+ * attribute, and the position dequantization, are kept as they are.
+ */
+std::shared_ptr<Model> ExpandHalfFloats(const Model & model);
+
+}
+
+#endif // BLOWGUN_VERTEX_QUANTIZATION_H_
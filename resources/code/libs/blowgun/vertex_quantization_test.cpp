@@ -0,0 +1,205 @@
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "model_loader_obj.h"
+#include "vertex_quantization.h"
+
+using namespace blowgun;
+
+namespace
+{
+    template <typename T>
+    T ReadAttribute(const Model & model, u32 vertex, VertexAttributeUsage::Enum usage,
+        u32 component)
+    {
+        const VertexElement * element = model.vertex_layout().Find(usage);
+        T value;
+        std::memcpy(&value, model.vertex_data() + vertex * model.vertex_layout().stride() +
+            element->offset + component * sizeof(T), sizeof(T));
+        return value;
+    }
+
+    // A single triangle whose texture coordinates go past [0, 1].
+    std::shared_ptr<Model> CreateTiledTriangle()
+    {
+        const float vertices[] = {
+            0.0f, 0.0f, 0.0f,   -1.5f, 0.0f,
+            1.0f, 0.0f, 0.0f,    2.25f, 0.0f,
+            0.0f, 1.0f, 0.0f,    0.0f, 3.0f,
+        };
+        VertexLayout layout;
+        layout
+            .Add(VertexAttributeUsage::kPosition, VertexAttributeFormat::kFloat3)
+            .Add(VertexAttributeUsage::kTexCoord, VertexAttributeFormat::kFloat2);
+
+        const u8 * bytes = reinterpret_cast<const u8 *>(vertices);
+        return std::make_shared<Model>(layout,
+            std::vector<u8>(bytes, bytes + sizeof(vertices)),
+            ComputeBounds(vertices, 3, 5 * sizeof(float)),
+            std::vector<ModelGroup>());
+    }
+}
+
+TEST(VertexQuantizationTest, HalfFloats)
+{
+    EXPECT_EQ(0x0000, FloatToHalf(0.0f));
+    EXPECT_EQ(0x3C00, FloatToHalf(1.0f));
+    EXPECT_EQ(0xC000, FloatToHalf(-2.0f));
+    EXPECT_EQ(0x3555, FloatToHalf(1.0f / 3.0f));
+    EXPECT_EQ(0x7BFF, FloatToHalf(65504.0f));
+    EXPECT_EQ(0x7C00, FloatToHalf(65520.0f));
+    EXPECT_EQ(0xFC00, FloatToHalf(-1e10f));
+    EXPECT_EQ(0x0001, FloatToHalf(std::ldexp(1.0f, -24)));
+    EXPECT_EQ(0x0400, FloatToHalf(std::ldexp(1.0f, -14)));
+
+    // Ties go to even.
+    EXPECT_EQ(0x3C00, FloatToHalf(1.0f + std::ldexp(1.0f, -11)));
+    EXPECT_EQ(0x3C02, FloatToHalf(1.0f + 3.0f * std::ldexp(1.0f, -11)));
+
+    for (float value = -300.0f; value < 300.0f; value += 0.173f)
+    {
+        EXPECT_NEAR(value, HalfToFloat(FloatToHalf(value)),
+            std::fabs(value) * std::ldexp(1.0f, -11) + 1e-7f);
+    }
+    EXPECT_EQ(std::ldexp(1.0f, -24), HalfToFloat(0x0001));
+    EXPECT_TRUE(std::isinf(HalfToFloat(0x7C00)));
+}
+
+TEST(VertexQuantizationTest, Octahedral)
+{
+    for (u32 i = 0; i < 2000; ++i)
+    {
+        // Spiral over the whole sphere, poles and equator included.
+        const float z = 1.0f - 2.0f * i / 1999.0f;
+        const float r = std::sqrt(std::max(0.0f, 1.0f - z * z));
+        const float angle = 2.3999632f * i;
+        const float vector[3] = { r * std::cos(angle), r * std::sin(angle), z };
+
+        i16 encoded[2];
+        float decoded[3];
+        EncodeOctahedral(vector, encoded);
+        DecodeOctahedral(encoded, decoded);
+
+        const float dot = vector[0] * decoded[0] + vector[1] * decoded[1] + vector[2] * decoded[2];
+        EXPECT_GT(dot, 0.99999f);
+    }
+
+    const float zero[3] = { 0.0f, 0.0f, 0.0f };
+    i16 encoded[2];
+    float decoded[3];
+    EncodeOctahedral(zero, encoded);
+    DecodeOctahedral(encoded, decoded);
+    EXPECT_EQ(1.0f, decoded[2]);
+}
+
+TEST(VertexQuantizationTest, QuantizeModel)
+{
+    ModelLoaderOBJ loader;
+    auto model = loader.SetIndexed(true).SetTangents(true).Load(std::string("data/banana.obj"));
+
+    // Its texture coordinates go past [0, 1].
+    EXPECT_EQ(24u, QuantizeModel(*model)->vertex_layout().stride());
+    auto quantized = QuantizeModel(*model, true);
+
+    const VertexLayout & layout = quantized->vertex_layout();
+    EXPECT_EQ(VertexAttributeFormat::kUnsignedShort4Normalized,
+        layout.Find(VertexAttributeUsage::kPosition)->format);
+    EXPECT_EQ(VertexAttributeFormat::kShort2Normalized,
+        layout.Find(VertexAttributeUsage::kNormal)->format);
+    EXPECT_EQ(VertexAttributeFormat::kByte4Normalized,
+        layout.Find(VertexAttributeUsage::kTangent)->format);
+    EXPECT_EQ(VertexAttributeFormat::kHalf2,
+        layout.Find(VertexAttributeUsage::kTexCoord)->format);
+    EXPECT_EQ(20u, layout.stride());
+    EXPECT_LT(2 * layout.stride(), model->vertex_layout().stride());
+
+    ASSERT_EQ(model->vertex_count(), quantized->vertex_count());
+    ASSERT_EQ(model->index_count(), quantized->index_count());
+    EXPECT_EQ(0, std::memcmp(model->index_data(), quantized->index_data(),
+        model->index_count() * ((model->index_format() == IndexFormat::kUnsignedInt) ? 4 : 2)));
+    EXPECT_EQ(model->groups().size(), quantized->groups().size());
+
+    // Positions come back within a step, with the matrix too.
+    const float scale = quantized->position_scale();
+    const Matrix dequantization = quantized->position_dequantization();
+    for (u32 i = 0; i < model->vertex_count(); i += 7)
+    {
+        float q[4];
+        for (u32 k = 0; k < 4; ++k)
+            q[k] = ReadAttribute<u16>(*quantized, i, VertexAttributeUsage::kPosition, k) / 65535.0f;
+        EXPECT_EQ(1.0f, q[3]);
+
+        const Vec3 offset = quantized->position_offset();
+        const float expected[3] = {
+            ReadAttribute<float>(*model, i, VertexAttributeUsage::kPosition, 0),
+            ReadAttribute<float>(*model, i, VertexAttributeUsage::kPosition, 1),
+            ReadAttribute<float>(*model, i, VertexAttributeUsage::kPosition, 2) };
+        const float dequantized[3] = {
+            offset.x + scale * q[0], offset.y + scale * q[1], offset.z + scale * q[2] };
+
+        for (u32 k = 0; k < 3; ++k)
+        {
+            EXPECT_NEAR(expected[k], dequantized[k], scale / 65535.0f);
+
+            const float transformed =
+                q[0] * dequantization.value(0 + k) + q[1] * dequantization.value(4 + k) +
+                q[2] * dequantization.value(8 + k) + q[3] * dequantization.value(12 + k);
+            EXPECT_NEAR(expected[k], transformed, scale / 65535.0f);
+        }
+
+        i16 encoded[2] = {
+            ReadAttribute<i16>(*quantized, i, VertexAttributeUsage::kNormal, 0),
+            ReadAttribute<i16>(*quantized, i, VertexAttributeUsage::kNormal, 1) };
+        float normal[3];
+        DecodeOctahedral(encoded, normal);
+        float dot = 0.0f;
+        for (u32 k = 0; k < 3; ++k)
+            dot += normal[k] * ReadAttribute<float>(*model, i, VertexAttributeUsage::kNormal, k);
+        EXPECT_GT(dot, 0.9999f);
+
+        EXPECT_EQ(ReadAttribute<float>(*model, i, VertexAttributeUsage::kTangent, 3) * 127.0f,
+            ReadAttribute<i8>(*quantized, i, VertexAttributeUsage::kTangent, 3));
+    }
+
+    EXPECT_THROW(QuantizeModel(*quantized), std::runtime_error *);
+}
+
+TEST(VertexQuantizationTest, TexCoords)
+{
+    ModelLoaderOBJ loader;
+    auto cube = QuantizeModel(*loader.Load(std::string("data/cube.obj")));
+    EXPECT_EQ(VertexAttributeFormat::kUnsignedShort2Normalized,
+        cube->vertex_layout().Find(VertexAttributeUsage::kTexCoord)->format);
+    EXPECT_EQ(0u, cube->index_count());
+
+    // Past [0, 1], only half floats can hold them.
+    auto tiled = CreateTiledTriangle();
+    EXPECT_EQ(VertexAttributeFormat::kFloat2,
+        QuantizeModel(*tiled)->vertex_layout().Find(VertexAttributeUsage::kTexCoord)->format);
+
+    auto half = QuantizeModel(*tiled, true);
+    EXPECT_EQ(VertexAttributeFormat::kHalf2,
+        half->vertex_layout().Find(VertexAttributeUsage::kTexCoord)->format);
+    EXPECT_EQ(12u, half->vertex_layout().stride());
+    EXPECT_EQ(-1.5f, HalfToFloat(ReadAttribute<u16>(*half, 0, VertexAttributeUsage::kTexCoord, 0)));
+    EXPECT_EQ(2.25f, HalfToFloat(ReadAttribute<u16>(*half, 1, VertexAttributeUsage::kTexCoord, 0)));
+    EXPECT_EQ(3.0f, HalfToFloat(ReadAttribute<u16>(*half, 2, VertexAttributeUsage::kTexCoord, 1)));
+
+    // Back to floats, for devices without half float attributes; the
+    // quantized positions stay.
+    auto expanded = ExpandHalfFloats(*half);
+    EXPECT_EQ(VertexAttributeFormat::kFloat2,
+        expanded->vertex_layout().Find(VertexAttributeUsage::kTexCoord)->format);
+    EXPECT_EQ(VertexAttributeFormat::kUnsignedShort4Normalized,
+        expanded->vertex_layout().Find(VertexAttributeUsage::kPosition)->format);
+    EXPECT_EQ(16u, expanded->vertex_layout().stride());
+    EXPECT_EQ(-1.5f, ReadAttribute<float>(*expanded, 0, VertexAttributeUsage::kTexCoord, 0));
+    EXPECT_EQ(3.0f, ReadAttribute<float>(*expanded, 2, VertexAttributeUsage::kTexCoord, 1));
+    EXPECT_EQ(ReadAttribute<u16>(*half, 1, VertexAttributeUsage::kPosition, 0),
+        ReadAttribute<u16>(*expanded, 1, VertexAttributeUsage::kPosition, 0));
+    EXPECT_EQ(half->position_scale(), expanded->position_scale());
+}
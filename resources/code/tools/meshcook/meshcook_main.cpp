@@ -0,0 +1,136 @@
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <blowgun/cooked_mesh.h>
+#include <blowgun/mesh_optimizer.h>
+#include <blowgun/model_loader_obj.h>
+#include <blowgun/vertex_quantization.h>
+
+namespace
+{
+    void PrintVertexCacheStatistics(const char * label, const blowgun::Model & model)
+    {
+        const std::vector<blowgun::u32> indices = model.ReadIndices();
+
+        std::cout << "  " << label << ":";
+        const blowgun::u32 cache_sizes[] = { 16, 32 };
+        for (int i = 0; i < 2; ++i)
+        {
+            const blowgun::VertexCacheStatistics statistics = blowgun::AnalyzeVertexCache(
+                indices.empty() ? 0 : &indices[0], model.index_count(), model.vertex_count(),
+                cache_sizes[i]);
+            std::cout << " FIFO " << cache_sizes[i]
+                << " ACMR " << statistics.acmr
+                << " ATVR " << statistics.atvr;
+        }
+        std::cout << std::endl;
+    }
+}
+
+// Usage: blowgun_meshcook [--no-index] [--no-optimize] [--quantize] [--half-floats]
+//                         [--threads N] INPUT.obj OUTPUT
+//
+// Convert a text model into a cooked mesh, which the applications can
+// map and use without parsing it. Indexed meshes are reordered for the
+// vertex cache, overdraw and vertex fetch, unless --no-optimize is
+// given. With --quantize, attributes are stored in smaller formats, see
+// `QuantizeModel`; --half-floats lets texture coordinates past [0, 1]
+// use half floats, for devices with GL_OES_vertex_half_float; others
+// have to convert them back with `ExpandHalfFloats` before drawing.
+int main(int argc, char ** argv)
+{
+    bool indexed = true;
+    bool optimized = true;
+    bool quantized = false;
+    bool half_floats = false;
+    blowgun::u32 thread_count = 0;
+    const char * input_path = 0;
+    const char * output_path = 0;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--no-index") == 0)
+            indexed = false;
+        else if (std::strcmp(argv[i], "--no-optimize") == 0)
+            optimized = false;
+        else if (std::strcmp(argv[i], "--quantize") == 0)
+            quantized = true;
+        else if (std::strcmp(argv[i], "--half-floats") == 0)
+            half_floats = true;
+        else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+            thread_count = static_cast<blowgun::u32>(std::atoi(argv[++i]));
+        else if (!input_path)
+            input_path = argv[i];
+        else if (!output_path)
+            output_path = argv[i];
+        else
+        {
+            std::cerr << "Unexpected argument: " << argv[i] << std::endl;
+            return 1;
+        }
+    }
+
+    if (!input_path || !output_path)
+    {
+        std::cerr << "Usage: " << argv[0]
+            << " [--no-index] [--no-optimize] [--quantize] [--half-floats] [--threads N]"
+            << " INPUT.obj OUTPUT" << std::endl;
+        return 1;
+    }
+
+    try
+    {
+        blowgun::ModelLoaderOBJ loader(thread_count);
+        loader.SetIndexed(indexed);
+        auto model = loader.Load(std::string(input_path));
+
+        std::shared_ptr<blowgun::Model> original;
+        if (indexed && optimized && model->index_count() > 0)
+        {
+            original = model;
+            model = blowgun::OptimizeModel(*original);
+        }
+
+        const blowgun::u32 float_stride = model->vertex_layout().stride();
+        if (quantized)
+            model = blowgun::QuantizeModel(*model, half_floats);
+
+        std::ofstream output(output_path, std::ios::out | std::ios::binary);
+        if (!output.is_open())
+        {
+            std::cerr << "Can't open " << output_path << std::endl;
+            return 1;
+        }
+        blowgun::CookMesh(*model, output);
+
+        std::cout << input_path << ": " << model->vertex_count() << " vertices, "
+            << model->index_count() << " indices, "
+            << model->groups().size() << " groups" << std::endl;
+
+        if (quantized)
+        {
+            std::cout << "  vertex stride: " << float_stride << " -> "
+                << model->vertex_layout().stride() << " bytes" << std::endl;
+        }
+
+        if (original)
+        {
+            PrintVertexCacheStatistics("before", *original);
+            PrintVertexCacheStatistics("after", *model);
+        }
+    }
+    catch (std::runtime_error * error)
+    {
+        std::cerr << error->what() << std::endl;
+        delete error;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,125 @@
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <GLES2/gl2.h>
+#include <GLES2/gl2ext.h>
+
+#include <blowgun/etc1.h>
+#include <blowgun/image_loader_tga.h>
+#include <blowgun/ktx.h>
+#include <blowgun/mipmap.h>
+
+// Usage: blowgun_texcook [--high] [--mipmaps] [--srgb] [--threads N] INPUT.tga OUTPUT.ktx
+//
+// Compress a TGA image to ETC1, in a KTX container that the applications
+// can map and upload without decoding it. With --mipmaps, the whole
+// chain is generated and compressed too, averaging sRGB colors as light
+// with --srgb. --high spends an order of magnitude longer for a better
+// fit. ETC1 has no alpha: the alpha channel of 32-bit images is dropped.
+int main(int argc, char ** argv)
+{
+    blowgun::ETC1Quality::Enum quality = blowgun::ETC1Quality::kFast;
+    bool mipmaps = false;
+    bool srgb = false;
+    blowgun::u32 thread_count = 0;
+    const char * input_path = 0;
+    const char * output_path = 0;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--high") == 0)
+            quality = blowgun::ETC1Quality::kHigh;
+        else if (std::strcmp(argv[i], "--mipmaps") == 0)
+            mipmaps = true;
+        else if (std::strcmp(argv[i], "--srgb") == 0)
+            srgb = true;
+        else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+            thread_count = static_cast<blowgun::u32>(std::atoi(argv[++i]));
+        else if (!input_path)
+            input_path = argv[i];
+        else if (!output_path)
+            output_path = argv[i];
+        else
+        {
+            std::cerr << "Unexpected argument: " << argv[i] << std::endl;
+            return 1;
+        }
+    }
+
+    if (!input_path || !output_path)
+    {
+        std::cerr << "Usage: " << argv[0]
+            << " [--high] [--mipmaps] [--srgb] [--threads N] INPUT.tga OUTPUT.ktx" << std::endl;
+        return 1;
+    }
+
+    try
+    {
+        std::ifstream input(input_path, std::ios::in | std::ios::binary);
+        if (!input.is_open())
+        {
+            std::cerr << "Can't open " << input_path << std::endl;
+            return 1;
+        }
+        std::shared_ptr<blowgun::Image> image = blowgun::ImageLoaderTGA().Load(input);
+
+        const blowgun::u32 channel_count = image->bpp / 8;
+        if (channel_count < 3)
+        {
+            std::cerr << input_path << ": ETC1 needs a color image" << std::endl;
+            return 1;
+        }
+
+        std::vector<std::vector<blowgun::byte>> levels;
+        levels.push_back(blowgun::EncodeETC1(image->data.data(), image->width, image->height,
+            channel_count, quality, thread_count));
+
+        if (mipmaps)
+        {
+            const std::vector<std::vector<blowgun::byte>> smaller = blowgun::GenerateMipmaps(
+                image->data.data(), image->width, image->height, channel_count, srgb,
+                thread_count);
+
+            blowgun::u32 width = image->width;
+            blowgun::u32 height = image->height;
+            for (size_t i = 0; i < smaller.size(); ++i)
+            {
+                width = (width > 1) ? width / 2 : 1;
+                height = (height > 1) ? height / 2 : 1;
+                levels.push_back(blowgun::EncodeETC1(smaller[i].data(), width, height,
+                    channel_count, quality, thread_count));
+            }
+        }
+
+        std::ofstream output(output_path, std::ios::out | std::ios::binary);
+        if (!output.is_open())
+        {
+            std::cerr << "Can't open " << output_path << std::endl;
+            return 1;
+        }
+        blowgun::WriteKTX(output, GL_ETC1_RGB8_OES, GL_RGB, 0, image->width, image->height,
+            levels);
+
+        size_t compressed_size = 0;
+        for (size_t i = 0; i < levels.size(); ++i)
+            compressed_size += levels[i].size();
+
+        std::cout << input_path << ": " << image->width << "x" << image->height << ", "
+            << levels.size() << " levels, " << image->data.size() << " -> "
+            << compressed_size << " bytes" << std::endl;
+    }
+    catch (std::runtime_error * error)
+    {
+        std::cerr << error->what() << std::endl;
+        delete error;
+        return 1;
+    }
+
+    return 0;
+}